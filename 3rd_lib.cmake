@@ -123,8 +123,19 @@ ExternalProject_Add(libav-5.1.4
 ExternalProject_Add(libsrtp
     EXCLUDE_FROM_ALL 1
     URL https://github.com/cisco/libsrtp/archive/refs/tags/v2.4.2.tar.gz
+    DEPENDS libboringssl
     BUILD_IN_SOURCE 1
-    CONFIGURE_COMMAND ./configure --prefix=${PROJECT_BINARY_DIR}
+    CONFIGURE_COMMAND ./configure --prefix=${PROJECT_BINARY_DIR} --enable-openssl --with-openssl-dir=${PROJECT_BINARY_DIR}
     BUILD_COMMAND make -j4
     INSTALL_COMMAND make install
 )
+
+# 仅单元测试使用
+ExternalProject_Add(libgtest
+    EXCLUDE_FROM_ALL 1
+    URL https://github.com/google/googletest/archive/refs/tags/v1.14.0.tar.gz
+    BUILD_IN_SOURCE 1
+    CONFIGURE_COMMAND cmake -B build -DCMAKE_BUILD_TYPE=Release -DBUILD_GMOCK=OFF -DCMAKE_INSTALL_PREFIX=${PROJECT_BINARY_DIR}
+    BUILD_COMMAND make -C build -j4
+    INSTALL_COMMAND make -C build install
+)
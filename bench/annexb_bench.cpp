@@ -0,0 +1,107 @@
+// Annex-B扫描吞吐，逐个实现(scalar/sse2/avx2)对比，单线程
+// 模拟4K码流：每帧若干个slice，nalu数据为不含起始码的随机字节，带少量防竞争字节
+// 用法: annexb_bench [数据MB数] [nalu大小]
+#include <stdlib.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "codec/annexb.hpp"
+
+using namespace mms;
+
+namespace {
+std::string make_stream(size_t total_bytes, size_t nalu_size, size_t & nalu_count) {
+    std::mt19937 rng(2024);
+    std::string stream;
+    stream.reserve(total_bytes + nalu_size + 4);
+    nalu_count = 0;
+    while (stream.size() < total_bytes) {
+        stream.append("\x00\x00\x00\x01", 4);
+        stream.push_back(0x41);
+        for (size_t i = 1; i < nalu_size; i++) {
+            char c = (char)(rng() & 0xff);
+            size_t n = stream.size();
+            if (c <= 0x03 && stream[n - 1] == 0x00 && stream[n - 2] == 0x00) {
+                stream.push_back(0x03);
+            }
+            stream.push_back(c);
+        }
+        if (stream.back() == 0x00) {
+            stream.back() = (char)0x80;
+        }
+        nalu_count++;
+    }
+    return stream;
+}
+};
+
+int main(int argc, char *argv[]) {
+    size_t mbytes = argc > 1 ? (size_t)atoi(argv[1]) : 256;
+    size_t nalu_size = argc > 2 ? (size_t)atoi(argv[2]) : 60000;
+    if (mbytes == 0 || nalu_size < 2) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    size_t nalu_count = 0;
+    std::string stream = make_stream(mbytes * 1024 * 1024, nalu_size, nalu_count);
+    printf("annexb stream %zu bytes, %zu nalus, default impl %s\n", stream.size(), nalu_count, annexb_scan_impl());
+
+    const int32_t rounds = 4;
+    std::vector<std::string_view> nalus;
+    nalus.reserve(nalu_count);
+    std::string rbsp;
+    for (auto impl : {"scalar", "sse2", "avx2"}) {
+        if (!set_annexb_scan_impl(impl)) {
+            printf("%s not supported\n", impl);
+            continue;
+        }
+
+        // 找出所有00 00
+        const uint8_t *begin = (const uint8_t *)stream.data();
+        const uint8_t *end = begin + stream.size();
+        int64_t pairs = 0;
+        int64_t start = bench::now_ns();
+        for (int32_t r = 0; r < rounds; r++) {
+            const uint8_t *p = begin;
+            while ((p = find_zero_pair(p, end)) < end) {
+                pairs++;
+                p++;
+            }
+        }
+        int64_t elapsed = bench::now_ns() - start;
+        std::string name = std::string(impl) + " find_zero_pair";
+        bench::report(name.c_str(), pairs, elapsed, "pairs", (int64_t)stream.size() * rounds);
+
+        // 按起始码切分
+        start = bench::now_ns();
+        for (int32_t r = 0; r < rounds; r++) {
+            nalus.clear();
+            split_annexb(stream, nalus);
+        }
+        elapsed = bench::now_ns() - start;
+        if (nalus.size() != nalu_count) {
+            printf("split error, %zu nalus, expect %zu\n", nalus.size(), nalu_count);
+            return -1;
+        }
+        name = std::string(impl) + " split_annexb";
+        bench::report(name.c_str(), nalu_count * rounds, elapsed, "nalus", (int64_t)stream.size() * rounds);
+
+        // 去防竞争字节，含输出拷贝
+        start = bench::now_ns();
+        int64_t bytes = 0;
+        for (int32_t r = 0; r < rounds; r++) {
+            for (auto & nalu : nalus) {
+                remove_emulation_prevention(nalu, rbsp);
+                bytes += nalu.size();
+            }
+        }
+        elapsed = bench::now_ns() - start;
+        name = std::string(impl) + " remove_emulation_prevention";
+        bench::report(name.c_str(), nalu_count * rounds, elapsed, "nalus", bytes);
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// 音频转码(AAC<->Opus)单核能同时支撑的流数
+// 先把正弦波编码成输入帧，再通过AudioTranscoder在一个转码线程上转码，
+// 只统计转码线程的cpu时间(AudioTranscoder的cpu_us)，流数 = 输出音频时长 / cpu时间
+// 用法: audio_transcode_bench [输入秒数]
+#include <math.h>
+#include <stdlib.h>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+
+#include "bench.hpp"
+#include "base/thread/thread_worker.hpp"
+#include "codec/aac/aac_encoder.hpp"
+#include "codec/opus/opus_encoder.hpp"
+#include "transcode/audio_transcoder.hpp"
+
+using namespace mms;
+
+namespace {
+// 交织的双声道正弦波
+std::vector<int16_t> make_pcm(int32_t sample_rate, int32_t seconds) {
+    std::vector<int16_t> pcm((size_t)sample_rate * seconds * 2);
+    for (size_t i = 0; i < pcm.size() / 2; i++) {
+        int16_t v = (int16_t)(8000 * sin(2 * M_PI * 440 * i / sample_rate));
+        pcm[2 * i] = v;
+        pcm[2 * i + 1] = v;
+    }
+    return pcm;
+}
+
+bool make_aac_frames(int32_t seconds, std::vector<AudioTranscoder::Frame> & frames, std::string & config) {
+    AACEncoder encoder;
+    if (!encoder.init(44100, 2)) {
+        return false;
+    }
+    config = encoder.get_specific_configuration();
+
+    auto pcm = make_pcm(44100, seconds);
+    size_t frame_samples = encoder.get_input_samples();
+    uint8_t out[8192];
+    for (size_t off = 0; off + frame_samples <= pcm.size(); off += frame_samples) {
+        int32_t bytes = encoder.encode_frame(pcm.data() + off, out, sizeof(out));
+        if (bytes > 0) {
+            AudioTranscoder::Frame f;
+            f.data.assign((char *)out, bytes);
+            frames.emplace_back(std::move(f));
+        }
+    }
+    return !frames.empty();
+}
+
+bool make_opus_frames(int32_t seconds, std::vector<AudioTranscoder::Frame> & frames) {
+    MOpusEncoder encoder;
+    if (!encoder.init(48000, 2)) {
+        return false;
+    }
+
+    auto pcm = make_pcm(48000, seconds);
+    const size_t frame_samples = 960;// 20ms
+    uint8_t out[4000];
+    for (size_t off = 0; off + frame_samples * 2 <= pcm.size(); off += frame_samples * 2) {
+        int32_t bytes = encoder.encode((uint8_t *)(pcm.data() + off), frame_samples, out, sizeof(out));
+        if (bytes > 0) {
+            AudioTranscoder::Frame f;
+            f.data.assign((char *)out, bytes);
+            f.pts = (int64_t)frames.size() * frame_samples;
+            frames.emplace_back(std::move(f));
+        }
+    }
+    return !frames.empty();
+}
+
+// 等转码线程处理完已投递的帧
+void drain(ThreadWorker & worker) {
+    std::promise<void> done;
+    boost::asio::post(worker.get_io_context(), [&done]() {
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+void bench_transcode(AudioTranscoder::Type type, const char *name, const std::vector<AudioTranscoder::Frame> & frames,
+                     const std::string & config, int32_t sample_rate) {
+    ThreadWorker worker;
+    worker.start();
+    auto transcoder = std::make_shared<AudioTranscoder>(&worker, type, name);
+    int owner = 0;
+    transcoder->attach(&owner, [](std::shared_ptr<std::vector<AudioTranscoder::Frame>> out) {
+        (void)out;
+    });
+
+    if (!transcoder->configure(&owner, config, sample_rate, 2)) {
+        printf("configure %s failed\n", name);
+        worker.stop();
+        return;
+    }
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        transcoder->feed(&owner, frames[i]);
+        // 转码线程最多积压MAX_PENDING_FRAMES帧，超过会丢
+        if (i % 100 == 99) {
+            drain(worker);
+        }
+    }
+    drain(worker);
+
+    auto v = transcoder->to_json();
+    transcoder->detach(&owner);
+    worker.stop();
+
+    int64_t cpu_us = v["cpu_us"].asInt64();
+    int64_t out_ms = v["out_ms"].asInt64();
+    if (v["dropped_frames"].asUInt64() > 0 || cpu_us <= 0) {
+        printf("%s: dropped %llu frames, cpu %lldus\n", name, (unsigned long long)v["dropped_frames"].asUInt64(), (long long)cpu_us);
+        return;
+    }
+
+    bench::report(name, (int64_t)frames.size(), cpu_us * 1000, "frames");
+    printf("%-40s %12lld ms out %14.1f streams per core\n", name, (long long)out_ms, out_ms * 1000.0 / cpu_us);
+    fflush(stdout);
+}
+};
+
+int main(int argc, char *argv[]) {
+    int32_t seconds = argc > 1 ? atoi(argv[1]) : 60;
+    if (seconds <= 0) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    std::vector<AudioTranscoder::Frame> aac_frames;
+    std::string aac_config;
+    if (!make_aac_frames(seconds, aac_frames, aac_config)) {
+        printf("encode aac input failed\n");
+        return -1;
+    }
+
+    std::vector<AudioTranscoder::Frame> opus_frames;
+    if (!make_opus_frames(seconds, opus_frames)) {
+        printf("encode opus input failed\n");
+        return -1;
+    }
+
+    printf("%d seconds of 44.1k/48k stereo input\n", seconds);
+    bench_transcode(AudioTranscoder::AAC_TO_OPUS, "aac->opus", aac_frames, aac_config, 44100);
+    bench_transcode(AudioTranscoder::OPUS_TO_AAC, "opus->aac", opus_frames, "", 48000);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+// 性能测试公用的计时及输出，每个测试程序单独运行，结果按行输出
+namespace mms {
+namespace bench {
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 输出一行结果：名称、次数、耗时及每秒次数，bytes大于0时同时输出吞吐
+inline void report(const char *name, int64_t ops, int64_t elapsed_ns, const char *unit, int64_t bytes = 0) {
+    double secs = elapsed_ns / 1e9;
+    if (secs <= 0) {
+        secs = 1e-9;
+    }
+    printf("%-40s %12lld %-8s %10.3f s %14.0f %s/s", name, (long long)ops, unit, secs, ops / secs, unit);
+    if (bytes > 0) {
+        printf(" %10.1f MB/s", bytes / secs / 1024 / 1024);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+};
+};
@@ -0,0 +1,174 @@
+// DTLS握手吞吐，客户端和服务端在内存中完成完整握手，不经过网络
+// 服务端的SSL_CTX配置与DtlsBoringSSLSession::start_handshake一致(每次握手新建SSL_CTX)，
+// 单独统计服务端的耗时，即每个核每秒能完成的握手数，多线程时模拟DtlsHandshakePool的多个握手线程
+// 用法: dtls_handshake_bench [每线程握手次数] [线程数]
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "openssl/ssl.h"
+#include "openssl/bio.h"
+
+#include "bench.hpp"
+#include "server/webrtc/dtls/dtls_cert.h"
+
+using namespace mms;
+
+namespace {
+int on_verify(int, X509_STORE_CTX *) {
+    return 1;
+}
+
+SSL_CTX *create_ctx(DtlsCert & cert, bool server) {
+    SSL_CTX *ctx = SSL_CTX_new(DTLS_method());
+    if (!ctx) {
+        return nullptr;
+    }
+
+#ifndef OPENSSL_IS_BORINGSSL
+    // 用系统openssl编译时，默认安全级别不允许512位的rsa证书
+    SSL_CTX_set_security_level(ctx, 0);
+#endif
+
+    if (!SSL_CTX_use_PrivateKey(ctx, cert.get_pkey()) || !SSL_CTX_use_certificate(ctx, cert.get_cert())) {
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_NO_TICKET |
+                             SSL_OP_SINGLE_ECDH_USE | SSL_OP_NO_QUERY_MTU);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_read_ahead(ctx, 1);
+    SSL_CTX_set_verify_depth(ctx, 4);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | (server ? SSL_VERIFY_FAIL_IF_NO_PEER_CERT : 0), on_verify);
+    if (!SSL_CTX_set_cipher_list(ctx, "DEFAULT:!NULL:!aNULL:!SHA256:!SHA384:!aECDH:!AESGCM+AES256:!aPSK") ||
+        SSL_CTX_set_tlsext_use_srtp(ctx, "SRTP_AES128_CM_SHA1_80") != 0) {
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+SSL *create_ssl(SSL_CTX *ctx) {
+    SSL *ssl = SSL_new(ctx);
+    if (!ssl) {
+        return nullptr;
+    }
+    SSL_set_bio(ssl, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+    SSL_set_mtu(ssl, 1350);
+    SSL_set_mode(ssl, SSL_MODE_AUTO_RETRY);
+    return ssl;
+}
+
+void transfer(SSL *from, SSL *to) {
+    char buf[4096];
+    int n;
+    while ((n = BIO_read(SSL_get_wbio(from), buf, sizeof(buf))) > 0) {
+        BIO_write(SSL_get_rbio(to), buf, n);
+    }
+}
+
+// 完成一次握手，返回服务端耗时(ns)，失败返回-1
+int64_t handshake_once(DtlsCert & server_cert, SSL_CTX *client_ctx) {
+    int64_t server_ns = 0;
+    int64_t start = bench::now_ns();
+    SSL_CTX *server_ctx = create_ctx(server_cert, true);
+    SSL *server = server_ctx ? create_ssl(server_ctx) : nullptr;
+    server_ns += bench::now_ns() - start;
+    SSL *client = create_ssl(client_ctx);
+    if (!server || !client) {
+        SSL_free(server);
+        SSL_free(client);
+        SSL_CTX_free(server_ctx);
+        return -1;
+    }
+
+    SSL_set_accept_state(server);
+    SSL_set_connect_state(client);
+    bool done = false;
+    // 完整握手只需要几个来回，超过说明出错了
+    for (int i = 0; i < 16 && !done; i++) {
+        SSL_do_handshake(client);
+        transfer(client, server);
+
+        start = bench::now_ns();
+        SSL_do_handshake(server);
+        server_ns += bench::now_ns() - start;
+        transfer(server, client);
+
+        done = SSL_is_init_finished(server) && SSL_is_init_finished(client);
+    }
+
+    start = bench::now_ns();
+    SSL_free(server);
+    SSL_CTX_free(server_ctx);
+    server_ns += bench::now_ns() - start;
+    SSL_free(client);
+    return done ? server_ns : -1;
+}
+
+void bench_handshake(DtlsCert::KeyType key_type, const char *name, int32_t count, int32_t threads) {
+    DtlsCert server_cert;
+    DtlsCert client_cert;
+    if (!server_cert.init("mms.cn", key_type) || !client_cert.init("client.mms.cn", DtlsCert::KEY_TYPE_ECDSA)) {
+        printf("create %s cert failed\n", name);
+        return;
+    }
+
+    std::atomic<int64_t> server_ns{0};
+    std::atomic<int32_t> failed{0};
+    std::vector<std::thread> ths;
+    int64_t start = bench::now_ns();
+    for (int32_t t = 0; t < threads; t++) {
+        ths.emplace_back([&]() {
+            SSL_CTX *client_ctx = create_ctx(client_cert, false);
+            if (!client_ctx) {
+                failed += count;
+                return;
+            }
+
+            for (int32_t i = 0; i < count; i++) {
+                int64_t ns = handshake_once(server_cert, client_ctx);
+                if (ns < 0) {
+                    failed++;
+                    continue;
+                }
+                server_ns += ns;
+            }
+            SSL_CTX_free(client_ctx);
+        });
+    }
+
+    for (auto & th : ths) {
+        th.join();
+    }
+    int64_t elapsed = bench::now_ns() - start;
+    if (failed > 0) {
+        printf("%s: %d handshakes failed\n", name, failed.load());
+        return;
+    }
+
+    int64_t total = (int64_t)count * threads;
+    std::string wall_name = std::string(name) + " " + std::to_string(threads) + " threads client+server";
+    bench::report(wall_name.c_str(), total, elapsed, "hs");
+    // 服务端耗时按单核累计，即每个握手线程的处理能力
+    std::string server_name = std::string(name) + " server per core";
+    bench::report(server_name.c_str(), total, server_ns.load(), "hs");
+}
+};
+
+int main(int argc, char *argv[]) {
+    int32_t count = argc > 1 ? atoi(argv[1]) : 2000;
+    int32_t threads = argc > 2 ? atoi(argv[2]) : 1;
+    if (count <= 0 || threads <= 0) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    bench_handshake(DtlsCert::KEY_TYPE_ECDSA, "ecdsa-p256", count, threads);
+    bench_handshake(DtlsCert::KEY_TYPE_RSA, "rsa", count, threads);
+    return 0;
+}
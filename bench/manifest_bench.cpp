@@ -0,0 +1,167 @@
+// m3u8生成开销：1000路流，每路每秒完成一个切片并重新生成m3u8，单线程
+// current与HlsLiveMediaSource::build_m3u8相同：切片行在切片完成时生成好，拼接后原子替换发布
+// legacy为改动前的做法：每次用stringstream按浮点格式化全部切片行，持有写锁生成并发布
+// 不含ll-hls的part行，两种做法中part行的生成方式相同
+// 用法: manifest_bench [流数] [模拟秒数] [m3u8切片数]
+#include <stdlib.h>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "base/utils/text_builder.h"
+#include "protocol/http/http_cached_response.hpp"
+
+using namespace mms;
+
+namespace {
+struct Seg {
+    int64_t seqno;
+    int64_t duration;
+    std::string filename;
+};
+
+const std::string CONTENT_TYPE = "application/vnd.apple.mpegurl";
+
+struct Stream {
+    std::string name;
+    int64_t create_at = 1700000000;
+    uint64_t m3u8_seq = 0;
+    std::deque<Seg> segs;
+};
+
+struct LegacyStream : public Stream {
+    std::shared_mutex m3u8_mtx;
+    std::string m3u8;
+    std::shared_ptr<HttpCachedResponse> m3u8_resp;
+
+    void on_segment(Seg seg, size_t window) {
+        segs.push_back(std::move(seg));
+        if (segs.size() > window) {
+            segs.pop_front();
+        }
+
+        std::unique_lock<std::shared_mutex> lck(m3u8_mtx);
+        std::stringstream ss;
+        ss << "#EXTM3U\r\n";
+        ss << "#EXT-X-VERSION:3\r\n";
+        int64_t max_duration = 0;
+        for (auto & s : segs) {
+            max_duration = std::max(max_duration, s.duration);
+        }
+        int target_duration = (int)ceil(max_duration / 1000.0);
+        ss << "#EXT-X-TARGETDURATION:" << target_duration << "\r\n";
+        ss.precision(3);
+        ss.setf(std::ios::fixed, std::ios::floatfield);
+        ss << "#EXT-X-MEDIA-SEQUENCE:" << segs.front().seqno << "\r\n";
+        for (auto & s : segs) {
+            ss << "#EXTINF:" << s.duration / 1000.0 << "\r\n";
+            ss << name << "/" << s.filename << "\r\n";
+        }
+        m3u8 = ss.str();
+        m3u8_resp = HttpCachedResponse::create_with_body(CONTENT_TYPE, m3u8, std::to_string(create_at) + "-" + std::to_string(++m3u8_seq),
+                                                         create_at * 1000, "max-age=1");
+    }
+
+    size_t body_size() {
+        std::shared_lock<std::shared_mutex> lck(m3u8_mtx);
+        return m3u8_resp->get_body().size();
+    }
+};
+
+struct CurrentStream : public Stream {
+    std::deque<std::string> seg_lines;
+    size_t m3u8_size_hint = 0;
+    std::atomic<std::shared_ptr<const HttpCachedResponse>> m3u8_resp;
+
+    void on_segment(Seg seg, size_t window) {
+        TextBuilder line;
+        line << "#EXTINF:" << TextBuilder::sec(seg.duration) << "\r\n" << name << "/" << seg.filename << "\r\n";
+        seg_lines.emplace_back(std::move(line.str()));
+        segs.push_back(std::move(seg));
+        if (segs.size() > window) {
+            segs.pop_front();
+            seg_lines.pop_front();
+        }
+
+        TextBuilder tb;
+        tb.reserve(m3u8_size_hint);
+        tb << "#EXTM3U\r\n";
+        tb << "#EXT-X-VERSION:" << 3 << "\r\n";
+        int64_t max_duration = 0;
+        for (auto & s : segs) {
+            max_duration = std::max(max_duration, s.duration);
+        }
+        tb << "#EXT-X-TARGETDURATION:" << (max_duration + 999) / 1000 << "\r\n";
+        tb << "#EXT-X-MEDIA-SEQUENCE:" << segs.front().seqno << "\r\n";
+        for (auto & l : seg_lines) {
+            tb << l;
+        }
+        m3u8_size_hint = tb.size() + 256;
+        m3u8_resp.store(HttpCachedResponse::create_with_body(CONTENT_TYPE, std::move(tb.str()), std::to_string(create_at) + "-" + std::to_string(++m3u8_seq),
+                                                             create_at * 1000, "max-age=1"), std::memory_order_release);
+    }
+
+    size_t body_size() {
+        return m3u8_resp.load(std::memory_order_acquire)->get_body().size();
+    }
+};
+
+// 切片时长在1s附近抖动，与按关键帧切片时一样不是整秒
+Seg make_seg(int64_t seqno) {
+    return Seg{seqno, 960 + (seqno * 37) % 80, std::to_string(seqno) + ".ts"};
+}
+
+template <typename S>
+void run(const char *name, int32_t stream_count, int32_t seconds, size_t window) {
+    std::vector<std::unique_ptr<S>> streams;
+    for (int32_t i = 0; i < stream_count; i++) {
+        auto s = std::make_unique<S>();
+        s->name = "stream_" + std::to_string(i);
+        streams.emplace_back(std::move(s));
+    }
+
+    // 先填满窗口，只统计稳定状态
+    int64_t seqno = 1;
+    for (; seqno <= (int64_t)window; seqno++) {
+        for (auto & s : streams) {
+            s->on_segment(make_seg(seqno), window);
+        }
+    }
+
+    int64_t start = bench::now_ns();
+    int64_t bytes = 0;
+    for (int32_t sec = 0; sec < seconds; sec++, seqno++) {
+        for (auto & s : streams) {
+            s->on_segment(make_seg(seqno), window);
+            bytes += s->body_size();
+        }
+    }
+    int64_t elapsed = bench::now_ns() - start;
+    int64_t reaps = (int64_t)stream_count * seconds;
+    bench::report(name, reaps, elapsed, "m3u8", bytes);
+    // 每秒每路生成一次时占用的单核比例
+    printf("%-40s %.2f us per m3u8, %.3f%% of one core for %d streams\n", name, elapsed / 1000.0 / reaps,
+           elapsed / 1e9 / seconds * 100, stream_count);
+}
+};
+
+int main(int argc, char *argv[]) {
+    int32_t stream_count = argc > 1 ? atoi(argv[1]) : 1000;
+    int32_t seconds = argc > 2 ? atoi(argv[2]) : 60;
+    size_t window = argc > 3 ? (size_t)atoi(argv[3]) : 5;
+    if (stream_count <= 0 || seconds <= 0 || window == 0) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    run<LegacyStream>("legacy stringstream m3u8", stream_count, seconds, window);
+    run<CurrentStream>("current TextBuilder m3u8", stream_count, seconds, window);
+    return 0;
+}
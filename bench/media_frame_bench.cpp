@@ -0,0 +1,224 @@
+// 一路1080p60 h264的rtmp视频帧被所有rtmp桥(转flv、ts、rtsp、webrtc、m4s)同时消费时的解析开销，单线程
+// legacy为改动前的做法：源解析标签头，每个桥再各自解析标签头并切分nalu到std::list
+// current与现在相同：源解析标签头并由attach_frame切分nalu、解析slice头生成MediaFrame，桥通过get_rtmp_video_frame共用
+// 只统计解析部分，各桥的封装开销在两种做法中相同，不计入
+// 用法: media_frame_bench [帧数] [码率kbps] [每帧slice数]
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "protocol/rtmp/rtmp_define.hpp"
+#include "protocol/rtmp/flv/flv_tag.hpp"
+#include "codec/media_frame.hpp"
+#include "codec/slice_info.hpp"
+#include "bridge/rtmp/rtmp_frame.hpp"
+
+using namespace mms;
+
+namespace {
+const int32_t NALU_LENGTH_SIZE = 4;
+// flv桥只需要标签头，其余4个桥都要切分nalu
+const int32_t NALU_BRIDGE_COUNT = 4;
+
+// 改动前各桥中复制的get_nalus
+int32_t legacy_get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> & nalus) {
+    uint8_t *data_start = data;
+    while (len > 0) {
+        int32_t nalu_len = 0;
+        if (len < NALU_LENGTH_SIZE) {
+            return -1;
+        }
+        nalu_len = ntohl(*(uint32_t *)data);
+        data += NALU_LENGTH_SIZE;
+        len -= NALU_LENGTH_SIZE;
+        if (len < nalu_len) {
+            return -2;
+        }
+        nalus.emplace_back(std::string_view((char *)data, nalu_len));
+        data += nalu_len;
+        len -= nalu_len;
+    }
+    return data - data_start;
+}
+
+void append_nalu(std::string & buf, const std::string & nalu) {
+    uint32_t len = htonl((uint32_t)nalu.size());
+    buf.append((const char *)&len, 4);
+    buf.append(nalu);
+}
+
+// 生成一帧的flv视频标签数据：5字节标签头 + 长度前缀的nalu，关键帧前带sei
+std::string make_tag(bool is_key, size_t frame_size, int32_t slice_count) {
+    std::string tag;
+    tag.push_back((char)((is_key ? 0x10 : 0x20) | VideoTagHeader::AVC));
+    tag.push_back(1);
+    // cts 33ms
+    tag.push_back(0);
+    tag.push_back(0);
+    tag.push_back(33);
+    if (is_key) {
+        append_nalu(tag, std::string("\x06\x05\x10", 3) + std::string(16, '\x5a') + "\x80");
+    }
+
+    size_t slice_size = frame_size / slice_count;
+    for (int32_t i = 0; i < slice_count; i++) {
+        std::string slice(slice_size, '\xab');
+        // first_mb_in_slice=0，slice_type=7(I)或5(P)
+        slice[0] = is_key ? 0x65 : 0x41;
+        slice[1] = is_key ? (char)0x88 : (char)0x98;
+        append_nalu(tag, slice);
+    }
+    return tag;
+}
+
+std::shared_ptr<RtmpMessage> make_msg(const std::string & tag, int32_t timestamp) {
+    auto msg = std::make_shared<RtmpMessage>(tag.size());
+    memcpy((char *)msg->get_unuse_data().data(), tag.data(), tag.size());
+    msg->inc_used_bytes(tag.size());
+    msg->message_type_id_ = RTMP_MESSAGE_TYPE_VIDEO;
+    msg->timestamp_ = timestamp;
+    return msg;
+}
+
+// 桥拿到nalu后按类型分发，两种做法相同
+inline int64_t walk_nalus(const auto & nalus) {
+    int64_t v = 0;
+    for (auto & nalu : nalus) {
+        v += (uint8_t)nalu[0] & 0x1f;
+    }
+    return v;
+}
+
+int64_t legacy_frame(std::shared_ptr<RtmpMessage> msg) {
+    int64_t v = 0;
+    // 源及flv桥解析标签头
+    for (int32_t i = 0; i < 2; i++) {
+        VideoTagHeader header;
+        auto payload = msg->get_using_data();
+        v += header.decode((uint8_t *)payload.data(), payload.size());
+    }
+
+    for (int32_t i = 0; i < NALU_BRIDGE_COUNT; i++) {
+        VideoTagHeader header;
+        auto payload = msg->get_using_data();
+        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
+        int64_t pts = msg->timestamp_ + header.get_cts();
+        std::list<std::string_view> nalus;
+        if (legacy_get_nalus((uint8_t *)payload.data() + header_consumed, payload.size() - header_consumed, nalus) < 0) {
+            return -1;
+        }
+        v += walk_nalus(nalus) + pts;
+    }
+    return v;
+}
+
+// 与RtmpMediaSource::attach_frame相同
+void attach_frame(std::shared_ptr<RtmpMessage> pkt, bool is_key, int32_t header_consumed, int32_t composition_time) {
+    auto frame = std::make_shared<MediaFrame>();
+    auto payload = pkt->get_using_data();
+    frame->codec = CODEC_H264;
+    frame->is_video = true;
+    frame->is_key = is_key;
+    frame->dts = pkt->timestamp_;
+    frame->pts = pkt->timestamp_ + composition_time;
+    frame->payload = std::string_view(payload.data() + header_consumed, payload.size() - header_consumed);
+    if (split_nalus((const uint8_t *)frame->payload.data(), frame->payload.size(), NALU_LENGTH_SIZE, frame->nalus) < 0) {
+        return;
+    }
+
+    SliceInfo slice_info;
+    for (auto & nalu : frame->nalus) {
+        if (parse_h264_slice_info(nalu, slice_info)) {
+            frame->frame_type = slice_info.frame_type;
+            frame->disposable = !is_key && slice_info.nal_ref_idc == 0;
+            break;
+        }
+    }
+    pkt->frame_ = frame;
+}
+
+int64_t current_frame(std::shared_ptr<RtmpMessage> msg) {
+    int64_t v = 0;
+    {// 源
+        VideoTagHeader header;
+        auto payload = msg->get_using_data();
+        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
+        attach_frame(msg, header.is_key_frame(), header_consumed, header.get_cts());
+    }
+
+    {// flv桥原样转发，仍需要标签头
+        VideoTagHeader header;
+        auto payload = msg->get_using_data();
+        v += header.decode((uint8_t *)payload.data(), payload.size());
+    }
+
+    for (int32_t i = 0; i < NALU_BRIDGE_COUNT; i++) {
+        auto frame = get_rtmp_video_frame(msg, NALU_LENGTH_SIZE);
+        if (!frame) {
+            return -1;
+        }
+        v += walk_nalus(frame->nalus) + frame->pts;
+    }
+    return v;
+}
+
+template <typename F>
+void run(const char *name, const std::vector<std::string> & tags, int32_t frame_count, int64_t tag_bytes, F && f) {
+    // 消息的分配及拷贝在两种做法中相同，不计入，每帧前清掉上一轮挂上的帧信息
+    std::vector<std::shared_ptr<RtmpMessage>> msgs;
+    for (auto & tag : tags) {
+        msgs.emplace_back(make_msg(tag, (int32_t)(msgs.size() * 1000 / 60)));
+    }
+
+    int64_t check = 0;
+    int64_t start = bench::now_ns();
+    for (int32_t i = 0; i < frame_count; i++) {
+        auto & msg = msgs[i % msgs.size()];
+        msg->frame_ = nullptr;
+        check += f(msg);
+    }
+    int64_t elapsed = bench::now_ns() - start;
+    bench::report(name, frame_count, elapsed, "frame", tag_bytes);
+    // 60fps时一路流每秒的解析开销
+    printf("%-40s %.3f us per frame, %.4f%% of one core per 1080p60 stream (check %lld)\n", name, elapsed / 1000.0 / frame_count,
+           elapsed / 1e9 / (frame_count / 60.0) * 100, (long long)check);
+}
+};
+
+int main(int argc, char *argv[]) {
+    int32_t frame_count = argc > 1 ? atoi(argv[1]) : 60000;
+    int32_t kbps = argc > 2 ? atoi(argv[2]) : 6000;
+    int32_t slice_count = argc > 3 ? atoi(argv[3]) : 4;
+    if (frame_count <= 0 || kbps <= 0 || slice_count <= 0) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    // 2s一个gop，关键帧约为非关键帧的10倍大小
+    const int32_t gop = 120;
+    size_t avg_frame = (size_t)kbps * 1000 / 8 / 60;
+    size_t p_size = avg_frame * gop / (gop - 1 + 10);
+    std::string key_tag = make_tag(true, p_size * 10, slice_count);
+    std::string p_tag = make_tag(false, p_size, slice_count);
+    // 一个gop的数据循环使用
+    std::vector<std::string> tags;
+    for (int32_t i = 0; i < gop; i++) {
+        tags.push_back(i == 0 ? key_tag : p_tag);
+    }
+    int64_t tag_bytes = 0;
+    for (int32_t i = 0; i < frame_count; i++) {
+        tag_bytes += tags[i % gop].size();
+    }
+    printf("%d frames, %d kbps, key frame %zu bytes, p frame %zu bytes, %d slices, %d nalu bridges + flv\n", frame_count, kbps,
+           key_tag.size(), p_tag.size(), slice_count, NALU_BRIDGE_COUNT);
+
+    run("legacy per-bridge parse", tags, frame_count, tag_bytes, legacy_frame);
+    run("current shared MediaFrame", tags, frame_count, tag_bytes, current_frame);
+    return 0;
+}
@@ -0,0 +1,144 @@
+// webrtc播放的rtp发送开销，单线程
+// 帧只打包成rtp包一次，每个订阅者在自己的输出缓冲中写头部(带twcc扩展)、拷贝负载，再批量原地加密，
+// 与WebRtcServerSession发送循环的做法一致，不包括socket发送
+// 用法: rtp_fanout_bench [订阅者数] [帧数] [帧大小]
+#include <stdlib.h>
+#include <string.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "protocol/rtp/rtp_packer.h"
+#include "server/webrtc/srtp/srtp_session.h"
+
+using namespace mms;
+
+namespace {
+constexpr size_t OUT_BUF_SIZE = 64 * 1024;
+constexpr uint8_t TWCC_EXT_ID = 3;
+constexpr int32_t PACK_FRAMES = 10000;
+
+struct Subscriber {
+    std::unique_ptr<uint8_t[]> out_buf{new uint8_t[OUT_BUF_SIZE]};
+    uint16_t twcc_seq = 0;
+    SRTPSession srtp;
+    std::vector<SRTPPacketBuf> srtp_bufs;
+};
+
+// 与发送循环相同：尽量多的包依次排进输出缓冲，写满一批后(可选)批量加密
+int64_t send_frame(Subscriber & sub, const std::vector<std::shared_ptr<RtpPacket>> & pkts, bool encrypt) {
+    int64_t bytes = 0;
+    size_t i = 0;
+    while (i < pkts.size()) {
+        sub.srtp_bufs.clear();
+        size_t offset = 0;
+        for (; i < pkts.size(); i++) {
+            if (offset + SRTP_MAX_TRAILER_LEN >= OUT_BUF_SIZE) {
+                break;
+            }
+
+            uint8_t *out = sub.out_buf.get() + offset;
+            int32_t rtp_size = pkts[i]->encode_with_twcc(out, OUT_BUF_SIZE - offset - SRTP_MAX_TRAILER_LEN, TWCC_EXT_ID, sub.twcc_seq);
+            if (rtp_size <= 0) {
+                break;
+            }
+            sub.twcc_seq++;
+
+            SRTPPacketBuf buf;
+            buf.data = out;
+            buf.len = rtp_size;
+            buf.out_len = rtp_size;
+            sub.srtp_bufs.push_back(buf);
+            offset += rtp_size + SRTP_MAX_TRAILER_LEN;
+        }
+
+        if (encrypt && sub.srtp.protect_srtp_batch(sub.srtp_bufs) < 0) {
+            return -1;
+        }
+
+        for (auto & buf : sub.srtp_bufs) {
+            bytes += buf.out_len;
+        }
+    }
+    return bytes;
+}
+
+bool bench_fanout(std::vector<Subscriber> & subs, const std::vector<std::vector<std::shared_ptr<RtpPacket>>> & frames, bool encrypt) {
+    int64_t pkt_count = 0;
+    int64_t bytes = 0;
+    int64_t start = bench::now_ns();
+    // 和线上一样按帧推进，每帧依次发给所有订阅者
+    for (auto & pkts : frames) {
+        for (auto & sub : subs) {
+            int64_t r = send_frame(sub, pkts, encrypt);
+            if (r < 0) {
+                printf("protect srtp failed\n");
+                return false;
+            }
+            bytes += r;
+            pkt_count += pkts.size();
+        }
+    }
+    int64_t elapsed = bench::now_ns() - start;
+    std::string name = std::to_string(subs.size()) + " subscribers " + (encrypt ? "serialize+srtp" : "serialize");
+    bench::report(name.c_str(), pkt_count, elapsed, "pkts", bytes);
+    return true;
+}
+};
+
+int main(int argc, char *argv[]) {
+    size_t sub_count = argc > 1 ? (size_t)atoi(argv[1]) : 1000;
+    int32_t frame_count = argc > 2 ? atoi(argv[2]) : 30;
+    size_t frame_size = argc > 3 ? (size_t)atoi(argv[3]) : 60000;
+    if (sub_count == 0 || frame_count <= 0 || frame_size < 2) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    // 一个大的IDR nalu，按FU-A切分
+    std::string nalu(frame_size, '\xab');
+    nalu[0] = 0x65;
+    std::list<std::string_view> nalus;
+    nalus.emplace_back(nalu);
+
+    // 打包只测一次的开销，帧数太少时计时不准，单独多打包一些
+    RtpPacker packer;
+    int64_t pkt_count = 0;
+    int64_t start = bench::now_ns();
+    for (int32_t i = 0; i < PACK_FRAMES; i++) {
+        pkt_count += packer.pack(nalus, 96, 0x12345678, i * 3000).size();
+    }
+    int64_t elapsed = bench::now_ns() - start;
+    bench::report("pack", pkt_count, elapsed, "pkts", (int64_t)PACK_FRAMES * frame_size);
+
+    std::vector<std::vector<std::shared_ptr<RtpPacket>>> frames;
+    frames.reserve(frame_count);
+    for (int32_t i = 0; i < frame_count; i++) {
+        frames.emplace_back(packer.pack(nalus, 96, 0x12345678, i * 3000));
+    }
+    printf("%d frames of %zu bytes, %zu rtp packets per frame\n", frame_count, frame_size, frames[0].size());
+
+    if (srtp_init() != srtp_err_status_ok) {
+        printf("srtp_init failed\n");
+        return -1;
+    }
+
+    std::vector<Subscriber> subs(sub_count);
+    std::string key(30, '\x5a');
+    for (auto & sub : subs) {
+        if (!sub.srtp.init(SRTP_AES128_CM_HMAC_SHA1_80, key, key)) {
+            printf("init srtp failed\n");
+            return -1;
+        }
+    }
+
+    if (!bench_fanout(subs, frames, false) || !bench_fanout(subs, frames, true)) {
+        return -1;
+    }
+
+    srtp_shutdown();
+    return 0;
+}
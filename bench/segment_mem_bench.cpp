@@ -0,0 +1,206 @@
+// ts/mp4切片内存的常驻内存(rss)及缺页次数，每种做法在单独的子进程中运行
+// 模拟多路直播流持续生成切片，每路保留最近的若干个切片(与hls/dash的切片窗口相同)，超出窗口的释放
+// legacy为改动前的做法：ts按188*4096字节的块分配，mp4从1MB的连续内存开始按倍数扩容并拷贝，均清零分配
+// pool为现在的做法：TsSegment/Mp4Segment从BlockPool取64KB的块，切片释放后块回到池中复用
+// 用法: segment_mem_bench [流数] [每路生成的切片数] [窗口切片数] [码率kbps]
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "base/block_pool.h"
+#include "protocol/ts/ts_segment.hpp"
+#include "protocol/mp4/m4s_segment.h"
+
+using namespace mms;
+
+namespace {
+struct Params {
+    int32_t stream_count;
+    int32_t seg_count;
+    int32_t window;
+    // 2s一个切片，每帧约为码率/30
+    size_t seg_bytes;
+    size_t frame_bytes;
+};
+
+// 改动前的TsSegment分配方式
+class LegacyTsSegment {
+public:
+    LegacyTsSegment() {
+        ts_chunks_.emplace_back(std::make_unique<uint8_t[]>(SINGLE_TS_BYTES));
+    }
+
+    std::string_view alloc_ts_packet() {
+        if (ts_chunk_off_ >= SINGLE_TS_BYTES) {
+            ts_chunks_.emplace_back(std::make_unique<uint8_t[]>(SINGLE_TS_BYTES));
+            ts_chunk_off_ = 0;
+        }
+        auto pkt = std::string_view((char *)ts_chunks_.back().get() + ts_chunk_off_, 188);
+        ts_chunk_off_ += 188;
+        return pkt;
+    }
+private:
+    std::vector<std::unique_ptr<uint8_t[]>> ts_chunks_;
+    size_t ts_chunk_off_ = 0;
+    constexpr static size_t SINGLE_TS_BYTES = 188 * 4096;
+};
+
+// 改动前的Mp4Segment分配方式
+class LegacyMp4Segment {
+public:
+    LegacyMp4Segment() {
+        buf_ = std::make_unique<uint8_t[]>(MP4_DEFAULT_SIZE);
+        allocated_bytes_ = MP4_DEFAULT_SIZE;
+    }
+
+    std::string_view alloc_buffer(size_t s) {
+        while ((used_bytes_ + s) >= allocated_bytes_) {
+            auto buf_new = std::make_unique<uint8_t[]>(allocated_bytes_ * 2);
+            allocated_bytes_ = allocated_bytes_ * 2;
+            memcpy(buf_new.get(), buf_.get(), used_bytes_);
+            buf_.swap(buf_new);
+        }
+        auto pkt = std::string_view((char *)buf_.get() + used_bytes_, s);
+        used_bytes_ += s;
+        return pkt;
+    }
+
+    void append(const std::string_view & data) {
+        auto buf = alloc_buffer(data.size());
+        memcpy((char *)buf.data(), data.data(), data.size());
+    }
+private:
+    std::unique_ptr<uint8_t[]> buf_;
+    size_t used_bytes_ = 0;
+    size_t allocated_bytes_ = 0;
+    static constexpr size_t MP4_DEFAULT_SIZE = 1 * 1024 * 1024;
+};
+
+// 与TsPacker一样逐个ts包写入
+template <typename S>
+void fill_ts(S & seg, const Params & p) {
+    for (size_t bytes = 0; bytes < p.seg_bytes; bytes += 188) {
+        auto pkt = seg.alloc_ts_packet();
+        memset((char *)pkt.data(), 0x47, pkt.size());
+    }
+}
+
+// 与RtmpToM4s一样：styp、moof及mdat头用alloc_buffer，帧数据逐帧append
+template <typename S>
+void fill_mp4(S & seg, const Params & p, const std::string & frame) {
+    memset((char *)seg.alloc_buffer(24).data(), 0, 24);
+    size_t frames = p.seg_bytes / p.frame_bytes;
+    size_t moof_bytes = 200 + frames * 16;
+    memset((char *)seg.alloc_buffer(moof_bytes).data(), 0, moof_bytes);
+    memset((char *)seg.alloc_buffer(8).data(), 0, 8);
+    for (size_t i = 0; i < frames; i++) {
+        seg.append(frame);
+    }
+}
+
+int64_t rss_bytes() {
+    long pages = 0;
+    long resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (!fp) {
+        return -1;
+    }
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+        resident = -1;
+    }
+    fclose(fp);
+    return (int64_t)resident * sysconf(_SC_PAGESIZE);
+}
+
+template <typename S, typename F>
+void run(const char *name, const Params & p, F && fill) {
+    std::vector<std::deque<std::shared_ptr<S>>> streams(p.stream_count);
+    // 先填满窗口，之后是稳定状态：每生成一个切片释放一个
+    for (int32_t i = 0; i < p.window; i++) {
+        for (auto & s : streams) {
+            auto seg = std::make_shared<S>();
+            fill(*seg);
+            s.push_back(seg);
+        }
+    }
+
+    struct rusage ru_start;
+    getrusage(RUSAGE_SELF, &ru_start);
+    int64_t rss_start = rss_bytes();
+    int64_t start = bench::now_ns();
+    int64_t segs = 0;
+    for (int32_t i = p.window; i < p.seg_count; i++) {
+        for (auto & s : streams) {
+            auto seg = std::make_shared<S>();
+            fill(*seg);
+            s.push_back(seg);
+            s.pop_front();
+            segs++;
+        }
+    }
+    int64_t elapsed = bench::now_ns() - start;
+    struct rusage ru_end;
+    getrusage(RUSAGE_SELF, &ru_end);
+
+    bench::report(name, segs, elapsed, "seg", segs * (int64_t)p.seg_bytes);
+    printf("%-40s rss %.1f MB -> %.1f MB, max rss %.1f MB, minor faults %ld (%.1f per seg), major faults %ld\n", name,
+           rss_start / 1024.0 / 1024, rss_bytes() / 1024.0 / 1024, ru_end.ru_maxrss / 1024.0,
+           ru_end.ru_minflt - ru_start.ru_minflt, segs > 0 ? (double)(ru_end.ru_minflt - ru_start.ru_minflt) / segs : 0.0,
+           ru_end.ru_majflt - ru_start.ru_majflt);
+    fflush(stdout);
+}
+
+// 在子进程中运行，各做法的rss及缺页互不影响
+template <typename F>
+void run_in_child(F && f) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        f();
+        _exit(0);
+    }
+    if (pid > 0) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+}
+};
+
+int main(int argc, char *argv[]) {
+    Params p;
+    p.stream_count = argc > 1 ? atoi(argv[1]) : 100;
+    p.seg_count = argc > 2 ? atoi(argv[2]) : 60;
+    p.window = argc > 3 ? atoi(argv[3]) : 10;
+    int32_t kbps = argc > 4 ? atoi(argv[4]) : 4000;
+    if (p.stream_count <= 0 || p.window <= 0 || p.seg_count <= p.window || kbps <= 0) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+    p.seg_bytes = (size_t)kbps * 1000 / 8 * 2;
+    p.frame_bytes = (size_t)kbps * 1000 / 8 / 30;
+    std::string frame(p.frame_bytes, '\xab');
+    printf("%d streams, %d segments per stream, window %d, %zu bytes per segment\n", p.stream_count, p.seg_count, p.window,
+           p.seg_bytes);
+
+    run_in_child([&] {
+        run<LegacyTsSegment>("legacy ts segment", p, [&](LegacyTsSegment & seg) { fill_ts(seg, p); });
+    });
+    run_in_child([&] {
+        run<TsSegment>("pool ts segment", p, [&](TsSegment & seg) { fill_ts(seg, p); });
+    });
+    run_in_child([&] {
+        run<LegacyMp4Segment>("legacy mp4 segment", p, [&](LegacyMp4Segment & seg) { fill_mp4(seg, p, frame); });
+    });
+    run_in_child([&] {
+        run<Mp4Segment>("pool mp4 segment", p, [&](Mp4Segment & seg) { fill_mp4(seg, p, frame); });
+    });
+    return 0;
+}
@@ -0,0 +1,83 @@
+// TsPacker的ts封装吞吐，单线程
+// 模拟30fps的h264加aac的直播流，每2s一个关键帧并开始新切片，es与转ts桥一样分成多段(起始码、aud、nalu)
+// 用法: ts_packer_bench [视频帧数] [视频帧大小]
+#include <stdlib.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "protocol/ts/ts_packer.hpp"
+#include "protocol/ts/ts_pes.hpp"
+#include "protocol/ts/ts_segment.hpp"
+
+using namespace mms;
+
+int main(int argc, char *argv[]) {
+    int32_t frame_count = argc > 1 ? atoi(argv[1]) : 30000;
+    size_t frame_size = argc > 2 ? (size_t)atoi(argv[2]) : 20000;
+    if (frame_count <= 0 || frame_size < 2) {
+        printf("invalid arguments\n");
+        return -1;
+    }
+
+    static const char start_code[] = {0x00, 0x00, 0x00, 0x01};
+    static const char aud[] = {0x09, (char)0xf0};
+    std::string idr(frame_size, '\xab');
+    idr[0] = 0x65;
+    std::string non_idr(frame_size / 4, '\xab');
+    non_idr[0] = 0x41;
+    // 7字节adts头加约128kbps的一帧
+    std::string adts(7 + 360, '\xcd');
+
+    TsPacker packer;
+    packer.set_video_stream(TsStreamVideoH264, TS_VIDEO_AVC_PID);
+    packer.set_audio_stream(TsStreamAudioAAC, TS_AUDIO_AAC_PID);
+
+    std::vector<std::string_view> video_segs;
+    std::vector<std::string_view> audio_segs{std::string_view(adts)};
+    std::shared_ptr<TsSegment> seg;
+    int64_t es_bytes = 0;
+    int64_t ts_bytes = 0;
+    int64_t pes_count = 0;
+    int64_t audio_ts = 0;
+    int64_t start = bench::now_ns();
+    for (int32_t i = 0; i < frame_count; i++) {
+        int64_t dts = (int64_t)i * 1000 / 30;
+        bool is_key = i % 60 == 0;
+        if (is_key) {
+            if (seg) {
+                ts_bytes += seg->get_ts_bytes();
+            }
+            seg = std::make_shared<TsSegment>();
+            packer.write_pat_pmt(seg);
+        }
+
+        const std::string & nalu = is_key ? idr : non_idr;
+        video_segs.clear();
+        video_segs.emplace_back(start_code, sizeof(start_code));
+        video_segs.emplace_back(aud, sizeof(aud));
+        video_segs.emplace_back(start_code, sizeof(start_code));
+        video_segs.emplace_back(nalu);
+        packer.pack_video(seg, video_segs, dts, dts + 66, is_key);
+        es_bytes += nalu.size() + 10;
+        pes_count++;
+
+        // 1024个样本/44.1k约23ms一帧音频
+        while (audio_ts <= dts) {
+            packer.pack_audio(seg, audio_segs, audio_ts);
+            es_bytes += adts.size();
+            pes_count++;
+            audio_ts += 23;
+        }
+    }
+    ts_bytes += seg->get_ts_bytes();
+    int64_t elapsed = bench::now_ns() - start;
+
+    printf("%d video frames, key frame %zu bytes, es %lld bytes, ts %lld bytes\n", frame_count, frame_size,
+           (long long)es_bytes, (long long)ts_bytes);
+    bench::report("pes es throughput", pes_count, elapsed, "pes", es_bytes);
+    bench::report("ts output throughput", ts_bytes / 188, elapsed, "pkts", ts_bytes);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "block_pool.h"
+using namespace mms;
+
+BlockPool & BlockPool::get_instance() {
+    // 不析构，避免进程退出时静态对象析构顺序导致切片在池销毁后才归还内存块
+    static BlockPool *instance = new BlockPool;
+    return *instance;
+}
+
+std::shared_ptr<uint8_t[]> BlockPool::alloc() {
+    uint8_t *block = nullptr;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (!free_blocks_.empty()) {
+            block = free_blocks_.back();
+            free_blocks_.pop_back();
+        }
+    }
+
+    if (!block) {
+        block = new uint8_t[BLOCK_SIZE];
+    }
+    used_blocks_.fetch_add(1, std::memory_order_relaxed);
+    return std::shared_ptr<uint8_t[]>(block, [this](uint8_t *b) {
+        recycle(b);
+    });
+}
+
+size_t BlockPool::get_free_blocks() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return free_blocks_.size();
+}
+
+void BlockPool::recycle(uint8_t *block) {
+    used_blocks_.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (free_blocks_.size() < MAX_FREE_BLOCKS) {
+            free_blocks_.push_back(block);
+            return;
+        }
+    }
+    delete[] block;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+
+namespace mms {
+// 固定大小内存块池，ts/mp4切片的数据按块分配
+// 块通过shared_ptr引用计数管理，最后一个引用释放后回到池中复用，避免每个切片反复申请释放大块内存
+class BlockPool {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    // 池中最多缓存的空闲块数，超过的直接释放
+    static constexpr size_t MAX_FREE_BLOCKS = 2048;
+
+    static BlockPool & get_instance();
+
+    std::shared_ptr<uint8_t[]> alloc();
+
+    size_t get_free_blocks();
+    size_t get_used_blocks() {
+        return used_blocks_.load(std::memory_order_relaxed);
+    }
+private:
+    BlockPool() = default;
+    void recycle(uint8_t *block);
+private:
+    std::mutex mtx_;
+    std::vector<uint8_t*> free_blocks_;
+    std::atomic<size_t> used_blocks_{0};
+};
+};
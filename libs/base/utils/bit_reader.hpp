@@ -0,0 +1,124 @@
+#pragma once
+#include <string.h>
+#include <string_view>
+#include <stdint.h>
+
+namespace mms {
+// 带64位缓存的读位器，按字节批量装入缓存，读取时只做移位，Exp-Golomb通过前导零计数一次解出。
+// skip_emulation_prevention为true时，装入缓存时跳过防竞争字节(00 00 03中的03)，
+// 可以直接读nalu，不需要先拷贝出一份rbsp
+class BitReader {
+public:
+    BitReader(std::string_view data, bool skip_emulation_prevention = false) : 
+        p_((const uint8_t *)data.data()), end_((const uint8_t *)data.data() + data.size()), skip_epb_(skip_emulation_prevention) {
+    }
+
+    // 一次最多读32位
+    bool read_bits(int32_t n, uint32_t & v) {
+        if (n == 0) {
+            v = 0;
+            return true;
+        }
+
+        if (cache_bits_ < n) {
+            refill();
+            if (cache_bits_ < n) {
+                return false;
+            }
+        }
+        v = (uint32_t)(cache_ >> (64 - n));
+        cache_ <<= n;
+        cache_bits_ -= n;
+        return true;
+    }
+
+    bool read_bit(uint8_t & b) {
+        uint32_t v;
+        if (!read_bits(1, v)) {
+            return false;
+        }
+        b = (uint8_t)v;
+        return true;
+    }
+
+    bool skip_bits(int32_t n) {
+        uint32_t v;
+        while (n > 32) {
+            if (!read_bits(32, v)) {
+                return false;
+            }
+            n -= 32;
+        }
+        return read_bits(n, v);
+    }
+
+    bool read_ue(uint32_t & v) {
+        if (cache_bits_ < 32) {
+            refill();
+        }
+
+        int32_t leading_zeros = cache_ ? __builtin_clzll(cache_) : 64;
+        if (leading_zeros >= cache_bits_ || leading_zeros > 31) {
+            return false;
+        }
+
+        int32_t len = 2 * leading_zeros + 1;
+        if (len <= cache_bits_) {
+            v = (uint32_t)((cache_ >> (64 - len)) - 1);
+            cache_ <<= len;
+            cache_bits_ -= len;
+            return true;
+        }
+        // 缓存里放不下整个码字时分两次读
+        uint32_t info;
+        if (!skip_bits(leading_zeros) || !read_bits(leading_zeros + 1, info)) {
+            return false;
+        }
+        v = info - 1;
+        return true;
+    }
+
+    bool read_se(int32_t & v) {
+        uint32_t ue;
+        if (!read_ue(ue)) {
+            return false;
+        }
+        v = (ue & 0x01) ? (int32_t)((ue + 1) >> 1) : -(int32_t)(ue >> 1);
+        return true;
+    }
+private:
+    void refill() {
+        if (!skip_epb_ && end_ - p_ >= 8) {// 快速路径，一次装入多个字节
+            uint64_t word;
+            memcpy(&word, p_, 8);
+            word = __builtin_bswap64(word);
+            int32_t bytes = (64 - cache_bits_) / 8;
+            if (bytes == 0) {
+                return;
+            }
+            cache_ |= (bytes == 8 ? word : (word >> (64 - bytes * 8))) << (64 - cache_bits_ - bytes * 8);
+            cache_bits_ += bytes * 8;
+            p_ += bytes;
+            return;
+        }
+
+        while (cache_bits_ <= 56 && p_ < end_) {
+            uint8_t byte = *p_++;
+            if (skip_epb_ && zero_count_ >= 2 && byte == 0x03) {
+                zero_count_ = 0;
+                continue;
+            }
+            zero_count_ = (byte == 0x00) ? zero_count_ + 1 : 0;
+            cache_ |= (uint64_t)byte << (56 - cache_bits_);
+            cache_bits_ += 8;
+        }
+    }
+private:
+    const uint8_t *p_;
+    const uint8_t *end_;
+    bool skip_epb_ = false;
+    int32_t zero_count_ = 0;
+    uint64_t cache_ = 0;// 左对齐，最高位是下一个要读的位
+    int32_t cache_bits_ = 0;
+};
+};
@@ -6,75 +6,54 @@ BitStream::BitStream(const std::string_view & stream) : stream_(stream) {
 
 }
 
-bool BitStream::read_one_bit(uint8_t & b) {
-    uint8_t v;
-    try {
-        v = (uint8_t)stream_.at(bit_pos_/8);
-    } catch (std::exception & e) {
+// 按字节成块读取，每次取当前字节内剩余的位，不再逐位读取
+bool BitStream::read_bits(size_t count, uint64_t & v) {
+    if (count > 64 || bit_pos_ + count > stream_.size() * 8) {
         return false;
     }
-    
-    if (v & (0x80 >> (bit_pos_ % 8))) {
-        b = 1;
-    } else {
-        b = 0;
+
+    const uint8_t *buf = (const uint8_t *)stream_.data();
+    v = 0;
+    while (count > 0) {
+        size_t avail = 8 - bit_pos_ % 8;
+        size_t take = avail < count ? avail : count;
+        uint8_t bits = (buf[bit_pos_ / 8] >> (avail - take)) & ((1 << take) - 1);
+        v = (v << take) | bits;
+        bit_pos_ += take;
+        count -= take;
+    }
+    return true;
+}
+
+bool BitStream::read_one_bit(uint8_t & b) {
+    if (bit_pos_ >= stream_.size() * 8) {
+        return false;
     }
+    b = ((uint8_t)stream_[bit_pos_ / 8] >> (7 - bit_pos_ % 8)) & 0x01;
     bit_pos_++;
     return true;
 }
 
 bool BitStream::read_u(size_t count, uint8_t & v) {
-    const char * buf = stream_.data();
-    v = 0;
-    for (size_t i = 0; i < count; i++)
-    {
-        v <<= 1;
-        if (buf[bit_pos_ / 8] & (0x80 >> (bit_pos_ % 8)))
-        {
-            v += 1;
-        }
-        bit_pos_++;
+    uint64_t t;
+    if (count > 8 || !read_bits(count, t)) {
+        return false;
     }
+    v = (uint8_t)t;
     return true;
 }
 
 bool BitStream::read_u(size_t count, uint16_t & v) {
-    // v = 0;
-    // for (size_t i = 0; i < count; i++) {
-    //     uint8_t bit;
-    //     if (!read_one_bit(bit)) {
-    //         return false;
-    //     }
-    //     v = (v << 1) | bit;
-    // }
-
-    const char * buf = stream_.data();
-    v = 0;
-    for (size_t i = 0; i < count; i++)
-    {
-        v <<= 1;
-        if (buf[bit_pos_ / 8] & (0x80 >> (bit_pos_ % 8)))
-        {
-            v += 1;
-        }
-        bit_pos_++;
+    uint64_t t;
+    if (count > 16 || !read_bits(count, t)) {
+        return false;
     }
+    v = (uint16_t)t;
     return true;
 }
 
 bool BitStream::read_u(size_t count, uint64_t & v) {
-    const char * buf = stream_.data();
-    v = 0;
-    for (size_t i=0; i < count; i++)
-    {
-        v <<= 1;
-        if (buf[bit_pos_ / 8] & (0x80 >> (bit_pos_ % 8)))
-        {
-            v += 1;
-        }
-        bit_pos_++;
-    }
-    return true;
+    return read_bits(count, v);
 }
 
 bool BitStream::write_one_bit(uint8_t v) {
@@ -116,18 +95,42 @@ bool BitStream::write_bits(size_t count, uint64_t v) {
     codeNum = 2^leadingZeroBits − 1 + read_u( leadingZeroBits ) (9-2)
 */
 bool BitStream::read_exp_golomb_ue(uint64_t & v) {
-    int leadingZeroBits = -1;
-    uint8_t b = 0;
-    for (b = 0; !b && leadingZeroBits < 64; leadingZeroBits++) {
-        if (!read_u(1, b)) {
+    // 按字节统计前导零，不再逐位读取
+    const uint8_t *buf = (const uint8_t *)stream_.data();
+    size_t total_bits = stream_.size() * 8;
+    size_t leading_zero_bits = 0;
+    size_t pos = bit_pos_;
+    while (true) {
+        if (pos >= total_bits || leading_zero_bits > 63) {
             return false;
         }
+
+        uint8_t b = (uint8_t)(buf[pos / 8] << (pos % 8));
+        if (b == 0) {
+            size_t n = 8 - pos % 8;
+            leading_zero_bits += n;
+            pos += n;
+            continue;
+        }
+
+        size_t n = __builtin_clz((uint32_t)b) - 24;
+        leading_zero_bits += n;
+        pos += n + 1;// 跳过值为1的位
+        break;
+    }
+
+    if (leading_zero_bits > 63) {
+        return false;
     }
+
+    size_t saved_pos = bit_pos_;
+    bit_pos_ = pos;
     uint64_t l;
-    if (!read_u(leadingZeroBits, l)) {
+    if (!read_bits(leading_zero_bits, l)) {
+        bit_pos_ = saved_pos;
         return false;
     }
-    v = (1 << leadingZeroBits) - 1 + l;
+    v = (((uint64_t)1) << leading_zero_bits) - 1 + l;
     return true;
 }
 
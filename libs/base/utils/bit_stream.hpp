@@ -16,6 +16,8 @@ public:
     bool write_bits(size_t count, uint64_t v);
     bool read_exp_golomb_ue(uint64_t & v);
     bool read_exp_golomb_se(int64_t & v);
+private:
+    bool read_bits(size_t count, uint64_t & v);
 public:
     std::string_view stream_;
     size_t bit_pos_ = 0;
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+#include <stdint.h>
+
+namespace mms {
+// 拼接m3u8/mpd等文本，整数直接用std::to_chars格式化，不经过iostream和locale
+class TextBuilder {
+public:
+    // 毫秒按秒输出，固定3位小数，如2000 -> 2.000，整数运算，不受浮点精度影响
+    struct Sec {
+        int64_t ms;
+    };
+
+    static Sec sec(int64_t ms) {
+        return Sec{ms};
+    }
+
+    void reserve(size_t n) {
+        buf_.reserve(n);
+    }
+
+    size_t size() const {
+        return buf_.size();
+    }
+
+    TextBuilder & operator<<(std::string_view v) {
+        buf_.append(v);
+        return *this;
+    }
+
+    TextBuilder & operator<<(const char *v) {
+        buf_.append(v);
+        return *this;
+    }
+
+    TextBuilder & operator<<(const std::string & v) {
+        buf_.append(v);
+        return *this;
+    }
+
+    TextBuilder & operator<<(char v) {
+        buf_.push_back(v);
+        return *this;
+    }
+
+    template<typename T>
+    requires std::is_integral_v<T>
+    TextBuilder & operator<<(T v) {
+        char tmp[24];
+        auto ret = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        buf_.append(tmp, ret.ptr - tmp);
+        return *this;
+    }
+
+    TextBuilder & operator<<(Sec v) {
+        int64_t ms = v.ms;
+        if (ms < 0) {
+            buf_.push_back('-');
+            ms = -ms;
+        }
+        *this << ms / 1000;
+        char frac[4] = {'.', (char)('0' + ms % 1000 / 100), (char)('0' + ms % 100 / 10), (char)('0' + ms % 10)};
+        buf_.append(frac, sizeof(frac));
+        return *this;
+    }
+
+    std::string & str() {
+        return buf_;
+    }
+private:
+    std::string buf_;
+};
+};
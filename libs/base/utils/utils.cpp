@@ -700,6 +700,12 @@ int64_t Utils::get_current_ms() {
     return tv.tv_sec*1000 + tv.tv_usec/1000;
 }
 
+int64_t Utils::get_current_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec*1000000 + tv.tv_usec;
+}
+
 std::string Utils::get_utc_time() {
     auto now = std::chrono::system_clock::now();
     std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
@@ -730,6 +736,16 @@ std::string Utils::get_utc_time_with_millis() {
     return std::string(final_buffer);
 }
 
+// http头中使用的时间格式，如: Sun, 06 Nov 1994 08:49:37 GMT
+std::string Utils::get_http_date(int64_t ms) {
+    std::time_t t = ms / 1000;
+    std::tm tm_struct;
+    gmtime_r(&t, &tm_struct);
+    char buffer[64];
+    strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm_struct);
+    return std::string(buffer);
+}
+
 const unsigned long EPOCH = 2208988800UL; // delta between epoch time and ntp time
 const double NTP_SCALE_FRAC = 4294967295.0; // maximum value of the ntp fractional part
 int64_t Utils::get_ntp_time() {
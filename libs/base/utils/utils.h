@@ -35,9 +35,11 @@ public:
     static bool bin_to_hex_str(const std::string & input, std::string & output, bool upper = false);
     static bool hex_str_to_bin(const std::string & input, std::string & output);
     static int64_t get_current_ms();
+    static int64_t get_current_us();
     static int64_t get_ntp_time();
     static std::string get_utc_time();
     static std::string get_utc_time_with_millis();
+    static std::string get_http_date(int64_t ms);
     static std::string get_bin_path();
     static bool aes_encrypt(const std::string &plaintext, const std::string &key, std::string &ciphertext);
     static bool aes_decrypt(const std::string &ciphertext, const std::string &key, std::string &plaintext);
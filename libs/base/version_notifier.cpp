@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "base/thread/thread_worker.hpp"
+#include "version_notifier.h"
+using namespace mms;
+
+void VersionNotifier::notify() {
+    std::list<std::shared_ptr<boost::asio::steady_timer>> waiters;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        version_++;
+        waiters.swap(waiters_);
+    }
+
+    // timer不是线程安全的，需要投递到等待者自己的线程上cancel
+    for (auto & timer : waiters) {
+        boost::asio::post(timer->get_executor(), [timer]() {
+            timer->cancel();
+        });
+    }
+}
+
+boost::asio::awaitable<uint64_t> VersionNotifier::wait(ThreadWorker *worker, uint64_t last_version, uint32_t timeout_ms) {
+    auto timer = std::make_shared<boost::asio::steady_timer>(worker->get_io_context());
+    timer->expires_after(std::chrono::milliseconds(timeout_ms));
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (version_ != last_version) {
+            co_return version_;
+        }
+        waiters_.push_back(timer);
+    }
+
+    boost::system::error_code ec;
+    co_await timer->async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    {
+        // 超时返回的需要自己从等待列表中移除
+        std::lock_guard<std::mutex> lck(mtx_);
+        auto it = std::find(waiters_.begin(), waiters_.end(), timer);
+        if (it != waiters_.end()) {
+            waiters_.erase(it);
+        }
+    }
+    co_return version_;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <list>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+namespace mms {
+class ThreadWorker;
+// 版本变更通知，数据更新时调用notify，一次性唤醒所有等待者(等待者可以在不同的worker上)
+class VersionNotifier {
+public:
+    VersionNotifier() = default;
+    virtual ~VersionNotifier() = default;
+public:
+    uint64_t version() const {
+        return version_;
+    }
+    void notify();
+    // 等待版本号不等于last_version，或超时，返回当前版本号
+    boost::asio::awaitable<uint64_t> wait(ThreadWorker *worker, uint64_t last_version, uint32_t timeout_ms);
+private:
+    std::mutex mtx_;
+    std::atomic<uint64_t> version_{0};
+    std::list<std::shared_ptr<boost::asio::steady_timer>> waiters_;
+};
+};
@@ -117,6 +117,14 @@ Json::Value AACCodec::to_json() {
     return data;
 }
 
+std::string AACCodec::get_codecs_str() {
+    // mp4a.40.后面是audio object type
+    if (!audio_specific_config_) {
+        return "";
+    }
+    return "mp4a.40." + std::to_string((int)audio_specific_config_->audio_object_type);
+}
+
 void AACCodec::set_audio_specific_config(std::shared_ptr<AudioSpecificConfig> audio_specific_config) {
     audio_specific_config_ = audio_specific_config;
     ready_ = true;
@@ -23,6 +23,7 @@ public:
 
     static std::shared_ptr<AACCodec> create_from_sdp(const MediaSdp & media_sdp, const Payload & payload);
     Json::Value to_json();
+    std::string get_codecs_str() override;
 public:
     void set_audio_specific_config(std::shared_ptr<AudioSpecificConfig> audio_specific_config);
     std::shared_ptr<AudioSpecificConfig> get_audio_specific_config();
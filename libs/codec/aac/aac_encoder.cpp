@@ -77,4 +77,12 @@ int32_t AACEncoder::encode(uint8_t *data_in, int32_t in_bytes, uint8_t *data_out
     }
 
     return 0;
+}
+
+int32_t AACEncoder::encode_frame(const int16_t *pcm, uint8_t *data_out, int32_t out_bytes) {
+    if (!handle_) {
+        return -1;
+    }
+
+    return faacEncEncode(handle_, (int32_t*)pcm, input_samples_need_, data_out, out_bytes);
 }
\ No newline at end of file
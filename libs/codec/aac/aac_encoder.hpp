@@ -9,6 +9,11 @@ public:
     virtual ~AACEncoder();
     bool init(int sample_rate, int channels);
     int32_t encode(uint8_t *data_in, int32_t in_len, uint8_t *data_out, int32_t out_len);
+    // 编码正好一帧(get_input_samples个样本，所有通道合计)，调用者自己缓存pcm，不经过内部缓冲
+    int32_t encode_frame(const int16_t *pcm, uint8_t *data_out, int32_t out_len);
+    size_t get_input_samples() {
+        return input_samples_need_;
+    }
 
     std::string get_specific_configuration();
 private:
@@ -0,0 +1,173 @@
+#include <string.h>
+#include <atomic>
+
+#include "annexb.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MMS_ANNEXB_X86 1
+#endif
+
+using namespace mms;
+
+namespace {
+using FindZeroPairFunc = const uint8_t *(*)(const uint8_t *, const uint8_t *);
+
+const uint8_t *find_zero_pair_scalar(const uint8_t *p, const uint8_t *end) {
+    while (p + 1 < end) {
+        if (p[1] != 0x00) {// p[1]不为0时，p及p+1开始的位置都不可能是00 00
+            p += 2;
+            continue;
+        }
+
+        if (p[0] == 0x00) {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+#ifdef MMS_ANNEXB_X86
+const uint8_t *find_zero_pair_sse2(const uint8_t *p, const uint8_t *end) {
+    const __m128i zero = _mm_setzero_si128();
+    // 多读一个字节判断跨块的00 00
+    while (p + 17 <= end) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        uint32_t zeros = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+        zeros |= (uint32_t)(p[16] == 0x00) << 16;
+        uint32_t pairs = zeros & (zeros >> 1);
+        if (pairs) {
+            return p + __builtin_ctz(pairs);
+        }
+        p += 16;
+    }
+    return find_zero_pair_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const uint8_t *find_zero_pair_avx2(const uint8_t *p, const uint8_t *end) {
+    const __m256i zero = _mm256_setzero_si256();
+    while (p + 33 <= end) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        uint64_t zeros = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+        zeros |= (uint64_t)(p[32] == 0x00) << 32;
+        uint64_t pairs = zeros & (zeros >> 1);
+        if (pairs) {
+            return p + __builtin_ctzll(pairs);
+        }
+        p += 32;
+    }
+    return find_zero_pair_sse2(p, end);
+}
+#endif
+
+struct ScanImpl {
+    FindZeroPairFunc func;
+    const char *name;
+};
+
+// 按优先级从低到高
+const ScanImpl SCAN_IMPLS[] = {
+    {find_zero_pair_scalar, "scalar"},
+#ifdef MMS_ANNEXB_X86
+    {find_zero_pair_sse2, "sse2"},
+    {find_zero_pair_avx2, "avx2"},
+#endif
+};
+
+bool is_supported(const ScanImpl & impl) {
+#ifdef MMS_ANNEXB_X86
+    __builtin_cpu_init();
+    if (impl.func == find_zero_pair_avx2) {
+        return __builtin_cpu_supports("avx2");
+    }
+
+    if (impl.func == find_zero_pair_sse2) {
+        return __builtin_cpu_supports("sse2");
+    }
+#endif
+    return true;
+}
+
+const ScanImpl *select_scan_impl() {
+    for (size_t i = sizeof(SCAN_IMPLS) / sizeof(SCAN_IMPLS[0]); i > 0; i--) {
+        if (is_supported(SCAN_IMPLS[i - 1])) {
+            return &SCAN_IMPLS[i - 1];
+        }
+    }
+    return &SCAN_IMPLS[0];
+}
+
+std::atomic<const ScanImpl *> & scan_impl() {
+    static std::atomic<const ScanImpl *> impl{select_scan_impl()};
+    return impl;
+}
+
+FindZeroPairFunc get_scan_impl() {
+    return scan_impl().load(std::memory_order_relaxed)->func;
+}
+};
+
+const uint8_t *mms::find_zero_pair(const uint8_t *p, const uint8_t *end) {
+    return get_scan_impl()(p, end);
+}
+
+const char *mms::annexb_scan_impl() {
+    return scan_impl().load(std::memory_order_relaxed)->name;
+}
+
+bool mms::set_annexb_scan_impl(const char *name) {
+    for (auto & impl : SCAN_IMPLS) {
+        if (strcmp(impl.name, name) == 0 && is_supported(impl)) {
+            scan_impl().store(&impl, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+const uint8_t *mms::find_start_code(const uint8_t *p, const uint8_t *end, int32_t & sc_len) {
+    auto find_func = get_scan_impl();
+    while (p < end) {
+        const uint8_t *q = find_func(p, end);
+        if (q + 2 >= end) {
+            return end;
+        }
+
+        if (q[2] == 0x01) {
+            sc_len = 3;
+            return q;
+        }
+
+        if (q[2] == 0x00 && q + 3 < end && q[3] == 0x01) {
+            sc_len = 4;
+            return q;
+        }
+        p = q + 1;
+    }
+    return end;
+}
+
+void mms::remove_emulation_prevention(std::string_view input, std::string & output) {
+    output.clear();
+    output.reserve(input.size());
+    auto find_func = get_scan_impl();
+    const uint8_t *p = (const uint8_t *)input.data();
+    const uint8_t *end = p + input.size();
+    while (p < end) {
+        const uint8_t *q = find_func(p, end);
+        if (q + 2 >= end) {
+            output.append((const char *)p, end - p);
+            break;
+        }
+
+        if (q[2] == 0x03) {// 00 00 03，保留00 00，跳过03
+            output.append((const char *)p, q + 2 - p);
+            p = q + 3;
+        } else {
+            output.append((const char *)p, q + 1 - p);
+            p = q + 1;
+        }
+    }
+}
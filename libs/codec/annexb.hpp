@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mms {
+// Annex-B起始码及防竞争字节的扫描，x86上运行时按cpu支持情况选择avx2/sse2实现，其他平台逐字节扫描
+
+// 查找下一个00 00的位置，找不到时返回end
+const uint8_t *find_zero_pair(const uint8_t *p, const uint8_t *end);
+// 查找下一个起始码(00 00 01或00 00 00 01)，找到时sc_len为起始码长度，找不到时返回end
+const uint8_t *find_start_code(const uint8_t *p, const uint8_t *end, int32_t & sc_len);
+// 当前使用的实现：avx2/sse2/scalar
+const char *annexb_scan_impl();
+// 强制使用指定的实现(scalar/sse2/avx2)，用于测试及性能对比，名称无效或cpu不支持时返回false
+bool set_annexb_scan_impl(const char *name);
+// 去掉防竞争字节(00 00 03中的03)
+void remove_emulation_prevention(std::string_view input, std::string & output);
+
+// 按起始码切分Annex-B数据，nalu指向原始数据，不拷贝
+template <typename C>
+void split_annexb(std::string_view data, C & nalus) {
+    const uint8_t *p = (const uint8_t *)data.data();
+    const uint8_t *end = p + data.size();
+    int32_t sc_len = 0;
+    p = find_start_code(p, end, sc_len);
+    while (p < end) {
+        const uint8_t *nalu_start = p + sc_len;
+        const uint8_t *next = find_start_code(nalu_start, end, sc_len);
+        const uint8_t *nalu_end = next;
+        while (nalu_end > nalu_start && *(nalu_end - 1) == 0x00) {// 去掉trailing_zero_8bits
+            nalu_end--;
+        }
+
+        if (nalu_end > nalu_start) {
+            nalus.emplace_back(std::string_view((const char *)nalu_start, nalu_end - nalu_start));
+        }
+        p = next;
+    }
+}
+
+// nalu列表转为4字节长度前缀(avcc/hvcc)格式的分段列表，长度写在len_buf中，不拷贝nalu数据
+// segs引用len_buf，使用segs期间len_buf不能再修改
+template <typename C>
+void append_length_prefixed_segs(const C & nalus, std::string & len_buf, std::vector<std::string_view> & segs) {
+    len_buf.resize(nalus.size() * 4);
+    char *len_data = len_buf.data();
+    for (auto & nalu : nalus) {
+        uint32_t len = nalu.size();
+        len_data[0] = (char)(len >> 24);
+        len_data[1] = (char)(len >> 16);
+        len_data[2] = (char)(len >> 8);
+        len_data[3] = (char)len;
+        segs.emplace_back(std::string_view(len_data, 4));
+        segs.emplace_back(nalu);
+        len_data += 4;
+    }
+}
+
+// nalu列表转为Annex-B格式的分段列表，只插入起始码，不拷贝nalu数据
+template <typename C>
+void append_annexb_segs(const C & nalus, std::vector<std::string_view> & segs) {
+    static const char annexb_start_code1[] = {0x00, 0x00, 0x00, 0x01};
+    static const char annexb_start_code2[] = {0x00, 0x00, 0x01};
+    bool first_nalu = true;
+    for (auto & nalu : nalus) {
+        if (first_nalu) { // 第一个nalu头部4个字节，后面的头部只需要3字节
+            first_nalu = false;
+            segs.emplace_back(std::string_view(annexb_start_code1, 4));
+        } else {
+            segs.emplace_back(std::string_view(annexb_start_code2, 3));
+        }
+        segs.emplace_back(nalu);
+    }
+}
+};
@@ -57,6 +57,11 @@ public:
         Json::Value v;
         return v;
     }
+
+    // rfc6381格式的编码描述，用于hls的CODECS及dash的codecs属性，未知时返回空
+    virtual std::string get_codecs_str() {
+        return "";
+    }
 protected:
     CodecType   codec_type_;
     std::string codec_name_;
@@ -9,6 +9,7 @@
 #include "protocol/sdp/media-level/payload.h"
 
 #include "h264_avcc.hpp"
+#include "codec/annexb.hpp"
 using namespace mms;
 //a=fmtp:98 profile-level-id=42A01E; packetization-mode=0;
 //  sprop-parameter-sets=&lt;parameter sets data#0&gt;
@@ -133,19 +134,7 @@ void H264Codec::set_pps(const std::string & pps) {
 }
 
 void H264Codec::deemulation_prevention(const std::string_view & input, std::string & output) {
-    output.clear();
-    size_t size = input.size();
-    for (size_t i = 0; i < size;) {
-        // 如果出现 0x00 0x00 0x03 模式
-        if (i + 2 < size && input[i] == 0x00 && input[i + 1] == 0x00 && input[i + 2] == 0x03) {
-            output.push_back(0x00);
-            output.push_back(0x00);
-            i += 3; // 跳过 0x03
-        } else {
-            output.push_back(input[i]);
-            i++;
-        }
-    }
+    remove_emulation_prevention(input, output);
 }
 
 bool H264Codec::get_wh(uint32_t & w, uint32_t & h) {
@@ -237,6 +226,16 @@ bool H264Codec::get_fps(double & fps) {
     return false;
 }
 
+std::string H264Codec::get_codecs_str() {
+    // avc1.后面是sps中的profile_idc、constraint_set标志及level_idc
+    if (sps_nalu_.size() < 4) {
+        return "";
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), "avc1.%02x%02x%02x", (uint8_t)sps_nalu_[1], (uint8_t)sps_nalu_[2], (uint8_t)sps_nalu_[3]);
+    return buf;
+}
+
 Json::Value H264Codec::to_json() {
     Json::Value data;
     data["codec_name"] = codec_name_;
@@ -98,6 +98,7 @@ public:
     std::shared_ptr<Payload> get_payload();
 
     Json::Value to_json() override;
+    std::string get_codecs_str() override;
 private:
     bool gen_avc_decoder_configuration_record();
     void deemulation_prevention(const std::string_view & input, std::string & output);//去除竞争字段
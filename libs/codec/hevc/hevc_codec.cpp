@@ -6,6 +6,7 @@
 #include "base/utils/utils.h"
 #include "protocol/sdp/media-level/media_sdp.hpp"
 #include "hevc_hvcc.hpp"
+#include "codec/annexb.hpp"
 
 #include "spdlog/spdlog.h"
 
@@ -191,19 +192,7 @@ void HevcCodec::set_sei_prefix(const std::string & sei_prefix) {
 }
 
 void HevcCodec::deemulation_prevention(const std::string_view & input, std::string & output) {
-    output.clear();
-    size_t size = input.size();
-    for (size_t i = 0; i < size;) {
-        // 如果出现 0x00 0x00 0x03 模式
-        if (i + 2 < size && input[i] == 0x00 && input[i + 1] == 0x00 && input[i + 2] == 0x03) {
-            output.push_back(0x00);
-            output.push_back(0x00);
-            i += 3; // 跳过 0x03
-        } else {
-            output.push_back(input[i]);
-            i++;
-        }
-    }
+    remove_emulation_prevention(input, output);
 }
 
 
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+#include "codec.hpp"
+#include "slice_info.hpp"
+
+namespace mms {
+// 按长度前缀(avcc/hvcc格式)切分nalu，返回消耗的字节数，数据不完整时返回负数
+template <typename C>
+int32_t split_nalus(const uint8_t *data, int32_t len, int32_t nalu_length_size, C & nalus) {
+    const uint8_t *data_start = data;
+    while (len > 0) {
+        if (len < nalu_length_size) {
+            return -1;
+        }
+
+        int32_t nalu_len = 0;
+        for (int32_t i = 0; i < nalu_length_size; i++) {
+            nalu_len = (nalu_len << 8) | data[i];
+        }
+        data += nalu_length_size;
+        len -= nalu_length_size;
+
+        if (nalu_len < 0 || len < nalu_len) {
+            return -2;
+        }
+
+        nalus.emplace_back(std::string_view((const char *)data, nalu_len));
+        data += nalu_len;
+        len -= nalu_len;
+    }
+    return data - data_start;
+}
+
+// 一帧数据解析后的规范表示，由源在收到数据时解析一次，挂在原始消息上供所有桥共用，
+// 桥不再各自重复解析标签头、切分nalu
+struct MediaFrame {
+    CodecType codec = CODEC_H264;
+    bool is_video = false;
+    bool is_key = false;
+    bool is_seq_header = false;
+    int64_t dts = 0;
+    int64_t pts = 0;
+    // 去掉标签头之后的数据，指向原始消息内部，原始消息释放后失效
+    std::string_view payload;
+    // nalu表，同样指向原始消息内部，不包含长度前缀
+    std::vector<std::string_view> nalus;
+    // 从第一个slice头部解析出的帧类型，用于源的帧统计
+    SliceFrameType frame_type = SLICE_FRAME_UNKNOWN;
+    // 不被其他帧参考，播放者落后太多时可以直接丢弃而不影响解码
+    bool disposable = false;
+};
+};
@@ -0,0 +1,108 @@
+#include "slice_info.hpp"
+#include "base/utils/bit_reader.hpp"
+#include "h264/h264_codec.hpp"
+#include "hevc/hevc_define.hpp"
+
+using namespace mms;
+
+bool mms::parse_h264_slice_info(std::string_view nalu, SliceInfo & info) {
+    if (nalu.size() < 2) {
+        return false;
+    }
+
+    uint8_t header = (uint8_t)nalu[0];
+    info.nal_type = header & 0x1f;
+    info.nal_ref_idc = (header >> 5) & 0x03;
+    info.temporal_id = 0;
+    info.frame_type = SLICE_FRAME_UNKNOWN;
+    size_t header_bytes = 1;
+    if (info.nal_type == 14 || info.nal_type == 20) {// svc/mvc扩展头，temporal_id在扩展头的第3个字节
+        if (nalu.size() < 4) {
+            return false;
+        }
+        info.temporal_id = ((uint8_t)nalu[3] >> 5) & 0x07;
+        header_bytes = 4;
+    }
+
+    // 非IDR slice、数据分区A、IDR slice及扩展slice，头部都以first_mb_in_slice、slice_type开始
+    if (info.nal_type != H264NaluTypeNonIDR && info.nal_type != 2 && info.nal_type != H264NaluTypeIDR && info.nal_type != 20) {
+        return false;
+    }
+
+    BitReader reader(nalu.substr(header_bytes), true);
+    uint32_t first_mb_in_slice;
+    uint32_t slice_type;
+    if (!reader.read_ue(first_mb_in_slice) || !reader.read_ue(slice_type)) {
+        return false;
+    }
+
+    switch (slice_type % 5) {
+        case 0:// P
+        case 3:// SP
+            info.frame_type = SLICE_FRAME_P;
+            break;
+        case 1:
+            info.frame_type = SLICE_FRAME_B;
+            break;
+        default:// I、SI
+            info.frame_type = SLICE_FRAME_I;
+            break;
+    }
+    return true;
+}
+
+bool mms::parse_hevc_slice_info(std::string_view nalu, SliceInfo & info, int32_t num_extra_slice_header_bits) {
+    if (nalu.size() < 3) {
+        return false;
+    }
+
+    info.nal_type = ((uint8_t)nalu[0] >> 1) & 0x3f;
+    // nuh_temporal_id_plus1不能为0
+    uint8_t temporal_id_plus1 = (uint8_t)nalu[1] & 0x07;
+    if (temporal_id_plus1 == 0) {
+        return false;
+    }
+    info.temporal_id = temporal_id_plus1 - 1;
+    info.frame_type = SLICE_FRAME_UNKNOWN;
+    if (info.nal_type > NAL_RSV_IRAP_VCL23) {
+        return false;
+    }
+    // 0~14中的偶数类型是子层非参考帧
+    info.nal_ref_idc = (info.nal_type <= 14 && (info.nal_type % 2) == 0) ? 0 : 1;
+
+    BitReader reader(nalu.substr(2), true);
+    uint8_t first_slice_segment_in_pic_flag;
+    if (!reader.read_bit(first_slice_segment_in_pic_flag)) {
+        return false;
+    }
+
+    if (info.nal_type >= NAL_BLA_W_LP && info.nal_type <= NAL_RSV_IRAP_VCL23) {
+        uint8_t no_output_of_prior_pics_flag;
+        if (!reader.read_bit(no_output_of_prior_pics_flag)) {
+            return false;
+        }
+    }
+
+    uint32_t slice_pic_parameter_set_id;
+    if (!reader.read_ue(slice_pic_parameter_set_id)) {
+        return false;
+    }
+    // 非第一个slice segment还需要sps/pps中的信息才能定位到slice_type，这里不再解析
+    if (!first_slice_segment_in_pic_flag) {
+        return true;
+    }
+
+    uint32_t slice_type;
+    if (!reader.skip_bits(num_extra_slice_header_bits) || !reader.read_ue(slice_type)) {
+        return false;
+    }
+
+    if (slice_type == 0) {
+        info.frame_type = SLICE_FRAME_B;
+    } else if (slice_type == 1) {
+        info.frame_type = SLICE_FRAME_P;
+    } else {
+        info.frame_type = SLICE_FRAME_I;
+    }
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <string_view>
+
+namespace mms {
+enum SliceFrameType : uint8_t {
+    SLICE_FRAME_UNKNOWN = 0,
+    SLICE_FRAME_I       = 1,
+    SLICE_FRAME_P       = 2,
+    SLICE_FRAME_B       = 3,
+};
+
+// 从slice头部解析出的帧信息，每帧只读前几个语法元素，供丢帧策略及统计使用
+struct SliceInfo {
+    uint8_t nal_type = 0;
+    // h264为nal_ref_idc，hevc没有这个字段，子层非参考帧为0，其余为1
+    uint8_t nal_ref_idc = 0;
+    uint8_t temporal_id = 0;
+    SliceFrameType frame_type = SLICE_FRAME_UNKNOWN;
+};
+
+// nalu不包含起始码及长度前缀，不是slice时返回false
+bool parse_h264_slice_info(std::string_view nalu, SliceInfo & info);
+// num_extra_slice_header_bits来自pps，只有图像的第一个slice segment才能解析出帧类型
+bool parse_hevc_slice_info(std::string_view nalu, SliceInfo & info, int32_t num_extra_slice_header_bits = 0);
+};
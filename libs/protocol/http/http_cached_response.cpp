@@ -0,0 +1,82 @@
+#include <sstream>
+#include "http_cached_response.hpp"
+#include "base/utils/utils.h"
+
+using namespace mms;
+
+std::shared_ptr<HttpCachedResponse> HttpCachedResponse::create(const std::string & content_type, size_t content_length,
+                                                               const std::string & etag, int64_t last_modified_ms,
+                                                               const std::string & cache_control) {
+    std::shared_ptr<HttpCachedResponse> resp(new HttpCachedResponse);
+    resp->etag_ = "\"" + etag + "\"";
+    resp->build(content_type, content_length, last_modified_ms, cache_control);
+    return resp;
+}
+
+std::shared_ptr<HttpCachedResponse> HttpCachedResponse::create_with_body(const std::string & content_type, std::string body,
+                                                                         const std::string & etag, int64_t last_modified_ms,
+                                                                         const std::string & cache_control) {
+    std::shared_ptr<HttpCachedResponse> resp(new HttpCachedResponse);
+    resp->etag_ = "\"" + etag + "\"";
+    resp->body_ = std::move(body);
+    resp->build(content_type, resp->body_.size(), last_modified_ms, cache_control);
+    return resp;
+}
+
+void HttpCachedResponse::build(const std::string & content_type, size_t content_length, int64_t last_modified_ms, const std::string & cache_control) {
+    std::string last_modified = Utils::get_http_date(last_modified_ms);
+    std::ostringstream ss;
+    ss << "HTTP/1.1 200 OK\r\n"
+       << "Content-Type: " << content_type << "\r\n"
+       << "Content-Length: " << content_length << "\r\n"
+       << "ETag: " << etag_ << "\r\n"
+       << "Last-Modified: " << last_modified << "\r\n"
+       << "Cache-Control: " << cache_control << "\r\n"
+       << "Access-Control-Allow-Origin: *\r\n"
+       << "Connection: close\r\n"
+       << "\r\n";
+    head_ = ss.str();
+
+    ss.str("");
+    ss << "HTTP/1.1 304 Not Modified\r\n"
+       << "ETag: " << etag_ << "\r\n"
+       << "Last-Modified: " << last_modified << "\r\n"
+       << "Cache-Control: " << cache_control << "\r\n"
+       << "Access-Control-Allow-Origin: *\r\n"
+       << "Connection: close\r\n"
+       << "\r\n";
+    not_modified_head_ = ss.str();
+}
+
+bool HttpCachedResponse::match(const std::string & if_none_match) const {
+    if (if_none_match.empty()) {
+        return false;
+    }
+
+    if (if_none_match == "*") {
+        return true;
+    }
+    // 可能是多个etag，逗号分隔，也可能带W/前缀
+    size_t pos = 0;
+    while (pos < if_none_match.size()) {
+        size_t end = if_none_match.find(',', pos);
+        if (end == std::string::npos) {
+            end = if_none_match.size();
+        }
+        std::string_view tag(if_none_match.data() + pos, end - pos);
+        while (!tag.empty() && tag.front() == ' ') {
+            tag.remove_prefix(1);
+        }
+        while (!tag.empty() && tag.back() == ' ') {
+            tag.remove_suffix(1);
+        }
+        if (tag.starts_with("W/")) {
+            tag.remove_prefix(2);
+        }
+        if (tag == etag_) {
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+
+namespace mms {
+// 预先序列化好的http响应头(及可选的body)，生成后不再修改，所有请求共享同一份数据
+// 用于m3u8及已完成的切片，配合ETag/If-None-Match支持304
+class HttpCachedResponse {
+public:
+    // body由外部提供(如切片数据)，只缓存响应头
+    static std::shared_ptr<HttpCachedResponse> create(const std::string & content_type, size_t content_length,
+                                                      const std::string & etag, int64_t last_modified_ms,
+                                                      const std::string & cache_control);
+    // 响应头和body一起缓存
+    static std::shared_ptr<HttpCachedResponse> create_with_body(const std::string & content_type, std::string body,
+                                                                const std::string & etag, int64_t last_modified_ms,
+                                                                const std::string & cache_control);
+    virtual ~HttpCachedResponse() = default;
+
+    const std::string & get_etag() const {
+        return etag_;
+    }
+
+    const std::string & get_head() const {
+        return head_;
+    }
+
+    const std::string & get_not_modified_head() const {
+        return not_modified_head_;
+    }
+
+    const std::string & get_body() const {
+        return body_;
+    }
+
+    // 请求头If-None-Match是否命中当前ETag
+    bool match(const std::string & if_none_match) const;
+private:
+    HttpCachedResponse() = default;
+    void build(const std::string & content_type, size_t content_length, int64_t last_modified_ms, const std::string & cache_control);
+private:
+    std::string etag_;
+    std::string head_;
+    std::string not_modified_head_;
+    std::string body_;
+};
+};
@@ -61,6 +61,22 @@ boost::asio::awaitable<bool> HttpResponse::write_data(std::vector<boost::asio::c
     co_return ret;
 }
 
+boost::asio::awaitable<bool> HttpResponse::write_chunk(std::vector<boost::asio::const_buffer> & bufs) {
+    static const std::string_view last_chunk("0\r\n\r\n");
+    size_t bytes = boost::asio::buffer_size(bufs);
+    if (bytes == 0) {
+        co_return co_await conn_->send((const uint8_t*)last_chunk.data(), last_chunk.size());
+    }
+
+    char chunk_head[32];
+    int32_t head_len = snprintf(chunk_head, sizeof(chunk_head), "%zx\r\n", bytes);
+    std::vector<boost::asio::const_buffer> chunk_bufs;
+    chunk_bufs.reserve(bufs.size() + 2);
+    chunk_bufs.push_back(boost::asio::buffer(chunk_head, head_len));
+    chunk_bufs.insert(chunk_bufs.end(), bufs.begin(), bufs.end());
+    chunk_bufs.push_back(boost::asio::buffer(last_chunk.data() + 1, 2));
+    co_return co_await conn_->send(chunk_bufs);
+}
 
 const std::string & HttpResponse::get_version() const {
     return version_;
@@ -29,6 +29,8 @@ public:
     boost::asio::awaitable<bool> write_data(const uint8_t *data, size_t len);
     boost::asio::awaitable<bool> write_data(const std::string_view & buf);
     boost::asio::awaitable<bool> write_data(std::vector<boost::asio::const_buffer> & bufs);
+    // Transfer-Encoding: chunked，bufs作为一个chunk发送，bufs为空时发送结束chunk
+    boost::asio::awaitable<bool> write_chunk(std::vector<boost::asio::const_buffer> & bufs);
     const std::string & get_version() const;
     int32_t get_status_code() const;
     const std::string & get_msg() const;
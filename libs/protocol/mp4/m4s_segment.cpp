@@ -1,27 +1,97 @@
 #include <string.h>
+#include <algorithm>
 
 #include "m4s_segment.h"
 using namespace mms;
 
 Mp4Segment::Mp4Segment() {
-    buf_ = std::make_unique<uint8_t[]>(MP4_DEFAULT_SIZE);
-    used_bytes_ = 0;
-    allocated_bytes_ = MP4_DEFAULT_SIZE;
 }
 
 std::string_view Mp4Segment::alloc_buffer(size_t s) {
-    if ((used_bytes_ + s) >= allocated_bytes_) {
-        auto buf_new = std::make_unique<uint8_t[]>(allocated_bytes_*2);
-        allocated_bytes_ = allocated_bytes_*2;
-        memcpy(buf_new.get(), buf_.get(), used_bytes_);
-        buf_.swap(buf_new);
+    if (blocks_.empty() || blocks_.back().capacity - blocks_.back().used < s) {
+        Block block;
+        if (s > BlockPool::BLOCK_SIZE) {
+            block.buf = std::shared_ptr<uint8_t[]>(new uint8_t[s]);
+            block.capacity = s;
+        } else {
+            block.buf = BlockPool::get_instance().alloc();
+            block.capacity = BlockPool::BLOCK_SIZE;
+        }
+        blocks_.emplace_back(std::move(block));
     }
 
-    auto pkt = std::string_view((char*)buf_.get() + used_bytes_, s);
+    auto & block = blocks_.back();
+    auto pkt = std::string_view((char*)block.buf.get() + block.used, s);
+    block.used += s;
     used_bytes_ += s;
     return pkt;
 }
 
+void Mp4Segment::append(const std::string_view & data) {
+    const char *p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        if (blocks_.empty() || blocks_.back().used >= blocks_.back().capacity) {
+            Block block;
+            block.buf = BlockPool::get_instance().alloc();
+            block.capacity = BlockPool::BLOCK_SIZE;
+            blocks_.emplace_back(std::move(block));
+        }
+
+        auto & block = blocks_.back();
+        size_t s = std::min(left, block.capacity - block.used);
+        memcpy(block.buf.get() + block.used, p, s);
+        block.used += s;
+        used_bytes_ += s;
+        p += s;
+        left -= s;
+    }
+}
+
+std::vector<std::string_view> Mp4Segment::get_used_bufs(size_t offset) {
+    std::vector<std::string_view> bufs;
+    for (auto & block : blocks_) {
+        if (offset >= block.used) {
+            offset -= block.used;
+            continue;
+        }
+        bufs.emplace_back((char*)block.buf.get() + offset, block.used - offset);
+        offset = 0;
+    }
+    return bufs;
+}
+
+void Mp4Segment::add_chunk(std::shared_ptr<const std::string> chunk) {
+    std::unique_lock<std::shared_mutex> lck(chunks_mtx_);
+    chunks_.emplace_back(std::move(chunk));
+}
+
+bool Mp4Segment::get_chunks(size_t offset, std::vector<std::shared_ptr<const std::string>> & chunks) {
+    std::shared_lock<std::shared_mutex> lck(chunks_mtx_);
+    if (is_reaped()) {
+        return true;
+    }
+
+    size_t chunk_offset = 0;
+    for (auto & chunk : chunks_) {
+        if (chunk_offset >= offset) {
+            chunks.push_back(chunk);
+        }
+        chunk_offset += chunk->size();
+    }
+    return false;
+}
+
+void Mp4Segment::merge_chunks() {
+    std::unique_lock<std::shared_mutex> lck(chunks_mtx_);
+    for (auto & chunk : chunks_) {
+        append(*chunk);
+    }
+    // 正在发送的读者持有chunk的引用，这里释放不影响读者
+    // 合并后由m4s source生成响应头再标记完成，在此之前读者取不到新的chunk，会等待完成通知
+    chunks_.clear();
+}
+
 void Mp4Segment::update_timestamp(int64_t start, int64_t end) {
     static const int64_t max_ms = 0x20c49ba5e353f7LL;
     if (start < 0 || start >= max_ms) {
@@ -2,13 +2,17 @@
 #include <string>
 #include <string_view>
 #include <memory>
+#include <vector>
+#include <atomic>
+#include <shared_mutex>
 
 #include "base/utils/utils.h"
+#include "base/block_pool.h"
 
 namespace mms {
+class HttpCachedResponse;
 class Mp4Segment {
 public:
-    static constexpr size_t MP4_DEFAULT_SIZE = 1 * 1024 * 1024;
     Mp4Segment();
     virtual ~Mp4Segment() {
 
@@ -22,18 +26,36 @@ public:
         filename_ = filename;
     }
 
+    // 初始化切片中的编码描述(rfc6381)，由生成初始化切片的桥设置
+    const std::string & get_codecs() {
+        return codecs_;
+    }
+
+    void set_codecs(const std::string & codecs) {
+        codecs_ = codecs;
+    }
+
     void set_reaped() {
-        is_reaped_ = true;
+        is_reaped_.store(true, std::memory_order_release);
     }
 
     inline bool is_reaped() {
-        return is_reaped_;
+        return is_reaped_.load(std::memory_order_acquire);
     }
 
+    // ll-dash: 生成中的切片按chunk(moof+mdat)追加，chunk单独分配，读者持有chunk的引用就可以边生成边发送
+    void add_chunk(std::shared_ptr<const std::string> chunk);
+    // 获取从offset字节开始已追加的chunk，切片已完成时返回true，此时通过get_used_bufs读取
+    bool get_chunks(size_t offset, std::vector<std::shared_ptr<const std::string>> & chunks);
+    // 切片完成，把chunk合并到连续内存中
+    void merge_chunks();
+
+    // 分配s字节的连续空间，当前块剩余空间不够时从BlockPool取新块，超过块大小的单独分配
     std::string_view alloc_buffer(size_t s);
-    std::string_view get_used_buf() {
-        return std::string_view((char*)buf_.get(), used_bytes_);
-    }
+    // 追加数据，可以跨块存放
+    void append(const std::string_view & data);
+    // 切片数据由多个块组成，返回从offset字节开始的各段数据
+    std::vector<std::string_view> get_used_bufs(size_t offset = 0);
 
 
     void update_timestamp(int64_t start, int64_t end);
@@ -58,8 +80,18 @@ public:
     int64_t get_bytes() {
         return used_bytes_;
     }
+
+    // 切片完成后设置，之后不再修改
+    void set_http_response(std::shared_ptr<const HttpCachedResponse> resp) {
+        http_resp_ = resp;
+    }
+
+    std::shared_ptr<const HttpCachedResponse> get_http_response() {
+        return http_resp_;
+    }
 protected:
     std::string filename_;
+    std::string codecs_;
     uint32_t seq_no_ = 0;
 
     int64_t create_at_ = Utils::get_current_ms();
@@ -67,10 +99,18 @@ protected:
     int64_t end_timestamp_ = 0;
     int64_t duration_ms_ = 0;
 
-    std::unique_ptr<uint8_t[]> buf_;
+    struct Block {
+        std::shared_ptr<uint8_t[]> buf;
+        size_t capacity = 0;
+        size_t used = 0;
+    };
+    // 写入只在切片完成之前，完成之后只读，读者不需要加锁
+    std::vector<Block> blocks_;
     size_t used_bytes_ = 0;
-    size_t allocated_bytes_;
 
-    bool is_reaped_  = false;
+    std::atomic<bool> is_reaped_{false};
+    std::shared_mutex chunks_mtx_;
+    std::vector<std::shared_ptr<const std::string>> chunks_;
+    std::shared_ptr<const HttpCachedResponse> http_resp_;
 };
 };
\ No newline at end of file
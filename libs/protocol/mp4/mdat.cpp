@@ -29,3 +29,8 @@ int64_t MdatBox::encode(NetBuffer& buf) {
     }
     return buf.pos() - start;
 }
+
+int64_t MdatBox::encode_header(NetBuffer& buf) {
+    update_size();
+    return Box::encode(buf);
+}
@@ -11,6 +11,8 @@ public:
     virtual ~MdatBox();
     int64_t size();
     int64_t encode(NetBuffer & buf);
+    // 只写box头，数据部分由调用者按datas_自行写入
+    int64_t encode_header(NetBuffer & buf);
 public:
     std::vector<std::string_view> datas_;
 };
@@ -135,6 +135,10 @@ public:
     CodecID get_codec_id() {
         return codec_id;
     }
+    // composition_time为SI24，可能为负数
+    int32_t get_cts() {
+        return (int32_t)(composition_time << 8) >> 8;
+    }
 
 public:
     int32_t decode(const uint8_t *data, size_t len);
@@ -195,6 +195,7 @@ namespace mms {
 #define RTMP_STATUS_STREAM_NOT_FOUND                "NetStream.Play.StreamNotFound"
 
 class RtmpChunk;
+struct MediaFrame;
 
 class ChunkMessageHeader { 
 public:
@@ -225,6 +226,8 @@ public:
     int32_t timestamp_;
     int32_t message_stream_id_;
     int32_t chunk_stream_id_ = 0;
+    // 源解析后的帧信息，没有经过源解析时为空
+    std::shared_ptr<MediaFrame> frame_;
 };
 
 class RtmpChunk {
@@ -25,10 +25,14 @@
 //       31:    reserved for future expansion of the sequence number space
 #define FMT_PLI     0x01
 #define FMT_SLI     0x02
+#define FMT_FIR     0x04
 #define FMT_AFB     0x0F
 #define FMT_RSV     0x1E
 #define FMT_TWCC    0X0F
 
+// rfc4585 6.2.  Transport Layer Feedback Messages, RTPFB FMT=1
+#define FMT_GENERIC_NACK 0x01
+
 namespace mms
 {
     class RtcpFbHeader
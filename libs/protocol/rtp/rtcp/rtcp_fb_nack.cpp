@@ -0,0 +1,85 @@
+#include "rtcp_fb_nack.h"
+using namespace mms;
+
+RtcpFbNack::RtcpFbNack() {
+    header_.version = 2;
+    header_.pt = PT_RTPFB;
+    header_.fmt = FMT_GENERIC_NACK;
+    header_.length = 2;
+}
+
+int32_t RtcpFbNack::decode(uint8_t *data, size_t len) {
+    uint8_t *data_start = data;
+    int32_t consumed = header_.decode(data, len);
+    if (consumed < 0) {
+        return -1;
+    }
+
+    data += consumed;
+    len -= consumed;
+    size_t fci_len = ((size_t)header_.length << 2) - 8;
+    if (fci_len > len || (fci_len % 4) != 0) {
+        return -2;
+    }
+
+    lost_seqs_.clear();
+    for (size_t i = 0; i < fci_len; i += 4) {
+        uint16_t pid = ntohs(*(uint16_t*)data);
+        uint16_t blp = ntohs(*(uint16_t*)(data + 2));
+        lost_seqs_.push_back(pid);
+        for (int b = 0; b < 16; b++) {
+            if (blp & (1 << b)) {
+                lost_seqs_.push_back(pid + b + 1);
+            }
+        }
+        data += 4;
+    }
+    return data - data_start;
+}
+
+void RtcpFbNack::add_lost_seq(uint16_t seq) {
+    lost_seqs_.push_back(seq);
+}
+
+size_t RtcpFbNack::size() {
+    // 按PID+BLP合并后的FCI个数
+    size_t fci_count = 0;
+    size_t i = 0;
+    while (i < lost_seqs_.size()) {
+        uint16_t pid = lost_seqs_[i++];
+        while (i < lost_seqs_.size() && (uint16_t)(lost_seqs_[i] - pid) >= 1 && (uint16_t)(lost_seqs_[i] - pid) <= 16) {
+            i++;
+        }
+        fci_count++;
+    }
+    return header_.size() + fci_count * 4;
+}
+
+int32_t RtcpFbNack::encode(uint8_t *data, size_t len) {
+    size_t total = size();
+    if (len < total) {
+        return -1;
+    }
+
+    header_.length = (total >> 2) - 1;
+    uint8_t *data_start = data;
+    int32_t consumed = header_.encode(data, len);
+    if (consumed < 0) {
+        return -2;
+    }
+    data += consumed;
+
+    size_t i = 0;
+    while (i < lost_seqs_.size()) {
+        uint16_t pid = lost_seqs_[i++];
+        uint16_t blp = 0;
+        while (i < lost_seqs_.size() && (uint16_t)(lost_seqs_[i] - pid) >= 1 && (uint16_t)(lost_seqs_[i] - pid) <= 16) {
+            blp |= 1 << ((uint16_t)(lost_seqs_[i] - pid) - 1);
+            i++;
+        }
+        *(uint16_t*)data = htons(pid);
+        *(uint16_t*)(data + 2) = htons(blp);
+        data += 4;
+    }
+    return data - data_start;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include "rtcp_fb_packet.h"
+// rfc4585 6.2.1.  Generic NACK
+//    0                   1                   2                   3
+//    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |            PID                |             BLP               |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   PID: 丢失包的序号
+//   BLP: PID之后16个包的丢失位图，bit i置位表示 PID+i+1 也丢失
+namespace mms {
+class RtcpFbNack : public RtcpFbPacket {
+public:
+    RtcpFbNack();
+    int32_t decode(uint8_t *data, size_t len);
+    void add_lost_seq(uint16_t seq);
+    int32_t encode(uint8_t *data, size_t len) override;
+    size_t size() override;
+
+    const std::vector<uint16_t> & get_lost_seqs() const {
+        return lost_seqs_;
+    }
+private:
+    std::vector<uint16_t> lost_seqs_;
+};
+};
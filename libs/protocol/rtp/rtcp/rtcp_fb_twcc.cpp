@@ -0,0 +1,97 @@
+#include "rtcp_fb_twcc.h"
+using namespace mms;
+
+#define TWCC_STATUS_NOT_RECEIVED    0
+#define TWCC_STATUS_SMALL_DELTA     1
+#define TWCC_STATUS_LARGE_DELTA     2
+
+RtcpFbTwcc::RtcpFbTwcc() {
+    header_.version = 2;
+    header_.pt = PT_RTPFB;
+    header_.fmt = FMT_TWCC;
+}
+
+int32_t RtcpFbTwcc::decode(uint8_t *data, size_t len) {
+    uint8_t *data_start = data;
+    int32_t consumed = header_.decode(data, len);
+    if (consumed < 0) {
+        return -1;
+    }
+
+    size_t total = ((size_t)header_.length + 1) << 2;
+    if (total > len || total < (size_t)consumed + 8) {
+        return -2;
+    }
+
+    uint8_t *end = data + total;
+    data += consumed;
+    base_seq_ = ntohs(*(uint16_t*)data);
+    status_count_ = ntohs(*(uint16_t*)(data + 2));
+    reference_time_ = (data[4] << 16) | (data[5] << 8) | data[6];
+    if (reference_time_ & 0x800000) { // 24位有符号
+        reference_time_ |= 0xFF000000;
+    }
+    fb_pkt_count_ = data[7];
+    data += 8;
+
+    // 1.解析packet chunk，得到每个包的状态
+    std::vector<uint8_t> symbols;
+    symbols.reserve(status_count_);
+    while (symbols.size() < status_count_) {
+        if (data + 2 > end) {
+            return -3;
+        }
+
+        uint16_t chunk = ntohs(*(uint16_t*)data);
+        data += 2;
+        if ((chunk & 0x8000) == 0) { // run length chunk
+            uint8_t symbol = (chunk >> 13) & 0x03;
+            uint16_t run_length = chunk & 0x1FFF;
+            for (uint16_t i = 0; i < run_length && symbols.size() < status_count_; i++) {
+                symbols.push_back(symbol);
+            }
+        } else if ((chunk & 0x4000) == 0) { // status vector chunk, 14个1bit符号
+            for (int i = 13; i >= 0 && symbols.size() < status_count_; i--) {
+                symbols.push_back((chunk >> i) & 0x01);
+            }
+        } else { // status vector chunk, 7个2bit符号
+            for (int i = 6; i >= 0 && symbols.size() < status_count_; i--) {
+                symbols.push_back((chunk >> (i * 2)) & 0x03);
+            }
+        }
+    }
+
+    // 2.按状态读取recv delta
+    packet_status_.clear();
+    packet_status_.reserve(status_count_);
+    int64_t recv_time_us = (int64_t)reference_time_ * 64000;
+    for (uint16_t i = 0; i < status_count_; i++) {
+        TwccPacketStatus s;
+        s.seq = base_seq_ + i;
+        s.received = false;
+        s.recv_time_us = 0;
+        uint8_t symbol = symbols[i];
+        if (symbol == TWCC_STATUS_SMALL_DELTA) {
+            if (data + 1 > end) {
+                return -4;
+            }
+            recv_time_us += (int64_t)data[0] * 250;
+            data += 1;
+            s.received = true;
+        } else if (symbol == TWCC_STATUS_LARGE_DELTA) {
+            if (data + 2 > end) {
+                return -5;
+            }
+            recv_time_us += (int64_t)(int16_t)ntohs(*(uint16_t*)data) * 250;
+            data += 2;
+            s.received = true;
+        }
+
+        if (s.received) {
+            s.recv_time_us = recv_time_us;
+        }
+        packet_status_.push_back(s);
+    }
+
+    return end - data_start;
+}
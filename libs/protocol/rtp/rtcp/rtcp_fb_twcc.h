@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include "rtcp_fb_packet.h"
+// draft-holmer-rmcat-transport-wide-cc-extensions-01 3.1. Transport-wide RTCP Feedback Message
+//    0                   1                   2                   3
+//    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |V=2|P|  FMT=15 |    PT=205     |           length              |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |                     SSRC of packet sender                     |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |                      SSRC of media source                     |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |      base sequence number     |      packet status count      |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |                 reference time                | fb pkt. count |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |          packet chunk         |         packet chunk          |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   .                                                               .
+//   |         packet chunk          |  recv delta   |  recv delta   |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   .                                                               .
+//   |           recv delta          |  recv delta   | zero padding  |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// reference time单位64ms，recv delta单位250us，small delta 1字节无符号，large delta 2字节有符号
+namespace mms {
+struct TwccPacketStatus {
+    uint16_t seq;
+    bool received;
+    int64_t recv_time_us; // 对端时钟，只能用来算差值
+};
+
+class RtcpFbTwcc : public RtcpFbPacket {
+public:
+    RtcpFbTwcc();
+    int32_t decode(uint8_t *data, size_t len);
+
+    uint8_t get_fb_pkt_count() const {
+        return fb_pkt_count_;
+    }
+
+    const std::vector<TwccPacketStatus> & get_packet_status() const {
+        return packet_status_;
+    }
+private:
+    uint16_t base_seq_ = 0;
+    uint16_t status_count_ = 0;
+    int32_t reference_time_ = 0;
+    uint8_t fb_pkt_count_ = 0;
+    std::vector<TwccPacketStatus> packet_status_;
+};
+};
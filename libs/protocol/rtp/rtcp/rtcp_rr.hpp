@@ -14,6 +14,9 @@ public:
     int32_t decode(uint8_t *data, int32_t len);
     int32_t encode(uint8_t *data, int32_t len);
     void add_reception_report_block(const ReceptionReportBlock & report);
+    const std::vector<ReceptionReportBlock> & get_reception_report_blocks() const {
+        return reception_report_blocks;
+    }
 private:
     std::vector<ReceptionReportBlock> reception_report_blocks;
 };
@@ -0,0 +1,144 @@
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "rtp_flexfec_encoder.h"
+#include "base/block_pool.h"
+using namespace mms;
+
+RtpFlexFecEncoder::RtpFlexFecEncoder(uint32_t fec_ssrc, uint8_t twcc_ext_id, size_t group_pkts, size_t fec_pkts) : fec_ssrc_(fec_ssrc), twcc_ext_id_(twcc_ext_id) {
+    group_pkts_ = std::min(std::max(group_pkts, (size_t)1), MAX_GROUP_PKTS);
+    fec_pkts_ = std::min(std::max(fec_pkts, (size_t)1), group_pkts_);
+    group_.reserve(MAX_GROUP_PKTS);
+    pkt_buf_ = std::make_unique<uint8_t[]>(MAX_PKT_SIZE);
+}
+
+void RtpFlexFecEncoder::add_packet(const std::shared_ptr<RtpPacket> & pkt, std::vector<std::shared_ptr<RtpPacket>> & fec_pkts) {
+    if (!group_.empty()) {
+        // 掩码只能表示基准序号之后15个包，序号回退、跳跃或ssrc变化时先结束当前组
+        uint16_t offset = pkt->get_seq_num() - group_[0]->get_seq_num();
+        if (offset == 0 || offset >= MAX_GROUP_PKTS || pkt->get_header().ssrc != group_[0]->get_header().ssrc) {
+            flush(fec_pkts);
+        }
+    }
+
+    group_.push_back(pkt);
+    // 小帧不单独成组，否则冗余比例会远超设定值
+    if (group_.size() >= group_pkts_ || (pkt->get_header().marker && group_.size() >= MIN_GROUP_PKTS)) {
+        flush(fec_pkts);
+    }
+}
+
+void RtpFlexFecEncoder::flush(std::vector<std::shared_ptr<RtpPacket>> & fec_pkts) {
+    if (group_.empty()) {
+        return;
+    }
+
+    // 组未满时按比例减少冗余包
+    size_t n = group_.size();
+    size_t k = std::max<size_t>((n * fec_pkts_ + group_pkts_ - 1) / group_pkts_, 1);
+    uint16_t base_seq = group_[0]->get_seq_num();
+    size_t first_fec = fec_pkts.size();
+    std::vector<size_t> fec_lens(k, 0);
+    for (size_t j = 0; j < k; j++) {
+        size_t max_len = 0;
+        for (size_t i = j; i < n; i += k) {
+            max_len = std::max(max_len, 8 + group_[i]->payload_len_ + group_[i]->get_header().csrc * 4);
+        }
+
+        auto fec_pkt = std::make_shared<RtpPacket>();
+        auto & header = fec_pkt->get_header();
+        header.version = 2;
+        header.padding = 0;
+        header.extension = 0;
+        header.csrc = 0;
+        header.marker = 0;
+        header.pt = 0;// 由订阅者按各自协商的pt改写
+        header.seqnum = fec_seq_++;
+        header.timestamp = group_[n - 1]->get_timestamp();
+        header.ssrc = fec_ssrc_;
+        fec_lens[j] = FEC_HEADER_SIZE + max_len;
+        memset(alloc_payload(*fec_pkt, fec_lens[j]), 0, fec_lens[j]);
+        fec_pkts.push_back(fec_pkt);
+    }
+
+    // 每个媒体包只异或进一个冗余包
+    for (size_t i = 0; i < n; i++) {
+        int32_t len = group_[i]->encode_with_twcc(pkt_buf_.get(), MAX_PKT_SIZE, twcc_ext_id_, 0);
+        if (len < 12) {
+            continue;
+        }
+
+        uint8_t *fec = (uint8_t*)fec_pkts[first_fec + i % k]->payload_;
+        uint8_t *src = pkt_buf_.get();
+        fec[0] ^= src[0];
+        fec[1] ^= src[1];
+        uint16_t len_recovery = ntohs(*(uint16_t*)(fec + 2)) ^ (uint16_t)(len - 12);
+        *(uint16_t*)(fec + 2) = htons(len_recovery);
+        fec[4] ^= src[4];
+        fec[5] ^= src[5];
+        fec[6] ^= src[6];
+        fec[7] ^= src[7];
+        uint8_t *dst = fec + FEC_HEADER_SIZE;
+        int32_t b = 12;
+        for (; b + 8 <= len; b += 8) {
+            uint64_t d, s;
+            memcpy(&d, dst + b - 12, 8);
+            memcpy(&s, src + b, 8);
+            d ^= s;
+            memcpy(dst + b - 12, &d, 8);
+        }
+        for (; b < len; b++) {
+            dst[b - 12] ^= src[b];
+        }
+    }
+
+    uint32_t media_ssrc = group_[0]->get_header().ssrc;
+    for (size_t j = 0; j < k; j++) {
+        uint8_t *fec = (uint8_t*)fec_pkts[first_fec + j]->payload_;
+        fec[0] &= 0x3f;// R、F位清0
+        fec[8] = 1;// SSRCCount
+        fec[9] = fec[10] = fec[11] = 0;
+        *(uint32_t*)(fec + 12) = htonl(media_ssrc);
+        *(uint16_t*)(fec + 16) = htons(base_seq);
+        uint16_t mask = 0x8000;// k位为1，只有15位掩码
+        for (size_t i = j; i < n; i += k) {
+            uint16_t offset = group_[i]->get_seq_num() - base_seq;
+            mask |= 1 << (14 - offset);
+        }
+        *(uint16_t*)(fec + 18) = htons(mask);
+    }
+    group_.clear();
+}
+
+bool RtpFlexFecEncoder::get_protected_seqs(const uint8_t *fec_payload, size_t len, uint16_t & base_seq, uint16_t & mask) {
+    // 只处理本编码器生成的格式：单ssrc，k位为1的2字节掩码
+    if (len < FEC_HEADER_SIZE || fec_payload[8] != 1 || !(fec_payload[18] & 0x80)) {
+        return false;
+    }
+    base_seq = ntohs(*(uint16_t*)(fec_payload + 16));
+    mask = ntohs(*(uint16_t*)(fec_payload + 18)) & 0x7fff;
+    return true;
+}
+
+void RtpFlexFecEncoder::xor_twcc_seq(uint8_t *fec_payload, size_t len, uint8_t csrc, uint16_t twcc_seq) {
+    // 媒体包12字节固定头之后依次为csrc、扩展头(0xBEDE、长度)、扩展id及长度，之后2字节是序号
+    size_t pos = FEC_HEADER_SIZE + csrc * 4 + 5;
+    if (pos + 2 > len) {
+        return;
+    }
+    fec_payload[pos] ^= twcc_seq >> 8;
+    fec_payload[pos + 1] ^= twcc_seq & 0xFF;
+}
+
+char *RtpFlexFecEncoder::alloc_payload(RtpPacket & pkt, size_t len) {
+    if (!payload_block_ || payload_block_pos_ + len > BlockPool::BLOCK_SIZE) {
+        payload_block_ = BlockPool::get_instance().alloc();
+        payload_block_pos_ = 0;
+    }
+
+    pkt.payload_block_ = payload_block_;
+    pkt.payload_ = (char*)payload_block_.get() + payload_block_pos_;
+    pkt.payload_len_ = len;
+    payload_block_pos_ += len;
+    return pkt.payload_;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "rtp_packet.h"
+namespace mms {
+// FlexFEC(draft-ietf-payload-flexible-fec-scheme-03，浏览器实现的版本)冗余包生成，单ssrc、2字节掩码(最多保护15个包)
+// 冗余包使用单独的ssrc和序号空间，不占用媒体流的序号，同一路流、同一保护等级的冗余包可以被所有订阅者共享
+// 包按订阅者实际发出的格式(带一个transport-cc扩展，序号填0)计算，订阅者发送时改写冗余包的pt和序号，
+// 并用xor_twcc_seq把所保护的媒体包实际发出的transport-cc序号异或进去
+class RtpFlexFecEncoder {
+public:
+    static constexpr size_t FEC_HEADER_SIZE = 20;
+    static constexpr size_t MAX_GROUP_PKTS = 15;
+
+    // 每group_pkts个媒体包生成fec_pkts个冗余包，媒体包按序号交织分配到各冗余包
+    RtpFlexFecEncoder(uint32_t fec_ssrc, uint8_t twcc_ext_id, size_t group_pkts, size_t fec_pkts);
+    // 组满，或者遇到帧结束且组内包数足够时，把生成的冗余包追加到fec_pkts
+    void add_packet(const std::shared_ptr<RtpPacket> & pkt, std::vector<std::shared_ptr<RtpPacket>> & fec_pkts);
+    void flush(std::vector<std::shared_ptr<RtpPacket>> & fec_pkts);
+    // 从冗余包负载中取出所保护媒体包的基准序号和掩码，掩码第14-i位为1表示保护了基准序号+i的包
+    static bool get_protected_seqs(const uint8_t *fec_payload, size_t len, uint16_t & base_seq, uint16_t & mask);
+    // 冗余包按序号0计算，异或进媒体包实际的transport-cc序号后与接收端看到的一致，csrc为媒体包的csrc个数
+    static void xor_twcc_seq(uint8_t *fec_payload, size_t len, uint8_t csrc, uint16_t twcc_seq);
+private:
+    static constexpr size_t MIN_GROUP_PKTS = 4;
+    static constexpr size_t MAX_PKT_SIZE = 1500;
+    char *alloc_payload(RtpPacket & pkt, size_t len);
+private:
+    uint32_t fec_ssrc_;
+    uint8_t twcc_ext_id_;
+    size_t group_pkts_;
+    size_t fec_pkts_;
+    uint16_t fec_seq_ = 0;
+    std::vector<std::shared_ptr<RtpPacket>> group_;
+    std::unique_ptr<uint8_t[]> pkt_buf_;
+    std::shared_ptr<uint8_t[]> payload_block_;
+    size_t payload_block_pos_ = 0;
+};
+};
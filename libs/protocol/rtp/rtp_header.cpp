@@ -164,18 +164,16 @@ int32_t RtpHeader::encode(uint8_t *data, size_t len)
         len -= 4;
     }
 
-    // todo:添加上extension
-    // if(rtp_header_extention)
-    // {
-    //     rtp_header_extention = std::make_shared<RtpHeaderExtention>();
-    //     int32_t consumed = rtp_header_extention->decode(data, len);
-    //     if (consumed < 0)
-    //     {
-    //         return -5;
-    //     }
-    //     data += consumed;
-    //     len -= consumed;
-    // }
+    if (extension && rtp_header_extention)
+    {
+        int32_t consumed = rtp_header_extention->encode(data, len);
+        if (consumed < 0)
+        {
+            return -6;
+        }
+        data += consumed;
+        len -= consumed;
+    }
     return data - data_start;
 }
 
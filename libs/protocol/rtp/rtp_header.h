@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <memory>
 #include <vector>
+#include <string_view>
 
 namespace mms
 {
@@ -22,12 +23,20 @@ namespace mms
         {
             return 4 + length*4;
         }
-        // todo
         virtual int32_t encode(uint8_t *data, size_t len)
         {
-            ((void)data);
-            ((void)len);
-            return 0;
+            uint8_t *data_start = data;
+            if (len < size())
+            {
+                return -1;
+            }
+            *(uint16_t*)data = htons(profile);
+            data += 2;
+            *(uint16_t*)data = htons(length);
+            data += 2;
+            memcpy(data, header_extension.get(), length*4);
+            data += length*4;
+            return data - data_start;
         }
 
         virtual int32_t decode(uint8_t *data, size_t len)
@@ -55,8 +64,66 @@ namespace mms
                 return -3;
             }
             memcpy(header_extension.get(), data, length*4);
+            data += length*4;
             return data - data_start;
         }
+
+        // 按rfc8285查找扩展元素，支持one-byte(0xBEDE)和two-byte(0x100X)两种格式，找不到返回空
+        std::string_view get_element(uint8_t id) const
+        {
+            const uint8_t *p = (const uint8_t*)header_extension.get();
+            size_t total = length*4;
+            size_t pos = 0;
+            bool one_byte = (profile == 0xBEDE);
+            if (!one_byte && (profile & 0xFFF0) != 0x1000)
+            {
+                return std::string_view();
+            }
+
+            while (pos < total)
+            {
+                if (p[pos] == 0) // padding
+                {
+                    pos++;
+                    continue;
+                }
+
+                uint8_t elem_id;
+                size_t elem_len;
+                if (one_byte)
+                {
+                    elem_id = p[pos] >> 4;
+                    elem_len = (p[pos] & 0x0F) + 1;
+                    if (elem_id == 15) // 保留值，停止解析
+                    {
+                        break;
+                    }
+                    pos += 1;
+                }
+                else
+                {
+                    if (pos + 2 > total)
+                    {
+                        break;
+                    }
+                    elem_id = p[pos];
+                    elem_len = p[pos + 1];
+                    pos += 2;
+                }
+
+                if (pos + elem_len > total)
+                {
+                    break;
+                }
+
+                if (elem_id == id)
+                {
+                    return std::string_view((const char*)p + pos, elem_len);
+                }
+                pos += elem_len;
+            }
+            return std::string_view();
+        }
     };
 
     class RtpHeader
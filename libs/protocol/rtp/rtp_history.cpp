@@ -0,0 +1,26 @@
+#include "rtp_history.h"
+using namespace mms;
+
+RtpHistory::RtpHistory(size_t capacity) {
+    size_t cap = 1;
+    while (cap < capacity && cap < 32768) {
+        cap <<= 1;
+    }
+    pkts_.resize(cap);
+    mask_ = cap - 1;
+}
+
+void RtpHistory::put(const std::shared_ptr<RtpPacket> & pkt) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    pkts_[pkt->get_seq_num() & mask_] = pkt;
+    ssrc_.store(pkt->get_header().ssrc);
+}
+
+std::shared_ptr<RtpPacket> RtpHistory::get(uint16_t seq) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto & pkt = pkts_[seq & mask_];
+    if (!pkt || pkt->get_seq_num() != seq) {
+        return nullptr;
+    }
+    return pkt;
+}
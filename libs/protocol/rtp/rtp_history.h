@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rtp_packet.h"
+namespace mms {
+// 按序号索引的rtp发送历史，一路流一份，所有订阅者共享（只持有RtpPacket引用，不拷贝数据），
+// 用于响应播放端的NACK重传
+class RtpHistory {
+public:
+    // capacity会向上取整为2的幂
+    RtpHistory(size_t capacity);
+
+    void put(const std::shared_ptr<RtpPacket> & pkt);
+    // 找不到或已被覆盖时返回nullptr
+    std::shared_ptr<RtpPacket> get(uint16_t seq);
+    uint32_t get_ssrc() const {
+        return ssrc_.load();
+    }
+public:
+    // NACK统计，所有订阅者累加
+    std::atomic<uint64_t> nack_recv_count_{0};      // 收到的NACK报文数
+    std::atomic<uint64_t> nack_seq_count_{0};       // NACK中请求的序号数
+    std::atomic<uint64_t> retrans_count_{0};        // 实际重传的包数
+    std::atomic<uint64_t> miss_count_{0};           // 历史中已找不到的包数
+    std::atomic<uint64_t> rate_limited_count_{0};   // 被限速丢弃的重传数
+private:
+    std::mutex mtx_;
+    std::vector<std::shared_ptr<RtpPacket>> pkts_;
+    uint16_t mask_;
+    std::atomic<uint32_t> ssrc_{0};
+};
+};
@@ -0,0 +1,107 @@
+#include "rtp_jitter_buffer.h"
+using namespace mms;
+
+RtpJitterBuffer::RtpJitterBuffer(int32_t delay_ms) : delay_ms_(delay_ms) {
+
+}
+
+bool RtpJitterBuffer::push(std::shared_ptr<RtpPacket> pkt, int64_t now_ms) {
+    uint16_t seq = pkt->get_seq_num();
+    if (!inited_) {
+        inited_ = true;
+        highest_seq_ = seq + 65536; // 留出回退空间，避免扩展序号下溢
+        next_seq_ = highest_seq_;
+    }
+
+    int16_t diff = (int16_t)(seq - (uint16_t)highest_seq_);
+    if (diff > (int32_t)MAX_MISSING || diff < -(int32_t)MAX_MISSING) {
+        // 推流端重置了序号，丢弃缓冲内的包，从新序号重新开始
+        uint64_t ext_seq = (highest_seq_ | 0xFFFF) + 1 + seq;
+        pkts_.clear();
+        missing_.clear();
+        next_seq_ = ext_seq;
+        highest_seq_ = ext_seq;
+        need_key_frame_ = true;
+        recv_count_++;
+        pkts_[ext_seq] = PktItem{pkt, now_ms};
+        return true;
+    }
+
+    uint64_t ext_seq = highest_seq_ + diff;
+    if (ext_seq < next_seq_) { // 已经输出或跳过
+        return false;
+    }
+
+    if (pkts_.find(ext_seq) != pkts_.end()) {
+        return false;
+    }
+
+    recv_count_++;
+    if (diff > 0) {
+        for (uint64_t s = highest_seq_ + 1; s < ext_seq; s++) {
+            missing_[s] = MissItem();
+        }
+        highest_seq_ = ext_seq;
+    } else {
+        auto it = missing_.find(ext_seq);
+        if (it != missing_.end()) {
+            if (it->second.nack_times > 0) {
+                recovered_count_++;
+            }
+            missing_.erase(it);
+        }
+    }
+
+    pkts_[ext_seq] = PktItem{pkt, now_ms};
+    return true;
+}
+
+void RtpJitterBuffer::skip_to(uint64_t ext_seq) {
+    lost_count_ += ext_seq - next_seq_;
+    missing_.erase(missing_.begin(), missing_.lower_bound(ext_seq));
+    next_seq_ = ext_seq;
+    need_key_frame_ = true;
+}
+
+void RtpJitterBuffer::pop(int64_t now_ms, std::vector<std::shared_ptr<RtpPacket>> & out) {
+    while (!pkts_.empty()) {
+        auto it = pkts_.begin();
+        if (it->first == next_seq_) {
+            out.emplace_back(std::move(it->second.pkt));
+            pkts_.erase(it);
+            next_seq_++;
+            continue;
+        }
+
+        // 前面有缺口，缺口后第一个包等待超时或缓冲太多，放弃缺口
+        if (now_ms - it->second.arrive_ms >= delay_ms_ || pkts_.size() >= MAX_PKTS) {
+            skip_to(it->first);
+            continue;
+        }
+        break;
+    }
+}
+
+void RtpJitterBuffer::get_nack_seqs(int64_t now_ms, std::vector<uint16_t> & seqs) {
+    for (auto & p : missing_) {
+        auto & m = p.second;
+        if (m.nack_times >= MAX_NACK_TIMES) {
+            continue;
+        }
+
+        if (m.nack_times > 0 && now_ms - m.last_nack_ms < NACK_INTERVAL_MS) {
+            continue;
+        }
+
+        m.nack_times++;
+        m.last_nack_ms = now_ms;
+        seqs.push_back((uint16_t)p.first);
+        nack_count_++;
+    }
+}
+
+bool RtpJitterBuffer::need_key_frame() {
+    bool v = need_key_frame_;
+    need_key_frame_ = false;
+    return v;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "rtp_packet.h"
+namespace mms {
+// 接收端rtp重排/抖动缓冲
+// 1.按扩展序号重排，乱序包在缓冲内归位后按序输出；
+// 2.发现序号缺口时生成NACK序号，按间隔重复请求，直到补上或超过最大次数；
+// 3.缺口等待超过delay_ms仍未补上则跳过，并标记需要请求关键帧。
+// 非线程安全，由所属会话在同一个协程上下文中调用
+class RtpJitterBuffer {
+public:
+    RtpJitterBuffer(int32_t delay_ms);
+
+    // 重复包、已输出过的迟到包返回false
+    bool push(std::shared_ptr<RtpPacket> pkt, int64_t now_ms);
+    // 取出可以按序输出的包
+    void pop(int64_t now_ms, std::vector<std::shared_ptr<RtpPacket>> & out);
+    // 本次需要发送NACK的序号
+    void get_nack_seqs(int64_t now_ms, std::vector<uint16_t> & seqs);
+    // 有缺口最终没有补上，需要请求关键帧，调用后清除标记
+    bool need_key_frame();
+
+    uint64_t get_recv_count() const {
+        return recv_count_;
+    }
+
+    uint64_t get_recovered_count() const {
+        return recovered_count_;
+    }
+
+    uint64_t get_lost_count() const {
+        return lost_count_;
+    }
+
+    uint64_t get_nack_count() const {
+        return nack_count_;
+    }
+private:
+    void skip_to(uint64_t ext_seq);
+private:
+    struct PktItem {
+        std::shared_ptr<RtpPacket> pkt;
+        int64_t arrive_ms;
+    };
+
+    struct MissItem {
+        int64_t last_nack_ms = 0;
+        int32_t nack_times = 0;
+    };
+
+    static constexpr int32_t NACK_INTERVAL_MS = 40;   // 同一个序号重复NACK的间隔
+    static constexpr int32_t MAX_NACK_TIMES = 10;     // 同一个序号最多NACK次数
+    static constexpr uint64_t MAX_MISSING = 1000;     // 序号跳变过大视为流重置
+    static constexpr size_t MAX_PKTS = 4096;          // 缓冲包数上限
+
+    int32_t delay_ms_;
+    bool inited_ = false;
+    bool need_key_frame_ = false;
+    uint64_t highest_seq_ = 0;      // 收到的最大扩展序号
+    uint64_t next_seq_ = 0;         // 下一个待输出的扩展序号
+    std::map<uint64_t, PktItem> pkts_;
+    std::map<uint64_t, MissItem> missing_;
+
+    uint64_t recv_count_ = 0;
+    uint64_t recovered_count_ = 0;
+    uint64_t lost_count_ = 0;
+    uint64_t nack_count_ = 0;
+};
+};
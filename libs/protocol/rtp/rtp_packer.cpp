@@ -5,6 +5,7 @@
 #include "rtp_packer.h"
 #include "spdlog/spdlog.h"
 #include "codec/hevc/hevc_define.hpp"
+#include "base/block_pool.h"
 
 using namespace mms;
 #define NAL_RTP_PACKET_SIZE 1400
@@ -40,10 +41,7 @@ std::vector<std::shared_ptr<RtpPacket>> RtpPacker::pack(char *data, int32_t len,
             pkt->header_.marker = 1;
             pkt->header_.seqnum = get_sequence_num();
             pkt->header_.ssrc = ssrc;
-            pkt->payload_ = new char[left_len];
-            memcpy(pkt->payload_, data + curr_pos, left_len);
-            // pkt->payload_ = data + curr_pos;
-            pkt->payload_len_ = left_len;
+            memcpy(alloc_payload(*pkt, left_len), data + curr_pos, left_len);
             consume_count = left_len;
         }
         else
@@ -54,10 +52,7 @@ std::vector<std::shared_ptr<RtpPacket>> RtpPacker::pack(char *data, int32_t len,
             pkt->header_.marker = 0;
             pkt->header_.seqnum = get_sequence_num();
             pkt->header_.ssrc = ssrc;
-            pkt->payload_ = new char[NAL_RTP_PACKET_SIZE];
-            memcpy(pkt->payload_, data + curr_pos, NAL_RTP_PACKET_SIZE);
-            // pkt->payload_ = data + curr_pos;
-            pkt->payload_len_ = NAL_RTP_PACKET_SIZE;
+            memcpy(alloc_payload(*pkt, NAL_RTP_PACKET_SIZE), data + curr_pos, NAL_RTP_PACKET_SIZE);
             consume_count = NAL_RTP_PACKET_SIZE;
         }
         pkts.push_back(pkt);
@@ -91,8 +86,7 @@ std::vector<std::shared_ptr<RtpPacket>> RtpPacker::pack(const std::list<std::str
                 pkt->header_.ssrc = ssrc;
                 int32_t left_bytes = total_bytes - data_pos;
                 int32_t payload_len = (left_bytes > NAL_RTP_PACKET_SIZE)?NAL_RTP_PACKET_SIZE:left_bytes;
-                pkt->payload_ = new char[payload_len+2];
-                pkt->payload_len_ = payload_len + 2;
+                alloc_payload(*pkt, payload_len + 2);
                 if ((data_pos + payload_len) >= total_bytes) {
                     end = true;
                     if (last) {
@@ -124,9 +118,7 @@ std::vector<std::shared_ptr<RtpPacket>> RtpPacker::pack(const std::list<std::str
             pkt->header_.timestamp = pts;
             pkt->header_.seqnum = get_sequence_num();
             pkt->header_.ssrc = ssrc;
-            pkt->payload_ = new char[nalu.size()];
-            pkt->payload_len_ = nalu.size();
-            memcpy(pkt->payload_, nalu.data(), nalu.size());
+            memcpy(alloc_payload(*pkt, nalu.size()), nalu.data(), nalu.size());
             if (last) {
                 pkt->header_.marker = 1;
             } else {
@@ -143,6 +135,28 @@ RtpPacker::~RtpPacker()
 
 }
 
+char *RtpPacker::alloc_payload(RtpPacket & pkt, size_t len)
+{
+    if (len > BlockPool::BLOCK_SIZE)
+    {
+        pkt.payload_ = new char[len];
+        pkt.payload_len_ = len;
+        return pkt.payload_;
+    }
+
+    if (!payload_block_ || payload_block_pos_ + len > BlockPool::BLOCK_SIZE)
+    {
+        payload_block_ = BlockPool::get_instance().alloc();
+        payload_block_pos_ = 0;
+    }
+
+    pkt.payload_block_ = payload_block_;
+    pkt.payload_ = (char*)payload_block_.get() + payload_block_pos_;
+    pkt.payload_len_ = len;
+    payload_block_pos_ += len;
+    return pkt.payload_;
+}
+
 
 H265RtpPacker::H265RtpPacker()
 {
@@ -178,8 +192,7 @@ std::vector<std::shared_ptr<RtpPacket>> H265RtpPacker::pack(const std::list<std:
                 pkt->header_.ssrc = ssrc;
                 int32_t left_bytes = total_bytes - data_pos;
                 int32_t payload_len = (left_bytes > NAL_RTP_PACKET_SIZE)?NAL_RTP_PACKET_SIZE:left_bytes;
-                pkt->payload_ = new char[payload_len+3];
-                pkt->payload_len_ = payload_len + 3;
+                alloc_payload(*pkt, payload_len + 3);
                 if ((data_pos + payload_len) >= total_bytes) {
                     end = true;
                     if (last) {
@@ -211,9 +224,7 @@ std::vector<std::shared_ptr<RtpPacket>> H265RtpPacker::pack(const std::list<std:
             pkt->header_.timestamp = pts;
             pkt->header_.seqnum = get_sequence_num();
             pkt->header_.ssrc = ssrc;
-            pkt->payload_ = new char[nalu.size()];
-            pkt->payload_len_ = nalu.size();
-            memcpy(pkt->payload_, nalu.data(), nalu.size());
+            memcpy(alloc_payload(*pkt, nalu.size()), nalu.data(), nalu.size());
             if (last) {
                 pkt->header_.marker = 1;
             } else {
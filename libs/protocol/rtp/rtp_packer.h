@@ -30,6 +30,11 @@ public:
 public:
     uint16_t get_sequence_num();
     std::atomic<uint16_t> rtp_seqnum_{0};
+protected:
+    // 负载从池化内存块中顺序切分，同一块被多个包(包括跨帧)共享，包打好后只读，所有订阅者共用
+    char *alloc_payload(RtpPacket & pkt, size_t len);
+    std::shared_ptr<uint8_t[]> payload_block_;
+    size_t payload_block_pos_ = 0;
 };
 
 class H265RtpPacker : public RtpPacker {
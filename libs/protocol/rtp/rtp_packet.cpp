@@ -4,7 +4,7 @@ using namespace mms;
 
 RtpPacket::~RtpPacket()
 {
-    if (payload_)
+    if (payload_ && !payload_block_)
     {
         delete[] payload_;
         payload_ = nullptr;
@@ -49,6 +49,33 @@ int32_t RtpPacket::encode(uint8_t *data, size_t len)
     return data - data_start;
 }
 
+int32_t RtpPacket::encode_with_twcc(uint8_t *data, size_t len, uint8_t ext_id, uint16_t twcc_seq)
+{
+    size_t fixed_size = 12 + header_.csrc * 4;
+    if (len < fixed_size + 8 + payload_len_) {
+        return -1;
+    }
+
+    int32_t consumed = header_.encode(data, len);
+    if (consumed < (int32_t)fixed_size) {
+        return -2;
+    }
+
+    uint8_t *p = data;
+    p[0] |= 0x10;
+    p += fixed_size;
+    *(uint16_t*)p = htons(0xBEDE);
+    *(uint16_t*)(p + 2) = htons(1);
+    p[4] = (ext_id << 4) | 0x01; // len字段为字节数-1
+    p[5] = twcc_seq >> 8;
+    p[6] = twcc_seq & 0xFF;
+    p[7] = 0;
+    p += 8;
+    memcpy(p, payload_, payload_len_);
+    p += payload_len_;
+    return p - data;
+}
+
 size_t RtpPacket::size()
 {
     return 0;
@@ -9,6 +9,8 @@ namespace mms {
 
     public:
         virtual int32_t encode(uint8_t *data, size_t len);
+        // 编码时用一个transport-cc扩展(one-byte header)替换原有扩展，不修改包本身，多个订阅者可共享同一个包
+        int32_t encode_with_twcc(uint8_t *data, size_t len, uint8_t ext_id, uint16_t twcc_seq);
         virtual int32_t decode_and_store(uint8_t *data, size_t len);
         virtual size_t size();
         uint16_t get_seq_num();
@@ -26,5 +28,7 @@ namespace mms {
         RtpHeader header_;
         char *payload_ = nullptr;
         size_t payload_len_ = 0;
+        // 非空时payload_指向这块共享内存(RtpPacker池化分配)，不单独释放
+        std::shared_ptr<uint8_t[]> payload_block_;
     };
 };
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cmath>
+#include "twcc_bandwidth_estimator.h"
+using namespace mms;
+
+TwccBandwidthEstimator::TwccBandwidthEstimator(int64_t start_bps) : estimated_bps_(start_bps) {
+    sent_pkts_.resize(SEND_HISTORY_SIZE);
+}
+
+void TwccBandwidthEstimator::on_packet_sent(uint16_t twcc_seq, size_t size, int64_t now_us) {
+    auto & p = sent_pkts_[twcc_seq % SEND_HISTORY_SIZE];
+    p.seq = twcc_seq;
+    p.size = size;
+    p.send_us = now_us;
+}
+
+void TwccBandwidthEstimator::on_feedback(const std::vector<TwccPacketStatus> & status, int64_t now_ms) {
+    for (auto & s : status) {
+        auto & p = sent_pkts_[s.seq % SEND_HISTORY_SIZE];
+        if (p.seq != s.seq || p.send_us < 0) {
+            continue;
+        }
+
+        total_pkts_++;
+        if (!s.received) {
+            lost_pkts_++;
+            continue;
+        }
+
+        acked_bytes_ += p.size;
+        update_delay(p.send_us, s.recv_time_us);
+    }
+
+    has_feedback_ = true;
+    update_estimate(now_ms);
+}
+
+void TwccBandwidthEstimator::update_delay(int64_t send_us, int64_t recv_us) {
+    if (first_arrival_us_ < 0) {
+        first_arrival_us_ = recv_us;
+    }
+
+    if (group_first_send_us_ < 0) {
+        group_first_send_us_ = send_us;
+        group_last_send_us_ = send_us;
+        group_last_recv_us_ = recv_us;
+        return;
+    }
+
+    if (send_us < group_first_send_us_) { // 乱序反馈，忽略
+        return;
+    }
+
+    if (send_us - group_first_send_us_ <= BURST_US) {
+        group_last_send_us_ = std::max(group_last_send_us_, send_us);
+        group_last_recv_us_ = std::max(group_last_recv_us_, recv_us);
+        return;
+    }
+
+    // 一个分组结束
+    if (prev_group_send_us_ >= 0) {
+        double send_delta_ms = (group_last_send_us_ - prev_group_send_us_) / 1000.0;
+        double recv_delta_ms = (group_last_recv_us_ - prev_group_recv_us_) / 1000.0;
+        accumulated_delay_ms_ += recv_delta_ms - send_delta_ms;
+        smoothed_delay_ms_ = 0.9 * smoothed_delay_ms_ + 0.1 * accumulated_delay_ms_;
+        update_trend((group_last_recv_us_ - first_arrival_us_) / 1000, smoothed_delay_ms_);
+    }
+
+    prev_group_send_us_ = group_last_send_us_;
+    prev_group_recv_us_ = group_last_recv_us_;
+    group_first_send_us_ = send_us;
+    group_last_send_us_ = send_us;
+    group_last_recv_us_ = recv_us;
+}
+
+void TwccBandwidthEstimator::update_trend(int64_t arrival_ms, double smoothed_delay_ms) {
+    trend_points_.emplace_back((double)arrival_ms, smoothed_delay_ms);
+    if (trend_points_.size() > TREND_WINDOW) {
+        trend_points_.pop_front();
+    }
+
+    if (trend_points_.size() < TREND_WINDOW) {
+        return;
+    }
+
+    // 最小二乘求斜率
+    double sum_x = 0, sum_y = 0;
+    for (auto & p : trend_points_) {
+        sum_x += p.first;
+        sum_y += p.second;
+    }
+    double avg_x = sum_x / trend_points_.size();
+    double avg_y = sum_y / trend_points_.size();
+    double num = 0, den = 0;
+    for (auto & p : trend_points_) {
+        num += (p.first - avg_x) * (p.second - avg_y);
+        den += (p.first - avg_x) * (p.first - avg_x);
+    }
+
+    double slope = den == 0 ? 0 : num / den;
+    modified_trend_ = slope * trend_points_.size() * TREND_GAIN;
+    if (modified_trend_ > OVERUSE_THRESHOLD) {
+        delay_state_ = DELAY_OVERUSE;
+    } else if (modified_trend_ < -OVERUSE_THRESHOLD) {
+        delay_state_ = DELAY_UNDERUSE;
+    } else {
+        delay_state_ = DELAY_NORMAL;
+    }
+}
+
+void TwccBandwidthEstimator::update_estimate(int64_t now_ms) {
+    if (acked_begin_ms_ == 0) {
+        acked_begin_ms_ = now_ms;
+        last_update_ms_ = now_ms;
+    }
+
+    // 确认码率和丢包率按250ms窗口统计
+    if (now_ms - acked_begin_ms_ >= 250) {
+        acked_bps_ = acked_bytes_ * 8 * 1000 / (now_ms - acked_begin_ms_);
+        acked_bytes_ = 0;
+        acked_begin_ms_ = now_ms;
+    }
+
+    if (total_pkts_ >= 20) {
+        loss_rate_ = (double)lost_pkts_ / total_pkts_;
+        lost_pkts_ = 0;
+        total_pkts_ = 0;
+    }
+
+    double elapsed_s = std::min<int64_t>(now_ms - last_update_ms_, 1000) / 1000.0;
+    last_update_ms_ = now_ms;
+    if (delay_state_ == DELAY_OVERUSE) {
+        if (now_ms - last_decrease_ms_ >= 200) {
+            int64_t target = acked_bps_ > 0 ? (int64_t)(acked_bps_ * 0.85) : (int64_t)(estimated_bps_ * 0.85);
+            estimated_bps_ = std::min(estimated_bps_, target);
+            last_decrease_ms_ = now_ms;
+        }
+    } else if (loss_rate_ > 0.1) {
+        if (now_ms - last_decrease_ms_ >= 300) {
+            // 按丢包率降，但不低于实际送达的码率
+            int64_t target = std::max<int64_t>(estimated_bps_ * (1 - 0.5 * loss_rate_), acked_bps_ * 0.85);
+            estimated_bps_ = std::min(estimated_bps_, target);
+            last_decrease_ms_ = now_ms;
+        }
+    } else if (loss_rate_ < 0.02 && delay_state_ == DELAY_NORMAL) {
+        estimated_bps_ = (int64_t)(estimated_bps_ * std::pow(1.08, elapsed_s));
+        estimated_bps_ = std::max(estimated_bps_, acked_bps_);
+        if (acked_bps_ > 0) {
+            estimated_bps_ = std::min<int64_t>(estimated_bps_, acked_bps_ * 3 / 2 + 100 * 1000);
+        }
+    }
+
+    estimated_bps_ = std::clamp<int64_t>(estimated_bps_, MIN_BPS, MAX_BPS);
+}
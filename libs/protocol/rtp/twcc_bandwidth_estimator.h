@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+#include "rtcp/rtcp_fb_twcc.h"
+namespace mms {
+// 基于transport-cc反馈的发送端带宽估计，简化版gcc
+// 1.时延：按5ms发送时间分组，计算组间单向时延变化，累计后做线性回归求趋势，趋势超过阈值视为过载；
+// 2.丢包：丢包率>10%按丢包率降码率(不低于确认码率的85%)，<2%且时延未过载时每秒乘性增长8%，且不低于确认码率；
+// 3.估计值不超过确认码率的1.5倍，避免应用受限时无限增长。
+// 非线程安全
+class TwccBandwidthEstimator {
+public:
+    enum DelayState {
+        DELAY_NORMAL = 0,
+        DELAY_OVERUSE = 1,
+        DELAY_UNDERUSE = 2,
+    };
+
+    TwccBandwidthEstimator(int64_t start_bps);
+
+    void on_packet_sent(uint16_t twcc_seq, size_t size, int64_t now_us);
+    void on_feedback(const std::vector<TwccPacketStatus> & status, int64_t now_ms);
+
+    int64_t get_estimated_bps() const {
+        return estimated_bps_;
+    }
+
+    int64_t get_acked_bps() const {
+        return acked_bps_;
+    }
+
+    double get_loss_rate() const {
+        return loss_rate_;
+    }
+
+    double get_delay_trend() const {
+        return modified_trend_;
+    }
+
+    DelayState get_delay_state() const {
+        return delay_state_;
+    }
+
+    bool has_feedback() const {
+        return has_feedback_;
+    }
+private:
+    void update_delay(int64_t send_us, int64_t recv_us);
+    void update_trend(int64_t arrival_ms, double smoothed_delay_ms);
+    void update_estimate(int64_t now_ms);
+private:
+    struct SentPacket {
+        uint16_t seq = 0;
+        uint32_t size = 0;
+        int64_t send_us = -1;
+    };
+
+    static constexpr size_t SEND_HISTORY_SIZE = 8192;
+    static constexpr int64_t BURST_US = 5000;
+    static constexpr size_t TREND_WINDOW = 20;
+    static constexpr double TREND_GAIN = 4.0;
+    static constexpr double OVERUSE_THRESHOLD = 12.5;
+    static constexpr int64_t MIN_BPS = 50 * 1000;
+    static constexpr int64_t MAX_BPS = 30 * 1000 * 1000;
+
+    std::vector<SentPacket> sent_pkts_;
+
+    // 当前分组和上一个分组
+    int64_t group_first_send_us_ = -1;
+    int64_t group_last_send_us_ = -1;
+    int64_t group_last_recv_us_ = -1;
+    int64_t prev_group_send_us_ = -1;
+    int64_t prev_group_recv_us_ = -1;
+    int64_t first_arrival_us_ = -1;
+    double accumulated_delay_ms_ = 0;
+    double smoothed_delay_ms_ = 0;
+    std::deque<std::pair<double, double>> trend_points_;
+    double modified_trend_ = 0;
+    DelayState delay_state_ = DELAY_NORMAL;
+
+    // 丢包和确认码率
+    uint32_t lost_pkts_ = 0;
+    uint32_t total_pkts_ = 0;
+    double loss_rate_ = 0;
+    int64_t acked_bytes_ = 0;
+    int64_t acked_begin_ms_ = 0;
+    int64_t acked_bps_ = 0;
+
+    bool has_feedback_ = false;
+    int64_t estimated_bps_;
+    int64_t last_update_ms_ = 0;
+    int64_t last_decrease_ms_ = 0;
+};
+};
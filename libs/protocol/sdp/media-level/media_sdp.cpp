@@ -93,6 +93,24 @@ bool MediaSdp::parse_attr(const std::string &line)
         }
         ext_maps.emplace_back(ext_map);
     }
+    else if (boost::starts_with(line, RidAttr::prefix))
+    {
+        RidAttr rid;
+        if (!rid.parse(line))
+        {
+            return false;
+        }
+        rids_.emplace_back(rid);
+    }
+    else if (boost::starts_with(line, SimulcastAttr::prefix))
+    {
+        SimulcastAttr simulcast;
+        if (!simulcast.parse(line))
+        {
+            return false;
+        }
+        simulcast_ = simulcast;
+    }
     else if (DirAttr::is_my_prefix(line))
     {
         DirAttr d;
@@ -264,6 +282,18 @@ std::string MediaSdp::to_string() const
     if (mid) {
         oss << mid.value().to_string();
     }
+
+    for (auto &e : ext_maps) {
+        oss << e.to_string();
+    }
+
+    for (auto &r : rids_) {
+        oss << r.to_string();
+    }
+
+    if (simulcast_) {
+        oss << simulcast_.value().to_string();
+    }
     
     if (fingerprint_) {
         oss << fingerprint_.value().to_string();
@@ -8,6 +8,8 @@
 #include "protocol/sdp/ice/ice_pwd.h"
 #include "protocol/sdp/ice/ice_options.h"
 #include "protocol/sdp/webrtc/extmap.hpp"
+#include "protocol/sdp/webrtc/rid.hpp"
+#include "protocol/sdp/webrtc/simulcast.hpp"
 #include "protocol/sdp/session-level/connection_info.hpp"
 #include "protocol/sdp/webrtc/ssrc.h"
 #include "protocol/sdp/media-level/mid.h"
@@ -212,6 +214,31 @@ namespace mms
             ext_maps.push_back(val);
         }
 
+        const std::vector<RidAttr> &get_rids() const
+        {
+            return rids_;
+        }
+
+        void set_rids(const std::vector<RidAttr> &val)
+        {
+            rids_ = val;
+        }
+
+        void add_rid(const RidAttr &val)
+        {
+            rids_.push_back(val);
+        }
+
+        const std::optional<SimulcastAttr> &get_simulcast() const
+        {
+            return simulcast_;
+        }
+
+        void set_simulcast(const std::optional<SimulcastAttr> &val)
+        {
+            simulcast_ = val;
+        }
+
         const std::optional<DirAttr> &get_dir() const
         {
             return dir;
@@ -471,6 +498,8 @@ namespace mms
         std::optional<MaxPTimeAttr> max_ptime;
         std::optional<Control> control;
         std::vector<Extmap> ext_maps;
+        std::vector<RidAttr> rids_;
+        std::optional<SimulcastAttr> simulcast_;
 
         std::optional<ConnectionInfo> connection_info;
         std::optional<MidAttr> mid;
@@ -38,6 +38,9 @@ bool SsrcGroup::parse(const std::string &line)
     {
         for (size_t i = 1; i < vs.size(); i++) {
             uint32_t ssrc_id = std::atoi(vs[i].c_str());
+            if (ssrcs_.find(ssrc_id) == ssrcs_.end()) {
+                ssrc_ids_.push_back(ssrc_id);
+            }
             ssrcs_[ssrc_id];
         }
     }
@@ -59,6 +62,9 @@ bool SsrcGroup::parse_ssrc(const std::string & line) {
     }
 
     uint32_t id = std::atoi(vs[0].c_str());
+    if (ssrcs_.find(id) == ssrcs_.end()) {
+        ssrc_ids_.push_back(id);
+    }
     if (!ssrcs_[id].parse(line)) {
         return false;
     }
@@ -69,8 +75,8 @@ std::string SsrcGroup::to_string() const {
     std::ostringstream oss;
     oss << prefix << semantics << " ";
     std::vector<std::string> v;
-    for (auto & p : ssrcs_) {
-        v.push_back(std::to_string(p.first));
+    for (auto id : ssrc_ids_) {
+        v.push_back(std::to_string(id));
     }
     oss << boost::join(v, " ") << std::endl;
     return oss.str();
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "protocol/sdp/webrtc/ssrc.h"
 // @refer https://tools.ietf.org/html/rfc5576#section-4
 // 2.10.1 ssrc-group#
@@ -34,11 +35,20 @@ public:
     }
 
     void add_ssrc(const Ssrc & ssrc) {
+        if (ssrcs_.find(ssrc.get_id()) == ssrcs_.end()) {
+            ssrc_ids_.push_back(ssrc.get_id());
+        }
         ssrcs_[ssrc.get_id()] = ssrc;
     }
+
+    // 按出现顺序排列，FID/FEC-FR的第一个为主流ssrc
+    const std::vector<uint32_t> & get_ssrc_ids() const {
+        return ssrc_ids_;
+    }
 public:
     std::string semantics;
     std::unordered_map<uint32_t, Ssrc> ssrcs_;
+    std::vector<uint32_t> ssrc_ids_;
 };
 
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "extmap.hpp"
 #include <iostream>
+#include <sstream>
 #include <boost/algorithm/string.hpp>
 
 #include "base/utils/utils.h"
@@ -26,4 +27,18 @@ bool Extmap::parse(const std::string & line) {
     uri = vs[1];
     
     return true;
+}
+
+std::string Extmap::to_string() const {
+    std::ostringstream oss;
+    oss << prefix << value;
+    if (!direction.empty()) {
+        oss << "/" << direction;
+    }
+    oss << " " << uri;
+    for (auto & attr : ext_attrs) {
+        oss << " " << attr;
+    }
+    oss << std::endl;
+    return oss.str();
 }
\ No newline at end of file
@@ -60,11 +60,21 @@
 #include <string>
 #include <vector>
 
+#define EXTMAP_URI_TWCC "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01"
+#define EXTMAP_URI_MID "urn:ietf:params:rtp-hdrext:sdes:mid"
+#define EXTMAP_URI_RID "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id"
+
 namespace mms {
 struct Extmap {
 public:
     static std::string prefix;
+    Extmap() = default;
+    Extmap(int id, const std::string & u) : value(std::to_string(id)), uri(u) {
+
+    }
+    virtual ~Extmap() = default;
     virtual bool parse(const std::string & line);
+    std::string to_string() const;
 public:
     std::string value;
     std::string direction;
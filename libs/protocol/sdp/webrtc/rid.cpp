@@ -0,0 +1,36 @@
+#include <sstream>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+
+#include "rid.hpp"
+using namespace mms;
+std::string RidAttr::prefix = "a=rid:";
+bool RidAttr::parse(const std::string & line) {
+    std::string::size_type end_pos = line.rfind("\r");
+    if (end_pos == std::string::npos) {
+        end_pos = line.size() - 1;
+    }
+    std::string valid_string = line.substr(prefix.size(), end_pos - prefix.size());
+    std::vector<std::string> vs;
+    boost::split(vs, valid_string, boost::is_any_of(" "));
+    if (vs.size() < 2) {
+        return false;
+    }
+
+    id_ = vs[0];
+    direction_ = vs[1];
+    if (vs.size() >= 3) {
+        restrictions_ = vs[2];
+    }
+    return true;
+}
+
+std::string RidAttr::to_string() const {
+    std::ostringstream oss;
+    oss << prefix << id_ << " " << direction_;
+    if (!restrictions_.empty()) {
+        oss << " " << restrictions_;
+    }
+    oss << std::endl;
+    return oss.str();
+}
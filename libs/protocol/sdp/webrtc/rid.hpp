@@ -0,0 +1,37 @@
+#pragma once
+// @rfc8851 RTP Payload Format Restrictions
+// a=rid:<rid-id> <direction> [pt=<fmt-list>;<restriction>=<value>...]
+// a=rid:h send
+// a=rid:l send max-width=640;max-height=360
+// rid用于标识同一个m行中的不同RTP流，simulcast推流时每一层有一个rid，
+// rtp包通过urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id扩展头携带rid，以此把ssrc和层对应起来
+#include <string>
+
+namespace mms {
+struct RidAttr {
+public:
+    static std::string prefix;
+    RidAttr() = default;
+    RidAttr(const std::string & id, const std::string & direction) : id_(id), direction_(direction) {
+
+    }
+    bool parse(const std::string & line);
+    std::string to_string() const;
+
+    const std::string & get_id() const {
+        return id_;
+    }
+
+    const std::string & get_direction() const {
+        return direction_;
+    }
+
+    const std::string & get_restrictions() const {
+        return restrictions_;
+    }
+public:
+    std::string id_;
+    std::string direction_;
+    std::string restrictions_;
+};
+};
@@ -0,0 +1,98 @@
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/algorithm/string/join.hpp>
+
+#include "simulcast.hpp"
+using namespace mms;
+std::string SimulcastAttr::prefix = "a=simulcast:";
+
+static std::vector<std::vector<std::string>> parse_streams(const std::string & s) {
+    std::vector<std::vector<std::string>> streams;
+    std::vector<std::string> vs;
+    boost::split(vs, s, boost::is_any_of(";"));
+    for (auto & stream : vs) {
+        if (stream.empty()) {
+            continue;
+        }
+        std::vector<std::string> alts;
+        boost::split(alts, stream, boost::is_any_of(","));
+        streams.push_back(alts);
+    }
+    return streams;
+}
+
+static std::string streams_to_string(const std::vector<std::vector<std::string>> & streams) {
+    std::vector<std::string> vs;
+    for (auto & alts : streams) {
+        vs.push_back(boost::join(alts, ","));
+    }
+    return boost::join(vs, ";");
+}
+
+static std::vector<std::string> first_rids(const std::vector<std::vector<std::string>> & streams) {
+    std::vector<std::string> rids;
+    for (auto & alts : streams) {
+        if (alts.empty()) {
+            continue;
+        }
+        std::string rid = alts[0];
+        if (!rid.empty() && rid[0] == '~') {
+            rid = rid.substr(1);
+        }
+        if (!rid.empty()) {
+            rids.push_back(rid);
+        }
+    }
+    return rids;
+}
+
+bool SimulcastAttr::parse(const std::string & line) {
+    std::string::size_type end_pos = line.rfind("\r");
+    if (end_pos == std::string::npos) {
+        end_pos = line.size() - 1;
+    }
+    std::string valid_string = line.substr(prefix.size(), end_pos - prefix.size());
+    std::vector<std::string> vs;
+    boost::split(vs, valid_string, boost::is_any_of(" "));
+    if (vs.size() < 2) {
+        return false;
+    }
+
+    for (size_t i = 0; i + 1 < vs.size(); i += 2) {
+        if (vs[i] == "send") {
+            send_streams_ = parse_streams(vs[i + 1]);
+        } else if (vs[i] == "recv") {
+            recv_streams_ = parse_streams(vs[i + 1]);
+        } else {
+            return false;
+        }
+    }
+    return !send_streams_.empty() || !recv_streams_.empty();
+}
+
+std::vector<std::string> SimulcastAttr::get_send_rids() const {
+    return first_rids(send_streams_);
+}
+
+std::vector<std::string> SimulcastAttr::get_recv_rids() const {
+    return first_rids(recv_streams_);
+}
+
+std::string SimulcastAttr::to_string() const {
+    std::ostringstream oss;
+    oss << prefix;
+    bool has_send = false;
+    if (!send_streams_.empty()) {
+        oss << "send " << streams_to_string(send_streams_);
+        has_send = true;
+    }
+
+    if (!recv_streams_.empty()) {
+        if (has_send) {
+            oss << " ";
+        }
+        oss << "recv " << streams_to_string(recv_streams_);
+    }
+    oss << std::endl;
+    return oss.str();
+}
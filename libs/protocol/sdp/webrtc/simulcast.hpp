@@ -0,0 +1,33 @@
+#pragma once
+// @rfc8853 Using Simulcast in SDP and RTP Sessions
+// a=simulcast:<direction> <alt-list>;<alt-list>... [<direction> <alt-list>...]
+// a=simulcast:send h;m;l
+// a=simulcast:send 1,2;~3 recv 4
+// ';'分隔不同的流，','分隔同一个流的可选rid，'~'前缀表示该流暂停
+#include <string>
+#include <vector>
+
+namespace mms {
+struct SimulcastAttr {
+public:
+    static std::string prefix;
+    SimulcastAttr() = default;
+    bool parse(const std::string & line);
+    std::string to_string() const;
+
+    // 每个流取第一个可选rid，忽略暂停标记，顺序与sdp中一致
+    std::vector<std::string> get_send_rids() const;
+    std::vector<std::string> get_recv_rids() const;
+
+    void set_send_streams(const std::vector<std::vector<std::string>> & streams) {
+        send_streams_ = streams;
+    }
+
+    void set_recv_streams(const std::vector<std::vector<std::string>> & streams) {
+        recv_streams_ = streams;
+    }
+public:
+    std::vector<std::vector<std::string>> send_streams_;
+    std::vector<std::vector<std::string>> recv_streams_;
+};
+};
@@ -0,0 +1,284 @@
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "ts_packer.hpp"
+#include "ts_header.hpp"
+#include "ts_pes.hpp"
+#include "ts_segment.hpp"
+#include "base/utils/utils.h"
+
+using namespace mms;
+
+TsPacker::TsPacker() {
+    init_pid_context(pat_, TsPidPAT);
+    init_pid_context(pmt_, TS_PMT_PID);
+    build_pat();
+    build_pmt();
+}
+
+void TsPacker::init_pid_context(PidContext & ctx, int16_t pid) {
+    ctx.pid = pid;
+    ctx.cc = 0;
+    ctx.header[0] = 0x47;
+    // transport_error_indicator(1b) = 0, payload_unit_start_indicator(1b) = 0, transport_priority(1b) = 0, pid(13b)
+    ctx.header[1] = (pid >> 8) & 0x1f;
+    ctx.header[2] = pid & 0xff;
+    // transport_scrambling_control(2b) = 00, adaptation_field_control(2b) = payload only, continuity_counter(4b) = 0
+    ctx.header[3] = TsAdapationControlPayloadOnly << 4;
+}
+
+void TsPacker::set_video_stream(TsStream type, int16_t pid) {
+    if (video_.pid == pid && video_.type == type) {
+        return;
+    }
+    init_pid_context(video_, pid);
+    video_.type = type;
+    pcr_pid_ = video_.pid;
+    build_pmt();
+}
+
+void TsPacker::set_audio_stream(TsStream type, int16_t pid) {
+    if (audio_.pid == pid && audio_.type == type) {
+        return;
+    }
+    init_pid_context(audio_, pid);
+    audio_.type = type;
+    if (!has_video()) {// 有视频时pcr放在视频上
+        pcr_pid_ = audio_.pid;
+    }
+    build_pmt();
+}
+
+void TsPacker::build_pat() {
+    uint8_t *buf = pat_buf_;
+    memcpy(buf, pat_.header, 4);
+    buf[1] |= 0x40;// payload_unit_start_indicator
+    buf += 4;
+    // pointer_field
+    *buf++ = 0;
+    uint8_t *pat_start = buf;
+    *buf++ = TsPsiTableIdPas;
+    // section_syntax_indicator(1b) = 1, '0', reserved(2b) = 11, section_length(12b)
+    // transport_stream_id(2B) + version/current_next_indicator(1B) + section_number(1B) + last_section_number(1B) + program(4B) + crc(4B)
+    int16_t section_len = 5 + 4 + 4;
+    *((uint16_t *)buf) = htons(0xb000 | (section_len & 0x0fff));
+    buf += 2;
+    *((uint16_t *)buf) = htons(0x0001);// transport_stream_id
+    buf += 2;
+    // reserved(2b) = 11, version_number(5b) = 0, current_next_indicator(1b) = 1
+    *buf++ = 0xc1;
+    *buf++ = 0;// section_number
+    *buf++ = 0;// last_section_number
+    // program_number(16b), reserved(3b), program_map_PID(13b)
+    uint32_t v32 = (TS_PMT_PID & 0x1FFF) | (0x07 << 13) | ((TS_PMT_NUMBER << 16) & 0xFFFF0000);
+    *((uint32_t *)buf) = htonl(v32);
+    buf += 4;
+    uint32_t crc32 = Utils::calc_mpeg_ts_crc32(pat_start, buf - pat_start);
+    *(uint32_t *)buf = htonl(crc32);
+    buf += 4;
+    memset(buf, 0xff, pat_buf_ + 188 - buf);
+}
+
+void TsPacker::build_pmt() {
+    uint8_t *buf = pmt_buf_;
+    memcpy(buf, pmt_.header, 4);
+    buf[1] |= 0x40;// payload_unit_start_indicator
+    buf += 4;
+    // pointer_field
+    *buf++ = 0;
+    uint8_t *pmt_start = buf;
+    *buf++ = TsPsiTableIdPms;
+    // program_number(2B) + version/current_next_indicator(1B) + section_number(1B) + last_section_number(1B) + PCR_PID(2B) + program_info_length(2B) + crc(4B)
+    // 每个流5字节
+    int16_t section_len = 5 + 4 + 4;
+    if (has_video()) {
+        section_len += 5;
+    }
+
+    if (has_audio()) {
+        section_len += 5;
+    }
+    *((uint16_t *)buf) = htons(0xb000 | (section_len & 0x0fff));
+    buf += 2;
+    *((uint16_t *)buf) = htons(TS_PMT_NUMBER);// program number
+    buf += 2;
+    *buf++ = 0xc1;
+    *buf++ = 0;// section_number
+    *buf++ = 0;// last_section_number
+    // reserved(3b), PCR_PID(13b)
+    *((uint16_t *)buf) = htons(0xe000 | (pcr_pid_ & 0x1fff));
+    buf += 2;
+    // reserved(4b), program_info_length(12b) = 0
+    *((uint16_t *)buf) = htons(0xf000);
+    buf += 2;
+    // stream_type(8b), reserved(3b), elementary_PID(13b), reserved(4b), ES_info_length(12b) = 0
+    for (auto ctx : {&audio_, &video_}) {
+        if (ctx->pid == -1) {
+            continue;
+        }
+        *buf++ = ctx->type;
+        *((uint16_t *)buf) = htons(0xe000 | (ctx->pid & 0x1fff));
+        buf += 2;
+        *((uint16_t *)buf) = htons(0xf000);
+        buf += 2;
+    }
+
+    uint32_t crc32 = Utils::calc_mpeg_ts_crc32(pmt_start, buf - pmt_start);
+    *(uint32_t *)buf = htonl(crc32);
+    buf += 4;
+    memset(buf, 0xff, pmt_buf_ + 188 - buf);
+}
+
+void TsPacker::write_psi(std::shared_ptr<TsSegment> ts_seg, PidContext & ctx, const uint8_t *psi) {
+    std::string_view ts = ts_seg->alloc_ts_packet();
+    uint8_t *buf = (uint8_t *)ts.data();
+    memcpy(buf, psi, 188);
+    buf[3] |= ctx.cc & 0x0f;
+    ctx.cc++;
+}
+
+void TsPacker::write_pat_pmt(std::shared_ptr<TsSegment> ts_seg) {
+    write_psi(ts_seg, pat_, pat_buf_);
+    write_psi(ts_seg, pmt_, pmt_buf_);
+}
+
+std::shared_ptr<PESPacket> TsPacker::create_pes(TsPESStreamId stream_id, const std::vector<std::string_view> & es_segs, int64_t dts, int64_t pts) {
+    auto pes_packet = std::make_shared<PESPacket>();
+    auto & pes_header = pes_packet->pes_header;
+    memset((void *)&pes_header, 0, sizeof(pes_header));
+
+    size_t es_len = 0;
+    for (auto & seg : es_segs) {
+        es_len += seg.size();
+    }
+    // dts == pts时，只需要pts
+    uint8_t PTS_DTS_flags = (dts == pts) ? 0x02 : 0x03;
+    uint8_t PES_header_data_length = (PTS_DTS_flags == 0x02) ? 5 : 10;
+    size_t pes_header_len = 9 + PES_header_data_length;
+    pes_packet->alloc_buf(pes_header_len + es_len);
+
+    uint8_t *pes = (uint8_t *)pes_packet->get_unuse_data().data();
+    // packet_start_code_prefix
+    *pes++ = 0x00;
+    *pes++ = 0x00;
+    *pes++ = 0x01;
+    *pes++ = stream_id;
+    uint32_t PES_packet_length_tmp = 3 + PES_header_data_length + es_len;
+    uint16_t PES_packet_length = PES_packet_length_tmp > 0xffff ? 0 : PES_packet_length_tmp;
+    *((uint16_t *)pes) = htons(PES_packet_length);
+    pes += 2;
+    // '10', PES_scrambling_control, PES_priority, data_alignment_indicator, copyright, original_or_copy
+    *pes++ = 0x80;
+    // PTS_DTS_flags, ESCR_flag, ES_rate_flag, DSM_trick_mode_flag, additional_copy_info_flag, PES_CRC_flag, PES_extension_flag
+    *pes++ = PTS_DTS_flags << 6;
+    *pes++ = PES_header_data_length;
+
+    auto write_timestamp = [&pes](uint8_t prefix, uint64_t v) {
+        *pes++ = (prefix << 4) | (((v >> 30) & 0x07) << 1) | 1;
+        uint16_t val = (((v >> 15) & 0x7fff) << 1) | 1;
+        *pes++ = val >> 8;
+        *pes++ = val;
+        val = ((v & 0x7fff) << 1) | 1;
+        *pes++ = val >> 8;
+        *pes++ = val;
+    };
+
+    pes_header.pts = pts * 90;
+    pes_header.dts = dts * 90;
+    if (PTS_DTS_flags == 0x02) {
+        write_timestamp(0x02, pes_header.pts);
+    } else {
+        write_timestamp(0x03, pes_header.pts);
+        write_timestamp(0x01, pes_header.dts);
+    }
+    pes_packet->inc_used_bytes(pes_header_len);
+
+    for (auto & seg : es_segs) {
+        memcpy((void *)pes_packet->get_unuse_data().data(), seg.data(), seg.size());
+        pes_packet->inc_used_bytes(seg.size());
+    }
+
+    pes_header.stream_id = stream_id;
+    pes_header.PES_packet_length = PES_packet_length;
+    pes_header.PTS_DTS_flags = PTS_DTS_flags;
+    pes_header.PES_header_data_length = PES_header_data_length;
+    return pes_packet;
+}
+
+void TsPacker::write_pes(std::shared_ptr<TsSegment> ts_seg, PidContext & ctx, std::shared_ptr<PESPacket> pes_packet, bool write_pcr) {
+    pes_packet->ts_index = ts_seg->get_curr_ts_chunk_index();
+    pes_packet->ts_off = ts_seg->get_curr_ts_chunk_offset();
+    pes_packet->ts_seg = ts_seg;
+
+    auto pes = pes_packet->get_using_data();
+    const uint8_t *data = (const uint8_t *)pes.data();
+    int32_t left = pes.size();
+    bool first = true;
+    int32_t ts_total_bytes = 0;
+    while (left > 0) {
+        std::string_view ts = ts_seg->alloc_ts_packet();
+        ts_total_bytes += 188;
+        uint8_t *buf = (uint8_t *)ts.data();
+        memcpy(buf, ctx.header, 4);
+        if (first) {
+            buf[1] |= 0x40;// payload_unit_start_indicator
+        }
+
+        // adaptation field的总长度，包括adaptation_field_length自己的1字节
+        int32_t af_total = 0;
+        bool pcr = first && write_pcr;
+        if (pcr) {
+            af_total = 8;// adaptation_field_length(1) + flags(1) + PCR(6)
+        }
+
+        if (left < 184 - af_total) {// 最后一个ts包不足，用adaptation field填充
+            af_total = 184 - left;
+        }
+
+        uint8_t *p = buf + 4;
+        if (af_total > 0) {
+            buf[3] = (TsAdapationControlBoth << 4) | (ctx.cc & 0x0f);
+            *p++ = af_total - 1;
+            if (af_total > 1) {
+                *p++ = pcr ? 0x10 : 0x00;// PCR_flag
+                if (pcr) {
+                    // program_clock_reference_base(33b), reserved(6b), program_clock_reference_extension(9b) = 0
+                    uint64_t pcr_base = pes_packet->pes_header.dts;
+                    *p++ = pcr_base >> 25;
+                    *p++ = pcr_base >> 17;
+                    *p++ = pcr_base >> 9;
+                    *p++ = pcr_base >> 1;
+                    *p++ = ((pcr_base & 0x01) << 7) | 0x7e;
+                    *p++ = 0x00;
+                }
+                memset(p, 0xff, buf + 4 + af_total - p);
+                p = buf + 4 + af_total;
+            }
+        } else {
+            buf[3] |= ctx.cc & 0x0f;
+        }
+        ctx.cc++;
+
+        int32_t payload_len = 184 - af_total;
+        memcpy(p, data, payload_len);
+        data += payload_len;
+        left -= payload_len;
+        first = false;
+    }
+    pes_packet->ts_bytes = ts_total_bytes;
+}
+
+std::shared_ptr<PESPacket> TsPacker::pack_video(std::shared_ptr<TsSegment> ts_seg, const std::vector<std::string_view> & es_segs, 
+                                                int64_t dts, int64_t pts, bool is_key) {
+    auto pes_packet = create_pes(TsPESStreamIdVideoCommon, es_segs, dts, pts);
+    pes_packet->is_key = is_key;
+    write_pes(ts_seg, video_, pes_packet, pcr_pid_ == video_.pid && is_key);
+    return pes_packet;
+}
+
+std::shared_ptr<PESPacket> TsPacker::pack_audio(std::shared_ptr<TsSegment> ts_seg, const std::vector<std::string_view> & es_segs, int64_t pts) {
+    auto pes_packet = create_pes(TsPESStreamIdAudioCommon, es_segs, pts, pts);
+    // 纯音频流，pcr放在音频上
+    write_pes(ts_seg, audio_, pes_packet, pcr_pid_ == audio_.pid);
+    return pes_packet;
+}
@@ -1,6 +1,57 @@
 #pragma once
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+#include "ts_pat_pmt.hpp"
+
 namespace mms {
+class TsSegment;
+struct PESPacket;
+// 通用ts封装，rtmp/flv/rtsp/webrtc转ts共用
+// 输入为与编码无关的es数据(如annexb格式的nalu，带adts头的aac)，由调用方组织好，可以分成多段不连续的内存
 class TsPacker {
+public:
+    TsPacker();
+    virtual ~TsPacker() = default;
+public:
+    void set_video_stream(TsStream type, int16_t pid);
+    void set_audio_stream(TsStream type, int16_t pid);
+    bool has_video() const {
+        return video_.pid != -1;
+    }
 
+    bool has_audio() const {
+        return audio_.pid != -1;
+    }
+    // 新切片开始时写入pat，pmt
+    void write_pat_pmt(std::shared_ptr<TsSegment> ts_seg);
+    // 时间戳单位ms，返回的pes记录了其在ts切片中的位置
+    std::shared_ptr<PESPacket> pack_video(std::shared_ptr<TsSegment> ts_seg, const std::vector<std::string_view> & es_segs, 
+                                          int64_t dts, int64_t pts, bool is_key);
+    std::shared_ptr<PESPacket> pack_audio(std::shared_ptr<TsSegment> ts_seg, const std::vector<std::string_view> & es_segs, int64_t pts);
+private:
+    struct PidContext {
+        int16_t pid = -1;
+        TsStream type = TsStreamReserved;
+        uint8_t cc = 0;
+        uint8_t header[4];// 预先生成的ts头，写入时只需要修改payload_unit_start_indicator，adaptation_field_control及continuity_counter
+    };
+    void init_pid_context(PidContext & ctx, int16_t pid);
+    void build_pat();
+    void build_pmt();
+    void write_psi(std::shared_ptr<TsSegment> ts_seg, PidContext & ctx, const uint8_t *psi);
+    std::shared_ptr<PESPacket> create_pes(TsPESStreamId stream_id, const std::vector<std::string_view> & es_segs, int64_t dts, int64_t pts);
+    void write_pes(std::shared_ptr<TsSegment> ts_seg, PidContext & ctx, std::shared_ptr<PESPacket> pes_packet, bool write_pcr);
+private:
+    PidContext pat_;
+    PidContext pmt_;
+    PidContext video_;
+    PidContext audio_;
+    int16_t pcr_pid_ = -1;
+    // pat及pmt内容固定，流信息变化时才重新生成
+    uint8_t pat_buf_[188];
+    uint8_t pmt_buf_[188];
+};
 };
-};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <string>
 #include <string_view>
 #include <memory>
+#include <algorithm>
 #include "string.h"
 
 #include "ts_segment.hpp"
@@ -8,7 +9,7 @@
 using namespace mms;
 
 TsSegment::TsSegment() {
-    ts_chunks_.emplace_back(std::move(std::make_unique<uint8_t[]>(SINGLE_TS_BYTES)));
+    ts_chunks_.emplace_back(BlockPool::get_instance().alloc());
     ts_chunk_index_ = 0;
 }
 
@@ -101,6 +102,7 @@ int32_t TsSegment::get_curr_ts_chunk_index() {
 
 std::vector<boost::asio::const_buffer> TsSegment::get_ts_seg(size_t chunk_index, size_t chunk_off, int32_t bytes) {
     std::vector<boost::asio::const_buffer> bufs;
+    std::shared_lock<std::shared_mutex> lck(chunks_mtx_);
     while (bytes > 0) {
         int32_t ts_seg_left = SINGLE_TS_BYTES - chunk_off;
         if (ts_seg_left > bytes) {
@@ -120,7 +122,8 @@ std::vector<boost::asio::const_buffer> TsSegment::get_ts_seg(size_t chunk_index,
 
 std::string_view TsSegment::alloc_ts_packet() {
     if (ts_chunk_off_ >= SINGLE_TS_BYTES) {
-        auto new_ts_buf = std::make_unique<uint8_t[]>(SINGLE_TS_BYTES);
+        auto new_ts_buf = BlockPool::get_instance().alloc();
+        std::unique_lock<std::shared_mutex> lck(chunks_mtx_);
         ts_chunks_.push_back(std::move(new_ts_buf));
         ts_chunk_index_++;
         ts_chunk_off_ = 0;
@@ -134,6 +137,7 @@ std::string_view TsSegment::alloc_ts_packet() {
 
 std::vector<std::string_view> TsSegment::get_ts_data() {
     std::vector<std::string_view> vs;
+    std::shared_lock<std::shared_mutex> lck(chunks_mtx_);
     for (auto it = ts_chunks_.begin(); it != ts_chunks_.end(); it++) {
         if ((it + 1) == ts_chunks_.end()) {
             vs.push_back(std::string_view((char*)(*it).get(), ts_chunk_off_));
@@ -147,4 +151,82 @@ std::vector<std::string_view> TsSegment::get_ts_data() {
 
 int64_t TsSegment::get_ts_bytes() {
     return total_ts_bytes_;
-}
\ No newline at end of file
+}
+
+void TsSegment::set_reaped() {
+    // 最后一个part的时长按上一帧间隔估算
+    if (part_start_ts_ != -1 && last_ts_ != -1) {
+        reap_part(last_ts_ + std::max<int64_t>(last_frame_interval_, 0));
+    }
+    is_reaped_ = true;
+}
+
+void TsSegment::update_part(int64_t timestamp, bool is_key) {
+    if (part_start_ts_ == -1) {
+        part_start_ts_ = timestamp;
+        part_independent_ = is_key;
+    }
+
+    if (last_ts_ != -1 && timestamp > last_ts_) {
+        last_frame_interval_ = timestamp - last_ts_;
+    }
+    last_ts_ = timestamp;
+}
+
+int64_t TsSegment::get_part_duration(int64_t timestamp) {
+    if (part_start_ts_ == -1) {
+        return 0;
+    }
+    return timestamp - part_start_ts_;
+}
+
+int64_t TsSegment::get_frame_interval(int64_t timestamp) {
+    if (last_ts_ == -1 || timestamp < last_ts_) {
+        return 0;
+    }
+    return timestamp - last_ts_;
+}
+
+void TsSegment::reap_part(int64_t timestamp) {
+    if (part_start_ts_ == -1 || total_ts_bytes_ <= part_start_bytes_) {
+        return;
+    }
+
+    TsPart part;
+    part.offset = part_start_bytes_;
+    part.bytes = total_ts_bytes_ - part_start_bytes_;
+    part.duration = std::max<int64_t>(timestamp - part_start_ts_, 0);
+    // 纯音频流，每个part都可以独立解码
+    part.independent = part_independent_ || !has_video();
+    {
+        std::unique_lock<std::shared_mutex> lck(chunks_mtx_);
+        parts_.push_back(part);
+    }
+    part_start_bytes_ = total_ts_bytes_;
+    part_start_ts_ = -1;
+    part_independent_ = false;
+}
+
+std::vector<TsPart> TsSegment::get_parts() {
+    std::shared_lock<std::shared_mutex> lck(chunks_mtx_);
+    return parts_;
+}
+
+size_t TsSegment::get_part_count() {
+    std::shared_lock<std::shared_mutex> lck(chunks_mtx_);
+    return parts_.size();
+}
+
+bool TsSegment::get_part_data(size_t index, std::vector<boost::asio::const_buffer> & bufs) {
+    TsPart part;
+    {
+        std::shared_lock<std::shared_mutex> lck(chunks_mtx_);
+        if (index >= parts_.size()) {
+            return false;
+        }
+        part = parts_[index];
+    }
+
+    bufs = get_ts_seg(part.offset / SINGLE_TS_BYTES, part.offset % SINGLE_TS_BYTES, part.bytes);
+    return true;
+}
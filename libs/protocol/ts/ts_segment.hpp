@@ -2,10 +2,22 @@
 #include <string>
 #include <string_view>
 #include <memory>
+#include <vector>
+#include <shared_mutex>
 #include <boost/asio/buffer.hpp>
 
 #include "base/utils/utils.h"
+#include "base/block_pool.h"
 namespace mms {
+class HttpCachedResponse;
+// ll-hls的partial segment，只记录在切片中的位置，数据不拷贝
+struct TsPart {
+    int64_t offset = 0;
+    int64_t bytes = 0;
+    int64_t duration = 0;
+    bool independent = false;
+};
+
 class TsSegment {
 public:
     TsSegment();
@@ -46,13 +58,29 @@ public:
     std::vector<std::string_view> get_ts_data();
     std::vector<boost::asio::const_buffer> get_ts_seg(size_t chunk_index, size_t chunk_off, int32_t bytes);
     int64_t get_ts_bytes();
-    void set_reaped() {
-        is_reaped_ = true;
-    }
+    void set_reaped();
+
+    // partial segment相关
+    void update_part(int64_t timestamp, bool is_key);
+    int64_t get_part_duration(int64_t timestamp);
+    int64_t get_frame_interval(int64_t timestamp);
+    void reap_part(int64_t timestamp);
+    std::vector<TsPart> get_parts();
+    size_t get_part_count();
+    bool get_part_data(size_t index, std::vector<boost::asio::const_buffer> & bufs);
 
     inline bool is_reaped() {
         return is_reaped_;
     }
+
+    // 切片完成后设置，之后不再修改
+    void set_http_response(std::shared_ptr<const HttpCachedResponse> resp) {
+        http_resp_ = resp;
+    }
+
+    std::shared_ptr<const HttpCachedResponse> get_http_response() {
+        return http_resp_;
+    }
 private:
     int64_t create_at_ = Utils::get_current_ms();
     int64_t start_dts_video_ = -1;
@@ -66,12 +94,24 @@ private:
     std::string filename_;
     int64_t seq_ = 0;
 
-    std::vector<std::unique_ptr<uint8_t[]>> ts_chunks_;
+    std::shared_mutex chunks_mtx_;
+    // ts数据块从BlockPool分配，切片释放后归还到池中
+    std::vector<std::shared_ptr<uint8_t[]>> ts_chunks_;
     int32_t ts_chunk_index_ = 0;
     size_t ts_chunk_off_ = 0;
     int64_t total_ts_bytes_ = 0;
     bool is_reaped_  = false;
 
-    constexpr static int SINGLE_TS_BYTES = 188*4096; 
+    std::vector<TsPart> parts_;
+    int64_t part_start_bytes_ = 0;
+    int64_t part_start_ts_ = -1;
+    int64_t last_ts_ = -1;
+    int64_t last_frame_interval_ = 0;
+    bool part_independent_ = false;
+
+    std::shared_ptr<const HttpCachedResponse> http_resp_;
+
+    // 每个数据块存放整数个ts包
+    constexpr static int SINGLE_TS_BYTES = 188*(BlockPool::BLOCK_SIZE/188);
 };
 };
\ No newline at end of file
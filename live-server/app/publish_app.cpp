@@ -20,6 +20,7 @@
 #include "core/flv_media_source.hpp"
 #include "core/rtmp_media_source.hpp"
 #include "core/rtmp_media_sink.hpp"
+#include "bridge/media_bridge.hpp"
 
 #include "config/auth/auth_config.h"
 
@@ -126,6 +127,71 @@ std::vector<std::shared_ptr<MediaSink>> PublishApp::create_push_streams(std::sha
     return sinks;
 }
 
+void PublishApp::prewarm_bridges(std::shared_ptr<MediaSource> source) {
+    // 回源拉取的流由播放者触发，预热会使拉流一直保持，只对源流预热
+    if (!source->is_origin()) {
+        return;
+    }
+
+    auto & prewarm = app_conf_->bridge_config().prewarm();
+    if (prewarm.empty()) {
+        return;
+    }
+
+    int64_t used_bytes = get_prewarm_bytes();
+    if (used_bytes >= app_conf_->bridge_config().prewarm_mem_budget()) {
+        CORE_WARN("prewarm segment memory:{} exceeds budget, skip prewarm for {}/{}/{}", used_bytes,
+                  get_domain_name(), get_app_name(), source->get_stream_name());
+        return;
+    }
+
+    auto self = std::static_pointer_cast<PublishApp>(shared_from_this());
+    const auto & stream_name = source->get_stream_name();
+    const auto & media_type = source->get_media_type();
+    for (auto & t : prewarm) {
+        std::shared_ptr<MediaBridge> bridge;
+        if (t == "hls" || t == "dash") {// 先转切片，再生成m3u8/mpd
+            bool m4s = t == "dash" || app_conf_->hls_config().cmaf_enabled();
+            auto seg_bridge = source->get_or_create_bridge(media_type + (m4s ? "-m4s" : "-ts"), self, stream_name);
+            if (seg_bridge) {
+                auto seg_source = seg_bridge->get_media_source();
+                bridge = seg_source->get_or_create_bridge(seg_source->get_media_type() + (t == "hls" ? "-hls" : "-mpd"), self, stream_name);
+            }
+        } else {
+            bridge = source->get_or_create_bridge(media_type + "-" + t, self, stream_name);
+        }
+
+        if (!bridge) {
+            CORE_WARN("prewarm {} for {}/{}/{} failed", t, get_domain_name(), get_app_name(), stream_name);
+            continue;
+        }
+
+        auto bridge_source = bridge->get_media_source();
+        bridge_source->set_source_info(get_domain_name(), get_app_name(), stream_name);
+        bridge_source->set_prewarmed(true);
+        {
+            std::lock_guard<std::mutex> lck(prewarm_sources_mtx_);
+            prewarm_sources_.push_back(bridge_source);
+        }
+        CORE_DEBUG("prewarm {} for {}/{}/{} ok", t, get_domain_name(), get_app_name(), stream_name);
+    }
+}
+
+int64_t PublishApp::get_prewarm_bytes() {
+    int64_t bytes = 0;
+    std::lock_guard<std::mutex> lck(prewarm_sources_mtx_);
+    for (auto it = prewarm_sources_.begin(); it != prewarm_sources_.end();) {
+        auto source = it->lock();
+        if (!source) {// 桥已拆除
+            it = prewarm_sources_.erase(it);
+            continue;
+        }
+        bytes += source->get_cached_bytes();
+        it++;
+    }
+    return bytes;
+}
+
 boost::asio::awaitable<Error> PublishApp::on_publish(std::shared_ptr<StreamSession> session) {
     auto err = publish_auth_check(session);
     if (ERROR_SUCCESS != err.code) {
@@ -370,6 +436,23 @@ bool PublishApp::can_reap_ts(bool is_key, std::shared_ptr<TsSegment> ts_seg) {
     return false;
 }
 
+bool PublishApp::ll_hls_enabled() {
+    return app_conf_->hls_config().ll_hls_enabled();
+}
+
+bool PublishApp::can_reap_ts_part(std::shared_ptr<TsSegment> ts_seg, int64_t timestamp) {
+    if (!ll_hls_enabled()) {
+        return false;
+    }
+
+    auto part_dur = ts_seg->get_part_duration(timestamp);
+    if (part_dur <= 0) {
+        return false;
+    }
+    // 再加一帧就会超过目标时长，则在这里切part，保证part时长不超过PART-TARGET
+    return part_dur + ts_seg->get_frame_interval(timestamp) > app_conf_->hls_config().ts_part_target_dur();
+}
+
 bool PublishApp::can_reap_mp4(bool is_key, int64_t duration, int64_t bytes) {
     if ((duration >= app_conf_->get_fmp4_min_seg_dur() && is_key)|| 
         duration >= app_conf_->get_fmp4_max_seg_dur()) {
@@ -11,6 +11,8 @@
 #include <string>
 #include <memory>
 #include <atomic>
+#include <mutex>
+#include <vector>
 #include <boost/asio/awaitable.hpp>
 
 #include "core/media_source_finder.h"
@@ -42,6 +44,10 @@ public:
                              
     boost::asio::awaitable<std::shared_ptr<MediaSource>> find_media_source(std::shared_ptr<StreamSession> session) override;
     std::vector<std::shared_ptr<MediaSink>> create_push_streams(std::shared_ptr<MediaSource> source, std::shared_ptr<StreamSession> session);
+    // 按bridge配置的prewarm列表提前创建桥，在源流就绪时调用
+    void prewarm_bridges(std::shared_ptr<MediaSource> source);
+    // 本应用预热的桥当前持有的切片字节数之和，与prewarm_mem_budget比较
+    int64_t get_prewarm_bytes();
 
     virtual boost::asio::awaitable<Error> on_publish(std::shared_ptr<StreamSession> session);
     virtual boost::asio::awaitable<Error> on_unpublish(std::shared_ptr<StreamSession> session);
@@ -52,10 +58,15 @@ public:
                                    std::shared_ptr<MediaSource> source);
 
     virtual bool can_reap_ts(bool is_key, std::shared_ptr<TsSegment> ts_seg);
+    virtual bool ll_hls_enabled();
+    virtual bool can_reap_ts_part(std::shared_ptr<TsSegment> ts_seg, int64_t timestamp);
     virtual bool can_reap_mp4(bool is_key, int64_t duration, int64_t seg_bytes);
 private:
     Error publish_auth_check(std::shared_ptr<StreamSession> session);
     boost::asio::awaitable<Error> invoke_on_publish_http_callback(const HttpCallbackConfig & conf, std::shared_ptr<StreamSession> session);
     boost::asio::awaitable<Error> invoke_on_unpublish_http_callback(const HttpCallbackConfig & conf, std::shared_ptr<StreamSession> session);
+private:
+    std::mutex prewarm_sources_mtx_;
+    std::vector<std::weak_ptr<MediaSource>> prewarm_sources_;
 };
 };
\ No newline at end of file
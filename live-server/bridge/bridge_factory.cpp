@@ -7,6 +7,11 @@
  * @FilePath: \mms\mms\server\transcode\bridge_factory.cpp
  * Copyright (c) 2023 by jbl19860422@gitee.com, All Rights Reserved. 
  */
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <chrono>
+
 #include "log/log.h"
 #include "bridge_factory.hpp"
 #include "base/thread/thread_worker.hpp"
@@ -31,11 +36,24 @@
 
 #include "ts/ts_to_hls.hpp"
 #include "mp4/m4s_to_mpd.hpp"
+#include "mp4/m4s_to_hls.hpp"
 
 #include "app/publish_app.h"
 #include "config/app_config.h"
 
 using namespace mms;
+namespace {
+std::mutex create_stats_mtx;
+std::unordered_map<std::string, uint64_t> create_total;
+std::deque<std::pair<int64_t, std::string>> recent_creates;// 最近一分钟内的创建记录
+
+void prune_recent_creates(int64_t now_ms) {
+    while (!recent_creates.empty() && now_ms - recent_creates.front().first > 60000) {
+        recent_creates.pop_front();
+    }
+}
+};
+
 std::shared_ptr<MediaBridge> BridgeFactory::create_bridge(ThreadWorker *worker, 
                                                          const std::string & id, 
                                                          std::shared_ptr<PublishApp> app,
@@ -44,18 +62,55 @@ std::shared_ptr<MediaBridge> BridgeFactory::create_bridge(ThreadWorker *worker,
                                                          const std::string & app_name, 
                                                          const std::string & stream_name) {
     CORE_INFO("create bridge:{}", id);                                    
+    auto bridge = new_bridge(worker, id, app, origin_source, domain_name, app_name, stream_name);
+    if (bridge) {
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::lock_guard<std::mutex> lck(create_stats_mtx);
+        create_total[id]++;
+        recent_creates.emplace_back(now_ms, id);
+        prune_recent_creates(now_ms);
+    }
+    return bridge;
+}
+
+Json::Value BridgeFactory::get_create_stats() {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lck(create_stats_mtx);
+    prune_recent_creates(now_ms);
+    Json::Value v;
+    for (auto & p : create_total) {
+        v[p.first]["total"] = (Json::UInt64)p.second;
+        v[p.first]["last_minute"] = 0;
+    }
+
+    for (auto & p : recent_creates) {
+        v[p.second]["last_minute"] = v[p.second]["last_minute"].asUInt() + 1;
+    }
+    return v;
+}
+
+std::shared_ptr<MediaBridge> BridgeFactory::new_bridge(ThreadWorker *worker, 
+                                                      const std::string & id, 
+                                                      std::shared_ptr<PublishApp> app,
+                                                      std::weak_ptr<MediaSource> origin_source,
+                                                      const std::string & domain_name, 
+                                                      const std::string & app_name, 
+                                                      const std::string & stream_name) {
     if (id == "rtmp-flv" && app->get_conf()->bridge_config().rtmp_to_flv()) {
         return std::make_shared<RtmpToFlv>(worker, app, origin_source, domain_name, app_name, stream_name);
     } else if (id == "rtmp-rtsp{rtp[es]}" && app->get_conf()->bridge_config().rtmp_to_rtsp()) {
         return std::make_shared<RtmpToRtsp>(worker, app, origin_source, domain_name, app_name, stream_name);
     } else if (id == "rtmp-ts" && app->get_conf()->bridge_config().rtmp_to_hls()) {
         return std::make_shared<RtmpToTs>(worker, app, origin_source, domain_name, app_name, stream_name);
-    } else if (id == "rtmp-m4s" && app->get_conf()->bridge_config().rtmp_to_webrtc()) {
+    } else if (id == "rtmp-m4s" && (app->get_conf()->bridge_config().rtmp_to_webrtc() ||
+                                    (app->get_conf()->bridge_config().rtmp_to_hls() && app->get_conf()->hls_config().cmaf_enabled()))) {
         return std::make_shared<RtmpToM4s>(worker, app, origin_source, domain_name, app_name, stream_name);
     } else if (id == "rtmp-webrtc{rtp[es]}" && app->get_conf()->bridge_config().rtmp_to_webrtc()) {
         return std::make_shared<RtmpToWebRtc>(worker, app, origin_source, domain_name, app_name, stream_name);
     } else if (id == "m4s-mpd") {
         return std::make_shared<M4sToMpd>(worker, app, origin_source, domain_name, app_name, stream_name);
+    } else if (id == "m4s-hls" && app->get_conf()->hls_config().cmaf_enabled()) {
+        return std::make_shared<M4sToHls>(worker, app, origin_source, domain_name, app_name, stream_name);
     } else if (id == "ts-hls" && app->get_conf()->bridge_config().rtmp_to_hls()) {
         return std::make_shared<TsToHls>(worker, app, origin_source, domain_name, app_name, stream_name);
     } else if (id == "rtsp{rtp[es]}-flv" && app->get_conf()->bridge_config().rtsp_to_flv()) {
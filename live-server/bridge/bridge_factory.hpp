@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include "json/json.h"
 
 namespace mms {
 class MediaBridge;
@@ -17,5 +18,15 @@ public:
                                                      const std::string & domain_name, 
                                                      const std::string & app_name, 
                                                      const std::string & stream_name); 
+    // 桥的创建次数统计(总数及最近一分钟)，观众进出频繁导致桥反复创建/销毁时可以从这里看出来
+    static Json::Value get_create_stats();
+private:
+    static std::shared_ptr<MediaBridge> new_bridge(ThreadWorker *worker, 
+                                                   const std::string & id, 
+                                                   std::shared_ptr<PublishApp> app,
+                                                   std::weak_ptr<MediaSource> origin_source,
+                                                   const std::string & domain_name, 
+                                                   const std::string & app_name, 
+                                                   const std::string & stream_name); 
 };
 };
\ No newline at end of file
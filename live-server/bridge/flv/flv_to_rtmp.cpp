@@ -50,7 +50,7 @@ bool FlvToRtmp::init() {
                     break;
                 }
 
-                if (rtmp_media_source_->has_no_sinks_for_time(
+                if (rtmp_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经10秒没人播放了
                     CORE_DEBUG("close FlvToRtmp because no players for 10s");
                     break;
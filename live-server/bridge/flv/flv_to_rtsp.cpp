@@ -12,6 +12,7 @@
 #include "codec/aac/adts.hpp"
 #include "codec/aac/mpeg4_aac.hpp"
 #include "codec/h264/h264_codec.hpp"
+#include "codec/media_frame.hpp"
 #include "codec/hevc/hevc_codec.hpp"
 #include "codec/mp3/mp3_codec.hpp"
 #include "config/app_config.h"
@@ -59,7 +60,7 @@ bool FlvToRtsp::init() {
                     break;
                 }
 
-                if (rtsp_media_source_->has_no_sinks_for_time(
+                if (rtsp_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     spdlog::debug("close FlvToRtsp because no players for 30s");
                     break;
@@ -374,33 +375,7 @@ boost::asio::awaitable<bool> FlvToRtsp::process_h265_packet(std::shared_ptr<FlvT
 }
 
 int32_t FlvToRtsp::get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> &nalus) {
-    uint8_t *data_start = data;
-    while (len > 0) {
-        int32_t nalu_len = 0;
-        if (len < nalu_length_size_) {
-            return -1;
-        }
-
-        if (nalu_length_size_ == 1) {
-            nalu_len = *data;
-        } else if (nalu_length_size_ == 2) {
-            nalu_len = ntohs((*(uint16_t *)data));
-        } else if (nalu_length_size_ == 4) {
-            nalu_len = ntohl(*(uint32_t *)data);
-        }
-
-        data += nalu_length_size_;
-        len -= nalu_length_size_;
-
-        if (len < nalu_len) {
-            return -2;
-        }
-
-        nalus.emplace_back(std::string_view((char *)data, nalu_len));
-        data += nalu_len;
-        len -= nalu_len;
-    }
-    return data - data_start;
+    return split_nalus(data, len, nalu_length_size_, nalus);
 }
 
 boost::asio::awaitable<bool> FlvToRtsp::process_aac_packet(std::shared_ptr<FlvTag> audio_pkt) {
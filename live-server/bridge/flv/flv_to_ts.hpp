@@ -19,6 +19,7 @@
 #include "core/rtmp_media_sink.hpp"
 #include "core/ts_media_source.hpp"
 #include "protocol/ts/ts_pat_pmt.hpp"
+#include "protocol/ts/ts_packer.hpp"
 #include "base/wait_group.h"
 #include "../rtmp/rtmp_to_ts.hpp"
 #include "base/obj_tracker.hpp"
@@ -40,6 +41,8 @@ public:
     bool on_video_packet(std::shared_ptr<FlvTag> video_pkt);
     bool on_audio_packet(std::shared_ptr<FlvTag> audio_pkt);
     void on_ts_segment(std::shared_ptr<TsSegment> ts_seg);
+    void reap_ts_part(int64_t timestamp, bool is_key);
+    void flush_audio_pes();
     void close() override;
 private:
     bool process_h264_packet(std::shared_ptr<FlvTag> video_pkt);
@@ -62,25 +65,13 @@ private:
     std::shared_ptr<Codec> video_codec_;
     std::shared_ptr<Codec> audio_codec_;
     int32_t nalu_length_size_ = 4;    
-    
-    int16_t audio_pid_ = -1;
-    int16_t video_pid_ = -1;
-    int16_t PCR_PID = -1;
-    TsStream video_type_;
-    TsStream audio_type_;
-    void create_pat(std::string_view & pat_seg);
-    void create_pmt(std::string_view & pmt_seg);
-    void create_video_ts(std::shared_ptr<PESPacket> video_pkt, int32_t pes_len, bool is_key);
-    void create_audio_ts(std::shared_ptr<PESPacket> audio_pkt);
-    std::unordered_map<int16_t, uint8_t> continuity_counter_;
 
+    TsPacker ts_packer_;
     boost::asio::steady_timer check_closable_timer_;
-    char video_pes_header_[256];
     std::vector<std::string_view> video_pes_segs_;
 
     int32_t adts_header_index_ = 0;
     std::vector<AdtsHeader> adts_headers_;
-    char audio_pes_header_[256];
     AudioBuff<FlvTag> audio_buf_;
 
     WaitGroup wg_;
@@ -0,0 +1,31 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "../media_bridge.hpp"
+#include "base/wait_group.h"
+#include "base/obj_tracker.hpp"
+
+namespace mms {
+class PublishApp;
+class M4sMediaSink;
+class ThreadWorker;
+class HlsLiveMediaSource;
+
+class M4sToHls : public MediaBridge, public ObjTracker<M4sToHls> {
+public:
+    M4sToHls(ThreadWorker *worker, std::shared_ptr<PublishApp> app, std::weak_ptr<MediaSource> origin_source, const std::string & domain_name, const std::string & app_name, const std::string & stream_name);
+    virtual ~M4sToHls();
+    bool init() override;
+    void close() override;
+private:
+    std::shared_ptr<M4sMediaSink> mp4_media_sink_;
+    std::shared_ptr<HlsLiveMediaSource> hls_media_source_;
+
+    boost::asio::steady_timer check_closable_timer_;
+
+    WaitGroup wg_;
+};
+};
\ No newline at end of file
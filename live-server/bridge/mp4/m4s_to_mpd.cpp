@@ -56,7 +56,7 @@ bool M4sToMpd::init() {
                     break;
                 }
 
-                if (mpd_media_source_->has_no_sinks_for_time(
+                if (mpd_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     CORE_DEBUG("close M4sToMpd because no players for {}s",
                                app_conf->bridge_config().no_players_timeout_ms() / 1000);
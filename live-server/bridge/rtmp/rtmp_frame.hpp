@@ -0,0 +1,74 @@
+#pragma once
+#include <memory>
+#include <string_view>
+
+#include "protocol/rtmp/rtmp_define.hpp"
+#include "protocol/rtmp/flv/flv_tag.hpp"
+#include "codec/media_frame.hpp"
+
+namespace mms {
+// 获取视频消息解析后的帧，源已经解析好时直接使用，否则(如不经过源的消息)按标签头自行解析一次
+// 非序列头的h264/hevc帧同时切分好nalu，解析失败返回nullptr
+inline std::shared_ptr<MediaFrame> get_rtmp_video_frame(std::shared_ptr<RtmpMessage> video_pkt, int32_t nalu_length_size) {
+    if (video_pkt->frame_) {
+        return video_pkt->frame_;
+    }
+
+    VideoTagHeader header;
+    auto payload = video_pkt->get_using_data();
+    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
+    if (header_consumed <= 0) {
+        return nullptr;
+    }
+
+    auto frame = std::make_shared<MediaFrame>();
+    if (header.get_codec_id() == VideoTagHeader::AVC) {
+        frame->codec = CODEC_H264;
+    } else if (header.get_codec_id() == VideoTagHeader::HEVC || header.get_codec_id() == VideoTagHeader::HEVC_FOURCC) {
+        frame->codec = CODEC_HEVC;
+    } else {
+        return nullptr;
+    }
+    frame->is_video = true;
+    frame->is_seq_header = header.is_seq_header();
+    frame->is_key = header.is_key_frame() && !frame->is_seq_header;
+    frame->dts = video_pkt->timestamp_;
+    frame->pts = video_pkt->timestamp_ + header.get_cts();
+    frame->payload = std::string_view(payload.data() + header_consumed, payload.size() - header_consumed);
+    if (!frame->is_seq_header) {
+        if (nalu_length_size <= 0 || 
+            split_nalus((const uint8_t *)frame->payload.data(), frame->payload.size(), nalu_length_size, frame->nalus) < 0) {
+            return nullptr;
+        }
+    }
+    return frame;
+}
+
+// 获取音频消息解析后的帧，同上
+inline std::shared_ptr<MediaFrame> get_rtmp_audio_frame(std::shared_ptr<RtmpMessage> audio_pkt) {
+    if (audio_pkt->frame_) {
+        return audio_pkt->frame_;
+    }
+
+    AudioTagHeader header;
+    auto payload = audio_pkt->get_using_data();
+    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
+    if (header_consumed < 0) {
+        return nullptr;
+    }
+
+    auto frame = std::make_shared<MediaFrame>();
+    if (header.sound_format == AudioTagHeader::AAC) {
+        frame->codec = CODEC_AAC;
+        frame->is_seq_header = header.is_seq_header();
+    } else if (header.sound_format == AudioTagHeader::MP3) {
+        frame->codec = CODEC_MP3;
+    } else {
+        return nullptr;
+    }
+    frame->dts = audio_pkt->timestamp_;
+    frame->pts = audio_pkt->timestamp_;
+    frame->payload = std::string_view(payload.data() + header_consumed, payload.size() - header_consumed);
+    return frame;
+}
+};
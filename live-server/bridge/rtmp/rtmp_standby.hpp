@@ -0,0 +1,94 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+#include "core/media_source.hpp"
+#include "protocol/rtmp/rtmp_define.hpp"
+#include "protocol/rtmp/flv/flv_tag.hpp"
+
+namespace mms {
+// 桥的热备状态：没有观众时停止输出，但继续接收源数据，保持编解码状态并缓存最近一个GOP，
+// 观众重新加入后从缓存的GOP开始恢复输出，不用等待下一个关键帧
+class RtmpStandby {
+public:
+    // GOP过长(或纯音频流)时只保留最近的这些消息
+    static constexpr size_t MAX_CACHED_MSGS = 4096;
+
+    bool is_standby() const {
+        return standby_;
+    }
+
+    void enter() {
+        standby_ = true;
+        since_ms_ = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        gop_.clear();
+    }
+
+    // 进入热备后有新的加入，说明需要恢复输出
+    bool should_resume(std::shared_ptr<MediaSource> source) const {
+        return standby_ && source->get_last_join_time() >= since_ms_;
+    }
+
+    // 热备期间缓存消息，返回true表示这是元数据或序列头，仍需处理以保持编解码状态
+    bool cache(std::shared_ptr<RtmpMessage> msg) {
+        auto payload = msg->get_using_data();
+        if (msg->get_message_type() == RTMP_MESSAGE_TYPE_VIDEO) {
+            VideoTagHeader header;
+            if (header.decode((uint8_t *)payload.data(), payload.size()) < 0) {
+                return false;
+            }
+
+            if (header.is_seq_header()) {
+                return true;
+            }
+
+            has_video_ = true;
+            if (header.is_key_frame()) {
+                gop_.clear();
+            } else if (gop_.empty()) {// 没有关键帧开头的缓存没有意义
+                return false;
+            }
+        } else if (msg->get_message_type() == RTMP_MESSAGE_TYPE_AUDIO) {
+            AudioTagHeader header;
+            if (header.decode((uint8_t *)payload.data(), payload.size()) < 0) {
+                return false;
+            }
+
+            if (header.is_seq_header()) {
+                return true;
+            }
+
+            if (has_video_ && gop_.empty()) {
+                return false;
+            }
+        } else {
+            return true;
+        }
+
+        gop_.emplace_back(msg);
+        if (gop_.size() > MAX_CACHED_MSGS) {
+            if (has_video_) {// 超长的GOP不再缓存，等待下一个关键帧
+                gop_.clear();
+            } else {
+                gop_.pop_front();
+            }
+        }
+        return false;
+    }
+
+    // 退出热备，返回缓存的GOP，调用方按顺序重新处理
+    std::vector<std::shared_ptr<RtmpMessage>> resume() {
+        standby_ = false;
+        std::vector<std::shared_ptr<RtmpMessage>> msgs(gop_.begin(), gop_.end());
+        gop_.clear();
+        return msgs;
+    }
+private:
+    bool standby_ = false;
+    bool has_video_ = false;
+    int64_t since_ms_ = 0;
+    std::deque<std::shared_ptr<RtmpMessage>> gop_;
+};
+};
@@ -48,7 +48,7 @@ bool RtmpToFlv::init() {
                     break;
                 }
 
-                if (flv_media_source_->has_no_sinks_for_time(
+                if (flv_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经10秒没人播放了
                     CORE_DEBUG("close RtmpToFlv because no players for 10s");
                     close();
@@ -136,13 +136,6 @@ bool RtmpToFlv::on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
 
 bool RtmpToFlv::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     auto video_pkt_using_data = video_pkt->get_using_data();
-    VideoTagHeader header;
-    int32_t header_consumed =
-        header.decode((uint8_t *)video_pkt_using_data.data(), video_pkt_using_data.size());
-    if (header_consumed < 0) {
-        return false;
-    }
-
     std::shared_ptr<FlvTag> video_flv_tag =
         std::make_shared<FlvTag>(FLV_TAG_HEADER_BYTES + video_pkt_using_data.size());
 
@@ -151,9 +144,12 @@ bool RtmpToFlv::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     video_flv_tag->tag_header.tag_type = FlvTagHeader::VideoTag;
     video_flv_tag->tag_header.timestamp = video_pkt->timestamp_;
 
+    // flv标签原样转发，标签头只在这里解析一次
     auto video_data = std::make_unique<VIDEODATA>();
     video_data->payload = video_pkt_using_data;
-    video_data->decode((uint8_t *)video_pkt_using_data.data(), video_pkt_using_data.size());
+    if (video_data->decode((uint8_t *)video_pkt_using_data.data(), video_pkt_using_data.size()) <= 0) {
+        return false;
+    }
     video_flv_tag->tag_data = std::move(video_data);
 
     video_flv_tag->encode();
@@ -68,6 +68,7 @@
 #include "protocol/ts/ts_header.hpp"
 #include "protocol/ts/ts_pat_pmt.hpp"
 #include "protocol/ts/ts_segment.hpp"
+#include "rtmp_frame.hpp"
 
 
 using namespace mms;
@@ -108,7 +109,7 @@ bool RtmpToM4s::init() {
                     break;
                 }
 
-                if (mp4_media_source_->has_no_sinks_for_time(
+                if (mp4_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     CORE_DEBUG("close RtmpToM4s because no players for {}ms",
                                app_conf->bridge_config().no_players_timeout_ms());
@@ -191,13 +192,14 @@ bool RtmpToM4s::on_metadata(std::shared_ptr<RtmpMessage> metadata_pkt) {
 
 bool RtmpToM4s::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     if (!video_codec_) {
-        VideoTagHeader header;
-        auto payload = video_pkt->get_using_data();
-        header.decode((uint8_t *)payload.data(), payload.size());
-        if (header.get_codec_id() == VideoTagHeader::AVC) {
+        auto frame = get_rtmp_video_frame(video_pkt, nalu_length_size_);
+        if (!frame) {
+            return false;
+        }
+
+        if (frame->codec == CODEC_H264) {
             video_codec_ = std::make_shared<H264Codec>();
-        } else if (header.get_codec_id() == VideoTagHeader::HEVC ||
-                   header.get_codec_id() == VideoTagHeader::HEVC_FOURCC) {
+        } else if (frame->codec == CODEC_HEVC) {
             video_codec_ = std::make_shared<HevcCodec>();
         } else {
             return false;
@@ -214,21 +216,19 @@ bool RtmpToM4s::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
 }
 
 bool RtmpToM4s::process_h264_packet(std::shared_ptr<RtmpMessage> video_pkt) {
-    VideoTagHeader header;
-    auto payload = video_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_video_frame(video_pkt, nalu_length_size_);
+    if (!frame) {
         return false;
     }
 
     H264Codec *h264_codec = ((H264Codec *)video_codec_.get());
-    if (header.is_seq_header()) {  // 关键帧索引
+    if (frame->is_seq_header) {  // 关键帧索引
         video_ready_ = true;
         video_header_ = video_pkt;
         // 解析avc configuration heade
         AVCDecoderConfigurationRecord avc_decoder_configuration_record;
-        int32_t consumed = avc_decoder_configuration_record.parse((uint8_t *)payload.data() + header_consumed,
-                                                                  payload.size() - header_consumed);
+        int32_t consumed = avc_decoder_configuration_record.parse((uint8_t *)frame->payload.data(),
+                                                                  frame->payload.size());
         if (consumed < 0) {
             return false;
         }
@@ -250,7 +250,7 @@ bool RtmpToM4s::process_h264_packet(std::shared_ptr<RtmpMessage> video_pkt) {
         }
     }
 
-    bool is_key = header.is_key_frame() && !header.is_seq_header();
+    bool is_key = frame->is_key;
     if (video_pkts_.size() <= 0 && !is_key) {  // 片段开始的帧，必须是关键帧
         return false;
     }
@@ -258,7 +258,14 @@ bool RtmpToM4s::process_h264_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     if (video_pkts_.size() >= 2) {
         int64_t duration = video_pkt->timestamp_ - video_pkts_[0]->timestamp_;
         if (publish_app_->can_reap_mp4(is_key, duration, video_bytes_)) {
-            reap_video_seg(video_pkt->timestamp_);
+            if (video_chunk_begin_ > 0) {// 已经输出过chunk，把剩下的帧作为最后一个chunk，再合并成完整切片
+                flush_video_chunk(video_pkt->timestamp_);
+                video_data_mp4_seg_->update_timestamp(video_pkts_[0]->timestamp_, video_pkt->timestamp_);
+                video_data_mp4_seg_->merge_chunks();
+                video_chunk_begin_ = 0;
+            } else {
+                reap_video_seg(video_pkt->timestamp_);
+            }
             video_reaped_ = true;
             video_pkts_.clear();
             video_bytes_ = 0;
@@ -266,7 +273,14 @@ bool RtmpToM4s::process_h264_packet(std::shared_ptr<RtmpMessage> video_pkt) {
         }
     }
 
-    video_bytes_ += payload.size() - header_consumed;
+    // ll-dash: 累计的帧达到chunk时长就输出一个chunk，最后一帧的时长需要用当前帧的时间戳计算
+    int32_t chunk_dur = publish_app_->get_conf()->get_fmp4_chunk_dur();
+    if (chunk_dur > 0 && video_pkts_.size() > video_chunk_begin_ && 
+        video_pkt->timestamp_ - video_pkts_[video_chunk_begin_]->timestamp_ >= chunk_dur) {
+        flush_video_chunk(video_pkt->timestamp_);
+    }
+
+    video_bytes_ += frame->payload.size();
     video_pkts_.push_back(video_pkt);
 
     return true;
@@ -360,11 +374,9 @@ void RtmpToM4s::reap_video_seg(int64_t dts) {
             te.sample_duration_ = (*it_next)->timestamp_ - (*it)->timestamp_;
         }
 
-        auto payload = (*it)->get_using_data();
-        VideoTagHeader header;
-        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-        te.sample_size_ = payload.size() - header_consumed;
-        te.sample_composition_time_offset_ = header.composition_time;
+        auto frame = get_rtmp_video_frame(*it, nalu_length_size_);
+        te.sample_size_ = frame->payload.size();
+        te.sample_composition_time_offset_ = (int32_t)(frame->pts - frame->dts);
         if (te.sample_composition_time_offset_ < 0) {
             trun->version_ = 1;
         }
@@ -376,10 +388,8 @@ void RtmpToM4s::reap_video_seg(int64_t dts) {
     // mdat
     mdat->datas_.clear();
     for (auto it = video_pkts_.begin(); it != video_pkts_.end(); it++) {
-        auto payload = (*it)->get_using_data();
-        VideoTagHeader header;
-        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-        std::string_view frame_data(payload.data() + header_consumed, payload.size() - header_consumed);
+        auto frame = get_rtmp_video_frame(*it, nalu_length_size_);
+        std::string_view frame_data(frame->payload.data(), frame->payload.size());
         mdat->datas_.push_back(frame_data);
     }
 
@@ -398,9 +408,12 @@ void RtmpToM4s::reap_video_seg(int64_t dts) {
     n = NetBuffer(video_data_mp4_seg_->alloc_buffer(s));
     moof->encode(n);
 
-    s = mdat->size();
-    n = NetBuffer(video_data_mp4_seg_->alloc_buffer(s));
-    mdat->encode(n);
+    // mdat数据直接追加到切片的数据块中，不需要整段连续空间
+    n = NetBuffer(video_data_mp4_seg_->alloc_buffer(mdat_header_bytes));
+    mdat->encode_header(n);
+    for (const auto & data : mdat->datas_) {
+        video_data_mp4_seg_->append(data);
+    }
 
     video_data_mp4_seg_->update_timestamp(video_pkts_[0]->timestamp_, dts);
     video_data_mp4_seg_->set_seqno(video_seq_no_);
@@ -478,10 +491,8 @@ void RtmpToM4s::reap_audio_seg(int64_t dts) {
             te.sample_duration_ = (*it_next)->timestamp_ - (*it)->timestamp_;
         }
 
-        auto payload = (*it)->get_using_data();
-        AudioTagHeader header;
-        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-        te.sample_size_ = payload.size() - header_consumed;
+        auto frame = get_rtmp_audio_frame(*it);
+        te.sample_size_ = frame->payload.size();
         te.sample_composition_time_offset_ = 0;
         if (te.sample_composition_time_offset_ < 0) {
             trun->version_ = 1;
@@ -494,10 +505,8 @@ void RtmpToM4s::reap_audio_seg(int64_t dts) {
     auto mdat = std::make_shared<MdatBox>();
     mdat->datas_.clear();
     for (auto it = audio_pkts_.begin(); it != audio_pkts_.end(); it++) {
-        auto payload = (*it)->get_using_data();
-        AudioTagHeader header;
-        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-        std::string_view frame_data(payload.data() + header_consumed, payload.size() - header_consumed);
+        auto frame = get_rtmp_audio_frame(*it);
+        std::string_view frame_data(frame->payload.data(), frame->payload.size());
         mdat->datas_.push_back(frame_data);
     }
 
@@ -516,15 +525,128 @@ void RtmpToM4s::reap_audio_seg(int64_t dts) {
     n = NetBuffer(audio_data_mp4_seg_->alloc_buffer(s));
     moof->encode(n);
 
-    s = mdat->size();
-    n = NetBuffer(audio_data_mp4_seg_->alloc_buffer(s));
-    mdat->encode(n);
+    // mdat数据直接追加到切片的数据块中，不需要整段连续空间
+    n = NetBuffer(audio_data_mp4_seg_->alloc_buffer(mdat_header_bytes));
+    mdat->encode_header(n);
+    for (const auto & data : mdat->datas_) {
+        audio_data_mp4_seg_->append(data);
+    }
 
     audio_data_mp4_seg_->set_seqno(audio_seq_no_);
     audio_data_mp4_seg_->update_timestamp(audio_pkts_[0]->timestamp_, dts);
     audio_data_mp4_seg_->set_filename("audio-" + std::to_string(audio_seq_no_++) + ".m4s");
 }
 
+void RtmpToM4s::flush_video_chunk(int64_t dts) {
+    if (video_chunk_begin_ >= video_pkts_.size()) {
+        return;
+    }
+
+    if (video_chunk_begin_ == 0) {// 切片的第一个chunk，创建新的切片
+        video_data_mp4_seg_ = std::make_shared<Mp4Segment>();
+        video_data_mp4_seg_->set_seqno(video_seq_no_);
+        video_data_mp4_seg_->set_filename("video-" + std::to_string(video_seq_no_++) + ".m4s");
+    }
+
+    video_data_mp4_seg_->add_chunk(encode_chunk(video_pkts_, video_chunk_begin_, dts, video_track_ID_, video_moof_seq_no_++, true));
+    video_chunk_begin_ = video_pkts_.size();
+    mp4_media_source_->on_video_mp4_chunk(video_data_mp4_seg_);
+}
+
+void RtmpToM4s::flush_audio_chunk(int64_t dts) {
+    if (audio_chunk_begin_ >= audio_pkts_.size()) {
+        return;
+    }
+
+    if (audio_chunk_begin_ == 0) {
+        audio_data_mp4_seg_ = std::make_shared<Mp4Segment>();
+        audio_data_mp4_seg_->set_seqno(audio_seq_no_);
+        audio_data_mp4_seg_->set_filename("audio-" + std::to_string(audio_seq_no_++) + ".m4s");
+    }
+
+    audio_data_mp4_seg_->add_chunk(encode_chunk(audio_pkts_, audio_chunk_begin_, dts, audio_track_ID_, audio_moof_seq_no_++, false));
+    audio_chunk_begin_ = audio_pkts_.size();
+    mp4_media_source_->on_audio_mp4_chunk(audio_data_mp4_seg_);
+}
+
+std::shared_ptr<std::string> RtmpToM4s::encode_chunk(const std::vector<std::shared_ptr<RtmpMessage>> & pkts, size_t begin, int64_t dts, 
+                                                     int16_t track_id, uint32_t moof_seq_no, bool is_video) {
+    auto moof = std::make_shared<MoofBox>();
+    auto mfhd = std::make_shared<MfhdBox>();
+    mfhd->sequence_number_ = moof_seq_no;
+    moof->mfhd_ = mfhd;
+
+    auto traf = std::make_shared<TrafBox>();
+    moof->traf_ = traf;
+
+    auto tfhd = std::make_shared<TfhdBox>(0);
+    tfhd->track_id_ = track_id;
+    tfhd->flags_ = TfhdFlagsDefaultBaseIsMoof;
+    traf->tfhd_ = tfhd;
+
+    auto tfdt = std::make_shared<TfdtBox>();
+    tfdt->base_media_decode_time = pkts[begin]->timestamp_;  // in ms
+    tfdt->version_ = 1;
+    traf->tfdt_ = tfdt;
+
+    auto trun = std::make_shared<TrunBox>(0);
+    trun->flags_ = TrunFlagsDataOffset | TrunFlagsSampleDuration | TrunFlagsSampleSize | TrunFlagsSampleFlag |
+                   TrunFlagsSampleCtsOffset;
+    traf->trun_ = trun;
+    trun->entries_.reserve(pkts.size() - begin);
+
+    auto mdat = std::make_shared<MdatBox>();
+    int64_t mdat_bytes = 0;
+    for (size_t i = begin; i < pkts.size(); i++) {
+        TrunEntry te(trun.get());
+        // 只有切片的第一帧是关键帧
+        te.sample_flags_ = i == 0 ? 0x02000000 : 0x01000000;
+        te.sample_duration_ = (i + 1 < pkts.size() ? pkts[i + 1]->timestamp_ : dts) - pkts[i]->timestamp_;
+
+        std::shared_ptr<MediaFrame> frame;
+        te.sample_composition_time_offset_ = 0;
+        if (is_video) {
+            frame = get_rtmp_video_frame(pkts[i], nalu_length_size_);
+            te.sample_composition_time_offset_ = (int32_t)(frame->pts - frame->dts);
+            if (te.sample_composition_time_offset_ < 0) {
+                trun->version_ = 1;
+            }
+        } else {
+            frame = get_rtmp_audio_frame(pkts[i]);
+        }
+        te.sample_size_ = frame->payload.size();
+        mdat_bytes += te.sample_size_;
+        trun->entries_.push_back(te);
+        mdat->datas_.push_back(std::string_view(frame->payload.data(), frame->payload.size()));
+    }
+
+    int64_t mdat_header_bytes = mdat->size() - mdat_bytes;
+    int64_t moof_bytes = moof->size();
+    trun->data_offset_ = (int32_t)(moof_bytes + mdat_header_bytes);
+
+    // 切片的第一个chunk前面加上styp，chunk模式下不输出sidx(需要整个切片的大小)
+    StypBox styp;
+    int64_t styp_bytes = 0;
+    if (begin == 0) {
+        styp.major_brand_ = Mp4BoxBrandMSDH;
+        styp.minor_version_ = 0;
+        styp.compatible_brands_.push_back(Mp4BoxBrandDASH);
+        styp.compatible_brands_.push_back(Mp4BoxBrandMSDH);
+        styp.compatible_brands_.push_back(Mp4BoxBrandMSIX);
+        styp_bytes = styp.size();
+    }
+
+    auto chunk = std::make_shared<std::string>();
+    chunk->resize(styp_bytes + moof_bytes + mdat->size());
+    NetBuffer n(std::string_view(chunk->data(), chunk->size()));
+    if (begin == 0) {
+        styp.encode(n);
+    }
+    moof->encode(n);
+    mdat->encode(n);
+    return chunk;
+}
+
 bool RtmpToM4s::generate_video_init_seg(std::shared_ptr<RtmpMessage> video_pkt) {
     (void)video_pkt;
     if (!video_codec_) {
@@ -544,6 +666,7 @@ bool RtmpToM4s::generate_h264_video_init_seg() {
     H264Codec *h264_codec = ((H264Codec *)video_codec_.get());
 
     init_video_mp4_seg_ = std::make_shared<Mp4Segment>();
+    init_video_mp4_seg_->set_codecs(video_codec_->get_codecs_str());
     FtypBox ftyp;
     ftyp.major_brand_ = Mp4BoxBrandISO5;
     ftyp.minor_version_ = 512;
@@ -786,6 +909,7 @@ bool RtmpToM4s::generate_audio_init_seg(std::shared_ptr<RtmpMessage> audio_pkt)
     }
 
     init_audio_mp4_seg_ = std::make_shared<Mp4Segment>();
+    init_audio_mp4_seg_->set_codecs(audio_codec_->get_codecs_str());
     FtypBox ftyp;
     ftyp.major_brand_ = Mp4BoxBrandISO5;
     ftyp.minor_version_ = 512;
@@ -864,9 +988,7 @@ bool RtmpToM4s::generate_audio_init_seg(std::shared_ptr<RtmpMessage> audio_pkt)
                         mp4a->sample_size_ = 16;  // aac 固定位深为16
                         mp4a->channel_count_ = audio_specific_config->channel_configuration;
 
-                        AudioTagHeader header;
-                        auto payload = audio_pkt->get_using_data();
-                        int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
+                        auto frame = get_rtmp_audio_frame(audio_pkt);
                         auto esds = std::make_shared<EsdsBox>();
                         mp4a->esds_ = esds;
                         Mp4ES_Descriptor &es = esds->es_;
@@ -877,7 +999,7 @@ bool RtmpToM4s::generate_audio_init_seg(std::shared_ptr<RtmpMessage> audio_pkt)
 
                         desc.dec_specific_info_ = std::make_shared<Mp4DecoderSpecificInfo>();
                         desc.dec_specific_info_->asc_ =
-                            std::string(payload.data() + header_consumed, payload.size() - header_consumed);
+                            std::string(frame->payload.data(), frame->payload.size());
 
                         stsd->entries_.push_back(mp4a);
                     }
@@ -1056,16 +1178,14 @@ bool RtmpToM4s::generate_combined_init_seg(std::shared_ptr<RtmpMessage> video_pk
             mp4a->sample_rate_ = audio_config->sampling_frequency << 16;
 
             auto esds = std::make_shared<EsdsBox>();
-            auto payload = audio_pkt->get_using_data();
-            AudioTagHeader header;
-            int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
+            auto frame = get_rtmp_audio_frame(audio_pkt);
             Mp4ES_Descriptor &es = esds->es_;
             es.ES_ID_ = 0x02;
             auto &desc = es.decConfigDescr_;
             desc.object_type_indication_ = Mp4ObjectTypeAac;
             desc.stream_type_ = Mp4StreamTypeAudioStream;
             desc.dec_specific_info_ = std::make_shared<Mp4DecoderSpecificInfo>();
-            desc.dec_specific_info_->asc_ = std::string(payload.data() + header_consumed, payload.size() - header_consumed);
+            desc.dec_specific_info_->asc_ = std::string(frame->payload.data(), frame->payload.size());
             mp4a->esds_ = esds;
 
             stsd->entries_.push_back(mp4a);
@@ -1106,10 +1226,8 @@ bool RtmpToM4s::generate_combined_init_seg(std::shared_ptr<RtmpMessage> video_pk
 
 
 bool RtmpToM4s::process_h265_packet(std::shared_ptr<RtmpMessage> video_pkt) {
-    VideoTagHeader header;
-    auto payload = video_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_video_frame(video_pkt, nalu_length_size_);
+    if (!frame) {
         return false;
     }
 
@@ -1118,13 +1236,13 @@ bool RtmpToM4s::process_h265_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     }
 
     HevcCodec *hevc_codec = ((HevcCodec *)video_codec_.get());
-    if (header.is_seq_header()) {  // 关键帧索引
+    if (frame->is_seq_header) {  // 关键帧索引
         video_ready_ = true;
         video_header_ = video_pkt;
         // 解析hvcc configuration heade
         HEVCDecoderConfigurationRecord hevc_decoder_configuration_record;
         int32_t consumed = hevc_decoder_configuration_record.decode(
-            (uint8_t *)payload.data() + header_consumed, payload.size() - header_consumed);
+            (uint8_t *)frame->payload.data(), frame->payload.size());
         if (consumed == 0) {
             return false;
         }
@@ -1140,36 +1258,6 @@ bool RtmpToM4s::process_h265_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     return true;
 }
 
-int32_t RtmpToM4s::get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> &nalus) {
-    uint8_t *data_start = data;
-    while (len > 0) {
-        int32_t nalu_len = 0;
-        if (len < nalu_length_size_) {
-            return -1;
-        }
-
-        if (nalu_length_size_ == 1) {
-            nalu_len = *data;
-        } else if (nalu_length_size_ == 2) {
-            nalu_len = ntohs((*(uint16_t *)data));
-        } else if (nalu_length_size_ == 4) {
-            nalu_len = ntohl(*(uint32_t *)data);
-        }
-
-        data += nalu_length_size_;
-        len -= nalu_length_size_;
-
-        if (len < nalu_len) {
-            return -2;
-        }
-
-        nalus.emplace_back(std::string_view((char *)data, nalu_len));
-        data += nalu_len;
-        len -= nalu_len;
-    }
-    return data - data_start;
-}
-
 bool RtmpToM4s::on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
     if (!audio_codec_) {
         return false;
@@ -1184,21 +1272,19 @@ bool RtmpToM4s::on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
 }
 
 bool RtmpToM4s::process_aac_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
-    AudioTagHeader header;
-    auto payload = audio_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_audio_frame(audio_pkt);
+    if (!frame) {
         return false;
     }
 
     AACCodec *aac_codec = ((AACCodec *)audio_codec_.get());
-    if (header.is_seq_header()) {  // 关键帧索引
+    if (frame->is_seq_header) {  // 关键帧索引
         audio_ready_ = true;
         audio_header_ = audio_pkt;
         // 解析aac configuration header
         std::shared_ptr<AudioSpecificConfig> audio_config = std::make_shared<AudioSpecificConfig>();
-        int32_t consumed = audio_config->parse((uint8_t *)payload.data() + header_consumed,
-                                               payload.size() - header_consumed);
+        int32_t consumed = audio_config->parse((uint8_t *)frame->payload.data(),
+                                               frame->payload.size());
         if (consumed < 0) {
             CORE_ERROR("parse aac audio header failed, ret:{}", consumed);
             return false;
@@ -1224,15 +1310,28 @@ bool RtmpToM4s::process_aac_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
         int64_t duration = audio_pkt->timestamp_ - audio_pkts_[0]->timestamp_;
         if (publish_app_->can_reap_mp4(false, duration, audio_bytes_) || video_reaped_) {
             video_reaped_ = false;
-            reap_audio_seg(audio_pkt->timestamp_);
+            if (audio_chunk_begin_ > 0) {
+                flush_audio_chunk(audio_pkt->timestamp_);
+                audio_data_mp4_seg_->update_timestamp(audio_pkts_[0]->timestamp_, audio_pkt->timestamp_);
+                audio_data_mp4_seg_->merge_chunks();
+                audio_chunk_begin_ = 0;
+            } else {
+                reap_audio_seg(audio_pkt->timestamp_);
+            }
             audio_pkts_.clear();
             audio_bytes_ = 0;
             mp4_media_source_->on_audio_mp4_segment(audio_data_mp4_seg_);
         }
     }
 
+    int32_t chunk_dur = publish_app_->get_conf()->get_fmp4_chunk_dur();
+    if (chunk_dur > 0 && audio_pkts_.size() > audio_chunk_begin_ && 
+        audio_pkt->timestamp_ - audio_pkts_[audio_chunk_begin_]->timestamp_ >= chunk_dur) {
+        flush_audio_chunk(audio_pkt->timestamp_);
+    }
+
     audio_pkts_.push_back(audio_pkt);
-    audio_bytes_ += payload.size() - header_consumed;
+    audio_bytes_ += frame->payload.size();
 
     return true;
 }
@@ -56,8 +56,12 @@ private:
     bool process_mp3_packet(std::shared_ptr<RtmpMessage> audio_pkt);
     void reap_video_seg(int64_t dts);
     void reap_audio_seg(int64_t dts);
+    // ll-dash: 把切片中还未输出的帧编码成一个chunk(moof+mdat)，追加到生成中的切片
+    void flush_video_chunk(int64_t dts);
+    void flush_audio_chunk(int64_t dts);
+    std::shared_ptr<std::string> encode_chunk(const std::vector<std::shared_ptr<RtmpMessage>> & pkts, size_t begin, int64_t dts, 
+                                              int16_t track_id, uint32_t moof_seq_no, bool is_video);
 private:
-    int32_t get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> & nalus);
     void on_stream_ready();
 
     std::shared_ptr<RtmpMediaSink> rtmp_media_sink_;
@@ -96,6 +100,11 @@ private:
 
     uint64_t video_seq_no_ = 1;
     uint64_t audio_seq_no_ = 1;
+    // ll-dash: 当前切片中下一个chunk的起始帧位置，以及moof的序号(每个chunk递增)
+    size_t video_chunk_begin_ = 0;
+    size_t audio_chunk_begin_ = 0;
+    uint32_t video_moof_seq_no_ = 1;
+    uint32_t audio_moof_seq_no_ = 1;
     bool video_reaped_ = false;
     WaitGroup wg_;
 };
@@ -12,6 +12,7 @@
 #include "codec/aac/adts.hpp"
 #include "codec/aac/mpeg4_aac.hpp"
 #include "codec/h264/h264_codec.hpp"
+#include "rtmp_frame.hpp"
 #include "codec/hevc/hevc_codec.hpp"
 #include "codec/mp3/mp3_codec.hpp"
 #include "config/app_config.h"
@@ -60,7 +61,7 @@ bool RtmpToRtsp::init() {
                     break;
                 }
 
-                if (rtsp_media_source_->has_no_sinks_for_time(
+                if (rtsp_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     CORE_DEBUG("close RtmpToRtsp because no players for 30s");
                     break;
@@ -171,22 +172,19 @@ boost::asio::awaitable<bool> RtmpToRtsp::on_audio_packet(std::shared_ptr<RtmpMes
 }
 
 boost::asio::awaitable<bool> RtmpToRtsp::process_h264_packet(std::shared_ptr<RtmpMessage> video_pkt) {
-    VideoTagHeader header;
-    auto payload = video_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_video_frame(video_pkt, nalu_length_size_);
+    if (!frame) {
         co_return false;
     }
 
     H264Codec *h264_codec = ((H264Codec *)video_codec_.get());
-    if (header.is_seq_header()) {  // 关键帧索引
+    if (frame->is_seq_header) {  // 关键帧索引
         video_ready_ = true;
         video_header_ = video_pkt;
         // sequence_header = true;
         // 解析avc configuration header
         AVCDecoderConfigurationRecord avc_decoder_configuration_record;
-        int32_t consumed = avc_decoder_configuration_record.parse((uint8_t *)payload.data() + header_consumed,
-                                                                  payload.size() - header_consumed);
+        int32_t consumed = avc_decoder_configuration_record.parse((uint8_t *)frame->payload.data(), frame->payload.size());
         if (consumed < 0) {
             co_return false;
         }
@@ -206,12 +204,7 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_h264_packet(std::shared_ptr<Rtm
     }
 
     // 获取到nalus
-    std::list<std::string_view> nalus;
-    auto consumed =
-        get_nalus((uint8_t *)payload.data() + header_consumed, payload.size() - header_consumed, nalus);
-    if (consumed < 0) {
-        co_return false;
-    }
+    std::list<std::string_view> nalus(frame->nalus.begin(), frame->nalus.end());
 
     // 判断sps,pps,aud等
     bool has_aud_nalu = false;
@@ -221,7 +214,7 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_h264_packet(std::shared_ptr<Rtm
         co_return false;
     }
 
-    int64_t pts = video_pkt->timestamp_ + header.composition_time;
+    int64_t pts = frame->pts;
     if (first_video_pts_ == 0) {
         first_video_pts_ = pts;
     }
@@ -249,7 +242,7 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_h264_packet(std::shared_ptr<Rtm
     }
 
     if (!got_video_key_frame_) {
-        if (header.is_key_frame()) {
+        if (frame->is_key) {
             got_video_key_frame_ = true;
         }
     }
@@ -271,21 +264,18 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_h264_packet(std::shared_ptr<Rtm
 }
 
 boost::asio::awaitable<bool> RtmpToRtsp::process_h265_packet(std::shared_ptr<RtmpMessage> video_pkt) {
-    VideoTagHeader header;
-    auto payload = video_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_video_frame(video_pkt, nalu_length_size_);
+    if (!frame) {
         co_return false;
     }
 
     HevcCodec *hevc_codec = ((HevcCodec *)video_codec_.get());
-    if (header.is_seq_header()) {  // 关键帧索引
+    if (frame->is_seq_header) {  // 关键帧索引
         video_ready_ = true;
         video_header_ = video_pkt;
         // 解析avc configuration header
         HEVCDecoderConfigurationRecord hevc_decoder_configuration_record;
-        int32_t consumed = hevc_decoder_configuration_record.decode(
-            (uint8_t *)payload.data() + header_consumed, payload.size() - header_consumed);
+        int32_t consumed = hevc_decoder_configuration_record.decode((uint8_t *)frame->payload.data(), frame->payload.size());
         if (consumed < 0) {
             co_return false;
         }
@@ -306,19 +296,14 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_h265_packet(std::shared_ptr<Rtm
     }
 
     // 获取到nalus
-    std::list<std::string_view> nalus;
-    auto consumed =
-        get_nalus((uint8_t *)payload.data() + header_consumed, payload.size() - header_consumed, nalus);
-    if (consumed < 0) {
-        co_return false;
-    }
+    std::list<std::string_view> nalus(frame->nalus.begin(), frame->nalus.end());
 
     // 判断sps,pps,aud等
     bool has_sps_nalu = false;
     bool has_pps_nalu = false;
     bool has_vps_nalu = false;
     bool has_key_nalu = false;
-    int64_t pts = video_pkt->timestamp_ + header.composition_time;
+    int64_t pts = frame->pts;
     if (first_video_pts_ == 0) {
         first_video_pts_ = pts;
     }
@@ -367,52 +352,19 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_h265_packet(std::shared_ptr<Rtm
     co_return true;
 }
 
-int32_t RtmpToRtsp::get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> &nalus) {
-    uint8_t *data_start = data;
-    while (len > 0) {
-        int32_t nalu_len = 0;
-        if (len < nalu_length_size_) {
-            return -1;
-        }
-
-        if (nalu_length_size_ == 1) {
-            nalu_len = *data;
-        } else if (nalu_length_size_ == 2) {
-            nalu_len = ntohs((*(uint16_t *)data));
-        } else if (nalu_length_size_ == 4) {
-            nalu_len = ntohl(*(uint32_t *)data);
-        }
-
-        data += nalu_length_size_;
-        len -= nalu_length_size_;
-
-        if (len < nalu_len) {
-            return -2;
-        }
-
-        nalus.emplace_back(std::string_view((char *)data, nalu_len));
-        data += nalu_len;
-        len -= nalu_len;
-    }
-    return data - data_start;
-}
-
 boost::asio::awaitable<bool> RtmpToRtsp::process_aac_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
-    AudioTagHeader header;
-    auto payload = audio_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_audio_frame(audio_pkt);
+    if (!frame) {
         co_return false;
     }
 
     AACCodec *aac_codec = ((AACCodec *)audio_codec_.get());
-    if (header.is_seq_header()) {  // 关键帧索引
+    if (frame->is_seq_header) {  // 关键帧索引
         audio_ready_ = true;
         audio_header_ = audio_pkt;
         // 解析avc configuration heade
         auto audio_config = std::make_shared<AudioSpecificConfig>();
-        int32_t consumed = audio_config->parse((uint8_t *)payload.data() + header_consumed,
-                                               payload.size() - header_consumed);
+        int32_t consumed = audio_config->parse((uint8_t *)frame->payload.data(), frame->payload.size());
         if (consumed < 0) {
             spdlog::error("parse aac audio header failed, ret:{}", consumed);
             co_return false;
@@ -439,7 +391,7 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_aac_packet(std::shared_ptr<Rtmp
         co_return false;
     }
 
-    int32_t payload_size = payload.size() - header_consumed;
+    int32_t payload_size = frame->payload.size();
     int16_t au_header_bytes = (13 + 3) / 8;
     char *p = (char *)audio_buf_;
     *(uint16_t *)p = htons(au_header_bytes * 8);
@@ -452,7 +404,7 @@ boost::asio::awaitable<bool> RtmpToRtsp::process_aac_packet(std::shared_ptr<Rtmp
     bit_stream.write_bits(3, au_index);
 
     p += 2;
-    memcpy(p, payload.data() + header_consumed, payload_size);
+    memcpy(p, frame->payload.data(), payload_size);
     p += payload_size;
 
     auto rtp_pkts = audio_rtp_packer_.pack(
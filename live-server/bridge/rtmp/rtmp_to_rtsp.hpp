@@ -31,7 +31,6 @@ public:
     void close() override;
 private:
     bool generate_sdp();
-    int32_t get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> & nalus);
 
     std::shared_ptr<RtmpMediaSink> rtmp_media_sink_;
     std::shared_ptr<RtspMediaSource> rtsp_media_source_;
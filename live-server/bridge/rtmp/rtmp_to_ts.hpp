@@ -10,6 +10,7 @@
 #pragma once 
 #include <vector>
 #include <list>
+#include <algorithm>
 #include <memory>
 #include <shared_mutex>
 
@@ -20,8 +21,11 @@
 #include "core/rtmp_media_sink.hpp"
 #include "core/ts_media_source.hpp"
 #include "protocol/ts/ts_pat_pmt.hpp"
+#include "protocol/ts/ts_packer.hpp"
+#include "../ts/ts_audio_buff.hpp"
 #include "base/wait_group.h"
 #include "base/obj_tracker.hpp"
+#include "rtmp_standby.hpp"
 
 namespace mms {
 class RtmpMetaDataMessage;
@@ -30,44 +34,20 @@ class PublishApp;
 class TsSegment;
 class PESPacket;
 
-template<typename T>
-struct AudioBuff {
-    AudioBuff() {
-        timestamp = 0;
-        audio_pes_len = 0;
-        audio_pkts.reserve(20);
-        audio_pes_segs.reserve(20);
-        audio_pes_segs.push_back(std::string_view(nullptr, 0));// 第一个，总留给pes header
-    }
-
-    void clear() {
-        timestamp = 0;
-        audio_pes_len = 0;
-        audio_pkts.clear();
-        audio_pes_segs.clear();
-        audio_pes_segs.push_back(std::string_view(nullptr, 0));
-    }
-
-    std::vector<std::shared_ptr<T>> audio_pkts;
-    std::vector<std::string_view> audio_pes_segs;
-    int32_t audio_pes_len = 0;
-    int64_t timestamp = 0;
-};
-
-struct AdtsHeader {
-    char data[7];
-};
-
 class RtmpToTs : public MediaBridge, public ObjTracker<RtmpToTs> {
 public:
     RtmpToTs(ThreadWorker *worker, std::shared_ptr<PublishApp> app, std::weak_ptr<MediaSource> origin_source, const std::string & domain_name, const std::string & app_name, const std::string & stream_name);
     virtual ~RtmpToTs();
 public:
     bool init() override;
+    bool on_rtmp_message(std::shared_ptr<RtmpMessage> rtmp_msg);
     bool on_metadata(std::shared_ptr<RtmpMessage> metadata_pkt);
     bool on_video_packet(std::shared_ptr<RtmpMessage> video_pkt);
     bool on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt);
     void on_ts_segment(std::shared_ptr<TsSegment> ts_seg);
+    void reap_ts_part(int64_t timestamp, bool is_key);
+    void flush_audio_pes();
+    void enter_standby();
     void close() override;
 private:
     bool process_h264_packet(std::shared_ptr<RtmpMessage> video_pkt);
@@ -76,7 +56,6 @@ private:
     bool process_mp3_packet(std::shared_ptr<RtmpMessage> audio_pkt);
     std::shared_ptr<TsSegment> curr_seg_;
 private:
-    int32_t get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> & nalus);
 
     std::shared_ptr<RtmpMediaSink> rtmp_media_sink_;
     std::shared_ptr<TsMediaSource> ts_media_source_;
@@ -91,25 +70,15 @@ private:
     std::shared_ptr<Codec> video_codec_;
     std::shared_ptr<Codec> audio_codec_;
     int32_t nalu_length_size_ = 4;
-    int16_t audio_pid_ = -1;
-    int16_t video_pid_ = -1;
-    int16_t PCR_PID = -1;
-    TsStream video_type_;
-    TsStream audio_type_;
-    void create_pat(std::string_view & pat_seg);
-    void create_pmt(std::string_view & pmt_seg);
-    void create_video_ts(std::shared_ptr<PESPacket> video_pkt, int32_t pes_len, bool is_key);
-    void create_audio_ts(std::shared_ptr<PESPacket> audio_pkt);
-    std::unordered_map<int16_t, uint8_t> continuity_counter_;
 
+    TsPacker ts_packer_;
     boost::asio::steady_timer check_closable_timer_;
-    char video_pes_header_[256];
     std::vector<std::string_view> video_pes_segs_;
 
     int32_t adts_header_index_ = 0;
     std::vector<AdtsHeader> adts_headers_;
-    char audio_pes_header_[256];
     AudioBuff<RtmpMessage> audio_buf_;
+    RtmpStandby standby_;
 
     WaitGroup wg_;
 };
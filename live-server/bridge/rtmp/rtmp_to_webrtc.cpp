@@ -11,9 +11,9 @@
 #include "base/thread/thread_worker.hpp"
 #include "core/flv_media_source.hpp"
 #include "codec/h264/h264_codec.hpp"
+#include "rtmp_frame.hpp"
 #include "codec/aac/aac_codec.hpp"
-#include "codec/aac/aac_decoder.hpp"
-#include "codec/opus/opus_encoder.hpp"
+#include "transcode/audio_transcode_service.hpp"
 
 #include "base/utils/utils.h"
 #include "server/webrtc/webrtc_server.hpp"
@@ -26,7 +26,7 @@ using namespace mms;
 
 RtmpToWebRtc::RtmpToWebRtc(ThreadWorker *worker, std::shared_ptr<PublishApp> app, 
                            std::weak_ptr<MediaSource> origin_source, const std::string & domain_name, const std::string & app_name, const std::string & stream_name) : 
-                           MediaBridge(worker, app, origin_source, domain_name, app_name, stream_name), check_closable_timer_(worker->get_io_context()), wg_(worker) {
+                           MediaBridge(worker, app, origin_source, domain_name, app_name, stream_name), check_closable_timer_(worker->get_io_context()), transcoded_audio_channel_(worker->get_io_context(), 1024), wg_(worker) {
     source_ = std::make_shared<WebRtcMediaSource>(worker, std::weak_ptr<StreamSession>(std::shared_ptr<StreamSession>(nullptr)), publish_app_);
     webrtc_media_source_ = std::static_pointer_cast<WebRtcMediaSource>(source_);
     sink_ = std::make_shared<RtmpMediaSink>(worker); 
@@ -35,10 +35,6 @@ RtmpToWebRtc::RtmpToWebRtc(ThreadWorker *worker, std::shared_ptr<PublishApp> app
 
 RtmpToWebRtc::~RtmpToWebRtc() {
     spdlog::debug("destroy RtmpToWebRtc");
-    if (swr_context_) {
-        swr_free(&swr_context_);
-        swr_context_ = nullptr;
-    }
 }
 
 bool RtmpToWebRtc::init() {
@@ -54,11 +50,17 @@ bool RtmpToWebRtc::init() {
                 break;
             }
 
-            if (webrtc_media_source_->has_no_sinks_for_time(app_conf->bridge_config().no_players_timeout_ms())) {//已经10秒没人播放了
-                spdlog::debug("close RtmpToWebRtc because no players for 10s");
+            auto no_players_timeout_ms = app_conf->bridge_config().no_players_timeout_ms();
+            if (webrtc_media_source_->is_idle(no_players_timeout_ms)) {//已经10秒没人播放了
+                spdlog::debug("close RtmpToWebRtc because no players for {}ms", webrtc_media_source_->get_idle_timeout(no_players_timeout_ms));
                 close();
                 break;
             }
+            // 热备期间不再转码打包，只保留解码器、rtp序号等状态和最近一个GOP
+            if (!standby_.is_standby() && webrtc_media_source_->has_no_sinks_for_time(no_players_timeout_ms)) {
+                spdlog::debug("RtmpToWebRtc of {}/{}/{} enter standby", domain_name_, app_name_, stream_name_);
+                standby_.enter();
+            }
         }
         co_return;
     }, [this, self](std::exception_ptr exp) {
@@ -71,6 +73,8 @@ bool RtmpToWebRtc::init() {
         close();
     });
 
+    start_audio_transcode();
+
     rtmp_media_sink_->set_on_source_status_changed_cb(
         [this, self](SourceStatus status) -> boost::asio::awaitable<void> {
             webrtc_media_source_->set_status(status);
@@ -79,19 +83,22 @@ bool RtmpToWebRtc::init() {
                     [this, self](const std::vector<std::shared_ptr<RtmpMessage>> &rtmp_msgs)
                         -> boost::asio::awaitable<bool> {
                         for (auto rtmp_msg : rtmp_msgs) {
-                            if (rtmp_msg->get_message_type() == RTMP_MESSAGE_TYPE_AUDIO) {
-                                if (!co_await on_audio_packet(rtmp_msg)) {
-                                    co_return false;
-                                }
-                            } else if (rtmp_msg->get_message_type() == RTMP_MESSAGE_TYPE_VIDEO) {
-                                if (!co_await on_video_packet(rtmp_msg)) {
-                                    co_return false;
-                                }
-                            } else {
-                                if (!co_await on_metadata(rtmp_msg)) {
-                                    co_return false;
+                            if (standby_.should_resume(webrtc_media_source_)) {
+                                spdlog::debug("RtmpToWebRtc of {}/{}/{} resume from standby", domain_name_, app_name_, stream_name_);
+                                for (auto & cached_msg : standby_.resume()) {
+                                    if (!co_await on_rtmp_message(cached_msg)) {
+                                        co_return false;
+                                    }
                                 }
                             }
+
+                            if (standby_.is_standby() && !standby_.cache(rtmp_msg)) {
+                                continue;
+                            }
+
+                            if (!co_await on_rtmp_message(rtmp_msg)) {
+                                co_return false;
+                            }
                         }
 
                         co_return true;
@@ -103,23 +110,30 @@ bool RtmpToWebRtc::init() {
     return true;
 }
 
+boost::asio::awaitable<bool> RtmpToWebRtc::on_rtmp_message(std::shared_ptr<RtmpMessage> rtmp_msg) {
+    if (rtmp_msg->get_message_type() == RTMP_MESSAGE_TYPE_AUDIO) {
+        co_return co_await on_audio_packet(rtmp_msg);
+    } else if (rtmp_msg->get_message_type() == RTMP_MESSAGE_TYPE_VIDEO) {
+        co_return co_await on_video_packet(rtmp_msg);
+    }
+    co_return co_await on_metadata(rtmp_msg);
+}
+
 boost::asio::awaitable<bool> RtmpToWebRtc::on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
-    AudioTagHeader header;
-    auto payload = audio_pkt->get_using_data();
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_audio_frame(audio_pkt);
+    if (!frame) {
         co_return false;
     }
 
     AACCodec *aac_codec = ((AACCodec*)audio_codec_.get());
     bool sequence_header = false;
-    if (header.is_seq_header()) {// 关键帧索引
+    if (frame->is_seq_header) {// 关键帧索引
         audio_ready_ = true;
         audio_header_ = audio_pkt;
         sequence_header = true;
         // 解析aac configuration header
         std::shared_ptr<AudioSpecificConfig> audio_config = std::make_shared<AudioSpecificConfig>();
-        int32_t consumed = audio_config->parse((uint8_t*)payload.data() + header_consumed, payload.size() - header_consumed);
+        int32_t consumed = audio_config->parse((uint8_t *)frame->payload.data(), frame->payload.size());
         if (consumed < 0) {
             spdlog::error("parse aac audio header failed, ret:{}", consumed);
             co_return false;
@@ -127,34 +141,10 @@ boost::asio::awaitable<bool> RtmpToWebRtc::on_audio_packet(std::shared_ptr<RtmpM
 
         aac_codec->set_audio_specific_config(audio_config);
 
-        aac_decoder_ = std::make_shared<AACDecoder>();
-        if (!aac_decoder_->init(std::string(payload.data() + header_consumed, payload.size() - header_consumed))) {
-            spdlog::error("init aac decoder failed");
-            co_return false;
-        }
-
-        if (!swr_context_) {
-            AVChannelLayout out_ch_layout;
-            AVChannelLayout in_ch_layout;
-            av_channel_layout_default(&out_ch_layout, 2);
-            av_channel_layout_default(&in_ch_layout, audio_config->channel_configuration);
-            int ret = swr_alloc_set_opts2(&swr_context_,
-                                &out_ch_layout, AV_SAMPLE_FMT_S16, 48000,
-                                &in_ch_layout, AV_SAMPLE_FMT_S16, audio_config->sampling_frequency, 
-                                0, NULL);
-            if (ret < 0) {
-                spdlog::error("swr init failed");
-                co_return false;
-            }
-        }
-
-        if (swr_init(swr_context_) < 0) {
-            spdlog::error("swr init failed");
+        if (!audio_transcoder_->configure(this, std::string(frame->payload.data(), frame->payload.size()), 0, 0)) {
+            spdlog::error("configure aac to opus transcoder failed");
             co_return false;
         }
-        
-        opus_encoder_ = std::make_shared<MOpusEncoder>();
-        opus_encoder_->init(48000, 2);
         co_return true;
     }
 
@@ -170,92 +160,73 @@ boost::asio::awaitable<bool> RtmpToWebRtc::on_audio_packet(std::shared_ptr<RtmpM
         first_audio_pts_ = audio_pkt->timestamp_;
     }
 
-    if (aac_decoder_) {
-        auto pcm = aac_decoder_->decode((uint8_t*)payload.data() + header_consumed, payload.size() - header_consumed);
-        if (swr_context_) {
-            // int dst_nb_samples = av_rescale_rnd(swr_get_delay(swr_context_, 48000) + in_samples, 44100, 48000, AV_ROUND_UP);
-            uint8_t *data_in[1];
-            uint8_t *data_out[1];
-            data_in[0] = (uint8_t*)pcm.data();
-            data_out[0] = (uint8_t*)resampled_pcm_ + resampled_pcm_bytes_;
-            int32_t total_samples = 0;
-            int32_t in_samples = pcm.size()/4;
-            int out_samples = swr_convert(swr_context_, (uint8_t**)&data_out, 2048, (const uint8_t**)&data_in, in_samples);
-            total_samples += out_samples;
-
-            resampled_pcm_bytes_ += total_samples*2*2;
-            std::vector<std::shared_ptr<RtpPacket>> rtp_pkts;
-            if (opus_encoder_) {
-                // frme_size：每个通道中输入音频信号的样本数，这里不是传pcm 数组大小，比如采用的是 48000 hz 编码，20ms 帧长，那么frame_size 应该是48*20 = 960，pcm 分配大小= frame_size x channels x sizeof(ipus_int16)。
-                const int samples_20ms = 48*20;//960//
-                const int bytes_per_20ms = samples_20ms *2 * 2;
-                while (resampled_pcm_bytes_ >= bytes_per_20ms) {
-                    auto opus_bytes = opus_encoder_->encode((uint8_t*)resampled_pcm_, samples_20ms, opus_data_, 8192);
-                    resampled_pcm_bytes_ -= bytes_per_20ms;
-                    memmove(resampled_pcm_, resampled_pcm_ + bytes_per_20ms, resampled_pcm_bytes_);
-                    auto rtp_pkts_tmp = audio_rtp_packer_.pack((char*)opus_data_, opus_bytes, audio_pt_, audio_ssrc_, audio_sample_count_*20*48);
-                    audio_sample_count_++;
-                    if (rtp_pkts_tmp.size() > 0) {
-                        for (auto r : rtp_pkts_tmp) {
-                            rtp_pkts.push_back(r);
-                        }
-                    }
-                }
-                auto ret = co_await webrtc_media_source_->on_audio_packets(rtp_pkts);
-                if (!ret) {
-                    co_return false;
-                }
-            }
-        }
-    }
-    
+    // 解码、重采样和编码交给转码线程，转好的opus由start_audio_transcode里的协程打包发送
+    AudioTranscoder::Frame aac_frame;
+    aac_frame.data.assign(frame->payload.data(), frame->payload.size());
+    audio_transcoder_->feed(this, std::move(aac_frame));
     co_return true;
 }
 
-int32_t RtmpToWebRtc::get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> & nalus) {
-    uint8_t *data_start = data;
-    while (len > 0) {
-        int32_t nalu_len = 0;
-        if (len < nalu_length_size_) {
-            return -1;
+void RtmpToWebRtc::start_audio_transcode() {
+    auto self(shared_from_this());
+    audio_transcoder_ = AudioTranscodeService::get_instance().get_or_create(domain_name_ + "/" + app_name_ + "/" + stream_name_,
+                                                                           AudioTranscoder::AAC_TO_OPUS, worker_);
+    std::weak_ptr<MediaBridge> weak_self = self;
+    audio_transcoder_->attach(this, [this, weak_self](std::shared_ptr<std::vector<AudioTranscoder::Frame>> frames) {
+        auto self = weak_self.lock();
+        if (!self) {
+            return;
         }
 
-        if (nalu_length_size_ == 1) {
-            nalu_len = *data;
-        } else if (nalu_length_size_ == 2) {
-            nalu_len = ntohs((*(uint16_t *)data));
-        } else if (nalu_length_size_ == 4) {
-            nalu_len = ntohl(*(uint32_t *)data);
+        if (!transcoded_audio_channel_.try_send(boost::system::error_code{}, frames)) {
+            spdlog::warn("RtmpToWebRtc of {}/{}/{} drop {} transcoded audio frames", domain_name_, app_name_, stream_name_, frames->size());
         }
+    });
 
-        data += nalu_length_size_;
-        len -= nalu_length_size_;
+    wg_.add(1);
+    boost::asio::co_spawn(worker_->get_io_context(), [this, self]()->boost::asio::awaitable<void> {
+        boost::system::error_code ec;
+        while (1) {
+            auto frames = co_await transcoded_audio_channel_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            if (ec) {
+                break;
+            }
 
-        if (len < nalu_len) {
-            return -2;
-        }
+            auto source = webrtc_media_source_;
+            if (!source) {
+                break;
+            }
 
-        nalus.emplace_back(std::string_view((char*)data, nalu_len));
-        data += nalu_len;
-        len -= nalu_len;
-    }
-    return data - data_start;
+            std::vector<std::shared_ptr<RtpPacket>> rtp_pkts;
+            for (auto & frame : *frames) {
+                auto rtp_pkts_tmp = audio_rtp_packer_.pack(frame.data.data(), frame.data.size(), audio_pt_, audio_ssrc_, frame.pts);
+                rtp_pkts.insert(rtp_pkts.end(), rtp_pkts_tmp.begin(), rtp_pkts_tmp.end());
+            }
+
+            if (!co_await source->on_audio_packets(rtp_pkts)) {
+                break;
+            }
+        }
+        co_return;
+    }, [this, self](std::exception_ptr exp) {
+        (void)exp;
+        wg_.done();
+        close();
+    });
 }
 
 boost::asio::awaitable<bool> RtmpToWebRtc::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
-    auto payload = video_pkt->get_using_data();
-    VideoTagHeader header;
-    int32_t header_consumed = header.decode((uint8_t *)payload.data(), payload.size());
-    if (header_consumed < 0) {
+    auto frame = get_rtmp_video_frame(video_pkt, nalu_length_size_);
+    if (!frame) {
         co_return false;
     }
 
     H264Codec *h264_codec = ((H264Codec*)video_codec_.get());
-    if (header.is_seq_header()) {// 关键帧索引
+    if (frame->is_seq_header) {// 关键帧索引
         video_header_ = video_pkt;
         // 解析avc configuration heade
         AVCDecoderConfigurationRecord avc_decoder_configuration_record;
-        int32_t consumed = avc_decoder_configuration_record.parse((uint8_t*)payload.data() + header_consumed, payload.size() - header_consumed);
+        int32_t consumed = avc_decoder_configuration_record.parse((uint8_t *)frame->payload.data(), frame->payload.size());
         if (consumed < 0) {
             co_return false;
         }
@@ -268,13 +239,9 @@ boost::asio::awaitable<bool> RtmpToWebRtc::on_video_packet(std::shared_ptr<RtmpM
         co_return true;
     } 
 
-    // bool is_key = header.is_key_frame() && !header.is_seq_header();
+    // bool is_key = frame->is_key;
     // 获取到nalus
-    std::list<std::string_view> nalus;
-    auto consumed = get_nalus((uint8_t*)payload.data() + header_consumed, payload.size() - header_consumed, nalus);
-    if (consumed < 0) {
-        co_return false;
-    }
+    std::list<std::string_view> nalus(frame->nalus.begin(), frame->nalus.end());
 
     // 判断sps,pps,aud等
     bool has_aud_nalu = false;
@@ -477,6 +444,10 @@ void RtmpToWebRtc::close() {
     auto self(shared_from_this());
     boost::asio::co_spawn(worker_->get_io_context(), [this, self]()->boost::asio::awaitable<void> {
         check_closable_timer_.cancel();
+        if (audio_transcoder_) {
+            audio_transcoder_->detach(this);
+        }
+        transcoded_audio_channel_.close();
         co_await wg_.wait();
         if (webrtc_media_source_) {
             webrtc_media_source_->close();
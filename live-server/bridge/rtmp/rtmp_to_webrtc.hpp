@@ -9,6 +9,7 @@
  */
 #pragma once
 #include <boost/asio/steady_timer.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
 
 #include "core/rtmp_media_sink.hpp"
 #include "core/webrtc_media_source.hpp"
@@ -16,9 +17,8 @@
 #include "protocol/sdp/sdp.hpp"
 #include "protocol/rtp/rtp_packer.h"
 #include "base/wait_group.h"
-extern "C" {
-    #include "libswresample/swresample.h"
-}
+#include "rtmp_standby.hpp"
+#include "transcode/audio_transcoder.hpp"
 #include "base/obj_tracker.hpp"
 
 namespace mms {
@@ -27,20 +27,19 @@ class RtmpMetaDataMessage;
 class Codec;
 class PublishApp;
 class RtmpMessage;
-class AACDecoder;
-class MOpusEncoder;
 
 class RtmpToWebRtc : public MediaBridge, public ObjTracker<RtmpToWebRtc> {
 public:
     RtmpToWebRtc(ThreadWorker *worker, std::shared_ptr<PublishApp>, std::weak_ptr<MediaSource> origin_source, const std::string & domain_name, const std::string & app_name, const std::string & stream_name);
     virtual ~RtmpToWebRtc();
     bool init() override;
+    boost::asio::awaitable<bool> on_rtmp_message(std::shared_ptr<RtmpMessage> rtmp_msg);
     boost::asio::awaitable<bool> on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt);
     boost::asio::awaitable<bool> on_video_packet(std::shared_ptr<RtmpMessage> video_pkt);
     boost::asio::awaitable<bool> on_metadata(std::shared_ptr<RtmpMessage> metadata_pkt);
     void close() override;
 protected:
-    int32_t get_nalus(uint8_t *data, int32_t len, std::list<std::string_view> & nalus);
+    void start_audio_transcode();
 
     std::shared_ptr<RtmpMediaSink> rtmp_media_sink_;
     std::shared_ptr<WebRtcMediaSource> webrtc_media_source_;
@@ -73,13 +72,10 @@ protected:
 
     RtpPacker video_rtp_packer_;
     RtpPacker audio_rtp_packer_;
-    std::shared_ptr<AACDecoder> aac_decoder_;
-    SwrContext *swr_context_ = nullptr;
-    uint8_t resampled_pcm_[8192*2];
-    int32_t resampled_pcm_bytes_ = 0;
-    std::shared_ptr<MOpusEncoder> opus_encoder_;
-    uint8_t opus_data_[8192*2];
-    int32_t audio_sample_count_ = 0;
+    // aac转opus在转码服务的线程上进行，转好的opus帧经channel回到本worker打包发送
+    std::shared_ptr<AudioTranscoder> audio_transcoder_;
+    boost::asio::experimental::concurrent_channel<void(boost::system::error_code, std::shared_ptr<std::vector<AudioTranscoder::Frame>>)> transcoded_audio_channel_;
+    RtmpStandby standby_;
 
     WaitGroup wg_;
 };
@@ -55,7 +55,7 @@ bool RtspToFlv::init() {
                     break;
                 }
 
-                if (flv_media_source_->has_no_sinks_for_time(
+                if (flv_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     break;
                 }
@@ -56,7 +56,7 @@ bool RtspToRtmp::init() {
                     break;
                 }
 
-                if (rtmp_media_source_->has_no_sinks_for_time(
+                if (rtmp_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     break;
                 }
@@ -20,6 +20,7 @@
 #include "codec/aac/aac_encoder.hpp"
 #include "codec/aac/adts.hpp"
 #include "codec/aac/mpeg4_aac.hpp"
+#include "codec/annexb.hpp"
 #include "codec/av1/av1_codec.hpp"
 #include "codec/h264/h264_codec.hpp"
 #include "codec/hevc/hevc_codec.hpp"
@@ -60,6 +61,10 @@ RtspToTs::~RtspToTs() {}
 
 bool RtspToTs::init() {
     auto self(shared_from_this());
+    auto conf = publish_app_->get_conf();
+    if (conf) {
+        audio_buf_.set_limits(conf->hls_config().ts_audio_pes_max_frames(), conf->hls_config().ts_audio_pes_max_dur());
+    }
     wg_.add(1);
     boost::asio::co_spawn(
         worker_->get_io_context(),
@@ -75,7 +80,7 @@ bool RtspToTs::init() {
                     break;
                 }
 
-                if (ts_media_source_->has_no_sinks_for_time(
+                if (ts_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     spdlog::debug("close RtspToTs because no players for 30s");
                     break;
@@ -100,13 +105,9 @@ bool RtspToTs::init() {
             if (video_codec_) {
                 has_video_ = true;
                 if (video_codec_->get_codec_type() == CODEC_H264) {
-                    video_pid_ = TS_VIDEO_AVC_PID;
-                    video_type_ = TsStreamVideoH264;
-                    continuity_counter_[video_pid_] = 0;
+                    ts_packer_.set_video_stream(TsStreamVideoH264, TS_VIDEO_AVC_PID);
                 } else if (video_codec_->get_codec_type() == CODEC_HEVC) {
-                    video_pid_ = TS_VIDEO_HEVC_PID;
-                    video_type_ = TsStreamVideoH265;
-                    continuity_counter_[video_pid_] = 0;
+                    ts_packer_.set_video_stream(TsStreamVideoH265, TS_VIDEO_HEVC_PID);
                 } else {
                     return false;
                 }
@@ -115,25 +116,16 @@ bool RtspToTs::init() {
             if (audio_codec_) {
                 has_audio_ = true;
                 if (audio_codec_->get_codec_type() == CODEC_AAC) {
-                    audio_pid_ = TS_AUDIO_AAC_PID;
-                    audio_type_ = TsStreamAudioAAC;
-                    continuity_counter_[audio_pid_] = 0;
-                    adts_headers_.reserve(200);
+                    ts_packer_.set_audio_stream(TsStreamAudioAAC, TS_AUDIO_AAC_PID);
+                    // 每个PES中的每一帧对应一个adts头，PES打包后才重新使用
+                    adts_headers_.resize(audio_buf_.max_frames);
                 } else if (audio_codec_->get_codec_type() == CODEC_MP3) {
-                    audio_pid_ = TS_AUDIO_MP3_PID;
-                    audio_type_ = TsStreamAudioMp3;
-                    continuity_counter_[audio_pid_] = 0;
+                    ts_packer_.set_audio_stream(TsStreamAudioMp3, TS_AUDIO_MP3_PID);
                 } else {
                     return false;
                 }
             }
 
-            if (has_video_) {
-                PCR_PID = video_pid_;
-            } else if (has_audio_) {
-                PCR_PID = audio_pid_;
-            }
-
             return true;
         });
 
@@ -340,15 +332,9 @@ void RtspToTs::generate_h264_ts(int64_t timestamp, std::shared_ptr<RtpH264NALU>
 
     if (!curr_seg_) {
         curr_seg_ = std::make_shared<TsSegment>();
-        std::string_view pat_seg = curr_seg_->alloc_ts_packet();
-        create_pat(pat_seg);
-        std::string_view pmt_seg = curr_seg_->alloc_ts_packet();
-        create_pmt(pmt_seg);
+        ts_packer_.write_pat_pmt(curr_seg_);
     }
-
-    auto pes_packet = std::make_shared<PESPacket>();  // pes_packet;
-    auto &pes_header = pes_packet->pes_header;
-    memset((void *)&pes_header, 0, sizeof(pes_header));
+    reap_ts_part(timestamp, is_key);
 
     // 判断sps,pps,aud等
     bool has_aud_nalu = false;
@@ -383,117 +369,11 @@ void RtspToTs::generate_h264_ts(int64_t timestamp, std::shared_ptr<RtpH264NALU>
     if (!has_aud_nalu) {
         nalus.push_front(aud_nalu);
     }
-    // 计算payload长度(第一个nalu头部4个字节，后面的头部只需要3字节)
-    int32_t payload_size = nalus.size() * 3 + 1;  // 头部的总字节数
-    for (auto &nalu : nalus) {
-        payload_size += nalu.size();
-    }
-
-    // 添加上pes header
-    // uint8_t *pes = video_pes_.get();
-    char *pes = video_pes_header_;
-    static char pes_start_prefix[3] = {0x00, 0x00, 0x01};  // 固定3字节头,跟annexb没什么关系
-    memcpy(pes, pes_start_prefix, 3);
-    pes += 3;
-    // stream_id
-    *pes++ = TsPESStreamIdVideoCommon;
-    // PES_packet_length
-    uint8_t PTS_DTS_flags = 0x03;
-    // if (header.composition_time == 0) {//dts = pts时，只需要dts
-    PTS_DTS_flags = 0x02;
-    // }
-
-    // PES_header_data_length
-    uint8_t PES_header_data_length = 0;
-    if (PTS_DTS_flags == 0x02) {
-        PES_header_data_length = 5;  // DTS 5字节
-    } else if (PTS_DTS_flags == 0x03) {
-        PES_header_data_length = 10;  // PTS 5字节
-    }
-
-    uint32_t PES_packet_length_tmp = 3 + PES_header_data_length + payload_size;
-    uint16_t PES_packet_length = PES_packet_length_tmp > 0xffff ? 0 : PES_packet_length_tmp;
-    *((uint16_t *)pes) = htons(PES_packet_length);
-    pes += 2;
-    // 10' 2 bslbf
-    // PES_scrambling_control 2 bslbf
-    // PES_priority 1 bslbf
-    // data_alignment_indicator 1 bslbf
-    // copyright 1 bslbf
-    // original_or_copy 1 bslbf
-    *pes++ = 0x80;
-    // PTS_DTS_flags 2 bslbf
-    // ESCR_flag 1 bslbf
-    // ES_rate_flag 1 bslbf
-    // DSM_trick_mode_flag 1 bslbf
-    // additional_copy_info_flag 1 bslbf
-    // PES_CRC_flag 1 bslbf
-    // PES_extension_flag
-    *pes++ = PTS_DTS_flags << 6;
-    *pes++ = PES_header_data_length;
-    if (PTS_DTS_flags & 0x02) {  // 填充pts
-        // uint64_t pts = (video_pkt->timestamp_ + header.composition_time)*90;
-        uint64_t pts = timestamp * 90;
-        int32_t val = 0;
-        val = int32_t(0x02 << 4 | (((pts >> 30) & 0x07) << 1) | 1);
-        *pes++ = val;
-
-        val = int32_t((((pts >> 15) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-
-        val = int32_t((((pts) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-    }
-
-    if (PTS_DTS_flags & 0x01) {  // 填充dts
-        uint64_t dts = timestamp * 90;
-        int32_t val = 0;
-        val = int32_t(0x03 << 4 | (((dts >> 30) & 0x07) << 1) | 1);
-        *pes++ = val;
-
-        val = int32_t((((dts >> 15) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-
-        val = int32_t((((dts) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-    }
-
-    int32_t video_pes_len = pes - video_pes_header_;
     video_pes_segs_.clear();
-    video_pes_segs_.emplace_back(std::string_view(video_pes_header_, video_pes_len));
-
-    static char annexb_start_code1[] = {0x00, 0x00, 0x01};
-    static char annexb_start_code2[] = {0x00, 0x00, 0x00, 0x01};
-    bool first_nalu = true;
-    for (auto &nalu : nalus) {
-        if (first_nalu) {
-            first_nalu = false;
-            video_pes_segs_.emplace_back(std::string_view(annexb_start_code2, 4));
-            video_pes_len += 4;
-        } else {
-            memcpy(pes, annexb_start_code1, 3);
-            video_pes_segs_.emplace_back(std::string_view(annexb_start_code1, 3));
-            video_pes_len += 3;
-        }
-        video_pes_segs_.emplace_back(nalu);
-        video_pes_len += nalu.size();
-    }
-
-    pes_packet->alloc_buf(video_pes_len);
-    for (auto &seg : video_pes_segs_) {
-        auto unuse_payload = pes_packet->get_unuse_data();
-        memcpy((void *)unuse_payload.data(), seg.data(), seg.size());
-        pes_packet->inc_used_bytes(seg.size());
-    }
+    append_annexb_segs(nalus, video_pes_segs_);
 
-    // 生成pes
-    // 切成ts切片
-    pes_packet->is_key = is_key;
-    create_video_ts(pes_packet, video_pes_len, is_key);
+    // 生成pes，并切成ts
+    auto pes_packet = ts_packer_.pack_video(curr_seg_, video_pes_segs_, timestamp, timestamp, is_key);
     curr_seg_->update_video_dts(timestamp);
     ts_media_source_->on_pes_packet(pes_packet);
 }
@@ -639,15 +519,9 @@ void RtspToTs::generate_h265_ts(int64_t timestamp, std::shared_ptr<RtpH265NALU>
 
     if (!curr_seg_) {
         curr_seg_ = std::make_shared<TsSegment>();
-        std::string_view pat_seg = curr_seg_->alloc_ts_packet();
-        create_pat(pat_seg);
-        std::string_view pmt_seg = curr_seg_->alloc_ts_packet();
-        create_pmt(pmt_seg);
+        ts_packer_.write_pat_pmt(curr_seg_);
     }
-
-    auto pes_packet = std::make_shared<PESPacket>();  // pes_packet;
-    auto &pes_header = pes_packet->pes_header;
-    memset((void *)&pes_header, 0, sizeof(pes_header));
+    reap_ts_part(timestamp, is_key);
 
     // 判断sps,pps,aud等
     // bool has_aud_nalu = false;
@@ -686,460 +560,15 @@ void RtspToTs::generate_h265_ts(int64_t timestamp, std::shared_ptr<RtpH265NALU>
     // if (!has_aud_nalu) {
     //     nalus.push_front(aud_nalu);
     // }
-    // 计算payload长度(第一个nalu头部4个字节，后面的头部只需要3字节)
-    int32_t payload_size = nalus.size() * 3 + 1;  // 头部的总字节数
-    for (auto &nalu : nalus) {
-        payload_size += nalu.size();
-    }
-
-    // 添加上pes header
-    // uint8_t *pes = video_pes_.get();
-    char *pes = video_pes_header_;
-    static char pes_start_prefix[3] = {0x00, 0x00, 0x01};  // 固定3字节头,跟annexb没什么关系
-    memcpy(pes, pes_start_prefix, 3);
-    pes += 3;
-    // stream_id
-    *pes++ = TsPESStreamIdVideoCommon;
-    // PES_packet_length
-    uint8_t PTS_DTS_flags = 0x03;
-    // if (header.composition_time == 0) {//dts = pts时，只需要dts
-    PTS_DTS_flags = 0x02;
-    // }
-
-    // PES_header_data_length
-    uint8_t PES_header_data_length = 0;
-    if (PTS_DTS_flags == 0x02) {
-        PES_header_data_length = 5;  // DTS 5字节
-    } else if (PTS_DTS_flags == 0x03) {
-        PES_header_data_length = 10;  // PTS 5字节
-    }
-
-    uint32_t PES_packet_length_tmp = 3 + PES_header_data_length + payload_size;
-    uint16_t PES_packet_length = PES_packet_length_tmp > 0xffff ? 0 : PES_packet_length_tmp;
-    *((uint16_t *)pes) = htons(PES_packet_length);
-    pes += 2;
-    // 10' 2 bslbf
-    // PES_scrambling_control 2 bslbf
-    // PES_priority 1 bslbf
-    // data_alignment_indicator 1 bslbf
-    // copyright 1 bslbf
-    // original_or_copy 1 bslbf
-    *pes++ = 0x80;
-    // PTS_DTS_flags 2 bslbf
-    // ESCR_flag 1 bslbf
-    // ES_rate_flag 1 bslbf
-    // DSM_trick_mode_flag 1 bslbf
-    // additional_copy_info_flag 1 bslbf
-    // PES_CRC_flag 1 bslbf
-    // PES_extension_flag
-    *pes++ = PTS_DTS_flags << 6;
-    *pes++ = PES_header_data_length;
-    if (PTS_DTS_flags & 0x02) {  // 填充pts
-        // uint64_t pts = (video_pkt->timestamp_ + header.composition_time)*90;
-        uint64_t pts = timestamp * 90;
-        int32_t val = 0;
-        val = int32_t(0x02 << 4 | (((pts >> 30) & 0x07) << 1) | 1);
-        *pes++ = val;
-
-        val = int32_t((((pts >> 15) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-
-        val = int32_t((((pts) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-    }
-
-    if (PTS_DTS_flags & 0x01) {  // 填充dts
-        uint64_t dts = timestamp * 90;
-        int32_t val = 0;
-        val = int32_t(0x03 << 4 | (((dts >> 30) & 0x07) << 1) | 1);
-        *pes++ = val;
-
-        val = int32_t((((dts >> 15) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-
-        val = int32_t((((dts) & 0x7fff) << 1) | 1);
-        *pes++ = (val >> 8);
-        *pes++ = val;
-    }
-
-    int32_t video_pes_len = pes - video_pes_header_;
     video_pes_segs_.clear();
-    video_pes_segs_.emplace_back(std::string_view(video_pes_header_, video_pes_len));
-
-    static char annexb_start_code1[] = {0x00, 0x00, 0x01};
-    static char annexb_start_code2[] = {0x00, 0x00, 0x00, 0x01};
-    bool first_nalu = true;
-    for (auto &nalu : nalus) {
-        if (first_nalu) {
-            first_nalu = false;
-            video_pes_segs_.emplace_back(std::string_view(annexb_start_code2, 4));
-            video_pes_len += 4;
-        } else {
-            memcpy(pes, annexb_start_code1, 3);
-            video_pes_segs_.emplace_back(std::string_view(annexb_start_code1, 3));
-            video_pes_len += 3;
-        }
-
-        video_pes_segs_.emplace_back(nalu);
-        video_pes_len += nalu.size();
-    }
-
-    pes_packet->alloc_buf(video_pes_len);
-    for (auto &seg : video_pes_segs_) {
-        auto unuse_payload = pes_packet->get_unuse_data();
-        memcpy((void *)unuse_payload.data(), seg.data(), seg.size());
-        pes_packet->inc_used_bytes(seg.size());
-    }
+    append_annexb_segs(nalus, video_pes_segs_);
 
-    // 生成pes
-    // 切成ts切片
-    pes_packet->is_key = is_key;
-    create_video_ts(pes_packet, video_pes_len, is_key);
+    // 生成pes，并切成ts
+    auto pes_packet = ts_packer_.pack_video(curr_seg_, video_pes_segs_, timestamp, timestamp, is_key);
     curr_seg_->update_video_dts(timestamp);
     ts_media_source_->on_pes_packet(pes_packet);
 }
 
-void RtspToTs::create_pat(std::string_view &data) {
-    uint8_t *buf = (uint8_t *)data.data();
-    /*********************** ts header *********************/
-    *buf++ = 0x47;  // ts header sync byte
-    // transport_error_indicator(1b)        0
-    // payload_unit_start_indicator(1b)     1
-    // transport_priority(1b)               0
-    // pid(13b)                             TsPidPAT
-    int16_t v = (0 << 15) | (1 << 14) | (0 << 13) | TsPidPAT;
-    (*(uint16_t *)buf) = htons(v);
-    buf += 2;
-    // transport_scrambling_control(2b) = 00
-    // adaptation_field_control(2b) = payload only
-    // continuity_counter_(4b)   = 0
-    *buf++ = (00 << 6) | (TsAdapationControlPayloadOnly << 4) | 00;
-    /********************** psi header *********************/
-    // payload_unit_start_indicator = 1, pointer_field = 0
-    *buf++ = 0;
-    uint8_t *pat_start = buf;
-    // table_id
-    *buf++ = TsPsiTableIdPas;
-    // 2B
-    // The section_syntax_indicator is a 1-bit field which shall be set to '1'.
-    // int8_t section_syntax_indicator; //1bit
-    // // const value, must be '0'
-    // int8_t const0_value; //1bit
-    // // reverved value, must be '1'
-    // int8_t const1_value; //2bits
-    // // This is a 12-bit field, the first two bits of which shall be '00'. The remaining 10 bits specify the
-    // number
-    // // of bytes of the section, starting immediately following the section_length field, and including the
-    // CRC. The value in this
-    // // field shall not exceed 1021 (0x3FD).
-    // uint16_t section_length; //12bits
-    // section_length = psi_size + 4;
-    // psi_size = transport_stream_id + reserved + version_number + current_next_indicator + section_number +
-    // last_section_number + program_number
-
-    // section_length
-    int16_t section_len = 5 + 4 + 4;  // transport_stream_id(2B) + current_next_indicator(1B) +
-                                      // section_number(1B) + last_section_number(1B) + crc
-    int16_t slv = section_len & 0x0FFF;
-    slv |= (1 << 15) & 0x8000;
-    slv |= (0 << 14) & 0x4000;
-    slv |= (3 << 12) & 0x3000;
-    *((uint16_t *)buf) = htons(slv);
-    buf += 2;
-    // transport_stream_id
-    *((uint16_t *)buf) = htons(0x0001);  // transport_stream_id
-    buf += 2;
-    // 1B
-    int8_t cniv = 0x01;       // current_next_indicator 1b 1
-    cniv |= (0 << 1) & 0x3E;  // version_number 5b 00000
-    cniv |= (3 << 6) & 0xC0;  // reserved 2b 11
-    *buf++ = cniv;
-    // section_number
-    *buf++ = 0;
-    // last_section_number
-    *buf++ = 0;
-    // program
-    int16_t pmt_number = TS_PMT_NUMBER;
-    int16_t pmt_pid = TS_PMT_PID;
-    uint32_t v32;
-    v32 = (pmt_pid & 0x1FFF) | (0x07 << 13) | ((pmt_number << 16) & 0xFFFF0000);
-    *((uint32_t *)buf) = htonl(v32);
-    buf += 4;
-    // crc32
-    uint32_t crc32 = Utils::calc_mpeg_ts_crc32(pat_start, buf - pat_start);
-    *(uint32_t *)buf = htonl(crc32);
-    buf += 4;
-    memset(buf, 0xFF, (uint8_t *)data.data() + 188 - buf);
-    return;
-}
-
-void RtspToTs::create_pmt(std::string_view &pmt_seg) {
-    uint8_t *buf = (uint8_t *)pmt_seg.data();
-    /*********************** ts header *********************/
-    *buf = 0x47;  // ts header sync byte
-    buf++;
-    // transport_error_indicator(1b)        0
-    // payload_unit_start_indicator(1b)     1
-    // transport_priority(1b)               0
-    // pid(13b)                             TS_PMT_PID
-    int16_t v = (0 << 15) | (1 << 14) | (0 << 13) | TS_PMT_PID;
-    (*(uint16_t *)buf) = htons(v);
-    buf += 2;
-    // transport_scrambling_control(2b) = 00
-    // adaptation_field_control(2b) = payload only
-    // continuity_counter_(4b)   = 0
-    *buf = (TsAdapationControlPayloadOnly << 4);
-    buf++;
-    /********************** psi header *********************/
-    // payload_unit_start_indicator = 1, pointer_field = 0
-    *buf = 0;
-    buf++;
-    uint8_t *pmt_start = buf;
-    // table_id
-    *buf = TsPsiTableIdPms;
-    buf++;
-    // 2B
-    // The section_syntax_indicator is a 1-bit field which shall be set to '1'.
-    // int8_t section_syntax_indicator; //1bit
-    // // const value, must be '0'
-    // int8_t const0_value; //1bit
-    // // reverved value, must be '1'
-    // int8_t const1_value; //2bits
-    // // This is a 12-bit field, the first two bits of which shall be '00'. The remaining 10 bits specify the
-    // number
-    // // of bytes of the section, starting immediately following the section_length field, and including the
-    // CRC. The value in this
-    // // field shall not exceed 1021 (0x3FD).
-    // uint16_t section_length; //12bits
-    // section_length = psi_size + 4;
-    // psi_size = transport_stream_id + reserved + version_number + current_next_indicator + section_number +
-    // last_section_number + program_number
-
-    // section_length
-    int16_t section_len =
-        5 + 4 + 4;  // 5 + PCR_PID(2B) + program_info_length(2B) + VIDEO(5B) + AUDIO(5B) + crc32(4B)
-    if (has_video_) {
-        section_len += 5;
-    }
-
-    if (has_audio_) {
-        section_len += 5;
-    }
-    int16_t slv = section_len & 0x0FFF;
-    slv |= (1 << 15) & 0x8000;
-    slv |= (0 << 14) & 0x4000;
-    slv |= (3 << 12) & 0x3000;
-    *((uint16_t *)buf) = htons(slv);
-    buf += 2;
-
-    // program number
-    *((uint16_t *)buf) = htons(TS_PMT_NUMBER);  // program number
-    buf += 2;
-    // 1B
-    int8_t cniv = 0x01;       // current_next_indicator 1b 1
-    cniv |= (0 << 1) & 0x3E;  // version_number 5b 00000
-    cniv |= (3 << 6) & 0xC0;  // reserved 2b 11
-    *buf = cniv;
-    buf++;
-    // section_number
-    *buf = 0;
-    buf++;
-    // last_section_number
-    *buf = 0;
-    buf++;
-    // reserved 3 bslbf
-    // PCR_PID 13 uimsbf
-    // 2B
-    int16_t ppv = PCR_PID & 0x1FFF;
-    ppv |= (7 << 13) & 0xE000;
-    *((uint16_t *)buf) = htons(ppv);
-    buf += 2;
-    // reserved 4 bslbf
-    // program_info_length 12 0
-    // 2B
-    int16_t pilv = 0 & 0xFFF;
-    pilv |= (0xf << 12) & 0xF000;
-    *((uint16_t *)buf) = htons(pilv);
-    buf += 2;
-    // for (i = 0; i < N1; i++) {
-    //     stream_type 8 uimsbf
-    //     reserved 3 bslbf
-    //     elementary_PID 13 uimsbf
-
-    //     reserved 4 bslbf
-    //     ES_info_length 12 uimsbf
-    //     for (i = 0; i < N2; i++) {
-    //         descriptor()
-    //     }
-    // }
-
-    if (has_audio_) {
-        *buf = audio_type_;
-        buf++;
-        int16_t epv = audio_pid_ & 0x1FFF;
-        epv |= (0x7 << 13) & 0xE000;
-        *((uint16_t *)buf) = htons(epv);
-        buf += 2;
-        int16_t eilv = 0 & 0x0FFF;
-        eilv |= (0xf << 12) & 0xF000;
-        *((uint16_t *)buf) = htons(eilv);
-        buf += 2;
-    }
-
-    if (has_video_) {
-        *buf = video_type_;
-        buf++;
-        int16_t epv = video_pid_ & 0x1FFF;
-        epv |= (0x7 << 13) & 0xE000;
-        *((uint16_t *)buf) = htons(epv);
-        buf += 2;
-        int16_t eilv = 0 & 0x0FFF;
-        eilv |= (0xf << 12) & 0xF000;
-        *((uint16_t *)buf) = htons(eilv);
-        buf += 2;
-    }
-
-    // crc32
-    uint32_t crc32 = Utils::calc_mpeg_ts_crc32(pmt_start, buf - pmt_start);
-    *(uint32_t *)buf = htonl(crc32);
-    buf += 4;
-    memset(buf, 0xFF, (uint8_t *)pmt_seg.data() + 188 - buf);
-    return;
-}
-
-void RtspToTs::create_video_ts(std::shared_ptr<PESPacket> pes_packet, int32_t pes_len, bool is_key) {
-    int32_t left_count = pes_len;
-    int32_t curr_pes_seg_index = 0;
-    pes_packet->ts_index = curr_seg_->get_curr_ts_chunk_index();
-    pes_packet->ts_off = curr_seg_->get_curr_ts_chunk_offset();
-    pes_packet->ts_seg = curr_seg_;
-    int32_t ts_total_bytes = 0;
-    while (left_count > 0) {
-        int32_t space_left = 184;
-        std::string_view ts_seg = curr_seg_->alloc_ts_packet();
-        ts_total_bytes += 188;
-        uint8_t *buf = (uint8_t *)ts_seg.data();
-        *buf++ = 0x47;  // ts header sync byte
-
-        uint8_t payload_unit_start_indicator = 0;
-        if (left_count == pes_len) {  // 第一个ts切片，置上标志位
-            payload_unit_start_indicator = 1;
-        }
-        // transport_error_indicator(1b)        0
-        // payload_unit_start_indicator(1b)     1
-        // transport_priority(1b)               0
-        // pid(13b)                             TsPidPAT
-        int16_t v = (0 << 15) | (payload_unit_start_indicator << 14) | (0 << 13) | video_pid_;
-        (*(uint16_t *)buf) = htons(v);
-        buf += 2;
-
-        bool write_pcr = false;
-        if (left_count == pes_len) {  // 第一个切片
-            if (PCR_PID == video_pid_ && is_key) {
-                write_pcr = true;
-            }
-        }
-
-        bool write_padding = false;
-        if (left_count < space_left) {
-            write_padding = true;
-        }
-
-        // transport_scrambling_control(2b) = 00
-        // adaptation_field_control(2b) = payload only
-        // continuity_counter_(4b)   = 0
-        if (write_pcr || write_padding) {
-            *buf++ = (00 << 6) | (TsAdapationControlBoth << 4) | (continuity_counter_[video_pid_] & 0x0f);
-        } else {
-            *buf++ =
-                (00 << 6) | (TsAdapationControlPayloadOnly << 4) | (continuity_counter_[video_pid_] & 0x0f);
-        }
-        continuity_counter_[video_pid_]++;
-
-        int adaptation_field_total_length = 0;
-        if (write_pcr) {
-            // adaptation_field_length
-            adaptation_field_total_length = 8;  // adaptation_field_length(1) + flags(1) + PCR(6) = 8
-            int staffing_count = 0;
-            if ((4 + adaptation_field_total_length + left_count) <= 188) {
-                staffing_count = 188 - (4 + adaptation_field_total_length + left_count);
-            } else {
-                staffing_count = 0;
-            }
-
-            if (staffing_count > 0) {
-                adaptation_field_total_length += staffing_count;
-            }
-            int adaptation_field_length = adaptation_field_total_length - 1;  // 需要减掉自己的1字节
-            *buf++ = adaptation_field_length;
-            *buf++ = 0x10;                 // (PCR_flag << 4) & 0x10; 有pcr，直接写成0x10
-            int64_t pcrv = (0) & 0x1ff;    // program_clock_reference_base
-            pcrv |= (0x3f << 9) & 0x7E00;  // reserved
-            pcrv |= (pes_packet->pes_header.dts << 15) & 0xFFFFFFFF8000LL;
-
-            char *pp = (char *)&pcrv;
-            *buf++ = pp[5];
-            *buf++ = pp[4];
-            *buf++ = pp[3];
-            *buf++ = pp[2];
-            *buf++ = pp[1];
-            *buf++ = pp[0];
-            // 如果存在填充，则填充尾部0xff
-            memset(buf, 0xff, staffing_count);
-            buf += staffing_count;
-            space_left -= adaptation_field_total_length;
-        }
-
-        if (write_padding) {
-            adaptation_field_total_length = 2;  // adaptation_field_length + flags = 2
-            int staffing_count = 0;
-            if ((4 + adaptation_field_total_length + left_count) <= 188) {
-                staffing_count = 188 - (4 + adaptation_field_total_length + left_count);
-            } else {
-                staffing_count = 0;
-            }
-
-            if (staffing_count > 0) {
-                adaptation_field_total_length += staffing_count;
-            }
-            int adaptation_field_length = adaptation_field_total_length - 1;
-            *buf++ = adaptation_field_length;
-            *buf++ = 0x00;  //(PCR_flag << 4) & 0x10;   末尾的，不需要pcr
-            memset(buf, 0xff, staffing_count);
-            buf += staffing_count;
-        }
-
-        int32_t consumed = 184 - adaptation_field_total_length;
-        int32_t left_consume = consumed;
-        int32_t buff_off = 0;
-        while (left_consume > 0) {
-            int32_t curr_seg_size = video_pes_segs_[curr_pes_seg_index].size();
-            if (curr_seg_size < left_consume) {
-                memcpy(buf + buff_off, video_pes_segs_[curr_pes_seg_index].data(), curr_seg_size);
-                curr_pes_seg_index++;
-                left_consume -= curr_seg_size;
-                buff_off += curr_seg_size;
-            } else if (curr_seg_size == left_consume) {  // 可以覆盖
-                memcpy(buf + buff_off, video_pes_segs_[curr_pes_seg_index].data(), left_consume);
-                curr_pes_seg_index++;
-                buff_off += left_consume;
-                left_consume = 0;
-            } else {  // curr_seg_size > left_consume
-                memcpy(buf + buff_off, video_pes_segs_[curr_pes_seg_index].data(), left_consume);
-                video_pes_segs_[curr_pes_seg_index].remove_prefix(left_consume);
-                left_consume = 0;
-                buff_off += left_consume;
-            }
-        }
-        buf += buff_off;
-        left_count -= consumed;
-    }
-    pes_packet->ts_bytes = ts_total_bytes;
-}
-
 void RtspToTs::process_audio_packet(std::shared_ptr<RtpPacket> pkt, int64_t timestamp) {
     if (!audio_codec_) {
         return;
@@ -1235,6 +664,14 @@ void RtspToTs::generate_aac_ts(int64_t timestamp, std::shared_ptr<RtpAACNALU> na
                     return;
                 }
 
+                // 切片时会把缓存的音频帧打包并重置adts头的位置，需要在生成本帧adts头之前
+                if (curr_seg_) {
+                    if (publish_app_->can_reap_ts(false, curr_seg_)) {
+                        on_ts_segment(curr_seg_);
+                        curr_seg_ = nullptr;
+                    }
+                }
+
                 frame_length += 7;
                 auto &adts_header = adts_headers_[adts_header_index_];
                 adts_header.data[0] = 0xff;
@@ -1256,97 +693,14 @@ void RtspToTs::generate_aac_ts(int64_t timestamp, std::shared_ptr<RtpAACNALU> na
                 // uint8_t adts_header[7] = { 0xff, 0xf9, 0x00, 0x00, 0x00, 0x0f, 0xfc };
                 adts_header_index_++;
 
-                if (curr_seg_) {
-                    if (publish_app_->can_reap_ts(false, curr_seg_)) {
-                        on_ts_segment(curr_seg_);
-                        curr_seg_ = nullptr;
-                    }
-                }
-
-                auto pes_packet = std::make_shared<PESPacket>();  // pes_packet;
-                auto &pes_header = pes_packet->pes_header;
-                memset((void *)&pes_header, 0, sizeof(pes_header));
-
-                audio_buf_.audio_pkts.emplace_back(nalu);
-                if (audio_buf_.audio_pes_len == 0) {
-                    audio_buf_.timestamp = timestamp;
-                }
-
+                audio_buf_.add_pkt(nalu, timestamp);
                 audio_buf_.audio_pes_segs.emplace_back(std::string_view(adts_header.data, 7));
                 audio_buf_.audio_pes_segs.insert(audio_buf_.audio_pes_segs.end(), segs.begin(), segs.end());
                 audio_buf_.audio_pes_len += frame_length;
-                if (audio_buf_.audio_pes_len < 1400) {  // 至少1400字节，再一起送切片
+                if (!audio_buf_.is_full()) {
                     return;
                 }
-
-                if (!curr_seg_) {
-                    curr_seg_ = std::make_shared<TsSegment>();
-                    std::string_view pat_seg = curr_seg_->alloc_ts_packet();
-                    create_pat(pat_seg);
-                    std::string_view pmt_seg = curr_seg_->alloc_ts_packet();
-                    create_pmt(pmt_seg);
-                }
-
-                char *pes = audio_pes_header_;
-                static char pes_start_prefix[3] = {0x00, 0x00, 0x01};
-                memcpy(pes, pes_start_prefix, 3);
-                pes += 3;
-                // stream_id
-                *pes++ = TsPESStreamIdAudioCommon;
-                uint8_t PTS_DTS_flags = 0x02;
-                uint8_t PES_header_data_length = 5;  // 只有pts
-                // int32_t payload_size = 7 + payload.size() - header_consumed;//adts header + payload
-                int32_t payload_size = audio_buf_.audio_pes_len;
-                uint32_t PES_packet_length_tmp = 3 + PES_header_data_length + payload_size;
-                uint16_t PES_packet_length = PES_packet_length_tmp > 0xffff ? 0 : PES_packet_length_tmp;
-                *((uint16_t *)pes) = htons(PES_packet_length);
-                pes += 2;
-                // 10' 2 bslbf
-                // PES_scrambling_control 2 bslbf
-                // PES_priority 1 bslbf
-                // data_alignment_indicator 1 bslbf
-                // copyright 1 bslbf
-                // original_or_copy 1 bslbf
-                *pes++ = 0x80;
-                // PTS_DTS_flags 2 bslbf
-                // ESCR_flag 1 bslbf
-                // ES_rate_flag 1 bslbf
-                // DSM_trick_mode_flag 1 bslbf
-                // additional_copy_info_flag 1 bslbf
-                // PES_CRC_flag 1 bslbf
-                // PES_extension_flag
-                *pes++ = PTS_DTS_flags << 6;
-                *pes++ = PES_header_data_length;
-                // audio pts
-                uint64_t pts = audio_buf_.timestamp * 90;
-                int32_t val = 0;
-                val = int32_t(0x03 << 4 | (((pts >> 30) & 0x07) << 1) | 1);
-                *pes++ = val;
-
-                val = int32_t((((pts >> 15) & 0x7fff) << 1) | 1);
-                *pes++ = (val >> 8);
-                *pes++ = val;
-
-                val = int32_t((((pts) & 0x7fff) << 1) | 1);
-                *pes++ = (val >> 8);
-                *pes++ = val;
-
-                int32_t pes_header_len = pes - audio_pes_header_;
-                audio_buf_.audio_pes_len += pes_header_len;
-                audio_buf_.audio_pes_segs[0] = std::string_view(audio_pes_header_, pes_header_len);
-
-                pes_packet->alloc_buf(audio_buf_.audio_pes_len);
-                for (auto seg : audio_buf_.audio_pes_segs) {
-                    auto unuse_payload = pes_packet->get_unuse_data();
-                    memcpy((void *)unuse_payload.data(), seg.data(), seg.size());
-                    pes_packet->inc_used_bytes(seg.size());
-                }
-
-                create_audio_ts(pes_packet);
-                curr_seg_->update_audio_pts(audio_buf_.timestamp);
-                ts_media_source_->on_pes_packet(pes_packet);
-                audio_buf_.clear();
-                adts_header_index_ = 0;
+                flush_audio_pes();
             }
         }
     }
@@ -1354,96 +708,45 @@ void RtspToTs::generate_aac_ts(int64_t timestamp, std::shared_ptr<RtpAACNALU> na
     return;
 }
 
-void RtspToTs::create_audio_ts(std::shared_ptr<PESPacket> pes_packet) {
-    int curr_pes_seg_index = 0;
-    int32_t left_count = audio_buf_.audio_pes_len;
-    pes_packet->ts_index = curr_seg_->get_curr_ts_chunk_index();
-    pes_packet->ts_off = curr_seg_->get_curr_ts_chunk_offset();
-    pes_packet->ts_seg = curr_seg_;
-    int32_t ts_total_bytes = 0;
-
-    while (left_count > 0) {
-        int32_t space_left = 184;
-        std::string_view ts_seg = curr_seg_->alloc_ts_packet();
-        ts_total_bytes += 188;
-        uint8_t *buf = (uint8_t *)ts_seg.data();
-        *buf++ = 0x47;  // ts header sync byte
-        // transport_error_indicator(1b)        0
-        // payload_unit_start_indicator(1b)     1
-        // transport_priority(1b)               0
-        // pid(13b)                             TsPidPAT
-        uint8_t payload_unit_start_indicator = 0;
-        if (left_count == audio_buf_.audio_pes_len) {
-            payload_unit_start_indicator = 1;
-        }
-        int16_t v = (0 << 15) | (payload_unit_start_indicator << 14) | (0 << 13) | audio_pid_;
-        (*(uint16_t *)buf) = htons(v);
-        buf += 2;
-        // transport_scrambling_control(2b) = 00
-        // adaptation_field_control(2b) = payload only
-        // continuity_counter_(4b)   = 0
-        bool write_padding = false;
-        if (left_count < space_left) {
-            write_padding = true;
-        }
+void RtspToTs::flush_audio_pes() {
+    if (audio_buf_.audio_pes_segs.empty()) {
+        return;
+    }
 
-        if (write_padding) {
-            *buf++ = (00 << 6) | (TsAdapationControlBoth << 4) | (continuity_counter_[audio_pid_] & 0x0f);
-        } else {
-            *buf++ =
-                (00 << 6) | (TsAdapationControlPayloadOnly << 4) | (continuity_counter_[audio_pid_] & 0x0f);
-        }
+    if (!curr_seg_) {
+        curr_seg_ = std::make_shared<TsSegment>();
+        ts_packer_.write_pat_pmt(curr_seg_);
+    }
+    reap_ts_part(audio_buf_.timestamp, false);
 
-        continuity_counter_[audio_pid_]++;
-        int adaptation_field_total_length = 0;
-        if (write_padding) {
-            adaptation_field_total_length = 2;  // adaptation_field_length + flags = 2
-            int staffing_count = 0;
-            if ((4 + adaptation_field_total_length + left_count) <= 188) {
-                staffing_count = 188 - (4 + adaptation_field_total_length + left_count);
-            } else {
-                staffing_count = 0;
-            }
+    // PES的PTS为第一帧的时间戳，后面的帧由播放器按帧长推算
+    auto pes_packet = ts_packer_.pack_audio(curr_seg_, audio_buf_.audio_pes_segs, audio_buf_.timestamp);
+    curr_seg_->update_audio_pts(audio_buf_.timestamp);
+    curr_seg_->update_audio_pts(audio_buf_.last_timestamp);
+    ts_media_source_->on_pes_packet(pes_packet);
+    audio_buf_.clear();
+    adts_header_index_ = 0;
+}
 
-            if (staffing_count > 0) {
-                adaptation_field_total_length += staffing_count;
-            }
-            int adaptation_field_length = adaptation_field_total_length - 1;
-            *buf++ = adaptation_field_length;
-            *buf++ = 0x00;  //(PCR_flag << 4) & 0x10;   末尾的，不需要pcr
-            memset(buf, 0xff, staffing_count);
-            buf += staffing_count;
-        }
+void RtspToTs::on_ts_segment(std::shared_ptr<TsSegment> seg) {
+    // 还没打包的音频帧时间戳都在切片结束之前，写入当前切片
+    flush_audio_pes();
+    seg->set_reaped();
+    ts_media_source_->on_ts_segment(seg);
+}
 
-        int consumed = 184 - adaptation_field_total_length;
-
-        int32_t left_consume = consumed;
-        int32_t buff_off = 0;
-        while (left_consume > 0) {
-            int32_t curr_seg_size = audio_buf_.audio_pes_segs[curr_pes_seg_index].size();
-            if (curr_seg_size < left_consume) {
-                memcpy(buf + buff_off, audio_buf_.audio_pes_segs[curr_pes_seg_index].data(), curr_seg_size);
-                curr_pes_seg_index++;
-                left_consume -= curr_seg_size;
-                buff_off += curr_seg_size;
-            } else if (curr_seg_size == left_consume) {  // 可以覆盖
-                memcpy(buf + buff_off, audio_buf_.audio_pes_segs[curr_pes_seg_index].data(), left_consume);
-                curr_pes_seg_index++;
-                buff_off += left_consume;
-                left_consume = 0;
-            } else {  // curr_seg_size > left_consume
-                memcpy(buf + buff_off, audio_buf_.audio_pes_segs[curr_pes_seg_index].data(), left_consume);
-                audio_buf_.audio_pes_segs[curr_pes_seg_index].remove_prefix(left_consume);
-                left_consume = 0;
-            }
-        }
-        buf += buff_off;
-        left_count -= consumed;
+void RtspToTs::reap_ts_part(int64_t timestamp, bool is_key) {
+    // 未开启ll-hls时不记录part，切片结束时也不会生成part
+    if (!publish_app_->ll_hls_enabled()) {
+        return;
     }
-    pes_packet->ts_bytes = ts_total_bytes;
-}
 
-void RtspToTs::on_ts_segment(std::shared_ptr<TsSegment> seg) { ts_media_source_->on_ts_segment(seg); }
+    if (publish_app_->can_reap_ts_part(curr_seg_, timestamp)) {
+        curr_seg_->reap_part(timestamp);
+        ts_media_source_->on_ts_part(curr_seg_);
+    }
+    curr_seg_->update_part(timestamp, is_key);
+}
 
 void RtspToTs::close() {
     if (closed_.test_and_set(std::memory_order_acquire)) {
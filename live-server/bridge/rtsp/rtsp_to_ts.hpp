@@ -22,6 +22,7 @@
 #include "core/rtmp_media_sink.hpp"
 #include "core/ts_media_source.hpp"
 #include "protocol/ts/ts_pat_pmt.hpp"
+#include "protocol/ts/ts_packer.hpp"
 #include "../rtmp/rtmp_to_ts.hpp"
 #include "protocol/rtp/rtp_packet.h"
 #include "protocol/rtp/rtp_aac_depacketizer.h"
@@ -60,6 +61,8 @@ public:
     void process_h265_packet(std::shared_ptr<RtpPacket> pkt);
     void process_audio_packet(std::shared_ptr<RtpPacket> pkt, int64_t timestamp);
     void on_ts_segment(std::shared_ptr<TsSegment> ts_seg);
+    void reap_ts_part(int64_t timestamp, bool is_key);
+    void flush_audio_pes();
     void close() override;
 private:
     std::shared_ptr<TsSegment> curr_seg_;
@@ -74,28 +77,17 @@ private:
     std::shared_ptr<Codec> video_codec_;
     std::shared_ptr<Codec> audio_codec_;
 
-    int16_t audio_pid_ = -1;
-    int16_t video_pid_ = -1;
-    int16_t PCR_PID = -1;
-    TsStream video_type_;
-    TsStream audio_type_;
     void generate_h264_ts(int64_t timestamp, std::shared_ptr<RtpH264NALU> & nalu);
     void generate_h265_ts(int64_t timestamp, std::shared_ptr<RtpH265NALU> & nalu);
     void process_aac_packet(std::shared_ptr<RtpPacket> audio_pkt, int64_t timestamp);
     void generate_aac_ts(int64_t timestamp, std::shared_ptr<RtpAACNALU> nalu);
-    void create_pat(std::string_view & pat_seg);
-    void create_pmt(std::string_view & pmt_seg);
-    void create_video_ts(std::shared_ptr<PESPacket> pes_packet, int32_t pes_len, bool is_key);
-    void create_audio_ts(std::shared_ptr<PESPacket> pes_packet);
-    std::unordered_map<int16_t, uint8_t> continuity_counter_;
 
+    TsPacker ts_packer_;
     boost::asio::steady_timer check_closable_timer_;
-    char video_pes_header_[256];
     std::vector<std::string_view> video_pes_segs_;
 
     int32_t adts_header_index_ = 0;
     std::vector<AdtsHeader> adts_headers_;
-    char audio_pes_header_[256];
     AudioBuff<RtpAACNALU> audio_buf_;
 
     std::unique_ptr<char[]> video_frame_cache_;
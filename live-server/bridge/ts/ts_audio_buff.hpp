@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace mms {
+// 多个音频帧合并为一个PES，减少每帧单独打包时PES头及ts包填充的开销
+template<typename T>
+struct AudioBuff {
+    // ADTS单帧最大8191字节，合并的字节数不超过这个值时再加一帧也不会超出PES_packet_length的16位上限
+    static constexpr int32_t MAX_PES_BYTES = 48 * 1024;
+
+    AudioBuff() {
+        timestamp = 0;
+        audio_pes_len = 0;
+        audio_pkts.reserve(20);
+        audio_pes_segs.reserve(20);
+    }
+
+    void set_limits(int32_t frames, int32_t dur) {
+        max_frames = std::max(frames, 1);
+        max_dur = std::max(dur, 0);
+    }
+
+    // 记录帧的时间戳，PES的PTS取第一帧的时间戳
+    void add_pkt(std::shared_ptr<T> pkt, int64_t ts) {
+        if (audio_pkts.empty()) {
+            timestamp = ts;
+        }
+        last_timestamp = ts;
+        audio_pkts.emplace_back(pkt);
+    }
+
+    bool is_full() const {
+        return (int32_t)audio_pkts.size() >= max_frames || last_timestamp - timestamp >= max_dur || audio_pes_len >= MAX_PES_BYTES;
+    }
+
+    void clear() {
+        timestamp = 0;
+        last_timestamp = 0;
+        audio_pes_len = 0;
+        audio_pkts.clear();
+        audio_pes_segs.clear();
+    }
+
+    std::vector<std::shared_ptr<T>> audio_pkts;
+    std::vector<std::string_view> audio_pes_segs;
+    int32_t audio_pes_len = 0;
+    int64_t timestamp = 0;
+    int64_t last_timestamp = 0;
+    int32_t max_frames = 8;
+    int32_t max_dur = 200;
+};
+
+struct AdtsHeader {
+    char data[7];
+};
+};
@@ -57,7 +57,7 @@ bool TsToHls::init() {
                     break;
                 }
 
-                if (hls_media_source_->has_no_sinks_for_time(
+                if (hls_media_source_->is_idle(
                         app_conf->bridge_config().no_players_timeout_ms())) {  // 已经30秒没人播放了
                     CORE_DEBUG("close TsToHls because no players for 30s");
                     break;
@@ -84,6 +84,11 @@ bool TsToHls::init() {
                         hls_media_source_->on_ts_segment(seg);
                         co_return true;
                     });
+                ts_media_sink_->on_ts_part(
+                    [this, self](std::shared_ptr<TsSegment> seg) -> boost::asio::awaitable<bool> {
+                        hls_media_source_->on_ts_part(seg);
+                        co_return true;
+                    });
             }
             co_return;
         });
@@ -112,6 +117,7 @@ void TsToHls::close() {
                 ts_media_sink_->on_close({});
                 ts_media_sink_->set_on_source_status_changed_cb({});
                 ts_media_sink_->on_ts_segment({});
+                ts_media_sink_->on_ts_part({});
                 ts_media_sink_->close();
                 if (origin_source) {
                     origin_source->remove_media_sink(ts_media_sink_);
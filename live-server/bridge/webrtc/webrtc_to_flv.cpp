@@ -9,7 +9,6 @@
 #include "app/publish_app.h"
 #include "base/thread/thread_worker.hpp"
 #include "codec/aac/aac_codec.hpp"
-#include "codec/aac/aac_encoder.hpp"
 #include "codec/codec.hpp"
 #include "codec/h264/h264_codec.hpp"
 #include "codec/hevc/hevc_codec.hpp"
@@ -18,13 +17,14 @@
 #include "core/flv_media_source.hpp"
 #include "core/rtp_media_sink.hpp"
 #include "protocol/rtmp/flv/flv_define.hpp"
+#include "transcode/audio_transcode_service.hpp"
 
 using namespace mms;
 
 WebRtcToFlv::WebRtcToFlv(ThreadWorker *worker, std::shared_ptr<PublishApp> app, std::weak_ptr<MediaSource> origin_source, const std::string &domain_name, const std::string &app_name,
                          const std::string &stream_name)
     : MediaBridge(worker, app, origin_source, domain_name, app_name, stream_name), 
-    check_closable_timer_(worker->get_io_context()), wg_(worker) {
+    check_closable_timer_(worker->get_io_context()), transcoded_audio_channel_(worker->get_io_context(), 1024), wg_(worker) {
     source_ = std::make_shared<FlvMediaSource>(worker, std::weak_ptr<StreamSession>(std::shared_ptr<StreamSession>(nullptr)), publish_app_);
     flv_media_source_ = std::static_pointer_cast<FlvMediaSource>(source_);
     sink_ = std::make_shared<RtpMediaSink>(worker);
@@ -35,10 +35,6 @@ WebRtcToFlv::WebRtcToFlv(ThreadWorker *worker, std::shared_ptr<PublishApp> app,
 }
 
 WebRtcToFlv::~WebRtcToFlv() { 
-    if (swr_context_) {
-        swr_free(&swr_context_);
-        swr_context_ = nullptr;
-    }
     spdlog::debug("destroy WebRtcToFlv"); 
 }
 
@@ -57,7 +53,7 @@ bool WebRtcToFlv::init() {
                     break;
                 }
 
-                if (flv_media_source_->has_no_sinks_for_time(app_conf->bridge_config().no_players_timeout_ms())) { // 已经30秒没人播放了
+                if (flv_media_source_->is_idle(app_conf->bridge_config().no_players_timeout_ms())) { // 已经30秒没人播放了
                     spdlog::debug("close WebRtcToFlv because no players for 30s");
                     break;
                 }
@@ -72,6 +68,8 @@ bool WebRtcToFlv::init() {
 
     rtp_media_sink_->on_close([this, self]() { close(); });
 
+    start_audio_transcode();
+
     rtp_media_sink_->set_source_codec_ready_cb([this, self](std::shared_ptr<Codec> video_codec, std::shared_ptr<Codec> audio_codec) -> bool {
         video_codec_ = video_codec;
         audio_codec_ = audio_codec;
@@ -85,28 +83,14 @@ bool WebRtcToFlv::init() {
             }
 
             OpusCodec *opus_codec = (OpusCodec *)audio_codec_.get();
-            opus_decoder_ = opus_codec->create_decoder(opus_codec->getFs(), opus_codec->get_channels());
-            if (!swr_context_) {
-                AVChannelLayout out_ch_layout;
-                AVChannelLayout in_ch_layout;
-                av_channel_layout_default(&out_ch_layout, 2);
-                av_channel_layout_default(&in_ch_layout, opus_codec->get_channels());
-                int ret = swr_alloc_set_opts2(&swr_context_, &out_ch_layout, AV_SAMPLE_FMT_S16, 44100, &in_ch_layout, AV_SAMPLE_FMT_S16, opus_codec->getFs(), 0, NULL);
-                if (ret < 0) {
-                    spdlog::error("swr init failed");
-                    return false;
-                }
-            }
-            if (swr_init(swr_context_) < 0) {
-                spdlog::error("swr init failed");
+            if (!audio_transcoder_->configure(this, "", opus_codec->getFs(), opus_codec->get_channels())) {
+                spdlog::error("configure opus to aac transcoder failed");
                 return false;
             }
 
             has_audio_ = true;
-            aac_encoder_ = std::make_unique<AACEncoder>();
-            aac_encoder_->init(44100, opus_codec->get_channels());
             my_audio_codec_ = std::make_shared<AACCodec>();
-            auto spec_conf = aac_encoder_->get_specific_configuration();
+            auto spec_conf = audio_transcoder_->get_out_config();
             std::shared_ptr<AudioSpecificConfig> audio_specific_config = std::make_shared<AudioSpecificConfig>();
             auto ret = audio_specific_config->parse((uint8_t*)spec_conf.data(), spec_conf.size());
             if (ret > 0) {
@@ -596,9 +580,9 @@ std::shared_ptr<FlvTag> WebRtcToFlv::generate_h264_flv_tag(uint32_t timestamp, s
     return nullptr;
 }
 
-std::shared_ptr<FlvTag> WebRtcToFlv::generate_aac_flv_tag(uint32_t timestamp) {
-    std::shared_ptr<FlvTag> audio_flv_tag = std::make_shared<FlvTag>(FLV_TAG_HEADER_BYTES + 2 + aac_bytes_);
-    audio_flv_tag->tag_header.data_size = aac_bytes_ + 2;
+std::shared_ptr<FlvTag> WebRtcToFlv::generate_aac_flv_tag(uint32_t timestamp, const std::string & aac_data) {
+    std::shared_ptr<FlvTag> audio_flv_tag = std::make_shared<FlvTag>(FLV_TAG_HEADER_BYTES + 2 + aac_data.size());
+    audio_flv_tag->tag_header.data_size = aac_data.size() + 2;
     audio_flv_tag->tag_header.stream_id = 0;
     audio_flv_tag->tag_header.tag_type = FlvTagHeader::AudioTag;
     audio_flv_tag->tag_header.timestamp = timestamp;
@@ -609,7 +593,7 @@ std::shared_ptr<FlvTag> WebRtcToFlv::generate_aac_flv_tag(uint32_t timestamp) {
     audio_data->header.sound_size = AudioTagHeader::Sample_16bit;
     audio_data->header.aac_packet_type = AudioTagHeader::AACRaw;
 
-    audio_data->payload = std::string_view((char *)aac_data_, aac_bytes_);
+    audio_data->payload = std::string_view(aac_data.data(), aac_data.size());
     audio_flv_tag->tag_data = std::move(audio_data);
 
     auto ret = audio_flv_tag->encode();
@@ -626,64 +610,72 @@ void WebRtcToFlv::process_audio_packet(std::shared_ptr<RtpPacket> pkt) {
 }
 
 void WebRtcToFlv::process_opus_packet(std::shared_ptr<RtpPacket> pkt) {
-    if (!swr_context_) {
-        AVChannelLayout out_ch_layout;
-        AVChannelLayout in_ch_layout;
-        av_channel_layout_default(&out_ch_layout, 2);
-        av_channel_layout_default(&in_ch_layout, 2);
-        int ret = swr_alloc_set_opts2(&swr_context_, &out_ch_layout, AV_SAMPLE_FMT_S16, 44100, &in_ch_layout, AV_SAMPLE_FMT_S16, 48000, 0, NULL);
-        if (ret < 0) {
-            spdlog::error("swr init failed");
+    // 解码、重采样和编码交给转码线程，转好的aac由start_audio_transcode里的协程处理
+    AudioTranscoder::Frame frame;
+    frame.data.assign(pkt->get_payload().data(), pkt->get_payload().size());
+    frame.pts = pkt->get_timestamp();
+    audio_transcoder_->feed(this, std::move(frame));
+}
+
+void WebRtcToFlv::start_audio_transcode() {
+    auto self(shared_from_this());
+    audio_transcoder_ = AudioTranscodeService::get_instance().get_or_create(domain_name_ + "/" + app_name_ + "/" + stream_name_,
+                                                                           AudioTranscoder::OPUS_TO_AAC, worker_);
+    std::weak_ptr<MediaBridge> weak_self = self;
+    audio_transcoder_->attach(this, [this, weak_self](std::shared_ptr<std::vector<AudioTranscoder::Frame>> frames) {
+        auto self = weak_self.lock();
+        if (!self) {
             return;
         }
 
-        if (swr_init(swr_context_) < 0) {
-            spdlog::error("swr init failed");
-            return;
+        if (!transcoded_audio_channel_.try_send(boost::system::error_code{}, frames)) {
+            spdlog::warn("WebRtcToFlv of {}/{}/{} drop {} transcoded audio frames", domain_name_, app_name_, stream_name_, frames->size());
         }
-    }
+    });
+
+    wg_.add(1);
+    boost::asio::co_spawn(
+        worker_->get_io_context(),
+        [this, self]() -> boost::asio::awaitable<void> {
+            boost::system::error_code ec;
+            while (1) {
+                auto frames = co_await transcoded_audio_channel_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                if (ec) {
+                    break;
+                }
 
-    if (!opus_decoder_) {
-        spdlog::error("opus decoder not initialize");
+                for (auto & frame : *frames) {
+                    process_aac_frame(frame);
+                }
+            }
+            co_return;
+        },
+        [this, self](std::exception_ptr exp) {
+            (void)exp;
+            wg_.done();
+        });
+}
+
+void WebRtcToFlv::process_aac_frame(const AudioTranscoder::Frame & frame) {
+    if (!flv_media_source_ || first_rtp_audio_ts_ == 0) {
         return;
     }
 
-    int in_samples = opus_decode(opus_decoder_.get(), (uint8_t *)pkt->get_payload().data(), pkt->get_payload().size(), decoded_pcm_, 4096, 0);
-    if (swr_context_) {
-        // int dst_nb_samples = av_rescale_rnd(swr_get_delay(swr_context_, 48000) + in_samples, 44100, 48000,
-        // AV_ROUND_UP);
-        uint8_t *data_in[1];
-        uint8_t *data_out[1];
-        data_in[0] = (uint8_t *)decoded_pcm_;
-        data_out[0] = (uint8_t *)resampled_pcm_;
-        int32_t total_samples = 0;
-        int out_samples = swr_convert(swr_context_, (uint8_t **)&data_out, 1024, (const uint8_t **)&data_in, in_samples);
-        total_samples += out_samples;
-        data_out[0] = (uint8_t *)resampled_pcm_ + total_samples * 2 * 2;
-        while ((out_samples = swr_convert(swr_context_, (uint8_t **)&data_out, 1024, NULL, 0)) > 0) {
-            data_out[0] = (uint8_t *)resampled_pcm_ + total_samples * 2 * 2;
-            total_samples += out_samples;
-        }
+    auto timestamp = AudioTranscoder::rtp_ts_to_ms(frame.pts, first_rtp_audio_ts_);
+    if (timestamp < 0) {
+        return;
+    }
 
-        if (!aac_encoder_) {
-            return;
+    auto audio_flv_tag = generate_aac_flv_tag(timestamp, frame.data);
+    if (!stream_ready_) {
+        stream_ready_ = (has_audio_?(audio_codec_ && my_audio_codec_->is_ready()):true) && (has_video_?(video_codec_ && video_codec_->is_ready()):true);
+        if (stream_ready_) {
+            generateFlvHeaders();
         }
+    }
 
-        auto aac_bytes = aac_encoder_->encode((uint8_t *)resampled_pcm_, total_samples * 2 * 2, aac_data_, 8192);
-        if (aac_bytes > 0) {
-            aac_bytes_ = aac_bytes;
-            auto audio_flv_tag = generate_aac_flv_tag((pkt->get_timestamp() - first_rtp_audio_ts_) / 48);
-            if (!stream_ready_) {
-                stream_ready_ = (has_audio_?(audio_codec_ && my_audio_codec_->is_ready()):true) && (has_video_?(video_codec_ && video_codec_->is_ready()):true);
-                if (stream_ready_) {
-                    generateFlvHeaders();
-                }
-            }
-            
-            if (audio_flv_tag && header_ready_) {
-                flv_media_source_->on_audio_packet(audio_flv_tag);
-            }
-        }
+    if (audio_flv_tag && header_ready_) {
+        flv_media_source_->on_audio_packet(audio_flv_tag);
     }
 }
 
@@ -697,6 +689,10 @@ void WebRtcToFlv::close() {
         worker_->get_io_context(),
         [this, self]() -> boost::asio::awaitable<void> {
             check_closable_timer_.cancel();
+            if (audio_transcoder_) {
+                audio_transcoder_->detach(this);
+            }
+            transcoded_audio_channel_.close();
             co_await wg_.wait();
 
             if (flv_media_source_) {
@@ -14,16 +14,14 @@
 
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
 
 #include "../media_bridge.hpp"
 #include "protocol/rtmp/amf0/amf0_inc.hpp"
 #include "protocol/rtmp/flv/flv_tag.hpp"
 #include "protocol/rtp/rtp_h264_depacketizer.h"
 #include "protocol/rtp/rtp_aac_depacketizer.h"
-#include "opus/opus.h"
-extern "C" {
-    #include "libswresample/swresample.h"
-}
+#include "transcode/audio_transcoder.hpp"
 
 #include "base/wait_group.h"
 #include "base/obj_tracker.hpp"
@@ -38,7 +36,6 @@ class Codec;
 class RtmpMetaDataMessage;
 class RtpH264NALU;
 class RtpAACNALU;
-class AACEncoder;
 class AACCodec;
 
 class WebRtcToRtmp : public MediaBridge, public ObjTracker<WebRtcToRtmp> {
@@ -55,8 +52,10 @@ public:
 private:
     void process_h264_packet(std::shared_ptr<RtpPacket> pkt);
     void process_opus_packet(std::shared_ptr<RtpPacket> pkt);
+    void start_audio_transcode();
+    void process_aac_frame(const AudioTranscoder::Frame & frame);
     std::shared_ptr<RtmpMessage> generate_h264_rtmp_msg(uint32_t timestamp, std::shared_ptr<RtpH264NALU> & nalu);
-    std::shared_ptr<RtmpMessage> generate_aac_rtmp_msg(uint32_t timestamp);
+    std::shared_ptr<RtmpMessage> generate_aac_rtmp_msg(uint32_t timestamp, const std::string & aac_data);
     bool generate_metadata();
     bool generate_video_header();
     bool generate_audio_header();
@@ -89,14 +88,9 @@ private:
     uint32_t first_rtp_video_ts_ = 0;
     uint32_t first_rtp_audio_ts_ = 0;
 
-    std::shared_ptr<OpusDecoder> opus_decoder_;
-    SwrContext *swr_context_ = nullptr;
-    opus_int16 decoded_pcm_[8192];
-    uint8_t resampled_pcm_[8192];
-    uint8_t aac_data_[8192];
-    int32_t aac_bytes_ = 0;
-    int32_t resampled_pcm_samples_ = 0;
-    std::unique_ptr<AACEncoder> aac_encoder_;
+    // opus转aac在转码服务的线程上进行，同一路流的rtmp/flv/ts桥共享，转好的aac帧经channel回到本worker
+    std::shared_ptr<AudioTranscoder> audio_transcoder_;
+    boost::asio::experimental::concurrent_channel<void(boost::system::error_code, std::shared_ptr<std::vector<AudioTranscoder::Frame>>)> transcoded_audio_channel_;
     bool header_ready_ = false;
     bool stream_ready_ = false;
     
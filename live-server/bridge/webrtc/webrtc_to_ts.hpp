@@ -12,6 +12,7 @@
 #include <list>
 #include <memory>
 #include <shared_mutex>
+#include <boost/asio/experimental/concurrent_channel.hpp>
 
 #include "protocol/rtp/rtp_h264_depacketizer.h"
 #include "protocol/rtp/rtp_aac_depacketizer.h"
@@ -21,12 +22,10 @@
 #include "core/rtmp_media_sink.hpp"
 #include "core/ts_media_source.hpp"
 #include "protocol/ts/ts_pat_pmt.hpp"
+#include "protocol/ts/ts_packer.hpp"
 #include "../rtmp/rtmp_to_ts.hpp"
 #include "protocol/rtp/rtp_packet.h"
-extern "C" {
-    #include "libswresample/swresample.h"
-}
-#include "opus/opus.h"
+#include "transcode/audio_transcoder.hpp"
 #include "base/wait_group.h"
 #include "base/obj_tracker.hpp"
 
@@ -45,7 +44,6 @@ class Codec;
 class RtmpMetaDataMessage;
 class RtpH264NALU;
 class RtpAACNALU;
-class AACEncoder;
 class AACCodec;
 
 class WebRtcToTs : public MediaBridge, public ObjTracker<WebRtcToTs> {
@@ -56,8 +54,10 @@ public:
     bool init() override;
     void process_video_packet(std::shared_ptr<RtpPacket> pkt);
     void process_h264_packet(std::shared_ptr<RtpPacket> pkt);
-    void process_audio_packet(std::shared_ptr<RtpPacket> pkt, int64_t timestamp);
+    void process_audio_packet(std::shared_ptr<RtpPacket> pkt);
     void on_ts_segment(std::shared_ptr<TsSegment> ts_seg);
+    void reap_ts_part(int64_t timestamp, bool is_key);
+    void flush_audio_pes();
     void close() override;
 private:
     std::shared_ptr<TsSegment> curr_seg_;
@@ -73,28 +73,20 @@ private:
     std::shared_ptr<Codec> audio_codec_;
     std::shared_ptr<AACCodec> my_audio_codec_;
     
-    int16_t audio_pid_ = -1;
-    int16_t video_pid_ = -1;
-    int16_t PCR_PID = -1;
-    TsStream video_type_;
-    TsStream audio_type_;
     void on_status_ok();
     void generate_h264_ts(int64_t timestamp, std::shared_ptr<RtpH264NALU> & nalu);
-    void process_opus_packet(std::shared_ptr<RtpPacket> pkt, int64_t timestamp);
-    void create_pat(std::string_view & pat_seg);
-    void create_pmt(std::string_view & pmt_seg);
-    void create_video_ts(std::shared_ptr<PESPacket> pes_packet, int32_t pes_len, bool is_key);
-    void create_audio_ts(std::shared_ptr<PESPacket> pes_packet);
-    std::unordered_map<int16_t, uint8_t> continuity_counter_;
+    void process_opus_packet(std::shared_ptr<RtpPacket> pkt);
+    void start_audio_transcode();
+    void process_aac_frame(std::shared_ptr<std::vector<AudioTranscoder::Frame>> frames, const AudioTranscoder::Frame & frame);
 
+    TsPacker ts_packer_;
     boost::asio::steady_timer check_closable_timer_;
-    char video_pes_header_[256];
     std::vector<std::string_view> video_pes_segs_;
 
     int32_t adts_header_index_ = 0;
     std::vector<AdtsHeader> adts_headers_;
-    char audio_pes_header_[256];
-    AudioBuff<RtpPacket> audio_buf_;
+    // 持有转码输出的整批帧，PES分段直接指向帧数据
+    AudioBuff<std::vector<AudioTranscoder::Frame>> audio_buf_;
 
     std::unique_ptr<char[]> video_frame_cache_;
     std::unique_ptr<char[]> audio_frame_cache_;
@@ -104,17 +96,9 @@ private:
 
     bool wait_first_key_frame_ = true;
     RtpH264Depacketizer rtp_h264_depacketizer_;
-    std::unique_ptr<char[]> aac_buf_;
-    int32_t aac_buf_bytes_ = 0;
 
-    std::shared_ptr<OpusDecoder> opus_decoder_;
-    SwrContext *swr_context_ = nullptr;
-    opus_int16 decoded_pcm_[8192];
-    uint8_t resampled_pcm_[8192];
-    uint8_t aac_data_[8192];
-    int32_t aac_bytes_ = 0;
-    int32_t resampled_pcm_samples_ = 0;
-    std::unique_ptr<AACEncoder> aac_encoder_;
+    std::shared_ptr<AudioTranscoder> audio_transcoder_;
+    boost::asio::experimental::concurrent_channel<void(boost::system::error_code, std::shared_ptr<std::vector<AudioTranscoder::Frame>>)> transcoded_audio_channel_;
 
     WaitGroup wg_;
 };
@@ -60,7 +60,6 @@ void RtmpPlayClientSession::start() {
 
     auto publish_app = std::static_pointer_cast<PublishApp>(app_);
     rtmp_media_source_ = std::make_shared<RtmpMediaSource>(get_worker(), std::weak_ptr<StreamSession>(self), publish_app);
-    rtmp_media_source_->set_origin(true);
     rtmp_media_source_->set_session(self);
     rtmp_media_source_->set_source_info(get_domain_name(), get_app_name(), get_stream_name());
 
@@ -164,6 +164,16 @@ int32_t AppConfig::load_config(const YAML::Node & node)
         max_fmp4_seg_bytes_ = max_fmp4_seg_bytes_node.as<int64_t>();
     }
 
+    auto fmp4_chunk_dur_node = node["fmp4_chunk_dur"];
+    if (fmp4_chunk_dur_node.IsDefined()) {
+        fmp4_chunk_dur_ = fmp4_chunk_dur_node.as<int32_t>();
+        // chunk不能超过切片时长，否则等同于不分chunk
+        if (fmp4_chunk_dur_ < 0 || fmp4_chunk_dur_ >= fmp4_min_seg_dur_) {
+            CORE_WARN("fmp4_chunk_dur:{} is invalid, disable chunked fmp4", fmp4_chunk_dur_);
+            fmp4_chunk_dur_ = 0;
+        }
+    }
+
     auto stream_resume_timeout = node["stream_resume_timeout"];
     if (stream_resume_timeout.IsDefined() && stream_resume_timeout.IsScalar()) {
         stream_resume_timeout_ = stream_resume_timeout.as<uint32_t>();
@@ -174,6 +184,21 @@ int32_t AppConfig::load_config(const YAML::Node & node)
         stream_conflict_policy_ = stream_conflict_policy.as<std::string>();
     }
 
+    auto key_frame_req_window_ms = node["key_frame_req_window_ms"];
+    if (key_frame_req_window_ms.IsDefined() && key_frame_req_window_ms.IsScalar()) {
+        key_frame_req_window_ms_ = key_frame_req_window_ms.as<int32_t>();
+    }
+
+    auto key_frame_req_min_interval_ms = node["key_frame_req_min_interval_ms"];
+    if (key_frame_req_min_interval_ms.IsDefined() && key_frame_req_min_interval_ms.IsScalar()) {
+        key_frame_req_min_interval_ms_ = key_frame_req_min_interval_ms.as<int32_t>();
+    }
+
+    auto key_frame_max_interval_ms = node["key_frame_max_interval_ms"];
+    if (key_frame_max_interval_ms.IsDefined() && key_frame_max_interval_ms.IsScalar()) {
+        key_frame_max_interval_ms_ = key_frame_max_interval_ms.as<int32_t>();
+    }
+
     return 0;
 }
 
@@ -182,6 +207,9 @@ Json::Value AppConfig::to_json() {
     japp_conf["domain_name"] = domain_name_;
     japp_conf["app_name"] = app_name_;
     japp_conf["stream_resume_timeout"] = stream_resume_timeout_;
+    japp_conf["key_frame_req_window_ms"] = key_frame_req_window_ms_;
+    japp_conf["key_frame_req_min_interval_ms"] = key_frame_req_min_interval_ms_;
+    japp_conf["key_frame_max_interval_ms"] = key_frame_max_interval_ms_;
     if (on_publish_.size() > 0) {
         Json::Value jon_publish;
         for (auto & on_publish : on_publish_) {
@@ -86,6 +86,10 @@ public:
         return max_fmp4_seg_bytes_;
     }
 
+    inline int32_t get_fmp4_chunk_dur() const {
+        return fmp4_chunk_dur_;
+    }
+
     inline uint32_t get_stream_resume_timeout() const {
         return stream_resume_timeout_;
     }
@@ -94,6 +98,18 @@ public:
         return stream_conflict_policy_;
     }
 
+    int32_t get_key_frame_req_window_ms() const {
+        return key_frame_req_window_ms_;
+    }
+
+    int32_t get_key_frame_req_min_interval_ms() const {
+        return key_frame_req_min_interval_ms_;
+    }
+
+    int32_t get_key_frame_max_interval_ms() const {
+        return key_frame_max_interval_ms_;
+    }
+
     Json::Value to_json();
 private:
     std::string domain_name_;
@@ -116,9 +132,14 @@ private:
     int32_t fmp4_min_seg_dur_ = 2000;//fmp4切片最小时长，默认2秒，最小不能小于1秒
     int32_t fmp4_max_seg_dur_ = 60000;//fmp4切片最大时长，默认1分钟
     int64_t max_fmp4_seg_bytes_ = 10*1024*1024;//最大mp4 10M
+    int32_t fmp4_chunk_dur_ = 0;//ll-dash: 切片内每个chunk(moof+mdat)的时长，单位ms，0表示不分chunk
     // 延迟删除
     uint32_t stream_resume_timeout_ = 10;//10秒删除流
     // 流冲突策略
     std::string stream_conflict_policy_ = "replace"; // replace or reject
+    // 按需关键帧请求
+    int32_t key_frame_req_window_ms_ = 100;//合并窗口，窗口内同一路流的多次请求只向推流端请求一次
+    int32_t key_frame_req_min_interval_ms_ = 1000;//两次请求的最小间隔
+    int32_t key_frame_max_interval_ms_ = 4000;//有转协议或录制时，超过该时长没有请求过则兜底请求一次，0表示关闭
 };
 };
\ No newline at end of file
@@ -29,6 +29,31 @@ int32_t BridgeConfig::load(const YAML::Node & config) {
         return -1;
     }
 
+    YAML::Node prewarm = config["prewarm"];
+    if (prewarm.IsDefined()) {
+        for (size_t i = 0; i < prewarm.size(); i++) {
+            std::string v = prewarm[i].as<std::string>();
+            boost::algorithm::to_lower(v);
+            if (v != "hls" && v != "dash" && v != "flv" && v != "ts") {
+                CORE_WARN("unsupported prewarm type:{}, ignore", v);
+                continue;
+            }
+            prewarm_.push_back(v);
+        }
+    }
+
+    auto prewarm_mem_budget = config["prewarm_mem_budget"];
+    if (prewarm_mem_budget.IsDefined()) {
+        auto v = prewarm_mem_budget.as<std::string>();
+        if (v.ends_with("k") || v.ends_with("K")) {
+            prewarm_mem_budget_ = std::atoll(v.substr(0, v.size() - 1).c_str())*1024;
+        } else if (v.ends_with("m") || v.ends_with("M")) {
+            prewarm_mem_budget_ = std::atoll(v.substr(0, v.size() - 1).c_str())*1024*1024;
+        } else {
+            prewarm_mem_budget_ = std::atoll(v.c_str());
+        }
+    }
+
     YAML::Node rtmp = config["rtmp"];
     if (rtmp.IsDefined()) {
         YAML::Node rtmp_to_flv = rtmp["to_flv"];
@@ -1,4 +1,6 @@
 #pragma once
+#include <string>
+#include <vector>
 #include "yaml-cpp/yaml.h"
 namespace mms {
 class BridgeConfig {
@@ -79,9 +81,19 @@ public:
     inline int64_t no_players_timeout_ms() const {
         return no_players_timeout_ms_;
     }
+
+    const std::vector<std::string> & prewarm() const {
+        return prewarm_;
+    }
+
+    inline int64_t prewarm_mem_budget() const {
+        return prewarm_mem_budget_;
+    }
 protected:
     // 超时配置
     int64_t no_players_timeout_ms_ = 10000;// 默认10秒
+    std::vector<std::string> prewarm_;//推流就绪后立即创建的桥(hls,dash,flv,ts)，第一个播放者不用等待切片生成
+    int64_t prewarm_mem_budget_ = 512*1024*1024;//本应用预热的桥持有的切片超过该值后，预热的桥不再保持，按无人播放超时拆除
     bool rtmp_to_flv_ = false;
     bool rtmp_to_rtsp_ = false;
     bool rtmp_to_hls_ = false;
@@ -138,6 +138,11 @@ bool Config::load_config(const std::string & config_path) {
         }
     }
 
+    YAML::Node audio_transcode_threads = config["audio_transcode_threads"];
+    if (audio_transcode_threads.IsDefined()) {
+        audio_transcode_threads_ = audio_transcode_threads.as<uint32_t>();
+    }
+
     auto domains = AppManager::get_instance().get_domains();
     std::unordered_map<std::string, bool> domains_exist_map;
     for (auto & domain : domains) {
@@ -81,6 +81,10 @@ public:
     uint32_t get_socket_inactive_timeout_ms() {
         return socket_inactive_timeout_ms_;
     }
+
+    uint32_t get_audio_transcode_threads() {
+        return audio_transcode_threads_;
+    }
 private:
     bool load_domain_config(const std::string & domain, const std::string & file);
 private:
@@ -100,6 +104,7 @@ private:
     // std::string webrtc_internal_bind_ip_ = "";
     std::string cert_root_ = "certs";
     uint32_t socket_inactive_timeout_ms_ = 60000;// 默认60秒超时
+    uint32_t audio_transcode_threads_ = 2;// 音频转码线程数，0表示在桥所在的线程上转码
 
     std::string record_root_path_;
     std::shared_mutex mutex_;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include "hls_config.h"
 #include "log/log.h"
@@ -40,6 +41,103 @@ int32_t HlsConfig::load(const YAML::Node & config) {
     auto min_ts_count_for_m3u8 = config["min_ts_count_for_m3u8"];
     if (min_ts_count_for_m3u8.IsDefined()) {
         min_ts_count_for_m3u8_ = min_ts_count_for_m3u8.as<uint32_t>();
+        // m3u8至少要有一个切片
+        if (min_ts_count_for_m3u8_ < 1) {
+            CORE_WARN("min_ts_count_for_m3u8:{} is too small, use 1", min_ts_count_for_m3u8_);
+            min_ts_count_for_m3u8_ = 1;
+        }
+    }
+
+    auto ll_hls_enabled = config["ll_hls_enabled"];
+    if (ll_hls_enabled.IsDefined()) {
+        ll_hls_enabled_ = ll_hls_enabled.as<bool>();
+    }
+
+    auto ts_part_target_dur = config["ts_part_target_dur"];
+    if (ts_part_target_dur.IsDefined()) {
+        ts_part_target_dur_ = ts_part_target_dur.as<int32_t>();
+        if (ts_part_target_dur_ < 100) {
+            CORE_WARN("ts_part_target_dur:{}ms is too small, use 100ms", ts_part_target_dur_);
+            ts_part_target_dur_ = 100;
+        }
+    }
+
+    auto m3u8_wait_timeout = config["m3u8_wait_timeout"];
+    if (m3u8_wait_timeout.IsDefined()) {
+        m3u8_wait_timeout_ = m3u8_wait_timeout.as<uint32_t>();
+    }
+
+    auto ts_window_count = config["ts_window_count"];
+    if (ts_window_count.IsDefined()) {
+        ts_window_count_ = ts_window_count.as<uint32_t>();
+    }
+
+    auto ts_window_dur = config["ts_window_dur"];
+    if (ts_window_dur.IsDefined()) {
+        ts_window_dur_ = ts_window_dur.as<int32_t>();
+    }
+
+    auto ts_window_max_bytes = config["ts_window_max_bytes"];
+    if (ts_window_max_bytes.IsDefined()) {
+        auto v = ts_window_max_bytes.as<std::string>();
+        if (v.ends_with("k") || v.ends_with("K")) {
+            ts_window_max_bytes_ = std::atoll(v.substr(0, v.size() - 1).c_str())*1024;
+        } else if (v.ends_with("m") || v.ends_with("M")) {
+            ts_window_max_bytes_ = std::atoll(v.substr(0, v.size() - 1).c_str())*1024*1024;
+        } else {
+            ts_window_max_bytes_ = std::atoll(v.c_str());
+        }
+    }
+
+    auto m3u8_window_count = config["m3u8_window_count"];
+    if (m3u8_window_count.IsDefined()) {
+        m3u8_window_count_ = m3u8_window_count.as<uint32_t>();
+    }
+
+    auto m3u8_window_dur = config["m3u8_window_dur"];
+    if (m3u8_window_dur.IsDefined()) {
+        m3u8_window_dur_ = m3u8_window_dur.as<int32_t>();
+    }
+
+    auto cmaf_enabled = config["cmaf_enabled"];
+    if (cmaf_enabled.IsDefined()) {
+        cmaf_enabled_ = cmaf_enabled.as<bool>();
+    }
+
+    auto ts_audio_pes_max_frames = config["ts_audio_pes_max_frames"];
+    if (ts_audio_pes_max_frames.IsDefined()) {
+        ts_audio_pes_max_frames_ = ts_audio_pes_max_frames.as<int32_t>();
+        if (ts_audio_pes_max_frames_ < 1) {
+            ts_audio_pes_max_frames_ = 1;
+        } else if (ts_audio_pes_max_frames_ > 64) {
+            CORE_WARN("ts_audio_pes_max_frames:{} is too large, use 64", ts_audio_pes_max_frames_);
+            ts_audio_pes_max_frames_ = 64;
+        }
+    }
+
+    auto ts_audio_pes_max_dur = config["ts_audio_pes_max_dur"];
+    if (ts_audio_pes_max_dur.IsDefined()) {
+        ts_audio_pes_max_dur_ = std::max(ts_audio_pes_max_dur.as<int32_t>(), 0);
+    }
+
+    // 音频合并的时长不能超过partial segment时长，否则part中可能没有音频
+    if (ll_hls_enabled_ && ts_audio_pes_max_dur_ > ts_part_target_dur_ / 2) {
+        ts_audio_pes_max_dur_ = ts_part_target_dur_ / 2;
+    }
+
+    // m3u8中输出的切片必须还在内存中
+    if (m3u8_window_count_ < 1) {
+        m3u8_window_count_ = 1;
+    }
+
+    if (ts_window_count_ < m3u8_window_count_) {
+        CORE_WARN("ts_window_count:{} is less than m3u8_window_count:{}, use {}", ts_window_count_, m3u8_window_count_, m3u8_window_count_);
+        ts_window_count_ = m3u8_window_count_;
+    }
+
+    if (ts_window_dur_ > 0 && ts_window_dur_ < m3u8_window_dur_) {
+        CORE_WARN("ts_window_dur:{}ms is less than m3u8_window_dur:{}ms, use {}ms", ts_window_dur_, m3u8_window_dur_, m3u8_window_dur_);
+        ts_window_dur_ = m3u8_window_dur_;
     }
 
     return 0;
@@ -28,11 +28,66 @@ public:
     uint32_t min_ts_count_for_m3u8() const {
         return min_ts_count_for_m3u8_;
     }
+
+    bool ll_hls_enabled() const {
+        return ll_hls_enabled_;
+    }
+
+    int32_t ts_part_target_dur() const {
+        return ts_part_target_dur_;
+    }
+
+    uint32_t m3u8_wait_timeout() const {
+        return m3u8_wait_timeout_;
+    }
+
+    uint32_t ts_window_count() const {
+        return ts_window_count_;
+    }
+
+    int32_t ts_window_dur() const {
+        return ts_window_dur_;
+    }
+
+    int64_t ts_window_max_bytes() const {
+        return ts_window_max_bytes_;
+    }
+
+    uint32_t m3u8_window_count() const {
+        return m3u8_window_count_;
+    }
+
+    int32_t m3u8_window_dur() const {
+        return m3u8_window_dur_;
+    }
+
+    bool cmaf_enabled() const {
+        return cmaf_enabled_;
+    }
+
+    int32_t ts_audio_pes_max_frames() const {
+        return ts_audio_pes_max_frames_;
+    }
+
+    int32_t ts_audio_pes_max_dur() const {
+        return ts_audio_pes_max_dur_;
+    }
 protected:
     bool enabled_ = false;
     int32_t ts_min_seg_dur_ = 2000;//ts切片最小时长，默认2秒，最小不能小于1秒
     int32_t ts_max_seg_dur_ = 60000;//ts切片最大时长，默认1分钟
     int64_t ts_max_size_ = 10*1024*1024;//最大ts 10M
     uint32_t min_ts_count_for_m3u8_ = 3;//默认至少3个ts切片，才输出m3u8
+    bool ll_hls_enabled_ = false;//低延迟hls(partial segment)
+    int32_t ts_part_target_dur_ = 500;//partial segment目标时长，默认500ms
+    uint32_t m3u8_wait_timeout_ = 20000;//m3u8未就绪时请求最多等待的时长，默认20秒
+    uint32_t ts_window_count_ = 10;//内存中保留的切片个数，默认10个
+    int32_t ts_window_dur_ = 0;//内存中保留的切片时长，单位ms，配置后优先于ts_window_count
+    int64_t ts_window_max_bytes_ = 128*1024*1024;//每路流保留切片的最大字节数，默认128M
+    uint32_t m3u8_window_count_ = 5;//m3u8中输出的切片个数，默认5个
+    int32_t m3u8_window_dur_ = 0;//m3u8中输出的切片时长，单位ms，配置后优先于m3u8_window_count
+    bool cmaf_enabled_ = false;//使用fmp4(cmaf)切片代替ts，与dash共用同一份切片
+    int32_t ts_audio_pes_max_frames_ = 8;//ts中多个音频帧合并为一个PES，每个PES最多合并的帧数，1表示不合并
+    int32_t ts_audio_pes_max_dur_ = 200;//每个音频PES最多合并的时长，单位ms
 };
 };
\ No newline at end of file
@@ -30,6 +30,50 @@ int32_t WebrtcConfig::load(const YAML::Node & config) {
     if (internal_ip.IsDefined() && internal_ip.IsScalar()) {
         internal_ip_ = internal_ip.as<std::string>();
     }
+
+    auto jitter_buffer_ms = config["jitter_buffer_ms"];
+    if (jitter_buffer_ms.IsDefined() && jitter_buffer_ms.IsScalar()) {
+        jitter_buffer_ms_ = jitter_buffer_ms.as<int32_t>();
+    }
+
+    auto srtp_gcm = config["srtp_gcm"];
+    if (srtp_gcm.IsDefined() && srtp_gcm.IsScalar()) {
+        srtp_gcm_ = srtp_gcm.as<bool>();
+    }
+
+    auto dtls_cert_type = config["dtls_cert_type"];
+    if (dtls_cert_type.IsDefined() && dtls_cert_type.IsScalar()) {
+        dtls_cert_type_ = dtls_cert_type.as<std::string>();
+        boost::algorithm::to_lower(dtls_cert_type_);
+        if (dtls_cert_type_ != "ecdsa" && dtls_cert_type_ != "rsa") {
+            return -1;
+        }
+    }
+
+    auto dtls_handshake_threads = config["dtls_handshake_threads"];
+    if (dtls_handshake_threads.IsDefined() && dtls_handshake_threads.IsScalar()) {
+        dtls_handshake_threads_ = dtls_handshake_threads.as<int32_t>();
+    }
+
+    auto dtls_max_handshakes = config["dtls_max_handshakes"];
+    if (dtls_max_handshakes.IsDefined() && dtls_max_handshakes.IsScalar()) {
+        dtls_max_handshakes_ = dtls_max_handshakes.as<int32_t>();
+    }
+
+    auto dtls_max_queued = config["dtls_max_queued"];
+    if (dtls_max_queued.IsDefined() && dtls_max_queued.IsScalar()) {
+        dtls_max_queued_ = dtls_max_queued.as<int32_t>();
+    }
+
+    auto dtls_queue_timeout_ms = config["dtls_queue_timeout_ms"];
+    if (dtls_queue_timeout_ms.IsDefined() && dtls_queue_timeout_ms.IsScalar()) {
+        dtls_queue_timeout_ms_ = dtls_queue_timeout_ms.as<int32_t>();
+    }
+
+    auto fec = config["fec"];
+    if (fec.IsDefined() && fec.IsScalar()) {
+        fec_ = fec.as<bool>();
+    }
     return 0;
 }
 
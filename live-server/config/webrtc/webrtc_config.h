@@ -17,10 +17,42 @@ public:
     uint16_t get_udp_port() const;
     const std::string & get_ip() const;
     const std::string & get_internal_ip() const;
+    int32_t get_jitter_buffer_ms() const {
+        return jitter_buffer_ms_;
+    }
+    bool is_srtp_gcm_enabled() const {
+        return srtp_gcm_;
+    }
+    const std::string & get_dtls_cert_type() const {
+        return dtls_cert_type_;
+    }
+    int32_t get_dtls_handshake_threads() const {
+        return dtls_handshake_threads_;
+    }
+    int32_t get_dtls_max_handshakes() const {
+        return dtls_max_handshakes_;
+    }
+    int32_t get_dtls_max_queued() const {
+        return dtls_max_queued_;
+    }
+    int32_t get_dtls_queue_timeout_ms() const {
+        return dtls_queue_timeout_ms_;
+    }
+    bool is_fec_enabled() const {
+        return fec_;
+    }
 protected:
     bool enabled_ = false;
     uint16_t udp_port_ = 8878;
     std::string ip_;
     std::string internal_ip_;//内网ip（像阿里云eip只能看到内外网ip不一致，需要配置）
+    int32_t jitter_buffer_ms_ = 100;//推流端重排缓冲时长，缺口超过该时长未通过NACK补上则跳过并请求关键帧，0表示关闭
+    bool srtp_gcm_ = true;//DTLS-SRTP协商时优先AES-GCM，对端不支持时回落到AES128_CM_SHA1_80
+    std::string dtls_cert_type_ = "ecdsa";//DTLS证书类型，ecdsa(P-256)或rsa
+    int32_t dtls_handshake_threads_ = 2;//DTLS握手专用线程数，握手运算不占用转发媒体的worker
+    int32_t dtls_max_handshakes_ = 64;//同时进行的握手数上限，0表示不限制
+    int32_t dtls_max_queued_ = 2048;//等待握手名额的最大排队数，超过直接拒绝
+    int32_t dtls_queue_timeout_ms_ = 5000;//排队等待握手名额的最长时间
+    bool fec_ = false;//播放端(WHEP)视频FlexFEC，对端接受后按RR丢包率调整冗余比例
 };
 };
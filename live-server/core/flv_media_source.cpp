@@ -315,6 +315,9 @@ void FlvMediaSource::on_stream_ready() {
             app_->create_push_streams(shared_from_this(), s);
         }
     }
+
+    // 预热桥，第一个播放者到来时切片已经生成
+    app_->prewarm_bridges(shared_from_this());
 }
 
 bool FlvMediaSource::add_media_sink(std::shared_ptr<MediaSink> media_sink) {
@@ -348,6 +351,7 @@ std::shared_ptr<MediaBridge> FlvMediaSource::get_or_create_bridge(const std::str
 
     auto media_source = bridge->get_media_source();
     media_source->set_source_info(app->get_domain_name(), app->get_app_name(), stream_name);
+    media_source->set_upstream_source(shared_from_this());
     
     bridges_.insert(std::pair(id, bridge));
     auto lazy_sink = std::static_pointer_cast<LazyMediaSink>(media_sink);
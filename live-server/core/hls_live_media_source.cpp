@@ -10,12 +10,34 @@
 #include <algorithm>
 #include "hls_live_media_source.hpp"
 #include "protocol/ts/ts_segment.hpp"
+#include "protocol/mp4/m4s_segment.h"
+#include "protocol/http/http_cached_response.hpp"
+#include "base/utils/utils.h"
+#include "base/utils/text_builder.h"
 
 #include "app/publish_app.h"
 #include "config/app_config.h"
 
 #include "spdlog/spdlog.h"
 using namespace mms;
+namespace {
+// 获取m3u8中输出的第一个切片位置，ts和fmp4切片共用
+template<typename Seg>
+size_t get_first_seg_index(const std::deque<std::shared_ptr<Seg>> & segs, const HlsConfig & hls_conf) {
+    size_t first_seg_index = 0;
+    if (hls_conf.m3u8_window_dur() > 0) {
+        int64_t window_dur = 0;
+        first_seg_index = segs.size();
+        while (first_seg_index > 0 && window_dur < hls_conf.m3u8_window_dur()) {
+            window_dur += segs[--first_seg_index]->get_duration();
+        }
+    } else if (segs.size() > hls_conf.m3u8_window_count()) {
+        first_seg_index = segs.size() - hls_conf.m3u8_window_count();
+    }
+    return first_seg_index;
+}
+};
+
 HlsLiveMediaSource::HlsLiveMediaSource(ThreadWorker *worker, std::weak_ptr<StreamSession> session, std::shared_ptr<PublishApp> app) : MediaSource("hls", session, app, worker) {
 
 }
@@ -29,6 +51,10 @@ bool HlsLiveMediaSource::init() {
 }
 
 bool HlsLiveMediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
+    if (is_kept_alive()) {
+        return false;
+    }
+
     int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     if (now_ms - last_sinks_or_bridges_leave_time_ < milli_secs) {
         return false;
@@ -37,33 +63,133 @@ bool HlsLiveMediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
 }
 
 void HlsLiveMediaSource::update_last_access_time() {
-    last_sinks_or_bridges_leave_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    record_access(now_ms);
+    last_sinks_or_bridges_leave_time_ = now_ms;
 }
 
 bool HlsLiveMediaSource::on_ts_segment(std::shared_ptr<TsSegment> ts) {
-    ts->set_seqno(++curr_seq_no_);
-    ts->set_filename(std::to_string(curr_seq_no_) + ".ts");
+    // 淘汰的切片放到锁外释放，正在发送这些切片的读者持有引用，不受影响
+    std::vector<std::shared_ptr<TsSegment>> evicted;
     std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
-    if (ts_segments_.size() >= 10) {
-        ts_segments_.pop_front();
+    // 开启ll-hls时，序号在第一个part生成时已经分配
+    if (ts->get_seqno() == 0) {
+        ts->set_seqno(++curr_seq_no_);
+        ts->set_filename(std::to_string(curr_seq_no_) + ".ts");
     }
+
+    // 切片已完成，内容不再变化，预先生成响应头，以切片在内存中保留的时长作为缓存时长
+    auto app_conf = app_->get_conf();
+    int64_t window_ms = ts->get_duration() * 10;
+    if (app_conf) {
+        auto & hls_conf = app_conf->hls_config();
+        window_ms = hls_conf.ts_window_dur() > 0 ? hls_conf.ts_window_dur() : ts->get_duration() * hls_conf.ts_window_count();
+    }
+    int64_t max_age = std::max<int64_t>(window_ms / 1000, 1);
+    ts->set_http_response(HttpCachedResponse::create("video/MP2T", ts->get_ts_bytes(),
+                                                     std::to_string(create_at_) + "-" + std::to_string(ts->get_seqno()),
+                                                     ts->get_create_at(), "max-age=" + std::to_string(max_age)));
     ts_segments_.push_back(ts);
+    TextBuilder line;
+    line << "#EXTINF:" << TextBuilder::sec(ts->get_duration()) << "\r\n" << get_stream_name() << "/" << ts->get_filename() << "\r\n";
+    ts_seg_lines_.emplace_back(std::move(line.str()));
+    ts_segments_bytes_ += ts->get_ts_bytes();
+    ts_segments_dur_ += ts->get_duration();
+    // 先放入索引，再清除正在生成的切片，保证读者总能找到
+    ts_index_[ts->get_seqno() % TS_INDEX_SIZE].store(ts, std::memory_order_release);
+    if (curr_partial_seg_.load(std::memory_order_acquire) == ts) {
+        curr_partial_seg_.store(nullptr, std::memory_order_release);
+    }
+
+    evict_ts_segments(evicted);
+    update_cached_bytes();
+    update_m3u8();
+    return true;
+}
+
+void HlsLiveMediaSource::evict_ts_segments(std::vector<std::shared_ptr<TsSegment>> & evicted) {
+    uint32_t window_count = 10;
+    int32_t window_dur = 0;
+    int64_t window_max_bytes = INT64_MAX;
+    auto app_conf = app_->get_conf();
+    if (app_conf) {
+        window_count = app_conf->hls_config().ts_window_count();
+        window_dur = app_conf->hls_config().ts_window_dur();
+        window_max_bytes = app_conf->hls_config().ts_window_max_bytes();
+    }
+
+    // 至少保留最新的一个切片
+    while (ts_segments_.size() > 1) {
+        auto & front = ts_segments_.front();
+        bool out_of_window = false;
+        if (window_dur > 0) {
+            out_of_window = ts_segments_dur_ - front->get_duration() >= window_dur;
+        } else {
+            out_of_window = ts_segments_.size() > window_count;
+        }
+
+        if (!out_of_window && ts_segments_bytes_ <= window_max_bytes && ts_segments_.size() <= TS_INDEX_SIZE) {
+            break;
+        }
+
+        // 索引位置可能已经被新的切片占用，只清除自己
+        auto expected = front;
+        ts_index_[front->get_seqno() % TS_INDEX_SIZE].compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+        ts_segments_bytes_ -= front->get_ts_bytes();
+        ts_segments_dur_ -= front->get_duration();
+        evicted.emplace_back(std::move(front));
+        ts_segments_.pop_front();
+        ts_seg_lines_.pop_front();
+    }
+}
+
+bool HlsLiveMediaSource::on_ts_part(std::shared_ptr<TsSegment> ts) {
+    auto app_conf = app_->get_conf();
+    if (app_conf && !app_conf->hls_config().ll_hls_enabled()) {
+        return true;
+    }
+
+    std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    if (ts->get_seqno() == 0) {
+        ts->set_seqno(++curr_seq_no_);
+        ts->set_filename(std::to_string(curr_seq_no_) + ".ts");
+    }
+    curr_partial_seg_.store(ts, std::memory_order_release);
     update_m3u8();
     return true;
 }
 
 std::string HlsLiveMediaSource::get_m3u8() {
-    std::shared_lock<std::shared_mutex> lck(m3u8_mtx_);
-    return m3u8_;
+    auto m3u8_resp = m3u8_resp_.load(std::memory_order_acquire);
+    if (!m3u8_resp) {
+        return "";
+    }
+    return m3u8_resp->get_body();
+}
+
+std::shared_ptr<const HttpCachedResponse> HlsLiveMediaSource::get_m3u8_response() {
+    return m3u8_resp_.load(std::memory_order_acquire);
 }
 
 void HlsLiveMediaSource::set_m3u8(const std::string & v) {
-    std::unique_lock<std::shared_mutex> lck(m3u8_mtx_);
-    m3u8_ = v;
+    {
+        std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
+        m3u8_resp_.store(make_m3u8_response(v), std::memory_order_release);
+    }
+    m3u8_notifier_.notify();
+}
+
+boost::asio::awaitable<uint64_t> HlsLiveMediaSource::wait_m3u8_update(ThreadWorker *worker, uint64_t last_version, uint32_t timeout_ms) {
+    co_return co_await m3u8_notifier_.wait(worker, last_version, timeout_ms);
 }
 
 void HlsLiveMediaSource::update_m3u8() {
-    std::unique_lock<std::shared_mutex> lck(m3u8_mtx_);
+    build_m3u8();
+    m3u8_notifier_.notify();
+}
+
+// 调用者持有ts_segments_mtx_
+void HlsLiveMediaSource::build_m3u8() {
     auto app_conf = app_->get_conf();
     if (!app_conf) {
         return;
@@ -73,48 +199,314 @@ void HlsLiveMediaSource::update_m3u8() {
         is_ready_ = true;
     }
 
-    if (!is_ready_) {
+    // ll-hls的part可能在第一个切片完成之前就触发更新
+    if (!is_ready_ || ts_segments_.empty()) {
         return;
     }
     
-    std::stringstream ss;
     // 获取输出的第一个切片位置
-    int first_seg_index = ts_segments_.size() >= 5 ? ts_segments_.size() - 5 : 0;
+    auto & hls_conf = app_conf->hls_config();
+    size_t first_seg_index = get_first_seg_index(ts_segments_, hls_conf);
+    TextBuilder tb;
+    tb.reserve(m3u8_size_hint_);
     // 填写头部
-    
-    ss << "#EXTM3U\r\n";
-    ss << "#EXT-X-VERSION:3\r\n";
+    bool ll_hls = hls_conf.ll_hls_enabled();
+    tb << "#EXTM3U\r\n";
+    tb << "#EXT-X-VERSION:" << (ll_hls ? 6 : 3) << "\r\n";
     // 获取最大切片时长
     int64_t max_duration = 0;
     for (size_t seg_index = first_seg_index; seg_index < ts_segments_.size(); seg_index++) {
         max_duration = std::max(max_duration, ts_segments_[seg_index]->get_duration());
     }
 
-    ss << "#EXT-X-TARGETDURATION:" << (int)ceil(max_duration / 1000.0) << "\r\n";
-    ss << "#EXT-X-MEDIA-SEQUENCE:" << ts_segments_[first_seg_index]->get_seqno() << "\r\n";
-    for (size_t seg_index = first_seg_index; seg_index < ts_segments_.size(); seg_index++) {
-        max_duration = std::max(max_duration, ts_segments_[seg_index]->get_duration());
+    int64_t target_duration = (max_duration + 999) / 1000;
+    tb << "#EXT-X-TARGETDURATION:" << target_duration << "\r\n";
+    if (ll_hls) {
+        int64_t part_target = hls_conf.ts_part_target_dur();
+        tb << "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=" << TextBuilder::sec(part_target * 3) << "\r\n";
+        tb << "#EXT-X-PART-INF:PART-TARGET=" << TextBuilder::sec(part_target) << "\r\n";
     }
-    ss.precision(3);
-    ss.setf(std::ios::fixed, std::ios::floatfield);
+    tb << "#EXT-X-MEDIA-SEQUENCE:" << ts_segments_[first_seg_index]->get_seqno() << "\r\n";
+
+    // 距离列表末尾3个target duration以内的切片才输出part
+    size_t first_part_index = ts_segments_.size();
+    if (ll_hls) {
+        int64_t dur_from_end = 0;
+        while (first_part_index > first_seg_index) {
+            dur_from_end += ts_segments_[first_part_index - 1]->get_duration();
+            if (dur_from_end > target_duration * 3000) {
+                break;
+            }
+            first_part_index--;
+        }
+    }
+
+    // 切片行在切片完成时已经生成好，这里只做拼接
     for (size_t seg_index = first_seg_index; seg_index < ts_segments_.size(); seg_index++) {
-        ss << "#EXTINF:" << ts_segments_[seg_index]->get_duration() / 1000.0 << "\r\n";
-        ss << get_stream_name() << "/" << ts_segments_[seg_index]->get_filename() << "\r\n";
+        if (seg_index >= first_part_index) {
+            write_parts(tb, ts_segments_[seg_index]);
+        }
+        tb << ts_seg_lines_[seg_index];
     }
 
-    m3u8_ = ss.str();
+    if (ll_hls) {
+        // 正在生成中的切片只输出已完成的part，并提示下一个part
+        int64_t next_seqno = curr_seq_no_ + 1;
+        size_t next_part = 0;
+        auto partial_seg = curr_partial_seg_.load(std::memory_order_acquire);
+        if (partial_seg) {
+            write_parts(tb, partial_seg);
+            next_seqno = partial_seg->get_seqno();
+            next_part = partial_seg->get_part_count();
+        }
+        tb << "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"" << get_stream_name() << "/" << next_seqno << "_" << next_part << ".ts\"\r\n";
+    }
+
+    m3u8_size_hint_ = tb.size() + 256;
+    m3u8_resp_.store(make_m3u8_response(std::move(tb.str())), std::memory_order_release);
 }
 
-std::shared_ptr<TsSegment> HlsLiveMediaSource::get_ts_segment(const std::string & ts_name) {
-    std::shared_lock<std::shared_mutex> lck(ts_segments_mtx_);
-    for (auto it = ts_segments_.rbegin(); it != ts_segments_.rend(); it++) {
-        if ((*it)->get_filename() == ts_name) {
-            return *it;
+std::shared_ptr<const HttpCachedResponse> HlsLiveMediaSource::make_m3u8_response(std::string m3u8) {
+    return HttpCachedResponse::create_with_body("application/vnd.apple.mpegurl", std::move(m3u8),
+                                                std::to_string(create_at_) + "-" + std::to_string(++m3u8_seq_),
+                                                Utils::get_current_ms(), "max-age=1");
+}
+
+bool HlsLiveMediaSource::on_audio_init_segment(std::shared_ptr<Mp4Segment> seg) {
+    std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    audio_init_seg_ = seg;
+    return true;
+}
+
+bool HlsLiveMediaSource::on_video_init_segment(std::shared_ptr<Mp4Segment> seg) {
+    std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    video_init_seg_ = seg;
+    return true;
+}
+
+bool HlsLiveMediaSource::on_audio_segment(std::shared_ptr<Mp4Segment> seg) {
+    std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    update_peak_bandwidth(audio_peak_bandwidth_, seg);
+    add_mp4_segment(audio_mp4_segs_, audio_seg_lines_, seg);
+    build_cmaf_m3u8();
+    lck.unlock();
+    m3u8_notifier_.notify();
+    return true;
+}
+
+bool HlsLiveMediaSource::on_video_segment(std::shared_ptr<Mp4Segment> seg) {
+    std::unique_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    update_peak_bandwidth(video_peak_bandwidth_, seg);
+    add_mp4_segment(video_mp4_segs_, video_seg_lines_, seg);
+    build_cmaf_m3u8();
+    lck.unlock();
+    m3u8_notifier_.notify();
+    return true;
+}
+
+void HlsLiveMediaSource::update_peak_bandwidth(int64_t & peak, std::shared_ptr<Mp4Segment> seg) {
+    int64_t duration = seg->get_duration();
+    if (duration <= 0) {
+        return;
+    }
+    peak = std::max(peak, seg->get_bytes() * 8 * 1000 / duration);
+}
+
+void HlsLiveMediaSource::add_mp4_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, std::deque<std::string> & lines, std::shared_ptr<Mp4Segment> seg) {
+    // 切片数据由m4s source持有，这里只按窗口保留列表
+    uint32_t window_count = 10;
+    int32_t window_dur = 0;
+    auto app_conf = app_->get_conf();
+    if (app_conf) {
+        window_count = app_conf->hls_config().ts_window_count();
+        window_dur = app_conf->hls_config().ts_window_dur();
+    }
+
+    segs.push_back(seg);
+    TextBuilder line;
+    line << "#EXTINF:" << TextBuilder::sec(seg->get_duration()) << ",\r\n" << seg->get_filename() << "\r\n";
+    lines.emplace_back(std::move(line.str()));
+    int64_t segs_dur = 0;
+    for (auto & s : segs) {
+        segs_dur += s->get_duration();
+    }
+
+    while (segs.size() > 1) {
+        auto & front = segs.front();
+        if (window_dur > 0) {
+            if (segs_dur - front->get_duration() < window_dur) {
+                break;
+            }
+        } else if (segs.size() <= window_count) {
+            break;
+        }
+        segs_dur -= front->get_duration();
+        segs.pop_front();
+        lines.pop_front();
+    }
+    update_cached_bytes();
+}
+
+void HlsLiveMediaSource::update_cached_bytes() {
+    int64_t bytes = ts_segments_bytes_;
+    for (auto & seg : audio_mp4_segs_) {
+        bytes += seg->get_bytes();
+    }
+    for (auto & seg : video_mp4_segs_) {
+        bytes += seg->get_bytes();
+    }
+    cached_bytes_.store(bytes, std::memory_order_relaxed);
+}
+
+std::string HlsLiveMediaSource::build_media_playlist(const std::deque<std::shared_ptr<Mp4Segment>> & segs, const std::deque<std::string> & lines, 
+                                                     const std::string & init_name, const HlsConfig & hls_conf) {
+    size_t first_seg_index = get_first_seg_index(segs, hls_conf);
+    int64_t max_duration = 0;
+    for (size_t seg_index = first_seg_index; seg_index < segs.size(); seg_index++) {
+        max_duration = std::max(max_duration, segs[seg_index]->get_duration());
+    }
+
+    // 切片相对于media playlist的路径，即/app/stream/下
+    TextBuilder tb;
+    tb.reserve(m3u8_size_hint_);
+    tb << "#EXTM3U\r\n";
+    tb << "#EXT-X-VERSION:7\r\n";
+    tb << "#EXT-X-TARGETDURATION:" << (max_duration + 999) / 1000 << "\r\n";
+    tb << "#EXT-X-MEDIA-SEQUENCE:" << segs[first_seg_index]->get_seqno() << "\r\n";
+    tb << "#EXT-X-MAP:URI=\"" << init_name << "\"\r\n";
+    for (size_t seg_index = first_seg_index; seg_index < segs.size(); seg_index++) {
+        tb << lines[seg_index];
+    }
+    m3u8_size_hint_ = std::max(m3u8_size_hint_, tb.size() + 256);
+    return std::move(tb.str());
+}
+
+// 调用者持有ts_segments_mtx_
+void HlsLiveMediaSource::build_cmaf_m3u8() {
+    auto app_conf = app_->get_conf();
+    if (!app_conf) {
+        return;
+    }
+
+    bool has_video = video_init_seg_ && !video_mp4_segs_.empty();
+    bool has_audio = audio_init_seg_ && !audio_mp4_segs_.empty();
+    if (!is_ready_) {
+        // 有视频时以视频切片数为准，纯音频流以音频切片数为准
+        auto & segs = video_init_seg_ ? video_mp4_segs_ : audio_mp4_segs_;
+        if (segs.size() < app_conf->hls_config().min_ts_count_for_m3u8()) {
+            return;
+        }
+        is_ready_ = true;
+    }
+
+    if (has_video) {
+        video_m3u8_resp_.store(make_m3u8_response(build_media_playlist(video_mp4_segs_, video_seg_lines_, video_init_seg_->get_filename(), 
+                                                                       app_conf->hls_config())), std::memory_order_release);
+    }
+
+    if (has_audio) {
+        audio_m3u8_resp_.store(make_m3u8_response(build_media_playlist(audio_mp4_segs_, audio_seg_lines_, audio_init_seg_->get_filename(), 
+                                                                       app_conf->hls_config())), std::memory_order_release);
+    }
+
+    if (!has_video && !has_audio) {
+        return;
+    }
+
+    // master playlist，相对于/app/stream.m3u8，所以media playlist的路径需要带上流名
+    TextBuilder tb;
+    tb << "#EXTM3U\r\n";
+    tb << "#EXT-X-VERSION:7\r\n";
+    tb << "#EXT-X-INDEPENDENT-SEGMENTS\r\n";
+    // BANDWIDTH包含音频轨道的码率，CODECS由初始化切片中的编码信息生成，未知的编码不写
+    int64_t bandwidth = (has_video ? video_peak_bandwidth_ : 0) + (has_audio ? audio_peak_bandwidth_ : 0);
+    std::string codecs = has_video ? video_init_seg_->get_codecs() : "";
+    if (has_audio && !audio_init_seg_->get_codecs().empty()) {
+        codecs += (codecs.empty() ? "" : ",") + audio_init_seg_->get_codecs();
+    }
+
+    if (has_video && has_audio) {
+        tb << "#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"audio\",NAME=\"audio\",DEFAULT=YES,AUTOSELECT=YES,URI=\"" << get_stream_name() << "/audio.m3u8\"\r\n";
+    }
+    tb << "#EXT-X-STREAM-INF:BANDWIDTH=" << bandwidth;
+    if (!codecs.empty()) {
+        tb << ",CODECS=\"" << codecs << "\"";
+    }
+    if (has_video && has_audio) {
+        tb << ",AUDIO=\"audio\"";
+    }
+    tb << "\r\n";
+    tb << get_stream_name() << (has_video ? "/video.m3u8\r\n" : "/audio.m3u8\r\n");
+
+    // master playlist只在音视频轨道变化时更新，保持etag不变
+    auto master_resp = m3u8_resp_.load(std::memory_order_acquire);
+    if (!master_resp || master_resp->get_body() != tb.str()) {
+        m3u8_resp_.store(make_m3u8_response(std::move(tb.str())), std::memory_order_release);
+    }
+}
+
+std::shared_ptr<const HttpCachedResponse> HlsLiveMediaSource::get_media_playlist_response(const std::string & name) {
+    if (name == "video") {
+        return video_m3u8_resp_.load(std::memory_order_acquire);
+    } else if (name == "audio") {
+        return audio_m3u8_resp_.load(std::memory_order_acquire);
+    }
+    return nullptr;
+}
+
+void HlsLiveMediaSource::write_parts(TextBuilder & tb, std::shared_ptr<TsSegment> ts_seg) {
+    auto parts = ts_seg->get_parts();
+    for (size_t i = 0; i < parts.size(); i++) {
+        tb << "#EXT-X-PART:DURATION=" << TextBuilder::sec(parts[i].duration) << ",URI=\"" << get_stream_name() << "/" << ts_seg->get_seqno() << "_" << i << ".ts\"";
+        if (parts[i].independent) {
+            tb << ",INDEPENDENT=YES";
         }
+        tb << "\r\n";
+    }
+}
+
+std::shared_ptr<TsSegment> HlsLiveMediaSource::get_ts_segment(int64_t seqno) {
+    if (seqno <= 0) {
+        return nullptr;
+    }
+
+    auto ts = ts_index_[seqno % TS_INDEX_SIZE].load(std::memory_order_acquire);
+    if (ts && ts->get_seqno() == seqno) {
+        return ts;
     }
     return nullptr;
 }
 
+std::shared_ptr<TsSegment> HlsLiveMediaSource::get_ts_segment_by_seqno(int64_t seqno) {
+    auto partial_seg = curr_partial_seg_.load(std::memory_order_acquire);
+    if (partial_seg && partial_seg->get_seqno() == seqno) {
+        return partial_seg;
+    }
+    return get_ts_segment(seqno);
+}
+
+bool HlsLiveMediaSource::has_part(int64_t msn, int64_t part) {
+    std::shared_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    if (!is_ready_) {
+        return false;
+    }
+
+    if (!ts_segments_.empty() && ts_segments_.back()->get_seqno() >= msn) {
+        return true;
+    }
+
+    auto partial_seg = curr_partial_seg_.load(std::memory_order_acquire);
+    if (part < 0 || !partial_seg || partial_seg->get_seqno() != msn) {
+        return false;
+    }
+    return (int64_t)partial_seg->get_part_count() > part;
+}
+
+int64_t HlsLiveMediaSource::get_last_seqno() {
+    std::shared_lock<std::shared_mutex> lck(ts_segments_mtx_);
+    return curr_seq_no_;
+}
+
 std::shared_ptr<MediaBridge> HlsLiveMediaSource::get_or_create_bridge(const std::string & id, std::shared_ptr<PublishApp> app, 
                                                                       const std::string & stream_name) {
     ((void)id);
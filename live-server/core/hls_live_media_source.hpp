@@ -1,16 +1,24 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <array>
+#include <atomic>
+#include <vector>
 #include <mutex>
 #include <deque>
 #include <shared_mutex>
 
 #include "core/media_source.hpp"
 #include "base/obj_tracker.hpp"
+#include "base/version_notifier.h"
 
 namespace mms
 {
     class TsSegment;
+    class Mp4Segment;
+    class HlsConfig;
+    class TextBuilder;
+    class HttpCachedResponse;
     class PublishApp;
     class MediaBridge;
     class ThreadWorker;
@@ -29,25 +37,80 @@ namespace mms
 
         // 数据处理相关函数
         bool on_ts_segment(std::shared_ptr<TsSegment> TsSegment);
+        bool on_ts_part(std::shared_ptr<TsSegment> ts_seg);
+        // cmaf: 输入fmp4切片，与dash共用m4s source生成的切片
+        bool on_audio_init_segment(std::shared_ptr<Mp4Segment> seg);
+        bool on_video_init_segment(std::shared_ptr<Mp4Segment> seg);
+        bool on_audio_segment(std::shared_ptr<Mp4Segment> seg);
+        bool on_video_segment(std::shared_ptr<Mp4Segment> seg);
         // 管理及数据获取相关函数
         bool is_ready()
         {
             return is_ready_;
         }
         std::string get_m3u8();
+        // 预先序列化好的m3u8响应，每次m3u8更新时重新生成
+        std::shared_ptr<const HttpCachedResponse> get_m3u8_response();
+        // cmaf: 音频或视频的media playlist，name为audio或video，get_m3u8_response返回master playlist
+        std::shared_ptr<const HttpCachedResponse> get_media_playlist_response(const std::string &name);
+        uint64_t get_m3u8_version() {
+            return m3u8_notifier_.version();
+        }
+        // 等待m3u8更新(版本号不等于last_version)或超时，所有等待者在m3u8更新时一起唤醒
+        boost::asio::awaitable<uint64_t> wait_m3u8_update(ThreadWorker *worker, uint64_t last_version, uint32_t timeout_ms);
         void set_m3u8(const std::string &v);
-        std::shared_ptr<TsSegment> get_ts_segment(const std::string &ts_name);
+        // 按序号查找已完成的切片，不需要加锁
+        std::shared_ptr<TsSegment> get_ts_segment(int64_t seqno);
+        // ll-hls: 按序号查找切片，包括正在生成中的切片
+        std::shared_ptr<TsSegment> get_ts_segment_by_seqno(int64_t seqno);
+        // ll-hls: 判断_HLS_msn/_HLS_part指定的切片或part是否已生成
+        bool has_part(int64_t msn, int64_t part);
+        int64_t get_last_seqno();
         std::shared_ptr<MediaBridge> get_or_create_bridge(const std::string &id, std::shared_ptr<PublishApp> app, 
                                                           const std::string &stream_name);
     protected:
         std::shared_mutex ts_segments_mtx_;
         std::deque<std::shared_ptr<TsSegment>> ts_segments_;
+        // 每个切片在m3u8中的行(#EXTINF及uri)，切片完成时生成一次，与ts_segments_一一对应
+        std::deque<std::string> ts_seg_lines_;
+        int64_t ts_segments_bytes_ = 0;
+        int64_t ts_segments_dur_ = 0;
+        // 已完成切片的索引，按seqno取模存放，读取时不需要ts_segments_mtx_
+        static constexpr size_t TS_INDEX_SIZE = 1024;
+        std::array<std::atomic<std::shared_ptr<TsSegment>>, TS_INDEX_SIZE> ts_index_;
+        std::atomic<std::shared_ptr<TsSegment>> curr_partial_seg_;
+        // cmaf切片，同样由ts_segments_mtx_保护
+        std::shared_ptr<Mp4Segment> audio_init_seg_;
+        std::shared_ptr<Mp4Segment> video_init_seg_;
+        std::deque<std::shared_ptr<Mp4Segment>> audio_mp4_segs_;
+        std::deque<std::string> audio_seg_lines_;
+        std::deque<std::shared_ptr<Mp4Segment>> video_mp4_segs_;
+        std::deque<std::string> video_seg_lines_;
+        // 单个切片码率的历史最大值，用作master playlist的BANDWIDTH，只增不减以保持master playlist稳定
+        int64_t audio_peak_bandwidth_ = 0;
+        int64_t video_peak_bandwidth_ = 0;
         uint64_t curr_seq_no_ = 0;
-        std::shared_mutex m3u8_mtx_;
-        std::string m3u8_;
+        // m3u8只在ts_segments_mtx_下生成，生成后不再修改，通过原子指针发布，读者不需要加锁
+        std::atomic<std::shared_ptr<const HttpCachedResponse>> m3u8_resp_;
+        std::atomic<std::shared_ptr<const HttpCachedResponse>> audio_m3u8_resp_;
+        std::atomic<std::shared_ptr<const HttpCachedResponse>> video_m3u8_resp_;
+        uint64_t m3u8_seq_ = 0;
+        size_t m3u8_size_hint_ = 0;
+        VersionNotifier m3u8_notifier_;
         bool is_ready_ = false;
 
     private:
         void update_m3u8();
+        void evict_ts_segments(std::vector<std::shared_ptr<TsSegment>> &evicted);
+        void build_m3u8();
+        void write_parts(TextBuilder &tb, std::shared_ptr<TsSegment> ts_seg);
+        void add_mp4_segment(std::deque<std::shared_ptr<Mp4Segment>> &segs, std::deque<std::string> &lines, std::shared_ptr<Mp4Segment> seg);
+        // 窗口内切片的字节数，调用者持有ts_segments_mtx_
+        void update_cached_bytes();
+        static void update_peak_bandwidth(int64_t &peak, std::shared_ptr<Mp4Segment> seg);
+        void build_cmaf_m3u8();
+        std::string build_media_playlist(const std::deque<std::shared_ptr<Mp4Segment>> &segs, const std::deque<std::string> &lines, 
+                                         const std::string &init_name, const HlsConfig &hls_conf);
+        std::shared_ptr<const HttpCachedResponse> make_m3u8_response(std::string m3u8);
     };
 };
\ No newline at end of file
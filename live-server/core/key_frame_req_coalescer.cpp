@@ -0,0 +1,28 @@
+#include <algorithm>
+
+#include "key_frame_req_coalescer.hpp"
+using namespace mms;
+
+int64_t KeyFrameReqCoalescer::add_request(uint32_t layer, int64_t now_ms, int32_t window_ms, int32_t min_interval_ms) {
+    req_layers_ |= 1u << layer;
+    if (timer_armed_) {
+        return -1;
+    }
+    timer_armed_ = true;
+    return std::max<int64_t>(window_ms, last_sent_ms_ + min_interval_ms - now_ms);
+}
+
+uint32_t KeyFrameReqCoalescer::take_layers() {
+    timer_armed_ = false;
+    uint32_t layers = req_layers_;
+    req_layers_ = 0;
+    return layers;
+}
+
+bool KeyFrameReqCoalescer::is_periodic_due(int64_t now_ms, int32_t max_interval_ms) const {
+    return now_ms - last_sent_ms_ >= max_interval_ms && !timer_armed_;
+}
+
+int64_t KeyFrameReqCoalescer::get_periodic_delay(int64_t now_ms, int32_t max_interval_ms) const {
+    return std::max<int64_t>(last_sent_ms_ + max_interval_ms - now_ms, 100);
+}
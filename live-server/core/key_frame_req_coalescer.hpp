@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+namespace mms {
+// 源的关键帧请求合并：窗口内的多次请求(可以是不同的层)合并成一次，两次实际请求之间不小于最小间隔
+// 只做判断，不启动定时器，由MediaSource在key_frame_mtx_内调用并按返回的延迟启动定时器
+class KeyFrameReqCoalescer {
+public:
+    // 收到一次请求，返回需要启动的合并定时器的延迟，窗口内已有请求在等待时合并到其中并返回-1
+    int64_t add_request(uint32_t layer, int64_t now_ms, int32_t window_ms, int32_t min_interval_ms);
+    // 合并定时器到期，取出待请求的层掩码
+    uint32_t take_layers();
+    // 兜底请求：距上次实际请求超过max_interval_ms，并且没有等待中的请求
+    bool is_periodic_due(int64_t now_ms, int32_t max_interval_ms) const;
+    // 下一次兜底检查的延迟
+    int64_t get_periodic_delay(int64_t now_ms, int32_t max_interval_ms) const;
+    // 请求已发给推流端
+    void on_sent(int64_t now_ms) {
+        last_sent_ms_ = now_ms;
+    }
+
+    bool is_pending() const {
+        return timer_armed_;
+    }
+
+    int64_t get_last_sent_ms() const {
+        return last_sent_ms_;
+    }
+private:
+    uint32_t req_layers_ = 0;//窗口内合并的待请求层
+    bool timer_armed_ = false;
+    int64_t last_sent_ms_ = 0;
+};
+};
@@ -7,10 +7,13 @@
  * Copyright (c) 2023 by jbl19860422@gitee.com, All Rights Reserved. 
  */
 #include "log/log.h"
+#include <algorithm>
+#include <charconv>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/use_awaitable.hpp>
 #include "protocol/mp4/m4s_segment.h"
+#include "protocol/http/http_cached_response.hpp"
 #include "m4s_media_source.hpp"
 #include "m4s_media_sink.hpp"
 
@@ -21,6 +24,7 @@
 #include "bridge/bridge_factory.hpp"
 #include "core/stream_session.hpp"
 #include "app/publish_app.h"
+#include "config/app_config.h"
 
 using namespace mms;
 M4sMediaSource::M4sMediaSource(ThreadWorker *worker, std::weak_ptr<StreamSession> session, std::shared_ptr<PublishApp> app) : 
@@ -59,6 +63,104 @@ bool M4sMediaSource::init() {
     return true;
 }
 
+void M4sMediaSource::make_http_response(std::shared_ptr<Mp4Segment> seg, const std::string & content_type) {
+    // 切片已完成，内容不再变化，在分发给dash/hls之前预先生成响应头，只生成一次
+    int64_t max_age = std::max<int64_t>(seg->get_duration() * 10 / 1000, 1);
+    seg->set_http_response(HttpCachedResponse::create(content_type, seg->get_bytes(),
+                                                      std::to_string(create_at_) + "-" + seg->get_filename(),
+                                                      seg->get_create_at(), "max-age=" + std::to_string(max_age)));
+    // 响应头生成后再标记完成，读者看到完成标记时响应头一定可用
+    seg->set_reaped();
+}
+
+void M4sMediaSource::add_mp4_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, std::shared_ptr<Mp4Segment> seg) {
+    // 保留的切片不少于hls配置的窗口，保证m3u8中的切片都能取到
+    size_t window_count = 10;
+    int32_t window_dur = 0;
+    auto app_conf = app_->get_conf();
+    if (app_conf) {
+        window_count = std::max<size_t>(window_count, app_conf->hls_config().ts_window_count());
+        window_dur = app_conf->hls_config().ts_window_dur();
+    }
+
+    std::unique_lock<std::shared_mutex> lck(mp4_segs_mtx_);
+    // 序号不连续(如重新推流)时清空，保证按序号偏移查找
+    if (!segs.empty() && segs.back()->get_seqno() + 1 != seg->get_seqno()) {
+        segs.clear();
+    }
+    segs.push_back(seg);
+    int64_t segs_dur = 0;
+    for (auto & s : segs) {
+        segs_dur += s->get_duration();
+    }
+
+    while (segs.size() > window_count) {
+        if (window_dur > 0 && segs_dur - segs.front()->get_duration() < window_dur) {
+            break;
+        }
+        segs_dur -= segs.front()->get_duration();
+        segs.pop_front();
+    }
+}
+
+std::shared_ptr<Mp4Segment> M4sMediaSource::find_mp4_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, const std::string & name, size_t prefix_len) {
+    // 文件名格式为video-N.m4s/audio-N.m4s
+    int64_t seqno = 0;
+    auto ret = std::from_chars(name.data() + prefix_len, name.data() + name.size(), seqno);
+    if (ret.ec != std::errc() || std::string_view(ret.ptr, name.data() + name.size() - ret.ptr) != ".m4s") {
+        return nullptr;
+    }
+
+    std::shared_lock<std::shared_mutex> lck(mp4_segs_mtx_);
+    if (segs.empty() || seqno < segs.front()->get_seqno()) {
+        return nullptr;
+    }
+
+    size_t index = seqno - segs.front()->get_seqno();
+    if (index >= segs.size()) {
+        return nullptr;
+    }
+    return segs[index];
+}
+
+std::shared_ptr<Mp4Segment> M4sMediaSource::get_mp4_segment(const std::string & name) {
+    if (name == "video-init.m4s") {
+        return video_init_seg_.load();
+    } else if (name == "audio-init.m4s") {
+        return audio_init_seg_.load();
+    } else if (name.starts_with("video-")) {
+        // 切片完成时先放入列表再清除生成中的切片，所以这里要先查生成中的切片
+        auto curr_seg = curr_video_seg_.load(std::memory_order_acquire);
+        if (curr_seg && curr_seg->get_filename() == name) {
+            return curr_seg;
+        }
+        return find_mp4_segment(video_mp4_segs_, name, 6);
+    } else if (name.starts_with("audio-")) {
+        auto curr_seg = curr_audio_seg_.load(std::memory_order_acquire);
+        if (curr_seg && curr_seg->get_filename() == name) {
+            return curr_seg;
+        }
+        return find_mp4_segment(audio_mp4_segs_, name, 6);
+    }
+    return nullptr;
+}
+
+bool M4sMediaSource::on_audio_mp4_chunk(std::shared_ptr<Mp4Segment> mp4_seg) {
+    curr_audio_seg_.store(mp4_seg, std::memory_order_release);
+    chunk_notifier_.notify();
+    return true;
+}
+
+bool M4sMediaSource::on_video_mp4_chunk(std::shared_ptr<Mp4Segment> mp4_seg) {
+    curr_video_seg_.store(mp4_seg, std::memory_order_release);
+    chunk_notifier_.notify();
+    return true;
+}
+
+boost::asio::awaitable<uint64_t> M4sMediaSource::wait_chunk_update(ThreadWorker *worker, uint64_t last_version, uint32_t timeout_ms) {
+    co_return co_await chunk_notifier_.wait(worker, last_version, timeout_ms);
+}
+
 bool M4sMediaSource::on_combined_init_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
     combined_init_seg_.store(mp4_seg);
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
@@ -70,6 +172,7 @@ bool M4sMediaSource::on_combined_init_segment(std::shared_ptr<Mp4Segment> mp4_se
 }
 
 bool M4sMediaSource::on_audio_init_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
+    make_http_response(mp4_seg, "audio/iso.segment");
     audio_init_seg_.store(mp4_seg);
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto sink : sinks_) {
@@ -80,6 +183,7 @@ bool M4sMediaSource::on_audio_init_segment(std::shared_ptr<Mp4Segment> mp4_seg)
 }
 
 bool M4sMediaSource::on_video_init_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
+    make_http_response(mp4_seg, "video/iso.segment");
     video_init_seg_.store(mp4_seg);
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto sink : sinks_) {
@@ -90,6 +194,12 @@ bool M4sMediaSource::on_video_init_segment(std::shared_ptr<Mp4Segment> mp4_seg)
 }
 
 bool M4sMediaSource::on_audio_mp4_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
+    make_http_response(mp4_seg, "audio/iso.segment");
+    add_mp4_segment(audio_mp4_segs_, mp4_seg);
+    auto curr_seg = mp4_seg;
+    if (curr_audio_seg_.compare_exchange_strong(curr_seg, nullptr, std::memory_order_acq_rel)) {
+        chunk_notifier_.notify();
+    }
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto sink : sinks_) {
         auto s = std::static_pointer_cast<M4sMediaSink>(sink);
@@ -99,6 +209,12 @@ bool M4sMediaSource::on_audio_mp4_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
 }
 
 bool M4sMediaSource::on_video_mp4_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
+    make_http_response(mp4_seg, "video/iso.segment");
+    add_mp4_segment(video_mp4_segs_, mp4_seg);
+    auto curr_seg = mp4_seg;
+    if (curr_video_seg_.compare_exchange_strong(curr_seg, nullptr, std::memory_order_acq_rel)) {
+        chunk_notifier_.notify();
+    }
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto sink : sinks_) {
         auto s = std::static_pointer_cast<M4sMediaSink>(sink);
@@ -108,6 +224,10 @@ bool M4sMediaSource::on_video_mp4_segment(std::shared_ptr<Mp4Segment> mp4_seg) {
 }
 
 bool M4sMediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
+    if (is_kept_alive()) {
+        return false;
+    }
+
     std::shared_lock<std::shared_mutex> lck2(bridges_mtx_);
     if (sinks_count_ > 0 || bridges_.size() > 0) {
         return false;
@@ -140,10 +260,12 @@ std::shared_ptr<MediaBridge> M4sMediaSource::get_or_create_bridge(const std::str
 
     auto media_sink = bridge->get_media_sink();
     media_sink->set_source(shared_from_this());
-    MediaSource::add_media_sink(media_sink);
+    // 后创建的bridge也需要收到init segment
+    add_media_sink(media_sink);
 
     auto media_source = bridge->get_media_source();
     media_source->set_source_info(app->get_domain_name(), app->get_app_name(), stream_name);
+    media_source->set_upstream_source(shared_from_this());
     
     bridges_.insert(std::pair(id, bridge));
     return bridge;
@@ -13,6 +13,8 @@
 #include <string>
 #include <memory>
 #include <atomic>
+#include <deque>
+#include <shared_mutex>
 
 #include <boost/circular_buffer.hpp>
 
@@ -20,6 +22,7 @@
 #include "protocol/ts/ts_pes.hpp"
 #include "base/sequence_pkt_buf.hpp"
 #include "base/obj_tracker.hpp"
+#include "base/version_notifier.h"
 
 namespace mms {
 class ThreadWorker;
@@ -42,6 +45,16 @@ public:
     bool on_video_init_segment(std::shared_ptr<Mp4Segment> mp4_seg);
     bool on_audio_mp4_segment(std::shared_ptr<Mp4Segment> mp4_seg);
     bool on_video_mp4_segment(std::shared_ptr<Mp4Segment> mp4_seg);
+    // ll-dash: 生成中的切片追加了新的chunk
+    bool on_audio_mp4_chunk(std::shared_ptr<Mp4Segment> mp4_seg);
+    bool on_video_mp4_chunk(std::shared_ptr<Mp4Segment> mp4_seg);
+    // 按文件名查找切片，dash和cmaf hls共用这里的切片，包括生成中的切片
+    std::shared_ptr<Mp4Segment> get_mp4_segment(const std::string & name);
+    uint64_t get_chunk_version() {
+        return chunk_notifier_.version();
+    }
+    // 等待新的chunk或切片生成，或超时
+    boost::asio::awaitable<uint64_t> wait_chunk_update(ThreadWorker *worker, uint64_t last_version, uint32_t timeout_ms);
 
     std::shared_ptr<MediaBridge> get_or_create_bridge(const std::string & id, std::shared_ptr<PublishApp> app, const std::string & stream_name);
     bool has_no_sinks_for_time(uint32_t milli_secs);
@@ -49,7 +62,16 @@ protected:
     std::atomic<std::shared_ptr<Mp4Segment>> combined_init_seg_;
     std::atomic<std::shared_ptr<Mp4Segment>> audio_init_seg_;
     std::atomic<std::shared_ptr<Mp4Segment>> video_init_seg_;
+    std::shared_mutex mp4_segs_mtx_;
     std::deque<std::shared_ptr<Mp4Segment>> audio_mp4_segs_;
     std::deque<std::shared_ptr<Mp4Segment>> video_mp4_segs_;
+    // 生成中的切片
+    std::atomic<std::shared_ptr<Mp4Segment>> curr_audio_seg_;
+    std::atomic<std::shared_ptr<Mp4Segment>> curr_video_seg_;
+    VersionNotifier chunk_notifier_;
+private:
+    void make_http_response(std::shared_ptr<Mp4Segment> seg, const std::string & content_type);
+    void add_mp4_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, std::shared_ptr<Mp4Segment> seg);
+    std::shared_ptr<Mp4Segment> find_mp4_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, const std::string & name, size_t prefix_len);
 };
 };
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/use_awaitable.hpp>
@@ -12,6 +13,7 @@
 
 #include "codec/codec.hpp"
 #include "config/config.h"
+#include "config/app_config.h"
 
 #include "bridge/media_bridge.hpp"
 #include "bridge/bridge_factory.hpp"
@@ -23,6 +25,7 @@
 #include "core/stream_session.hpp"
 
 #include "base/network/bitrate_monitor.h"
+#include "base/utils/utils.h"
 
 using namespace mms;
 
@@ -56,6 +59,18 @@ Json::Value MediaSource::to_json() {
     if (acodec) {
         v["acodec"] = acodec->to_json();
     }
+
+    std::lock_guard<std::mutex> lck(key_frame_mtx_);
+    if (key_frame_requester_) {
+        Json::Value kf;
+        kf["join"] = (Json::UInt64)key_frame_req_counts_[KEY_FRAME_REASON_JOIN];
+        kf["decode_error"] = (Json::UInt64)key_frame_req_counts_[KEY_FRAME_REASON_DECODE_ERROR];
+        kf["packet_lost"] = (Json::UInt64)key_frame_req_counts_[KEY_FRAME_REASON_PACKET_LOST];
+        kf["layer_switch"] = (Json::UInt64)key_frame_req_counts_[KEY_FRAME_REASON_LAYER_SWITCH];
+        kf["periodic"] = (Json::UInt64)key_frame_req_counts_[KEY_FRAME_REASON_PERIODIC];
+        kf["sent"] = (Json::UInt64)key_frame_sent_count_;
+        v["key_frame_requests"] = kf;
+    }
     return v;
 }
 
@@ -108,16 +123,52 @@ void MediaSource::set_source_info(const std::string & domain, const std::string
 }
 
 bool MediaSource::add_media_sink(std::shared_ptr<MediaSink> media_sink) {
-    std::unique_lock<std::shared_mutex> lck(sinks_mtx_);
-    sinks_.insert(media_sink);
-    media_sink->set_source(this->shared_from_this());
-    if (get_status() != E_SOURCE_STATUS_INIT) {
-        media_sink->on_source_status_changed(status_.load());
+    {
+        std::unique_lock<std::shared_mutex> lck(sinks_mtx_);
+        sinks_.insert(media_sink);
+        media_sink->set_source(this->shared_from_this());
+        if (get_status() != E_SOURCE_STATUS_INIT) {
+            media_sink->on_source_status_changed(status_.load());
+        }
+        sinks_count_++;
+    }
+    record_join();
+    // 没有GOP缓存的源，新加入的订阅者(或桥)要等下一个关键帧才能解码
+    if (!has_gop_cache()) {
+        request_key_frame(KEY_FRAME_REASON_JOIN);
     }
-    sinks_count_++;
     return true;
 }
 
+void MediaSource::record_join() {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    last_join_time_ = now_ms;
+    std::lock_guard<std::mutex> lck(joins_mtx_);
+    join_times_.push_back(now_ms);
+    while (!join_times_.empty() && now_ms - join_times_.front() > JOIN_WINDOW_MS) {
+        join_times_.pop_front();
+    }
+}
+
+void MediaSource::record_access(int64_t now_ms) {
+    // 并发的请求只有一个会看到间隔，不会重复计数
+    int64_t prev = last_access_time_.exchange(now_ms);
+    if (now_ms - prev > ACCESS_JOIN_GAP_MS) {
+        record_join();
+    }
+}
+
+uint32_t MediaSource::get_idle_timeout(uint32_t base_ms) {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lck(joins_mtx_);
+    while (!join_times_.empty() && now_ms - join_times_.front() > JOIN_WINDOW_MS) {
+        join_times_.pop_front();
+    }
+    // 第一次加入不算，之后窗口内每多一次加入，超时多延长一个基准时长
+    uint32_t rejoins = join_times_.size() > 1 ? join_times_.size() - 1 : 0;
+    return base_ms * std::min(1 + rejoins, MAX_IDLE_FACTOR);
+}
+
 bool MediaSource::remove_media_sink(std::shared_ptr<MediaSink> media_sink) {
     std::unique_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto it = sinks_.begin(); it != sinks_.end(); it++) {
@@ -161,7 +212,24 @@ bool MediaSource::remove_bridge(const std::string & id) {
     return true;
 }
 
+bool MediaSource::is_kept_alive() {
+    if (!prewarmed_ || !app_) {
+        return false;
+    }
+
+    auto app_conf = app_->get_conf();
+    if (!app_conf) {
+        return false;
+    }
+    // 本应用预热的桥持有的切片超出预算时不再保持，按正常的无人播放超时拆除
+    return app_->get_prewarm_bytes() < app_conf->bridge_config().prewarm_mem_budget();
+}
+
 bool MediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
+    if (is_kept_alive()) {
+        return false;
+    }
+
     std::shared_lock<std::shared_mutex> lck2(bridges_mtx_);
     if (sinks_count_ > 0 || bridges_.size() > 0) {
         return false;
@@ -230,6 +298,112 @@ void MediaSource::add_recorder(const std::string & type, std::shared_ptr<Recorde
     recorders_[type] = recorder;
 }
 
+void MediaSource::set_key_frame_requester(const std::function<void(uint32_t layers)> & requester) {
+    std::lock_guard<std::mutex> lck(key_frame_mtx_);
+    key_frame_requester_ = requester;
+}
+
+void MediaSource::request_key_frame(KeyFrameReason reason, uint32_t layer) {
+    int32_t window_ms = 100;
+    int32_t min_interval_ms = 1000;
+    auto app_conf = app_ ? app_->get_conf() : nullptr;
+    if (app_conf) {
+        window_ms = app_conf->get_key_frame_req_window_ms();
+        min_interval_ms = app_conf->get_key_frame_req_min_interval_ms();
+    }
+
+    std::unique_lock<std::mutex> lck(key_frame_mtx_);
+    if (!key_frame_requester_) {
+        auto upstream = upstream_source_.lock();
+        lck.unlock();
+        if (upstream) {
+            upstream->request_key_frame(reason, 0);
+        }
+        return;
+    }
+
+    key_frame_req_counts_[reason]++;
+    int64_t delay_ms = key_frame_coalescer_.add_request(layer, Utils::get_current_ms(), window_ms, min_interval_ms);
+    if (delay_ms < 0) {// 窗口内已有请求在等待，合并
+        return;
+    }
+    lck.unlock();
+    start_key_frame_timer(delay_ms, false);
+}
+
+void MediaSource::start_key_frame_timer(int64_t delay_ms, bool periodic) {
+    auto self(shared_from_this());
+    boost::asio::co_spawn(worker_->get_io_context(), [this, self, delay_ms, periodic]()->boost::asio::awaitable<void> {
+        boost::system::error_code ec;
+        boost::asio::steady_timer timer(worker_->get_io_context());
+        timer.expires_after(std::chrono::milliseconds(delay_ms));
+        co_await timer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        on_key_frame_timer(periodic);
+        co_return;
+    }, boost::asio::detached);
+}
+
+bool MediaSource::need_periodic_key_frame() {
+    {
+        std::shared_lock<std::shared_mutex> lck(bridges_mtx_);
+        if (!bridges_.empty()) {
+            return true;
+        }
+    }
+    std::shared_lock<std::shared_mutex> lck(recorder_mtx_);
+    return !recorders_.empty();
+}
+
+void MediaSource::on_key_frame_timer(bool periodic) {
+    int32_t max_interval_ms = 4000;
+    auto app_conf = app_ ? app_->get_conf() : nullptr;
+    if (app_conf) {
+        max_interval_ms = app_conf->get_key_frame_max_interval_ms();
+    }
+    // 转协议、录制的切片依赖关键帧，推流端(如浏览器)的GOP可能很长，需要兜底
+    bool need_periodic = max_interval_ms > 0 && !closed_.test() && need_periodic_key_frame();
+
+    std::function<void(uint32_t layers)> requester;
+    uint32_t layers = 0;
+    int64_t next_periodic_ms = -1;
+    {
+        std::lock_guard<std::mutex> lck(key_frame_mtx_);
+        int64_t now_ms = Utils::get_current_ms();
+        if (periodic) {
+            if (!need_periodic || !key_frame_requester_) {
+                periodic_key_frame_running_ = false;
+            } else if (key_frame_coalescer_.is_periodic_due(now_ms, max_interval_ms)) {
+                key_frame_req_counts_[KEY_FRAME_REASON_PERIODIC]++;
+                layers = 1;
+            }
+        } else {
+            layers = key_frame_coalescer_.take_layers();
+            if (need_periodic && !periodic_key_frame_running_) {
+                periodic_key_frame_running_ = true;
+                next_periodic_ms = max_interval_ms;
+            }
+        }
+
+        if (layers != 0 && key_frame_requester_ && !closed_.test()) {
+            requester = key_frame_requester_;
+            key_frame_coalescer_.on_sent(now_ms);
+            key_frame_sent_count_++;
+        }
+
+        if (periodic && periodic_key_frame_running_) {
+            next_periodic_ms = key_frame_coalescer_.get_periodic_delay(now_ms, max_interval_ms);
+        }
+    }
+
+    if (requester) {
+        requester(layers);
+    }
+
+    if (next_periodic_ms >= 0) {
+        start_key_frame_timer(next_periodic_ms, true);
+    }
+}
+
 bool MediaSource::is_stream_ready() {
     return stream_ready_;
 }
@@ -239,6 +413,7 @@ void MediaSource::close() {
         return;
     }
 
+    set_key_frame_requester(nullptr);
     auto self(shared_from_this());
     boost::asio::co_spawn(worker_->get_io_context(), [self, this]()->boost::asio::awaitable<void> {
         auto session = get_session();
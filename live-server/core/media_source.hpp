@@ -2,6 +2,7 @@
 #include <memory>
 #include <string>
 #include <set>
+#include <deque>
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
@@ -12,6 +13,7 @@
 #include "base/wait_group.h"
 #include "json/json.h"
 #include "source_status.h"
+#include "key_frame_req_coalescer.hpp"
 #include "base/thread/thread_worker.hpp"
 
 namespace mms {
@@ -29,6 +31,15 @@ class MediaEvent;
 class MediaSource : public std::enable_shared_from_this<MediaSource> {
     friend class MediaSink;
 public:
+    // 关键帧请求的原因
+    enum KeyFrameReason {
+        KEY_FRAME_REASON_JOIN = 0,//新的订阅者或桥加入，源没有缓存GOP
+        KEY_FRAME_REASON_DECODE_ERROR,//下游上报解码错误(PLI/FIR)
+        KEY_FRAME_REASON_PACKET_LOST,//丢包NACK补不回来
+        KEY_FRAME_REASON_LAYER_SWITCH,//simulcast切层
+        KEY_FRAME_REASON_PERIODIC,//有转协议、录制时的兜底请求
+        KEY_FRAME_REASON_MAX,
+    };
     MediaSource(const std::string & media_type, std::weak_ptr<StreamSession> session, std::shared_ptr<PublishApp> app, ThreadWorker *worker);
 
     virtual ~MediaSource();
@@ -57,6 +68,24 @@ public:
     bool set_session(std::shared_ptr<StreamSession> s);
 
     virtual bool has_no_sinks_for_time(uint32_t milli_secs);
+    // 预热创建的桥，源存在期间保持，不因为没有播放者而拆除
+    void set_prewarmed(bool v) {
+        prewarmed_ = v;
+    }
+    bool is_kept_alive();
+    // 持有的切片字节数，预热的桥按此计入所属应用的预热内存预算
+    int64_t get_cached_bytes() const {
+        return cached_bytes_.load(std::memory_order_relaxed);
+    }
+    // 近期有观众频繁加入时放大空闲超时，避免观众进进出出的流上反复创建/销毁桥
+    uint32_t get_idle_timeout(uint32_t base_ms);
+    bool is_idle(uint32_t base_ms) {
+        return has_no_sinks_for_time(get_idle_timeout(base_ms));
+    }
+
+    int64_t get_last_join_time() const {
+        return last_join_time_;
+    }
     void set_source_info(const std::string & domain, const std::string & app_name, const std::string & stream_name);
     const std::string & get_domain_name() const {
         return domain_name_;
@@ -100,6 +129,20 @@ public:
 
     SourceStatus get_status() const;
     void set_status(SourceStatus status);
+
+    // 按需请求关键帧，任意线程可调用
+    // 窗口内的多次请求合并成一次，两次之间不小于最小间隔，到期后在源的worker上调用推流端设置的requester，
+    // 由推流端按协议发送(WebRTC/RTSP为PLI)，没有requester的源(如转协议生成的源)转给上游源
+    void request_key_frame(KeyFrameReason reason, uint32_t layer = 0);
+    // layers为待请求关键帧的层掩码，非simulcast只有第0层
+    void set_key_frame_requester(const std::function<void(uint32_t layers)> & requester);
+    void set_upstream_source(std::weak_ptr<MediaSource> upstream) {
+        upstream_source_ = upstream;
+    }
+    // 缓存了GOP或切片的源，新订阅者从缓存的关键帧开始，加入时不需要请求关键帧
+    virtual bool has_gop_cache() {
+        return true;
+    }
     
     virtual Json::Value to_json();
 
@@ -124,11 +167,21 @@ public:
     boost::asio::awaitable<Json::Value> sync_to_json();
     void notify_status(SourceStatus status);
     virtual void close();
+protected:
+    void record_join();
+    // hls/dash通过http拉取，没有sink，一段时间没有请求后的再次请求算作一次加入
+    void record_access(int64_t now_ms);
+    void start_key_frame_timer(int64_t delay_ms, bool periodic);
+    void on_key_frame_timer(bool periodic);
+    bool need_periodic_key_frame();
 protected:
     bool is_origin_ = false;
     std::atomic_flag closed_ = ATOMIC_FLAG_INIT;
     std::string media_type_;//rtmp,rtsp,flv,hls,ts,gb28181,webrtc,srt...
     bool stream_ready_ = false;
+    std::atomic<bool> prewarmed_{false};
+    // 由持有切片的子类在切片进出窗口时更新
+    std::atomic<int64_t> cached_bytes_{0};
     std::atomic<uint32_t> sinks_count_{0};
     std::atomic<uint32_t> bridge_count_{0};
     std::mutex session_mutex_;
@@ -141,6 +194,15 @@ protected:
     std::shared_mutex bridges_mtx_;
     std::unordered_map<std::string, std::shared_ptr<MediaBridge>> bridges_;//桥接类型的sink，意味着这只是一个桥，没人的时候要拆掉，而且桥可以转换格式之类的   
     int64_t last_sinks_or_bridges_leave_time_ = -1; 
+    // 统计窗口内的加入时间，用于计算自适应的空闲超时
+    static constexpr int64_t JOIN_WINDOW_MS = 10*60*1000;
+    static constexpr uint32_t MAX_IDLE_FACTOR = 6;
+    std::mutex joins_mtx_;
+    std::deque<int64_t> join_times_;
+    std::atomic<int64_t> last_join_time_{0};
+    // 播放中的hls/dash播放器至少每个切片时长请求一次m3u8/mpd或切片
+    static constexpr int64_t ACCESS_JOIN_GAP_MS = 10*1000;
+    std::atomic<int64_t> last_access_time_{0};
     std::shared_mutex recorder_mtx_;
     std::unordered_map<std::string, std::shared_ptr<Recorder>> recorders_;
 
@@ -158,5 +220,13 @@ protected:
     std::atomic<SourceStatus> status_{E_SOURCE_STATUS_INIT};
 
     std::string client_ip_;//创建该流的对端ip
+
+    std::mutex key_frame_mtx_;
+    std::function<void(uint32_t layers)> key_frame_requester_;
+    std::weak_ptr<MediaSource> upstream_source_;
+    KeyFrameReqCoalescer key_frame_coalescer_;
+    bool periodic_key_frame_running_ = false;
+    uint64_t key_frame_req_counts_[KEY_FRAME_REASON_MAX] = {0};//按原因统计收到的请求
+    uint64_t key_frame_sent_count_ = 0;//实际发给推流端的请求数
 };
 };
\ No newline at end of file
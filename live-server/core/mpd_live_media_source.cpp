@@ -14,12 +14,11 @@
 #include <boost/asio/detached.hpp>
 #include <boost/asio/use_awaitable.hpp>
 #include <chrono>
-#include <format>
-#include <sstream>
 
 #include "app/publish_app.h"
 #include "base/thread/thread_worker.hpp"
 #include "base/utils/utils.h"
+#include "base/utils/text_builder.h"
 #include "config/app_config.h"
 #include "core/stream_session.hpp"
 #include "protocol/mp4/m4s_segment.h"
@@ -37,6 +36,10 @@ MpdLiveMediaSource::~MpdLiveMediaSource() {}
 bool MpdLiveMediaSource::init() { return true; }
 
 bool MpdLiveMediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
+    if (is_kept_alive()) {
+        return false;
+    }
+
     int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                          std::chrono::steady_clock::now().time_since_epoch())
                          .count();
@@ -47,12 +50,15 @@ bool MpdLiveMediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
 }
 
 void MpdLiveMediaSource::update_last_access_time() {
-    last_sinks_or_bridges_leave_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                            std::chrono::steady_clock::now().time_since_epoch())
-                                            .count();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+    record_access(now_ms);
+    last_sinks_or_bridges_leave_time_ = now_ms;
 }
 
 bool MpdLiveMediaSource::on_audio_init_segment(std::shared_ptr<Mp4Segment> seg) {
+    // 响应头已经在m4s source中生成
     std::unique_lock<std::shared_mutex> lck(segments_mtx_);
     audio_init_seg_ = seg;
     // update_mpd();
@@ -68,36 +74,100 @@ bool MpdLiveMediaSource::on_video_init_segment(std::shared_ptr<Mp4Segment> seg)
 
 bool MpdLiveMediaSource::on_audio_segment(std::shared_ptr<Mp4Segment> seg) {
     std::unique_lock<std::shared_mutex> lck(segments_mtx_);
-    if (audio_segments_.size() >= 10) {
-        audio_segments_.pop_front();
-    }
-    audio_segments_.push_back(seg);
+    add_segment(audio_segments_, audio_seg_lines_, seg);
     update_mpd();
     return true;
 }
 
 bool MpdLiveMediaSource::on_video_segment(std::shared_ptr<Mp4Segment> seg) {
     std::unique_lock<std::shared_mutex> lck(segments_mtx_);
-    if (video_segments_.size() >= 10) {
-        video_segments_.pop_front();
-    }
-    video_segments_.push_back(seg);
+    add_segment(video_segments_, video_seg_lines_, seg);
     update_mpd();
     return true;
 }
 
-std::string MpdLiveMediaSource::get_mpd() {
-    std::shared_lock<std::shared_mutex> lck(mpd_mtx_);
-    return mpd_;
+void MpdLiveMediaSource::add_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, std::deque<std::string> & lines, std::shared_ptr<Mp4Segment> seg) {
+    if (segs.size() >= 10) {
+        segs.pop_front();
+        lines.pop_front();
+    }
+    segs.push_back(seg);
+    TextBuilder line;
+    line << "                        <S t=\"" << seg->get_start_timestamp() << "\" d=\"" << seg->get_duration() << "\" />\n";
+    lines.emplace_back(std::move(line.str()));
+    update_cached_bytes();
+}
+
+void MpdLiveMediaSource::update_cached_bytes() {
+    int64_t bytes = 0;
+    for (auto & seg : audio_segments_) {
+        bytes += seg->get_bytes();
+    }
+    for (auto & seg : video_segments_) {
+        bytes += seg->get_bytes();
+    }
+    cached_bytes_.store(bytes, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const std::string> MpdLiveMediaSource::get_mpd() {
+    return mpd_.load(std::memory_order_acquire);
 }
 
 void MpdLiveMediaSource::set_mpd(const std::string &v) {
-    std::unique_lock<std::shared_mutex> lck(mpd_mtx_);
-    mpd_ = v;
+    mpd_.store(std::make_shared<const std::string>(v), std::memory_order_release);
+}
+
+std::string MpdLiveMediaSource::get_mpd_tail() {
+    if (!ll_dash_.load(std::memory_order_relaxed)) {
+        return "</MPD>\n";
+    }
+    // ll-dash播放器需要和服务器对时来计算切片可用时间
+    return "    <UTCTiming schemeIdUri=\"urn:mpeg:dash:utc:direct:2014\" value=\"" + Utils::get_utc_time_with_millis() + "\" />\n</MPD>\n";
+}
+
+int64_t MpdLiveMediaSource::measure_bandwidth(const std::deque<std::shared_ptr<Mp4Segment>> & segs) {
+    int64_t bytes = 0;
+    int64_t duration = 0;
+    for (auto & seg : segs) {
+        bytes += seg->get_bytes();
+        duration += seg->get_duration();
+    }
+
+    if (duration <= 0) {
+        return 0;
+    }
+    return bytes * 8 * 1000 / duration;
+}
+
+void MpdLiveMediaSource::write_adaptation_set(TextBuilder & tb, const std::deque<std::shared_ptr<Mp4Segment>> & segs, const std::deque<std::string> & lines,
+                                              const std::string & type, int64_t bandwidth, const std::string & codecs, int64_t availability_time_offset) {
+    size_t start_seg_index = segs.size() >= 3 ? segs.size() - 3 : 0;
+    tb << "        <AdaptationSet mimeType=\"" << type << "/mp4\" segmentAlignment=\"true\" startWithSAP=\"1\">\n";
+    tb << "            <Representation id=\"" << type << "\" bandwidth=\"" << bandwidth << "\"";
+    if (!codecs.empty()) {
+        tb << " codecs=\"" << codecs << "\"";
+    }
+    tb << ">\n";
+    tb << "                <SegmentTemplate initialization=\"$RepresentationID$-init.m4s\" "
+       << "media=\"$RepresentationID$-$Number$.m4s\" "
+       << "startNumber=\"" << segs.at(start_seg_index)->get_seqno() << "\" "
+       << "timescale=\"1000\"";
+    if (availability_time_offset >= 0) {
+        tb << " availabilityTimeOffset=\"" << TextBuilder::sec(availability_time_offset) << "\" availabilityTimeComplete=\"false\"";
+    }
+    tb << ">\n";
+    tb << "                    <SegmentTimeline>\n";
+    for (size_t i = start_seg_index; i < lines.size(); ++i) {
+        tb << lines[i];
+    }
+    tb << "                    </SegmentTimeline>\n";
+    tb << "                </SegmentTemplate>\n";
+    tb << "            </Representation>\n";
+    tb << "        </AdaptationSet>\n";
 }
 
+// 调用者持有segments_mtx_
 void MpdLiveMediaSource::update_mpd() {
-    std::unique_lock<std::shared_mutex> lck(mpd_mtx_);
     auto app_conf = app_->get_conf();
     if (!app_conf) {
         return;
@@ -115,81 +185,67 @@ void MpdLiveMediaSource::update_mpd() {
         return;
     }
 
-    double last_duration = 0;
+    int64_t last_duration = 0;
     if (audio_segments_.size() > 0) {
         last_duration = audio_segments_[audio_segments_.size() - 1]->get_duration();
     }
 
     if (video_segments_.size() > 0) {
-        last_duration =
-            std::max((double)video_segments_[video_segments_.size() - 1]->get_duration(), last_duration);
+        last_duration = std::max(video_segments_[video_segments_.size() - 1]->get_duration(), last_duration);
     }
 
-    std::stringstream ss;
-    ss << "<?xml version=\"1.0\" encoding=\"utf-8\"?>" << std::endl
+    int64_t max_duration = 0;
+    for (auto & seg : audio_segments_) {
+        max_duration = std::max(max_duration, seg->get_duration());
+    }
+
+    for (auto & seg : video_segments_) {
+        max_duration = std::max(max_duration, seg->get_duration());
+    }
+
+    // ll-dash: 切片按chunk生成，切片开始生成后就可以请求，提前量为切片时长减去一个chunk
+    int32_t chunk_dur = app_conf->get_fmp4_chunk_dur();
+    bool ll_dash = chunk_dur > 0;
+    int64_t availability_time_offset = -1;
+    if (ll_dash) {
+        availability_time_offset = std::max(app_conf->get_fmp4_min_seg_dur() - chunk_dur, 0);
+    }
+
+    TextBuilder tb;
+    tb.reserve(mpd_size_hint_);
+    tb << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
        << "<MPD "
-          "profiles=\"urn:mpeg:dash:profile:isoff-live:2011,http://dashif.org/guidelines/dash-if-simple\" "
-       << std::endl
-       << "    ns1:schemaLocation=\"urn:mpeg:dash:schema:mpd:2011 DASH-MPD.xsd\" " << std::endl
+          "profiles=\"urn:mpeg:dash:profile:isoff-live:2011,http://dashif.org/guidelines/dash-if-simple\" \n"
+       << "    ns1:schemaLocation=\"urn:mpeg:dash:schema:mpd:2011 DASH-MPD.xsd\" \n"
        << "    xmlns=\"urn:mpeg:dash:schema:mpd:2011\" "
-          "    xmlns:ns1=\"http://www.w3.org/2001/XMLSchema-instance\" "
-       << std::endl
-       << "    type=\"dynamic\" " << std::endl
-       << "    maxSegmentDuration=\"PT5.0S\"" << std::endl
-       << "    minimumUpdatePeriod=\"PT" << 5 << "S\" " << std::endl
-       << "    suggestedPresentationDelay=\"PT10S\"" << std::endl
-       << "    timeShiftBufferDepth=\"PT" << 6 * (last_duration / 1000) << "S\" " << std::endl
-       << "    availabilityStartTime=\"" << availabilityStartTime << "\" " << std::endl
-       << "    publishTime=\"" << Utils::get_utc_time_with_millis() << "\" " << std::endl
-       << "    minBufferTime=\"PT" << 4 * (last_duration / 1000) << "S\" >" << std::endl;
-    ss << "    <BaseURL>" << stream_name_ << "/" << "</BaseURL>" << std::endl;
-    ss << "    <Period start=\"PT0S\">" << std::endl;
+          "    xmlns:ns1=\"http://www.w3.org/2001/XMLSchema-instance\" \n"
+       << "    type=\"dynamic\" \n"
+       << "    maxSegmentDuration=\"PT" << TextBuilder::sec(max_duration) << "S\"\n"
+       << "    minimumUpdatePeriod=\"PT" << TextBuilder::sec(last_duration) << "S\" \n"
+       << "    suggestedPresentationDelay=\"PT" << TextBuilder::sec(ll_dash ? 2 * chunk_dur : 10000) << "S\"\n"
+       << "    timeShiftBufferDepth=\"PT" << TextBuilder::sec(6 * last_duration) << "S\" \n"
+       << "    availabilityStartTime=\"" << availabilityStartTime << "\" \n"
+       << "    publishTime=\"" << Utils::get_utc_time_with_millis() << "\" \n"
+       << "    minBufferTime=\"PT" << TextBuilder::sec(4 * last_duration) << "S\" >\n";
+    tb << "    <BaseURL>" << stream_name_ << "/" << "</BaseURL>\n";
+    if (ll_dash) {// ll-dash播放器需要和服务器对时来计算切片可用时间
+        tb << "    <ServiceDescription id=\"0\">\n"
+           << "        <Latency target=\"" << app_conf->get_fmp4_min_seg_dur() + chunk_dur << "\" />\n"
+           << "    </ServiceDescription>\n";
+    }
+    tb << "    <Period start=\"PT0S\">\n";
 
     if (audio_init_seg_ && !audio_segments_.empty()) {
-        size_t start_seg_index = audio_segments_.size() >= 3 ? audio_segments_.size() - 3 : 0;
-        ss << "        <AdaptationSet mimeType=\"audio/mp4\" segmentAlignment=\"true\" startWithSAP=\"1\">"
-           << std::endl;
-        ss << "            <Representation id=\"audio\" bandwidth=\"48000\" codecs=\"mp4a.40.2\">"
-           << std::endl;
-        ss << "                <SegmentTemplate initialization=\"$RepresentationID$-init.m4s\" "
-           << "media=\"$RepresentationID$-$Number$.m4s\" "
-           << "startNumber=\"" << audio_segments_.at(start_seg_index)->get_seqno() << "\" "
-           << "timescale=\"1000\">" << std::endl;
-        ss << "                    <SegmentTimeline>" << std::endl;
-        for (size_t i = start_seg_index; i < audio_segments_.size(); ++i) {
-            ss << "                        <S t=\"" << audio_segments_.at(i)->get_start_timestamp() << "\" ";
-            ss << "d=\"" << audio_segments_.at(i)->get_duration() << "\" />" << std::endl;
-        }
-        ss << "                    </SegmentTimeline>" << std::endl;
-        ss << "                </SegmentTemplate>" << std::endl;
-        ss << "            </Representation>" << std::endl;
-        ss << "        </AdaptationSet>" << std::endl;
+        write_adaptation_set(tb, audio_segments_, audio_seg_lines_, "audio", measure_bandwidth(audio_segments_), audio_init_seg_->get_codecs(), availability_time_offset);
     }
 
     if (video_init_seg_ && !video_segments_.empty()) {
-        size_t start_seg_index = video_segments_.size() >= 3 ? video_segments_.size() - 3 : 0;
-        ss << "        <AdaptationSet mimeType=\"video/mp4\" segmentAlignment=\"true\" startWithSAP=\"1\">"
-           << std::endl;
-        ss << "            <Representation id=\"video\" bandwidth=\"800000\" codecs=\"avc1.64001e\">"
-           << std::endl;
-        ss << "                <SegmentTemplate initialization=\"$RepresentationID$-init.m4s\" "
-           << "media=\"$RepresentationID$-$Number$.m4s\" "
-           << "startNumber=\"" << video_segments_.at(start_seg_index)->get_seqno() << "\" "
-           << "timescale=\"1000\">" << std::endl;
-        ss << "                    <SegmentTimeline>" << std::endl;
-        for (size_t i = start_seg_index; i < video_segments_.size(); ++i) {
-            ss << "                        <S t=\"" << video_segments_.at(i)->get_start_timestamp() << "\" ";
-            ss << "d=\"" << video_segments_.at(i)->get_duration() << "\" />" << std::endl;
-        }
-        ss << "                    </SegmentTimeline>" << std::endl;
-        ss << "                </SegmentTemplate>" << std::endl;
-        ss << "            </Representation>" << std::endl;
-        ss << "        </AdaptationSet>" << std::endl;
-    }
-    ss << "    </Period>" << std::endl;
-    ss << "</MPD>" << std::endl;
-    mpd_ = ss.str();
-    // spdlog::info("update mpd:{}", mpd_);
+        write_adaptation_set(tb, video_segments_, video_seg_lines_, "video", measure_bandwidth(video_segments_), video_init_seg_->get_codecs(), availability_time_offset);
+    }
+    tb << "    </Period>\n";
+    mpd_size_hint_ = tb.size() + 256;
+    ll_dash_.store(ll_dash, std::memory_order_relaxed);
+    mpd_.store(std::make_shared<const std::string>(std::move(tb.str())), std::memory_order_release);
 }
 
 std::shared_ptr<Mp4Segment> MpdLiveMediaSource::get_mp4_segment(const std::string &name) {
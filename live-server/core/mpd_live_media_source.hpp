@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <atomic>
 #include <string>
 #include <mutex>
 #include <deque>
@@ -14,6 +15,7 @@ class PublishApp;
 class MediaBridge;
 class ThreadWorker;
 class StreamSession;
+class TextBuilder;
 
 class MpdLiveMediaSource : public MediaSource, public ObjTracker<MpdLiveMediaSource> {
 public:
@@ -36,7 +38,11 @@ public:
         return is_ready_;
     }
 
-    std::string get_mpd();
+    // mpd生成后不再修改，通过原子指针发布，读者不需要加锁
+    // 不包含结尾的</MPD>，响应时接上get_mpd_tail()
+    std::shared_ptr<const std::string> get_mpd();
+    // ll-dash的UTCTiming要带上响应时的服务器时间，不能放在缓存的mpd中
+    std::string get_mpd_tail();
     void set_mpd(const std::string & v);
     std::shared_ptr<Mp4Segment> get_mp4_segment(const std::string & mp4_name);
     std::shared_ptr<MediaBridge> get_or_create_bridge(const std::string & id, std::shared_ptr<PublishApp> app, const std::string & stream_name);
@@ -46,12 +52,23 @@ protected:
     std::shared_ptr<Mp4Segment> video_init_seg_;
     std::deque<std::shared_ptr<Mp4Segment>> audio_segments_;
     std::deque<std::shared_ptr<Mp4Segment>> video_segments_;
+    // 每个切片在SegmentTimeline中的<S>行，切片加入时生成一次
+    std::deque<std::string> audio_seg_lines_;
+    std::deque<std::string> video_seg_lines_;
     uint64_t curr_seq_no_ = 0;
-    std::shared_mutex mpd_mtx_;
-    std::string mpd_;
+    std::atomic<std::shared_ptr<const std::string>> mpd_;
+    size_t mpd_size_hint_ = 0;
+    std::atomic<bool> ll_dash_{false};
     bool is_ready_ = false;
     std::string availabilityStartTime;
 private:
     void update_mpd();
+    // 按窗口内切片的字节数和时长计算码率
+    static int64_t measure_bandwidth(const std::deque<std::shared_ptr<Mp4Segment>> & segs);
+    void add_segment(std::deque<std::shared_ptr<Mp4Segment>> & segs, std::deque<std::string> & lines, std::shared_ptr<Mp4Segment> seg);
+    // 窗口内切片的字节数，调用者持有segments_mtx_
+    void update_cached_bytes();
+    void write_adaptation_set(TextBuilder & tb, const std::deque<std::shared_ptr<Mp4Segment>> & segs, const std::deque<std::string> & lines,
+                              const std::string & type, int64_t bandwidth, const std::string & codecs, int64_t availability_time_offset);
 };
 };
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "bridge/media_bridge.hpp"
 
 #include "codec/codec.hpp"
+#include "codec/media_frame.hpp"
 #include "codec/h264/h264_avcc.hpp"
 #include "codec/h264/h264_codec.hpp"
 #include "codec/aac/aac_codec.hpp"
@@ -58,6 +59,13 @@ Json::Value RtmpMediaSource::to_json() {
     if (acodec) {
         v["acodec"] = acodec->to_json();
     }
+
+    Json::Value frames;
+    frames["i"] = (Json::UInt64)frame_type_counts_[SLICE_FRAME_I].load(std::memory_order_relaxed);
+    frames["p"] = (Json::UInt64)frame_type_counts_[SLICE_FRAME_P].load(std::memory_order_relaxed);
+    frames["b"] = (Json::UInt64)frame_type_counts_[SLICE_FRAME_B].load(std::memory_order_relaxed);
+    frames["dropped"] = (Json::UInt64)dropped_frames_.load(std::memory_order_relaxed);
+    v["frames"] = frames;
     
     auto session = get_session();
     if (session) {
@@ -95,6 +103,7 @@ std::shared_ptr<MediaBridge> RtmpMediaSource::get_or_create_bridge(const std::st
 
     auto media_source = bridge->get_media_source();
     media_source->set_source_info(app->get_domain_name(), app->get_app_name(), stream_name);
+    media_source->set_upstream_source(shared_from_this());
     
     bridges_.insert(std::pair(id, bridge));
     auto lazy_sink = std::static_pointer_cast<LazyMediaSink>(media_sink);
@@ -130,6 +139,7 @@ bool RtmpMediaSource::on_audio_packet(std::shared_ptr<RtmpMessage> audio_pkt) {
         }
         av_pkts_.clear();
     }
+    attach_frame(audio_pkt, false, false, sequence_header, header_consumed, 0);
     latest_frame_index_ = av_pkts_.add_pkt(audio_pkt);
 
     if (!stream_ready_) {
@@ -191,6 +201,7 @@ bool RtmpMediaSource::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
             }
             H264Codec *h264_codec = ((H264Codec*)video_codec_.get());
             h264_codec->set_sps_pps(avc_decoder_configuration_record.get_sps(), avc_decoder_configuration_record.get_pps());
+            nalu_length_size_ = avc_decoder_configuration_record.nalu_length_size_minus_one + 1;
         } else if ((header.get_codec_id() == VideoTagHeader::HEVC || header.get_codec_id() == VideoTagHeader::HEVC_FOURCC) && video_codec_->get_codec_type() == CODEC_HEVC) {
             HEVCDecoderConfigurationRecord hevc_decoder_configuration_record;
             int32_t consumed = hevc_decoder_configuration_record.decode((uint8_t*)payload.data() + header_consumed, payload.size() - header_consumed);
@@ -202,11 +213,14 @@ bool RtmpMediaSource::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
             hevc_codec->set_sps_pps_vps(hevc_decoder_configuration_record.get_sps(), 
                                         hevc_decoder_configuration_record.get_pps(), 
                                         hevc_decoder_configuration_record.get_vps());
+            nalu_length_size_ = hevc_decoder_configuration_record.lengthSizeMinusOne + 1;
         }
 
         av_pkts_.clear();
     }
 
+    attach_frame(video_pkt, true, header.is_key_frame() && !header.is_seq_header(), header.is_seq_header(), header_consumed, header.get_cts());
+
     latest_frame_index_ = av_pkts_.add_pkt(video_pkt);
     if (header.is_key_frame() && !header.is_seq_header()) {// 关键帧索引
         std::unique_lock<std::shared_mutex> wlock(keyframe_indexes_rw_mutex_);
@@ -236,6 +250,45 @@ bool RtmpMediaSource::on_video_packet(std::shared_ptr<RtmpMessage> video_pkt) {
     return true;
 }
 
+void RtmpMediaSource::attach_frame(std::shared_ptr<RtmpMessage> pkt, bool is_video, bool is_key, bool is_seq_header, 
+                                   int32_t header_consumed, int32_t composition_time) {
+    auto codec = is_video ? video_codec_ : audio_codec_;
+    if (!codec) {
+        return;
+    }
+
+    auto frame = std::make_shared<MediaFrame>();
+    auto payload = pkt->get_using_data();
+    frame->codec = codec->get_codec_type();
+    frame->is_video = is_video;
+    frame->is_key = is_key;
+    frame->is_seq_header = is_seq_header;
+    frame->dts = pkt->timestamp_;
+    frame->pts = pkt->timestamp_ + composition_time;
+    frame->payload = std::string_view(payload.data() + header_consumed, payload.size() - header_consumed);
+    if (is_video && !is_seq_header && (frame->codec == CODEC_H264 || frame->codec == CODEC_HEVC)) {
+        if (split_nalus((const uint8_t*)frame->payload.data(), frame->payload.size(), nalu_length_size_, frame->nalus) < 0) {
+            // 数据不完整时不挂帧信息，由桥按原来的方式处理
+            return;
+        }
+
+        SliceInfo slice_info;
+        for (auto & nalu : frame->nalus) {
+            bool is_slice = frame->codec == CODEC_H264 ? parse_h264_slice_info(nalu, slice_info) : parse_hevc_slice_info(nalu, slice_info);
+            if (is_slice) {
+                frame->frame_type = slice_info.frame_type;
+                if (slice_info.temporal_id > 0) {
+                    multi_temporal_layer_ = true;
+                }
+                frame->disposable = !is_key && slice_info.nal_ref_idc == 0 && !multi_temporal_layer_;
+                frame_type_counts_[frame->frame_type].fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    pkt->frame_ = frame;
+}
+
 void RtmpMediaSource::on_stream_ready() {
     {// 创建推流
         auto s = get_session();
@@ -243,6 +296,9 @@ void RtmpMediaSource::on_stream_ready() {
             app_->create_push_streams(shared_from_this(), s);
         }
     }
+
+    // 预热桥，第一个播放者到来时切片已经生成
+    app_->prewarm_bridges(shared_from_this());
 }
 
 bool RtmpMediaSource::on_metadata(std::shared_ptr<RtmpMessage> metadata_pkt) {
@@ -368,8 +424,16 @@ std::vector<std::shared_ptr<RtmpMessage>> RtmpMediaSource::get_pkts(int64_t &las
     } else {
         int64_t start_idx = last_pkt_index;
         uint32_t pkt_count = 0;
+        // 落后太多时跳过不被参考的帧，不影响解码，帮助慢的播放者追上
+        bool lagging = latest_frame_index_ - start_idx > DROP_DISPOSABLE_LAG;
         while(start_idx <= latest_frame_index_ && pkt_count < max_count) {
             auto t = av_pkts_.get_pkt(start_idx);
+            if (t && lagging && t->frame_ && t->frame_->disposable) {
+                dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+                start_idx++;
+                continue;
+            }
+
             if (t) {
                 pkts.emplace_back(av_pkts_.get_pkt(start_idx));
                 pkt_count++;
@@ -11,6 +11,7 @@
 #include <vector>
 #include <set>
 #include <shared_mutex>
+#include <atomic>
 #include <boost/circular_buffer.hpp>
 #include <boost/asio/awaitable.hpp>
 
@@ -52,11 +53,21 @@ protected:
     boost::circular_buffer<uint64_t> keyframe_indexes_;
     int64_t latest_frame_index_ = 0;
     void on_stream_ready();
+    // 收到数据时解析一次，挂到消息上供所有桥共用
+    void attach_frame(std::shared_ptr<RtmpMessage> pkt, bool is_video, bool is_key, bool is_seq_header, 
+                      int32_t header_consumed, int32_t composition_time);
 protected:
     bool video_ready_ = false;
     bool audio_ready_ = false;
     int32_t latest_video_timestamp_ = 0;
     int32_t latest_audio_timestamp_ = 0;
     bool is_enhance_rtmp_ = false;
+    int32_t nalu_length_size_ = 4;
+    // hevc出现过temporal_id>0的帧后，子层非参考帧可能被更高层参考，不再标记为可丢弃
+    bool multi_temporal_layer_ = false;
+    // 读取位置落后超过这个数量时跳过可丢弃的帧，缓存共1024个包
+    static constexpr int64_t DROP_DISPOSABLE_LAG = 512;
+    std::atomic<uint64_t> frame_type_counts_[4] = {};
+    std::atomic<uint64_t> dropped_frames_{0};
 };
 };
\ No newline at end of file
@@ -22,10 +22,26 @@ boost::asio::awaitable<bool> RtpMediaSink::on_video_packets(std::vector<std::sha
     co_return co_await video_pkts_cb_(video_pkts);
 }
 
+boost::asio::awaitable<bool> RtpMediaSink::on_video_layer_packets(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> video_pkts)
+{
+    if (video_layer_pkts_cb_) {
+        co_return co_await video_layer_pkts_cb_(layer, video_pkts);
+    }
+
+    if (layer != 0) {
+        co_return true;
+    }
+    co_return co_await on_video_packets(video_pkts);
+}
+
 void RtpMediaSink::set_video_pkts_cb(const std::function<boost::asio::awaitable<bool>(std::vector<std::shared_ptr<RtpPacket>> msg)> & cb) {
     video_pkts_cb_ = cb;
 }
 
+void RtpMediaSink::set_video_layer_pkts_cb(const std::function<boost::asio::awaitable<bool>(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> msg)> & cb) {
+    video_layer_pkts_cb_ = cb;
+}
+
 void RtpMediaSink::set_audio_pkts_cb(const std::function<boost::asio::awaitable<bool>(std::vector<std::shared_ptr<RtpPacket>> msg)> & cb) {
     audio_pkts_cb_ = cb;
 }
@@ -43,5 +59,6 @@ void RtpMediaSink::close() {
     ready_cb_ = {};
     video_pkts_cb_ = {};
     audio_pkts_cb_ = {};
+    video_layer_pkts_cb_ = {};
     MediaSink::close();
 }
\ No newline at end of file
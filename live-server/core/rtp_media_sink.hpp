@@ -18,12 +18,17 @@ public:
     void set_source_codec_ready_cb(const std::function<bool(std::shared_ptr<Codec> video_codec, std::shared_ptr<Codec> audio_codec)> & ready_cb);
     virtual boost::asio::awaitable<bool> on_audio_packets(std::vector<std::shared_ptr<RtpPacket>> audio_pkts);
     virtual boost::asio::awaitable<bool> on_video_packets(std::vector<std::shared_ptr<RtpPacket>> video_pkts);
+    // simulcast源按层分发视频包，未设置分层回调的sink只接收主层(0层)
+    virtual boost::asio::awaitable<bool> on_video_layer_packets(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> video_pkts);
+    // 回调在源的分发协程中对各个sink依次执行，不能在回调里等待播放者的发送，否则一个慢的播放者会阻塞其他播放者
     void set_video_pkts_cb(const std::function<boost::asio::awaitable<bool>(std::vector<std::shared_ptr<RtpPacket>> msg)> & video_pkts_cb);
+    void set_video_layer_pkts_cb(const std::function<boost::asio::awaitable<bool>(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> msg)> & video_layer_pkts_cb);
     void set_audio_pkts_cb(const std::function<boost::asio::awaitable<bool>(std::vector<std::shared_ptr<RtpPacket>> msg)> & audio_pkts_cb);
     void close() override;
 private:
     std::function<boost::asio::awaitable<bool>(std::vector<std::shared_ptr<RtpPacket>> pkts)> video_pkts_cb_;
     std::function<boost::asio::awaitable<bool>(std::vector<std::shared_ptr<RtpPacket>> pkts)> audio_pkts_cb_;
+    std::function<boost::asio::awaitable<bool>(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> pkts)> video_layer_pkts_cb_;
 
     std::function<bool(std::shared_ptr<Codec> video_codec, std::shared_ptr<Codec> audio_codec)> ready_cb_;
 };
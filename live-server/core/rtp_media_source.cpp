@@ -20,7 +20,8 @@
 using namespace mms;
 
 RtpMediaSource::RtpMediaSource(const std::string & media_type, std::weak_ptr<StreamSession> session, std::shared_ptr<PublishApp> app, ThreadWorker *worker) : MediaSource(media_type, session, app, worker) {
-
+    video_rtp_history_ = std::make_shared<RtpHistory>(VIDEO_RTP_HISTORY_SIZE);
+    audio_rtp_history_ = std::make_shared<RtpHistory>(AUDIO_RTP_HISTORY_SIZE);
 }
 
 bool RtpMediaSource::init() {
@@ -33,6 +34,10 @@ RtpMediaSource::~RtpMediaSource() {
 
 boost::asio::awaitable<bool> RtpMediaSource::on_audio_packets(std::vector<std::shared_ptr<RtpPacket>> audio_pkts) 
 {    
+    for (auto & pkt : audio_pkts) {
+        audio_rtp_history_->put(pkt);
+    }
+
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto & sink : sinks_) {
         co_await (std::static_pointer_cast<RtpMediaSink>(sink))->on_audio_packets(audio_pkts);
@@ -43,6 +48,10 @@ boost::asio::awaitable<bool> RtpMediaSource::on_audio_packets(std::vector<std::s
 
 boost::asio::awaitable<bool> RtpMediaSource::on_video_packets(std::vector<std::shared_ptr<RtpPacket>> video_pkts) 
 {
+    for (auto & pkt : video_pkts) {
+        video_rtp_history_->put(pkt);
+    }
+
     std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
     for (auto & sink : sinks_) {
         co_await (std::static_pointer_cast<RtpMediaSink>(sink))->on_video_packets(video_pkts);
@@ -59,6 +68,24 @@ boost::asio::awaitable<bool> RtpMediaSource::on_source_codec_ready() {
     co_return true;
 }
 
+Json::Value RtpMediaSource::rtp_history_to_json() {
+    Json::Value v;
+    uint64_t nack_recv = 0, nack_seqs = 0, retrans = 0, miss = 0, rate_limited = 0;
+    for (auto & h : {video_rtp_history_, audio_rtp_history_}) {
+        nack_recv += h->nack_recv_count_.load();
+        nack_seqs += h->nack_seq_count_.load();
+        retrans += h->retrans_count_.load();
+        miss += h->miss_count_.load();
+        rate_limited += h->rate_limited_count_.load();
+    }
+    v["nack_recv"] = (Json::UInt64)nack_recv;
+    v["nack_seqs"] = (Json::UInt64)nack_seqs;
+    v["retrans"] = (Json::UInt64)retrans;
+    v["miss"] = (Json::UInt64)miss;
+    v["rate_limited"] = (Json::UInt64)rate_limited;
+    return v;
+}
+
 std::shared_ptr<MediaBridge> RtpMediaSource::get_or_create_bridge(const std::string & id, std::shared_ptr<PublishApp> app, const std::string &stream_name) {
     ((void)id);
     ((void)app);
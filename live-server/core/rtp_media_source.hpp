@@ -21,6 +21,7 @@
 #include "base/sequence_pkt_buf.hpp"
 
 #include "protocol/rtp/rtp_packet.h"
+#include "protocol/rtp/rtp_history.h"
 #include "protocol/rtp/rtp_h264_depacketizer.h"
 #include "base/obj_tracker.hpp"
 
@@ -38,7 +39,25 @@ public:
     virtual boost::asio::awaitable<bool> on_source_codec_ready();
 
     std::shared_ptr<MediaBridge> get_or_create_bridge(const std::string & id, std::shared_ptr<PublishApp> app, const std::string & stream_name);
+
+    std::shared_ptr<RtpHistory> get_video_rtp_history() {
+        return video_rtp_history_;
+    }
+
+    std::shared_ptr<RtpHistory> get_audio_rtp_history() {
+        return audio_rtp_history_;
+    }
+    // 只转发实时的rtp包，没有缓存GOP
+    bool has_gop_cache() override {
+        return false;
+    }
 protected:
+    Json::Value rtp_history_to_json();
+    // 视频按1s左右的高码率包数估算，音频20ms一包保留5s
+    static constexpr size_t VIDEO_RTP_HISTORY_SIZE = 1024;
+    static constexpr size_t AUDIO_RTP_HISTORY_SIZE = 256;
+    std::shared_ptr<RtpHistory> video_rtp_history_;
+    std::shared_ptr<RtpHistory> audio_rtp_history_;
     boost::circular_buffer<std::shared_ptr<RtpPacket>> av_pkts_;
     std::map<uint16_t, std::shared_ptr<RtpPacket>> video_pkts_;
     std::map<uint16_t, std::shared_ptr<RtpPacket>> audio_pkts_;
@@ -126,6 +126,9 @@ void RtspMediaSource::on_stream_ready() {
         }
     }
 
+    // 预热桥，第一个播放者到来时切片已经生成
+    app_->prewarm_bridges(shared_from_this());
+
     {// 给桥发信息
         std::unique_lock<std::shared_mutex> lck(bridges_mtx_);
         for (auto it = bridges_.begin(); it != bridges_.end(); it++) {
@@ -316,6 +319,7 @@ std::shared_ptr<MediaBridge> RtspMediaSource::get_or_create_bridge(const std::st
 
     auto media_source = bridge->get_media_source();
     media_source->set_source_info(app->get_domain_name(), app->get_app_name(), stream_name);
+    media_source->set_upstream_source(shared_from_this());
     
     bridges_.insert(std::pair(id, bridge));
     if (stream_ready_) {
@@ -29,6 +29,21 @@ bool TsMediaSink::recv_ts_segment(std::shared_ptr<TsSegment> ts_seg) {
     return true;
 }
 
+bool TsMediaSink::recv_ts_part(std::shared_ptr<TsSegment> ts_seg) {
+    if (!part_cb_) {
+        return true;
+    }
+
+    auto self(this->shared_from_this());
+    boost::asio::co_spawn(worker_->get_io_context(), [this, self, ts_seg]()->boost::asio::awaitable<void> {
+        if (part_cb_) {
+            co_await part_cb_(ts_seg);
+        }
+        co_return;
+    }, boost::asio::detached);
+    return true;
+}
+
 boost::asio::awaitable<void> TsMediaSink::do_work() {
     if (source_ == nullptr || !source_->is_stream_ready()) {
         co_return;
@@ -51,6 +66,10 @@ void TsMediaSink::on_ts_segment(const std::function<boost::asio::awaitable<bool>
     cb_ = cb;
 }
 
+void TsMediaSink::on_ts_part(const std::function<boost::asio::awaitable<bool>(std::shared_ptr<TsSegment> msg)> & cb) {
+    part_cb_ = cb;
+}
+
 void TsMediaSink::on_pes_pkts(const std::function<boost::asio::awaitable<bool>(const std::vector<std::shared_ptr<PESPacket>> & pkts)> & cb) {
     pes_pkts_cb_ = cb;
 }
\ No newline at end of file
@@ -18,13 +18,16 @@ public:
     virtual ~TsMediaSink();
     boost::asio::awaitable<void> do_work() override;
     bool recv_ts_segment(std::shared_ptr<TsSegment> ts_seg);
+    bool recv_ts_part(std::shared_ptr<TsSegment> ts_seg);
     void on_ts_segment(const std::function<boost::asio::awaitable<bool>(std::shared_ptr<TsSegment> msg)> & cb);
+    void on_ts_part(const std::function<boost::asio::awaitable<bool>(std::shared_ptr<TsSegment> msg)> & cb);
     void on_pes_pkts(const std::function<boost::asio::awaitable<bool>(const std::vector<std::shared_ptr<PESPacket>> & pkts)> & cb);
     void close() override;
 private:
     int64_t last_send_pkt_index_ = -1;
     
     std::function<boost::asio::awaitable<bool>(std::shared_ptr<TsSegment> msg)> cb_;
+    std::function<boost::asio::awaitable<bool>(std::shared_ptr<TsSegment> msg)> part_cb_ = {};
     std::function<boost::asio::awaitable<bool>(const std::vector<std::shared_ptr<PESPacket>> & pes_pkts)> pes_pkts_cb_ = {};
 };
 };
\ No newline at end of file
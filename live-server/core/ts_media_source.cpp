@@ -58,7 +58,20 @@ bool TsMediaSource::on_ts_segment(std::shared_ptr<TsSegment> ts_seg) {
     return true;
 }
 
+bool TsMediaSource::on_ts_part(std::shared_ptr<TsSegment> ts_seg) {
+    std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
+    for (auto sink : sinks_) {
+        auto s = std::static_pointer_cast<TsMediaSink>(sink);
+        s->recv_ts_part(ts_seg);
+    }
+    return true;
+}
+
 bool TsMediaSource::has_no_sinks_for_time(uint32_t milli_secs) {
+    if (is_kept_alive()) {
+        return false;
+    }
+
     std::shared_lock<std::shared_mutex> lck2(bridges_mtx_);
     if (sinks_count_ > 0 || bridges_.size() > 0) {
         return false;
@@ -196,6 +209,7 @@ std::shared_ptr<MediaBridge> TsMediaSource::get_or_create_bridge(const std::stri
 
     auto media_source = bridge->get_media_source();
     media_source->set_source_info(app->get_domain_name(), app->get_app_name(), stream_name);
+    media_source->set_upstream_source(shared_from_this());
 
     bridges_.insert(std::pair(id, bridge));
     return bridge;
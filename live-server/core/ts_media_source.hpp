@@ -36,6 +36,7 @@ public:
     Json::Value to_json() override;
     bool init();
     bool on_ts_segment(std::shared_ptr<TsSegment> ts_seg);
+    bool on_ts_part(std::shared_ptr<TsSegment> ts_seg);
     bool on_pes_packet(std::shared_ptr<PESPacket> pes_packet);
     std::vector<std::shared_ptr<PESPacket>> get_pkts(int64_t &last_pkt_index, uint32_t max_count);
 
@@ -14,9 +14,28 @@
 #include "codec/opus/opus_codec.hpp"
 
 #include "app/publish_app.h"
+#include <boost/algorithm/string/join.hpp>
 
 using namespace mms;
+namespace {
+// 各保护等级：触发的丢包率，每组媒体包数，每组冗余包数
+struct VideoFecLevel {
+    double loss;
+    size_t group_pkts;
+    size_t fec_pkts;
+};
+
+const VideoFecLevel VIDEO_FEC_LEVEL_TABLE[WebRtcMediaSource::VIDEO_FEC_LEVELS] = {
+    {0, 0, 0},
+    {0.01, 10, 1},
+    {0.03, 10, 2},
+    {0.06, 9, 3},
+    {0.10, 8, 4},
+};
+};
+
 WebRtcMediaSource::WebRtcMediaSource(ThreadWorker *worker, std::weak_ptr<StreamSession> session, std::shared_ptr<PublishApp> app) : RtpMediaSource("webrtc{rtp[es]}", session, app, worker) {
+    video_fec_ssrc_ = (uint32_t)Utils::get_rand64();
 }
 
 Json::Value WebRtcMediaSource::to_json() {
@@ -38,6 +57,28 @@ Json::Value WebRtcMediaSource::to_json() {
         v["acodec"] = acodec->to_json();
     }
 
+    v["nack"] = rtp_history_to_json();
+    if (is_simulcast()) {
+        Json::Value layers = Json::arrayValue;
+        for (size_t i = 0; i < simulcast_layers_.size(); i++) {
+            Json::Value l;
+            l["rid"] = simulcast_layers_[i]->rid;
+            l["ssrc"] = simulcast_layers_[i]->ssrc.load();
+            l["bps"] = (Json::Int64)get_simulcast_layer_bps(i);
+            layers.append(l);
+        }
+        v["simulcast"] = layers;
+    }
+
+    Json::Value fec = Json::arrayValue;
+    for (int32_t level = 1; level < VIDEO_FEC_LEVELS; level++) {
+        Json::Value l;
+        l["level"] = level;
+        l["players"] = video_fec_users_[level].load();
+        l["fec_pkts"] = (Json::UInt64)video_fec_pkts_count_[level].load();
+        fec.append(l);
+    }
+    v["fec"] = fec;
     auto session = get_session();
     if (session) {
         v["session"] = session->to_json();
@@ -106,6 +147,7 @@ std::string WebRtcMediaSource::process_publish_sdp(const std::string & sdp) {
                 spdlog::error("create video codec from sdp failed");
                 return "";
             }
+            create_simulcast_layers(media);
             has_video_ = true;
         }
     }
@@ -217,15 +259,36 @@ int32_t WebRtcMediaSource::create_local_sdp()
             video_sdp.set_mid_attr(media.get_mid_attr().value());
             video_sdp.add_candidate(Candidate("fund_common", 1, "UDP", 2130706431, webrtc_session->get_local_ip(), webrtc_session->get_udp_port(), Candidate::CAND_TYPE_HOST, "", 0, {{"generation", "0"}}));
             video_sdp.set_rtcp_mux(RtcpMux());
-            if (media.get_ssrc_group())
+            if (is_simulcast())
             {
-                video_sdp.set_ssrc_group(media.get_ssrc_group().value());
+                // 各层ssrc在收到rtp包后通过rid扩展头确定，mid扩展在bundle中用于分流
+                if (mid_ext_id_ != 0)
+                {
+                    video_sdp.add_extmap(Extmap(mid_ext_id_, EXTMAP_URI_MID));
+                }
+                video_sdp.add_extmap(Extmap(rid_ext_id_, EXTMAP_URI_RID));
+                std::vector<std::vector<std::string>> streams;
+                for (auto &layer : simulcast_layers_)
+                {
+                    video_sdp.add_rid(RidAttr(layer->rid, "recv"));
+                    streams.push_back({layer->rid});
+                }
+                SimulcastAttr simulcast;
+                simulcast.set_recv_streams(streams);
+                video_sdp.set_simulcast(simulcast);
             }
-
-            for (auto &p : media.get_ssrcs())
+            else
             {
-                video_sdp.add_ssrc(Ssrc(p.second.get_id(), webrtc_session->get_session_name(), webrtc_session->get_session_name(), webrtc_session->get_session_name() + "_video"));
-                video_ssrc_ = p.second.get_id();
+                if (media.get_ssrc_group())
+                {
+                    video_sdp.set_ssrc_group(media.get_ssrc_group().value());
+                }
+
+                for (auto &p : media.get_ssrcs())
+                {
+                    video_sdp.add_ssrc(Ssrc(p.second.get_id(), webrtc_session->get_session_name(), webrtc_session->get_session_name(), webrtc_session->get_session_name() + "_video"));
+                    video_ssrc_ = p.second.get_id();
+                }
             }
 
             video_sdp.set_finger_print(FingerPrint("sha-1", webrtc_session->get_dtls_cert()->get_finger_print()));
@@ -285,6 +348,13 @@ void WebRtcMediaSource::create_play_sdp() {
     auto &play_medias = play_sdp.get_media_sdps();
     for (auto &media : play_medias) {
         media.set_dir(media.get_reverse_dir());
+        if (media.get_media() == "video" && is_simulcast()) {
+            // 播放端只看到一路视频，去掉推流端的rid/simulcast信息
+            media.set_rids({});
+            media.set_simulcast(std::nullopt);
+            media.set_extmap({});
+            media.add_ssrc(Ssrc(simulcast_play_ssrc_, stream_name_, stream_name_, stream_name_ + "_video"));
+        }
     }
     play_offer_sdp_ = std::make_shared<Sdp>();
     *play_offer_sdp_ = play_sdp;
@@ -295,6 +365,188 @@ bool WebRtcMediaSource::process_play_sdp(const std::string & sdp) {
     return true;
 }
 
+void WebRtcMediaSource::create_simulcast_layers(const MediaSdp & media_sdp) {
+    auto & simulcast = media_sdp.get_simulcast();
+    if (!simulcast) {
+        return;
+    }
+
+    for (auto & ext : media_sdp.get_extmap()) {
+        if (ext.uri == EXTMAP_URI_RID) {
+            rid_ext_id_ = (uint8_t)std::atoi(ext.value.c_str());
+        } else if (ext.uri == EXTMAP_URI_MID) {
+            mid_ext_id_ = (uint8_t)std::atoi(ext.value.c_str());
+        }
+    }
+
+    auto rids = simulcast.value().get_send_rids();
+    if (rids.size() <= 1 || rid_ext_id_ == 0) {// 没有rid扩展头无法区分各层，按普通推流处理
+        return;
+    }
+
+    for (auto & rid : rids) {
+        if (simulcast_layers_.size() >= MAX_SIMULCAST_LAYERS) {
+            break;
+        }
+        auto layer = std::make_unique<SimulcastLayer>();
+        layer->rid = rid;
+        layer->rtp_history = simulcast_layers_.empty() ? video_rtp_history_ : std::make_shared<RtpHistory>(VIDEO_RTP_HISTORY_SIZE);
+        simulcast_layers_.push_back(std::move(layer));
+    }
+    simulcast_play_ssrc_ = (uint32_t)Utils::get_rand64();
+    CORE_INFO("webrtc publish with simulcast, layers:{}", boost::join(rids, ","));
+}
+
+int32_t WebRtcMediaSource::find_simulcast_layer(const std::string & rid) const {
+    for (size_t i = 0; i < simulcast_layers_.size(); i++) {
+        if (simulcast_layers_[i]->rid == rid) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const std::string & WebRtcMediaSource::get_simulcast_rid(uint32_t layer) const {
+    return simulcast_layers_[layer]->rid;
+}
+
+void WebRtcMediaSource::set_simulcast_layer_ssrc(uint32_t layer, uint32_t ssrc) {
+    if (layer >= simulcast_layers_.size()) {
+        return;
+    }
+    simulcast_layers_[layer]->ssrc = ssrc;
+    if (layer == 0) {
+        video_ssrc_ = ssrc;
+    }
+}
+
+uint32_t WebRtcMediaSource::get_simulcast_layer_ssrc(uint32_t layer) const {
+    if (layer >= simulcast_layers_.size()) {
+        return 0;
+    }
+    return simulcast_layers_[layer]->ssrc.load();
+}
+
+int64_t WebRtcMediaSource::get_simulcast_layer_bps(uint32_t layer) const {
+    if (layer >= simulcast_layers_.size()) {
+        return 0;
+    }
+    auto & l = simulcast_layers_[layer];
+    if (Utils::get_current_ms() - l->last_pkt_ms.load() > 2000) {
+        return 0;
+    }
+    return l->bps.load();
+}
+
+std::shared_ptr<RtpHistory> WebRtcMediaSource::get_simulcast_rtp_history_by_ssrc(uint32_t ssrc) {
+    for (auto & l : simulcast_layers_) {
+        if (l->ssrc.load() == ssrc) {
+            return l->rtp_history;
+        }
+    }
+    return nullptr;
+}
+
+boost::asio::awaitable<bool> WebRtcMediaSource::on_video_layer_packets(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> video_pkts) {
+    if (layer >= simulcast_layers_.size()) {
+        co_return true;
+    }
+
+    auto & l = simulcast_layers_[layer];
+    int64_t now_ms = Utils::get_current_ms();
+    for (auto & pkt : video_pkts) {
+        l->rtp_history->put(pkt);
+        l->in_bytes += pkt->payload_len_ + 12;
+    }
+    l->last_pkt_ms = now_ms;
+    if (l->begin_ms == 0) {
+        l->begin_ms = now_ms;
+    } else if (now_ms - l->begin_ms >= 1000) {
+        l->bps = l->in_bytes * 8 * 1000 / (now_ms - l->begin_ms);
+        l->in_bytes = 0;
+        l->begin_ms = now_ms;
+    }
+
+    std::shared_lock<std::shared_mutex> lck(sinks_mtx_);
+    for (auto & sink : sinks_) {
+        co_await (std::static_pointer_cast<RtpMediaSink>(sink))->on_video_layer_packets(layer, video_pkts);
+    }
+    co_return true;
+}
+
+boost::asio::awaitable<bool> WebRtcMediaSource::on_video_packets(std::vector<std::shared_ptr<RtpPacket>> video_pkts) {
+    protect_video_packets(video_pkts);
+    co_return co_await RtpMediaSource::on_video_packets(std::move(video_pkts));
+}
+
+int32_t WebRtcMediaSource::get_video_fec_level_by_loss(double loss) {
+    for (int32_t level = VIDEO_FEC_LEVELS - 1; level > 0; level--) {
+        if (loss >= VIDEO_FEC_LEVEL_TABLE[level].loss) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+void WebRtcMediaSource::update_video_fec_level(int32_t old_level, int32_t new_level) {
+    if (old_level > 0 && old_level < VIDEO_FEC_LEVELS) {
+        video_fec_users_[old_level]--;
+    }
+
+    if (new_level > 0 && new_level < VIDEO_FEC_LEVELS) {
+        video_fec_users_[new_level]++;
+    }
+}
+
+void WebRtcMediaSource::protect_video_packets(const std::vector<std::shared_ptr<RtpPacket>> & video_pkts) {
+    if (video_pkts.empty()) {
+        return;
+    }
+
+    VideoFecBatch *batch = nullptr;
+    for (int32_t level = 1; level < VIDEO_FEC_LEVELS; level++) {
+        auto & encoder = video_fec_encoders_[level];
+        if (video_fec_users_[level].load() <= 0) {// 没有播放者的等级不再计算，未完成的组直接丢弃
+            encoder = nullptr;
+            continue;
+        }
+
+        if (!encoder) {
+            auto & conf = VIDEO_FEC_LEVEL_TABLE[level];
+            encoder = std::make_unique<RtpFlexFecEncoder>(video_fec_ssrc_, WebRtcServerSession::TWCC_EXT_ID, conf.group_pkts, conf.fec_pkts);
+        }
+
+        if (!batch) {
+            batch = &video_fec_batches_[video_fec_batch_index_ % VIDEO_FEC_BATCHES];
+            video_fec_batch_index_++;
+            batch->last_pkt = video_pkts.back();
+            for (auto & pkts : batch->fec_pkts) {
+                pkts.clear();
+            }
+        }
+
+        for (auto & pkt : video_pkts) {
+            encoder->add_packet(pkt, batch->fec_pkts[level]);
+        }
+        video_fec_pkts_count_[level] += batch->fec_pkts[level].size();
+    }
+}
+
+void WebRtcMediaSource::get_video_fec_packets(int32_t level, const std::vector<std::shared_ptr<RtpPacket>> & video_pkts, std::vector<std::shared_ptr<RtpPacket>> & fec_pkts) {
+    if (level <= 0 || level >= VIDEO_FEC_LEVELS || video_pkts.empty()) {
+        return;
+    }
+
+    // 从最新的一批往前找
+    for (size_t i = 1; i <= VIDEO_FEC_BATCHES && i <= video_fec_batch_index_; i++) {
+        auto & batch = video_fec_batches_[(video_fec_batch_index_ - i) % VIDEO_FEC_BATCHES];
+        if (batch.last_pkt == video_pkts.back()) {
+            fec_pkts.insert(fec_pkts.end(), batch.fec_pkts[level].begin(), batch.fec_pkts[level].end());
+            return;
+        }
+    }
+}
+
 Payload* WebRtcMediaSource::find_suitable_video_payload(MediaSdp & media_sdp) {
     Payload *match_payload = nullptr;
     auto & payloads  = media_sdp.get_payloads();
@@ -411,6 +663,7 @@ std::shared_ptr<MediaBridge> WebRtcMediaSource::get_or_create_bridge(const std::
 
     auto media_source = bridge->get_media_source();
     media_source->set_source_info(app->get_domain_name(), app->get_app_name(), stream_name);
+    media_source->set_upstream_source(shared_from_this());
 
     bridges_.insert(std::pair(id, bridge));
     if (stream_ready_) {
@@ -1,8 +1,10 @@
 #pragma once
+#include <atomic>
 #include "protocol/sdp/sdp.hpp"
 #include "core/rtp_media_source.hpp"
 #include "codec/codec.hpp"
 #include "protocol/rtp/rtp_h264_depacketizer.h"
+#include "protocol/rtp/rtp_flexfec_encoder.h"
 #include "base/obj_tracker.hpp"
 namespace mms {
 class ThreadWorker;
@@ -58,6 +60,46 @@ public:
     void set_audio_ssrc(uint32_t v) {
         audio_ssrc_ = v;
     }
+    // simulcast推流，层号按a=simulcast中的顺序，0层为主层，转协议、录制等只使用主层
+    static constexpr size_t MAX_SIMULCAST_LAYERS = 8;
+    bool is_simulcast() const {
+        return !simulcast_layers_.empty();
+    }
+
+    size_t get_simulcast_layer_count() const {
+        return simulcast_layers_.size();
+    }
+
+    uint8_t get_rid_ext_id() const {
+        return rid_ext_id_;
+    }
+
+    // 所有播放者看到的统一视频ssrc，切层时改写成该ssrc
+    uint32_t get_simulcast_play_ssrc() const {
+        return simulcast_play_ssrc_;
+    }
+
+    int32_t find_simulcast_layer(const std::string & rid) const;
+    const std::string & get_simulcast_rid(uint32_t layer) const;
+    void set_simulcast_layer_ssrc(uint32_t layer, uint32_t ssrc);
+    uint32_t get_simulcast_layer_ssrc(uint32_t layer) const;
+    // 最近一秒的码率，超过2s没收到数据返回0
+    int64_t get_simulcast_layer_bps(uint32_t layer) const;
+    std::shared_ptr<RtpHistory> get_simulcast_rtp_history_by_ssrc(uint32_t ssrc);
+    boost::asio::awaitable<bool> on_video_layer_packets(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> video_pkts);
+    boost::asio::awaitable<bool> on_video_packets(std::vector<std::shared_ptr<RtpPacket>> video_pkts) override;
+
+    // 播放端FlexFEC，每个保护等级一个编码器，同等级的播放者共享冗余包，0级为不保护
+    static constexpr int32_t VIDEO_FEC_LEVELS = 5;
+    // 按RR上报的丢包率选择等级
+    static int32_t get_video_fec_level_by_loss(double loss);
+    uint32_t get_video_fec_ssrc() const {
+        return video_fec_ssrc_;
+    }
+    // 播放者切换保护等级时调用，没有播放者的等级不生成冗余包
+    void update_video_fec_level(int32_t old_level, int32_t new_level);
+    // 只能在视频包回调中调用，把这批视频包生成的冗余包追加到fec_pkts
+    void get_video_fec_packets(int32_t level, const std::vector<std::shared_ptr<RtpPacket>> & video_pkts, std::vector<std::shared_ptr<RtpPacket>> & fec_pkts);
     // boost::asio::awaitable<bool> on_video_packet(std::shared_ptr<RtpPacket> video_pkt);
     // boost::asio::awaitable<bool> on_audio_packet(std::shared_ptr<RtpPacket> audio_pkt);
 
@@ -67,6 +109,8 @@ private:
     void create_play_sdp();
     Payload* find_suitable_video_payload(MediaSdp & media_sdp);
     Payload* find_suitable_audio_payload(MediaSdp & media_sdp);
+    void create_simulcast_layers(const MediaSdp & media_sdp);
+    void protect_video_packets(const std::vector<std::shared_ptr<RtpPacket>> & video_pkts);
     
     Sdp remote_sdp_;
     Sdp local_sdp_;
@@ -77,6 +121,35 @@ private:
 
     uint32_t video_ssrc_ = 0;
     uint32_t audio_ssrc_ = 0;
+
+    struct SimulcastLayer {
+        std::string rid;
+        std::atomic<uint32_t> ssrc{0};
+        std::shared_ptr<RtpHistory> rtp_history;
+        // 以下码率统计在推流会话线程中更新
+        int64_t in_bytes = 0;
+        int64_t begin_ms = 0;
+        std::atomic<int64_t> bps{0};
+        std::atomic<int64_t> last_pkt_ms{0};
+    };
+    std::vector<std::unique_ptr<SimulcastLayer>> simulcast_layers_;
+    uint8_t rid_ext_id_ = 0;
+    uint8_t mid_ext_id_ = 0;
+    uint32_t simulcast_play_ssrc_ = 0;
+
+    uint32_t video_fec_ssrc_ = 0;
+    std::atomic<int32_t> video_fec_users_[VIDEO_FEC_LEVELS] = {};
+    std::atomic<uint64_t> video_fec_pkts_count_[VIDEO_FEC_LEVELS] = {};
+    // 以下在源的线程中访问
+    std::unique_ptr<RtpFlexFecEncoder> video_fec_encoders_[VIDEO_FEC_LEVELS];
+    // 分发到订阅者时可能交错(收包和重排定时器两个协程)，最近几批的冗余包按批的最后一个媒体包索引
+    static constexpr size_t VIDEO_FEC_BATCHES = 8;
+    struct VideoFecBatch {
+        std::shared_ptr<RtpPacket> last_pkt;
+        std::vector<std::shared_ptr<RtpPacket>> fec_pkts[VIDEO_FEC_LEVELS];
+    };
+    VideoFecBatch video_fec_batches_[VIDEO_FEC_BATCHES];
+    size_t video_fec_batch_index_ = 0;
 };
 
 };
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include "version.h"
 #include "recorder/recorder_db.h"
 #include "system/system.h"
+#include "transcode/audio_transcode_service.hpp"
 
 using namespace mms;
 
@@ -136,6 +137,8 @@ int main(int argc, char *argv[]) {
         CORE_ERROR("init recorder db failed");
         return -1;
     }
+
+    AudioTranscodeService::get_instance().start(config->get_audio_transcode_threads());
     
     // start dns service
     DnsService &dns_service = DnsService::get_instance();
@@ -250,6 +253,9 @@ int main(int argc, char *argv[]) {
     if (config->get_http_api_config().is_enabled()) {
         http_api_server =
             std::make_shared<HttpApiServer>(thread_pool_inst::get_mutable_instance().get_worker(RAND_WORKER));
+        if (webrtc_server) {
+            http_api_server->set_webrtc_server(webrtc_server);
+        }
         if (!http_api_server->start(config->get_http_api_config().port())) {
             CORE_ERROR("start http api server on port:{} failed", config->get_http_api_config().port());
             return -3;
@@ -314,6 +320,7 @@ int main(int argc, char *argv[]) {
     }
 
     System::get_instance().uninit();
+    AudioTranscodeService::get_instance().stop();
     thread_pool_inst::get_mutable_instance().stop();
     sleep(1);
     CORE_INFO("mms exit!!!");
@@ -96,8 +96,9 @@ bool M4sRecorder::on_audio_init_segment(std::shared_ptr<Mp4Segment> m4s_seg) {
     if (!m4s_file.is_open()) {
         return false;
     }
-    auto mp4_data = m4s_seg->get_used_buf();
-    m4s_file.write(mp4_data.data(), mp4_data.size());
+    for (auto & mp4_data : m4s_seg->get_used_bufs()) {
+        m4s_file.write(mp4_data.data(), mp4_data.size());
+    }
     m4s_file.close();
     auto key = domain_name_ + "/" + app_name_ + "/" + stream_name_ + "/dash/" + std::to_string(record_start_time_) + "/m4s";
     RecorderDb::get_instance().safe_put(key, m4s_seg->get_filename());
@@ -113,10 +114,11 @@ bool M4sRecorder::on_video_init_segment(std::shared_ptr<Mp4Segment> m4s_seg) {
     if (!m4s_file.is_open()) {
         return false;
     }
-    auto mp4_data = m4s_seg->get_used_buf();
-    m4s_file.write(mp4_data.data(), mp4_data.size());
+    for (auto & mp4_data : m4s_seg->get_used_bufs()) {
+        m4s_file.write(mp4_data.data(), mp4_data.size());
+    }
     m4s_file.close();
-    write_bytes_ += mp4_data.size();
+    write_bytes_ += m4s_seg->get_bytes();
     auto key = domain_name_ + "/" + app_name_ + "/" + stream_name_ + "/dash/" + std::to_string(record_start_time_) + "/m4s";
     RecorderDb::get_instance().safe_put(key, m4s_seg->get_filename());
     // update_mpd();
@@ -130,10 +132,11 @@ bool M4sRecorder::on_audio_segment(std::shared_ptr<Mp4Segment> m4s_seg) {
     if (!m4s_file.is_open()) {
         return false;
     }
-    auto mp4_data = m4s_seg->get_used_buf();
-    m4s_file.write(mp4_data.data(), mp4_data.size());
+    for (auto & mp4_data : m4s_seg->get_used_bufs()) {
+        m4s_file.write(mp4_data.data(), mp4_data.size());
+    }
     m4s_file.close();
-    write_bytes_ += mp4_data.size();
+    write_bytes_ += m4s_seg->get_bytes();
 
     M4sRecordSeg seg;
     seg.create_at_ = m4s_seg->get_create_at();
@@ -158,10 +161,11 @@ bool M4sRecorder::on_video_segment(std::shared_ptr<Mp4Segment> m4s_seg) {
     if (!m4s_file.is_open()) {
         return false;
     }
-    auto mp4_data = m4s_seg->get_used_buf();
-    m4s_file.write(mp4_data.data(), mp4_data.size());
+    for (auto & mp4_data : m4s_seg->get_used_bufs()) {
+        m4s_file.write(mp4_data.data(), mp4_data.size());
+    }
     m4s_file.close();
-    write_bytes_ += mp4_data.size();
+    write_bytes_ += m4s_seg->get_bytes();
 
     M4sRecordSeg seg;
     seg.create_at_ = m4s_seg->get_create_at();
@@ -26,8 +26,11 @@
 #include "../../version.h"
 #include "obj_viewer.h"
 #include "recorder/recorder_manager.h"
+#include "server/webrtc/webrtc_server.hpp"
 #include "recorder/recorder.h"
 #include "system/system.h"
+#include "bridge/bridge_factory.hpp"
+#include "transcode/audio_transcode_service.hpp"
 
 using namespace mms;
 bool HttpApiServer::register_route() {
@@ -42,6 +45,16 @@ bool HttpApiServer::register_route() {
         return false;
     }
 
+    ret = on_get("/api/bridge_stats", std::bind(&HttpApiServer::get_bridge_stats, this, std::placeholders::_1,std::placeholders::_2,std::placeholders::_3));
+    if (!ret) {
+        return false;
+    }
+
+    ret = on_get("/api/webrtc_sessions", std::bind(&HttpApiServer::get_webrtc_sessions, this, std::placeholders::_1,std::placeholders::_2,std::placeholders::_3));
+    if (!ret) {
+        return false;
+    }
+
     ret = on_get("/api/domain_apps", std::bind(&HttpApiServer::get_domain_apps, this, std::placeholders::_1,std::placeholders::_2,std::placeholders::_3));
     if (!ret) {
         return false;
@@ -184,6 +197,58 @@ boost::asio::awaitable<void> HttpApiServer::get_obj_count(std::shared_ptr<HttpSe
     co_return;
 }
 
+boost::asio::awaitable<void> HttpApiServer::get_bridge_stats(std::shared_ptr<HttpServerSession> session, std::shared_ptr<HttpRequest> req, std::shared_ptr<HttpResponse> resp) {
+    (void)session;
+    (void)req;
+    resp->add_header("Access-Control-Allow-Origin", "*");
+    resp->add_header("Content-type", "application/json");
+    if (!(co_await resp->write_header(200, "OK"))) {
+        resp->close();
+        co_return;
+    }
+
+    Json::Value root;
+    root["code"] = 0;
+    root["data"] = BridgeFactory::get_create_stats();
+    root["audio_transcode"] = AudioTranscodeService::get_instance().to_json();
+    std::string body = root.toStyledString();
+    bool ret = co_await resp->write_data((const uint8_t*)(body.data()), body.size());
+    if (!ret) {
+        resp->close();
+        co_return;
+    }
+
+    resp->close();
+    co_return;
+}
+
+boost::asio::awaitable<void> HttpApiServer::get_webrtc_sessions(std::shared_ptr<HttpServerSession> session, std::shared_ptr<HttpRequest> req, std::shared_ptr<HttpResponse> resp) {
+    (void)session;
+    (void)req;
+    resp->add_header("Access-Control-Allow-Origin", "*");
+    resp->add_header("Content-type", "application/json");
+    if (!(co_await resp->write_header(200, "OK"))) {
+        resp->close();
+        co_return;
+    }
+
+    Json::Value root;
+    root["code"] = 0;
+    root["data"] = Json::arrayValue;
+    if (webrtc_server_) {
+        root["data"] = co_await webrtc_server_->get_sessions_json();
+    }
+    std::string body = root.toStyledString();
+    bool ret = co_await resp->write_data((const uint8_t*)(body.data()), body.size());
+    if (!ret) {
+        resp->close();
+        co_return;
+    }
+
+    resp->close();
+    co_return;
+}
+
 boost::asio::awaitable<void> HttpApiServer::get_domain_apps(std::shared_ptr<HttpServerSession> session, 
                                                             std::shared_ptr<HttpRequest> req, 
                                                             std::shared_ptr<HttpResponse> resp) {
@@ -10,6 +10,9 @@ public:
     }
     
     virtual ~HttpApiServer() = default;
+    void set_webrtc_server(std::shared_ptr<WebRtcServer> webrtc_server) {
+        webrtc_server_ = webrtc_server;
+    }
 private:
     boost::asio::awaitable<void> response_json(std::shared_ptr<HttpResponse> resp, int32_t code, const std::string & msg);
     bool register_route();
@@ -22,6 +25,14 @@ private:
                                                std::shared_ptr<HttpRequest> req, 
                                                std::shared_ptr<HttpResponse> resp);
 
+    boost::asio::awaitable<void> get_bridge_stats(std::shared_ptr<HttpServerSession> session, 
+                                                  std::shared_ptr<HttpRequest> req, 
+                                                  std::shared_ptr<HttpResponse> resp);
+
+    boost::asio::awaitable<void> get_webrtc_sessions(std::shared_ptr<HttpServerSession> session, 
+                                                     std::shared_ptr<HttpRequest> req, 
+                                                     std::shared_ptr<HttpResponse> resp);
+
     boost::asio::awaitable<void> get_domain_apps(std::shared_ptr<HttpServerSession> session, 
                                                  std::shared_ptr<HttpRequest> req, 
                                                  std::shared_ptr<HttpResponse> resp);
@@ -54,5 +65,7 @@ private:
     boost::asio::awaitable<void> get_mem_info(std::shared_ptr<HttpServerSession> session, 
                                                  std::shared_ptr<HttpRequest> req, 
                                                  std::shared_ptr<HttpResponse> resp);
+private:
+    std::shared_ptr<WebRtcServer> webrtc_server_;
 };
 };
\ No newline at end of file
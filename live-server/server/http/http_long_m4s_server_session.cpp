@@ -163,12 +163,16 @@ void HttpLongM4sServerSession::start() {
 }
 
 boost::asio::awaitable<bool> HttpLongM4sServerSession::send_fmp4_seg(std::shared_ptr<Mp4Segment> seg) {
-    auto data = seg->get_used_buf();
-    if (!co_await http_response_->write_data(data)) {
+    std::vector<boost::asio::const_buffer> bufs;
+    for (auto & data : seg->get_used_bufs()) {
+        bufs.push_back(boost::asio::buffer(data.data(), data.size()));
+    }
+
+    if (!co_await http_response_->write_data(bufs)) {
         stop();
         co_return false;
     }
-    CORE_DEBUG("send data bytes:{}", data.size());
+    CORE_DEBUG("send data bytes:{}", seg->get_bytes());
     co_return true;
 }
 
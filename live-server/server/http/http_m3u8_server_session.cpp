@@ -9,13 +9,16 @@
 #include "app/play_app.h"
 #include "app/publish_app.h"
 #include "base/thread/thread_worker.hpp"
+#include "base/utils/utils.h"
 #include "bridge/media_bridge.hpp"
 #include "config/app_config.h"
 #include "core/hls_live_media_source.hpp"
 #include "core/source_manager.hpp"
 #include "core/ts_media_source.hpp"
+#include "core/m4s_media_source.hpp"
 #include "protocol/http/http_request.hpp"
 #include "protocol/http/http_response.hpp"
+#include "protocol/http/http_cached_response.hpp"
 
 
 using namespace mms;
@@ -76,6 +79,19 @@ void HttpM3u8ServerSession::start() {
             // }
 
             std::shared_ptr<HlsLiveMediaSource> hls_source;
+            auto app_conf = publish_app->get_conf();
+            // cmaf: 从m4s source生成fmp4的hls，与dash共用切片
+            bool cmaf = app_conf && app_conf->hls_config().cmaf_enabled();
+            // 带id时请求的是cmaf的音频/视频media playlist
+            const auto & playlist_id = http_request_->get_path_param("id");
+            if (!playlist_id.empty() && (!cmaf || (playlist_id != "audio" && playlist_id != "video"))) {
+                http_response_->add_header("Connection", "close");
+                http_response_->add_header("Content-Length", "0");
+                http_response_->add_header("Access-Control-Allow-Origin", "*");
+                co_await http_response_->write_header(404, "Not Found");
+                co_return;
+            }
+
             if (!source) {  // todo : reply 404
                 http_response_->add_header("Connection", "close");
                 http_response_->add_header("Content-Length", "0");
@@ -84,9 +100,9 @@ void HttpM3u8ServerSession::start() {
                 co_return;
             } else {
                 if (source->get_media_type() != "hls") {
-                    auto ts_bridge = source->get_or_create_bridge(source->get_media_type() + "-ts",
-                                                                  publish_app, stream_name_);
-                    if (!ts_bridge) {
+                    auto seg_bridge = source->get_or_create_bridge(source->get_media_type() + (cmaf ? "-m4s" : "-ts"),
+                                                                   publish_app, stream_name_);
+                    if (!seg_bridge) {
                         http_response_->add_header("Connection", "close");
                         http_response_->add_header("Content-Length", "0");
                         http_response_->add_header("Access-Control-Allow-Origin", "*");
@@ -94,9 +110,16 @@ void HttpM3u8ServerSession::start() {
                         co_return;
                     }
 
-                    auto ts_source = std::static_pointer_cast<TsMediaSource>(ts_bridge->get_media_source());
-                    auto hls_bridge = ts_source->get_or_create_bridge(ts_source->get_media_type() + "-hls",
+                    std::shared_ptr<MediaBridge> hls_bridge;
+                    if (cmaf) {
+                        auto m4s_source = std::static_pointer_cast<M4sMediaSource>(seg_bridge->get_media_source());
+                        hls_bridge = m4s_source->get_or_create_bridge(m4s_source->get_media_type() + "-hls",
                                                                       publish_app, stream_name_);
+                    } else {
+                        auto ts_source = std::static_pointer_cast<TsMediaSource>(seg_bridge->get_media_source());
+                        hls_bridge = ts_source->get_or_create_bridge(ts_source->get_media_type() + "-hls",
+                                                                     publish_app, stream_name_);
+                    }
                     if (!hls_bridge) {
                         http_response_->add_header("Connection", "close");
                         http_response_->add_header("Content-Length", "0");
@@ -110,8 +133,40 @@ void HttpM3u8ServerSession::start() {
                     hls_source = std::static_pointer_cast<HlsLiveMediaSource>(source);
                 }
 
-                int try_count = 0;
-                while (try_count <= 2000) {// 起播3个切片，有的切片很大，保险点最好等个20秒，todo:加上可配置选项
+                // ll-hls blocking playlist reload: 带_HLS_msn/_HLS_part参数时，等到对应的切片或part生成后再回复
+                int64_t hls_msn = -1;
+                int64_t hls_part = -1;
+                if (app_conf && app_conf->hls_config().ll_hls_enabled() && !cmaf) {
+                    const auto & msn_param = http_request_->get_query_param("_HLS_msn");
+                    const auto & part_param = http_request_->get_query_param("_HLS_part");
+                    try {
+                        if (!msn_param.empty()) {
+                            hls_msn = std::stoll(msn_param);
+                        }
+                        if (!part_param.empty()) {
+                            hls_part = std::stoll(part_param);
+                        }
+                    } catch (std::exception & e) {
+                        hls_msn = -1;
+                    }
+
+                    if ((!part_param.empty() && hls_msn < 0) || (hls_msn >= 0 && hls_msn > hls_source->get_last_seqno() + 2)) {
+                        http_response_->add_header("Connection", "close");
+                        http_response_->add_header("Content-Length", "0");
+                        http_response_->add_header("Access-Control-Allow-Origin", "*");
+                        co_await http_response_->write_header(400, "Bad Request");
+                        co_return;
+                    }
+                }
+
+                // 起播需要等待足够的切片，有的切片很大，默认最多等20秒
+                // 等待期间挂在hls source的m3u8更新通知上，m3u8更新时所有等待的请求一起唤醒
+                int64_t wait_timeout = app_conf ? app_conf->hls_config().m3u8_wait_timeout() : 20000;
+                if (hls_msn >= 0) {// 阻塞请求最多等待3个切片时长，超时回复503
+                    wait_timeout = 3 * app_conf->hls_config().ts_min_seg_dur();
+                }
+                int64_t wait_start = Utils::get_current_ms();
+                while (true) {
                     hls_source->update_last_access_time();
                     auto status = hls_source->get_status();
                     bool ret = co_await process_source_status(status);
@@ -119,31 +174,39 @@ void HttpM3u8ServerSession::start() {
                         co_return;
                     }
 
-                    std::string m3u8 = hls_source->get_m3u8();
-                    if (m3u8.empty()) {
-                        try_count++;
-                        boost::system::error_code ec;
-                        boost::asio::steady_timer timer(worker_->get_io_context());
-                        timer.expires_after(std::chrono::milliseconds(100));
-                        co_await timer.async_wait(
-                            boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                    // 先取版本号再判断，避免判断之后、等待之前的更新丢失
+                    uint64_t m3u8_version = hls_source->get_m3u8_version();
+                    auto m3u8_resp = playlist_id.empty() ? hls_source->get_m3u8_response() : hls_source->get_media_playlist_response(playlist_id);
+                    if (!m3u8_resp || (hls_msn >= 0 && !hls_source->has_part(hls_msn, hls_part))) {
+                        int64_t elapsed = Utils::get_current_ms() - wait_start;
+                        if (elapsed >= wait_timeout) {
+                            break;
+                        }
+                        // 分段等待，便于及时感知源状态的变化
+                        co_await hls_source->wait_m3u8_update(worker_, m3u8_version, std::min<int64_t>(wait_timeout - elapsed, 1000));
                         continue;
                     }
 
-                    http_response_->add_header("Connection", "close");
-                    http_response_->add_header("Content-Type", "application/vnd.apple.mpegurl");
-                    http_response_->add_header("Content-Length", std::to_string(m3u8.size()));
-                    http_response_->add_header("Access-Control-Allow-Origin", "*");
-                    if (!(co_await http_response_->write_header(200, "OK"))) {
+                    // 响应头已经预先生成好，直接和body一起发送
+                    if (m3u8_resp->match(http_request_->get_header("If-None-Match"))) {
+                        co_await http_response_->write_data(std::string_view(m3u8_resp->get_not_modified_head()));
                         co_return;
                     }
 
-                    co_await http_response_->write_data((uint8_t*)m3u8.data(), m3u8.size());
+                    std::vector<boost::asio::const_buffer> bufs;
+                    bufs.push_back(boost::asio::buffer(m3u8_resp->get_head()));
+                    bufs.push_back(boost::asio::buffer(m3u8_resp->get_body()));
+                    co_await http_response_->write_data(bufs);
                     co_return;
                 }
 
                 http_response_->add_header("Connection", "close");
                 http_response_->add_header("Access-Control-Allow-Origin", "*");
+                if (hls_msn >= 0) {
+                    http_response_->add_header("Content-Length", "0");
+                    co_await http_response_->write_header(503, "Service Unavailable");
+                    co_return;
+                }
                 co_await http_response_->write_header(404, "Not Found");
             }
 
@@ -11,6 +11,7 @@
 
 #include "protocol/http/http_request.hpp"
 #include "protocol/http/http_response.hpp"
+#include "protocol/http/http_cached_response.hpp"
 #include "protocol/mp4/m4s_segment.h"
 
 #include "base/thread/thread_worker.hpp"
@@ -20,6 +21,8 @@
 #include "core/mpd_live_media_source.hpp"
 #include "bridge/media_bridge.hpp"
 #include "core/source_manager.hpp"
+#include "config/app_config.h"
+#include "base/utils/utils.h"
 
 using namespace mms;
 HttpM4sServerSession::HttpM4sServerSession(std::shared_ptr<HttpRequest> http_req, std::shared_ptr<HttpResponse> http_resp):StreamSession(http_resp->get_worker()) {
@@ -68,7 +71,7 @@ void HttpM4sServerSession::start() {
         auto id = http_request_->get_path_param("id");
         const std::string mp4_name = stream_name_ + "/" + id + ".m4s";
         auto source = SourceManager::get_instance().get_source(publish_app->get_domain_name(), get_app_name(), get_stream_name());
-        std::shared_ptr<MpdLiveMediaSource> mpd_source;
+        std::shared_ptr<Mp4Segment> mp4_seg;
         if (!source) {//todo : reply 404
             CORE_DEBUG("could not find source for domain:{}, app:{}", domain_name_, app_name_);
             http_response_->add_header("Connection", "close");
@@ -89,24 +92,39 @@ void HttpM4sServerSession::start() {
                     co_return;
                 }
 
+                // dash和cmaf hls共用m4s source中的切片，不需要再创建mpd bridge
                 auto mp4_source = std::static_pointer_cast<M4sMediaSource>(mp4_bridge->get_media_source());
-                auto mpd_bridge = mp4_source->get_or_create_bridge(mp4_source->get_media_type() + "-mpd", publish_app, stream_name_);
-                if (!mpd_bridge) {
-                    http_response_->add_header("Connection", "close");
-                    http_response_->add_header("Content-Length", "0");
-                    http_response_->add_header("Access-Control-Allow-Origin", "*");
-                    co_await http_response_->write_header(415, "Unsupported Media Type");
-                    stop();
+                mp4_seg = mp4_source->get_mp4_segment(id + ".m4s");
+                // ll-dash: 播放器按availabilityTimeOffset提前请求下一个切片，等待切片开始生成
+                auto app_conf = publish_app->get_conf();
+                if (!mp4_seg && app_conf && app_conf->get_fmp4_chunk_dur() > 0) {
+                    int64_t wait_timeout = app_conf->get_fmp4_min_seg_dur();
+                    int64_t wait_start = Utils::get_current_ms();
+                    while (!mp4_seg) {
+                        int64_t elapsed = Utils::get_current_ms() - wait_start;
+                        if (elapsed >= wait_timeout) {
+                            break;
+                        }
+                        uint64_t chunk_version = mp4_source->get_chunk_version();
+                        mp4_seg = mp4_source->get_mp4_segment(id + ".m4s");
+                        if (!mp4_seg) {
+                            co_await mp4_source->wait_chunk_update(worker_, chunk_version, wait_timeout - elapsed);
+                        }
+                    }
+                }
+
+                if (mp4_seg && !mp4_seg->is_reaped()) {
+                    if (!co_await send_partial_segment(mp4_source, mp4_seg)) {
+                        stop();
+                    }
                     co_return;
                 }
-                mpd_source = std::static_pointer_cast<MpdLiveMediaSource>(mpd_bridge->get_media_source());
             } else {
-                mpd_source = std::static_pointer_cast<MpdLiveMediaSource>(source);
+                auto mpd_source = std::static_pointer_cast<MpdLiveMediaSource>(source);
+                mpd_source->update_last_access_time();
+                mp4_seg = mpd_source->get_mp4_segment(id + ".m4s");
             }
 
-            mpd_source->update_last_access_time();
-            
-            auto mp4_seg = mpd_source->get_mp4_segment(id + ".m4s");
             if (!mp4_seg) {
                 http_response_->add_header("Connection", "close");
                 http_response_->add_header("Content-Length", "0");
@@ -116,28 +134,78 @@ void HttpM4sServerSession::start() {
                 co_return;
             }
             
-            auto mp4_data = mp4_seg->get_used_buf();
-            if (id.starts_with("video")) {
-                http_response_->add_header("Content-Type", "video/iso.segment");
-            } else if (id.starts_with("audio")) {
-                http_response_->add_header("Content-Type", "audio/iso.segment");
-            }
-            
-            http_response_->add_header("Connection", "close");
-            http_response_->add_header("Access-Control-Allow-Origin", "*");
-            http_response_->add_header("Content-Length", std::to_string(mp4_data.size()));
-            if (!co_await http_response_->write_header(200, "Ok")) {
-                stop();
+            // 切片完成时已生成好响应头，支持If-None-Match
+            auto mp4_resp = mp4_seg->get_http_response();
+            if (mp4_resp->match(http_request_->get_header("If-None-Match"))) {
+                co_await http_response_->write_data(std::string_view(mp4_resp->get_not_modified_head()));
                 co_return;
             }
 
-            co_await http_response_->write_data(mp4_data);
+            auto mp4_datas = mp4_seg->get_used_bufs();
+            std::vector<boost::asio::const_buffer> bufs;
+            bufs.push_back(boost::asio::buffer(mp4_resp->get_head()));
+            for (auto & mp4_data : mp4_datas) {
+                bufs.push_back(boost::asio::buffer(mp4_data.data(), mp4_data.size()));
+            }
+            co_await http_response_->write_data(bufs);
         }
 
         co_return;
     }, boost::asio::detached);
 }
 
+boost::asio::awaitable<bool> HttpM4sServerSession::send_partial_segment(std::shared_ptr<M4sMediaSource> mp4_source, std::shared_ptr<Mp4Segment> mp4_seg) {
+    http_response_->add_header("Content-Type", mp4_seg->get_filename().starts_with("audio") ? "audio/iso.segment" : "video/iso.segment");
+    http_response_->add_header("Transfer-Encoding", "chunked");
+    http_response_->add_header("Cache-Control", "no-cache");
+    http_response_->add_header("Access-Control-Allow-Origin", "*");
+    if (!co_await http_response_->write_header(200, "OK")) {
+        co_return false;
+    }
+
+    // 已发送的字节数，chunk合并成完整切片后从这个位置继续发送
+    size_t sent_bytes = 0;
+    int64_t last_progress_time = Utils::get_current_ms();
+    while (true) {
+        // 先取版本号再取数据，避免取数据之后、等待之前的更新丢失
+        uint64_t chunk_version = mp4_source->get_chunk_version();
+        std::vector<std::shared_ptr<const std::string>> chunks;
+        bool reaped = mp4_seg->get_chunks(sent_bytes, chunks);
+        std::vector<boost::asio::const_buffer> bufs;
+        if (reaped) {
+            for (auto & mp4_data : mp4_seg->get_used_bufs(sent_bytes)) {
+                bufs.push_back(boost::asio::buffer(mp4_data.data(), mp4_data.size()));
+            }
+        } else {
+            for (auto & chunk : chunks) {
+                bufs.push_back(boost::asio::buffer(*chunk));
+            }
+        }
+
+        if (!bufs.empty()) {
+            if (!co_await http_response_->write_chunk(bufs)) {
+                co_return false;
+            }
+            sent_bytes += boost::asio::buffer_size(bufs);
+            last_progress_time = Utils::get_current_ms();
+        }
+
+        if (reaped) {
+            bufs.clear();
+            co_return co_await http_response_->write_chunk(bufs);
+        }
+
+        if (bufs.empty()) {
+            // 源已经停止，切片不会再完成
+            if (Utils::get_current_ms() - last_progress_time >= 10000) {
+                co_return false;
+            }
+            co_await mp4_source->wait_chunk_update(worker_, chunk_version, 1000);
+        }
+    }
+    co_return true;
+}
+
 void HttpM4sServerSession::stop() {
     // todo: how to record 404 error to log.
     if (closed_.test_and_set()) {
@@ -11,6 +11,8 @@ class HttpRequest;
 class HttpResponse;
 class RtmpMediaSink;
 class ThreadWorker;
+class M4sMediaSource;
+class Mp4Segment;
 class HttpM4sServerSession : public StreamSession, public ObjTracker<HttpM4sServerSession> {
 public:
     HttpM4sServerSession(std::shared_ptr<HttpRequest> http_req, std::shared_ptr<HttpResponse> http_resp);
@@ -18,6 +20,8 @@ public:
     void start();
     void stop();
 private:
+    // ll-dash: 生成中的切片用chunked transfer边生成边发送，直到切片完成
+    boost::asio::awaitable<bool> send_partial_segment(std::shared_ptr<M4sMediaSource> mp4_source, std::shared_ptr<Mp4Segment> mp4_seg);
     std::shared_ptr<RtmpMediaSink> rtmp_media_sink_;
     std::shared_ptr<HttpRequest> http_request_;
     std::shared_ptr<HttpResponse> http_response_;
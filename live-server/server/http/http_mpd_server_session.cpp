@@ -126,8 +126,8 @@ void HttpMpdServerSession::start() {
                 int try_count = 0;
                 while (try_count <= 400) {
                     mpd_source->update_last_access_time();
-                    std::string mpd = mpd_source->get_mpd();
-                    if (mpd.empty()) {
+                    auto mpd = mpd_source->get_mpd();
+                    if (!mpd || mpd->empty()) {
                         try_count++;
                         boost::system::error_code ec;
                         boost::asio::steady_timer timer(worker_->get_io_context());
@@ -139,13 +139,17 @@ void HttpMpdServerSession::start() {
 
                     http_response_->add_header("Connection", "close");
                     http_response_->add_header("Content-Type", "application/dash+xml");
-                    http_response_->add_header("Content-Length", std::to_string(mpd.size()));
+                    auto mpd_tail = mpd_source->get_mpd_tail();
+                    http_response_->add_header("Content-Length", std::to_string(mpd->size() + mpd_tail.size()));
                     http_response_->add_header("Access-Control-Allow-Origin", "*");
                     if (!(co_await http_response_->write_header(200, "OK"))) {
                         stop();
                         co_return;
                     }
-                    co_await http_response_->write_data((uint8_t*)mpd.data(), mpd.size());
+                    std::vector<boost::asio::const_buffer> bufs;
+                    bufs.push_back(boost::asio::buffer(*mpd));
+                    bufs.push_back(boost::asio::buffer(mpd_tail));
+                    co_await http_response_->write_data(bufs);
                     co_return;
                 }
 
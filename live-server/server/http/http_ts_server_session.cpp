@@ -1,3 +1,4 @@
+#include <charconv>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/use_awaitable.hpp>
@@ -11,9 +12,12 @@
 
 #include "protocol/http/http_request.hpp"
 #include "protocol/http/http_response.hpp"
+#include "protocol/http/http_cached_response.hpp"
 #include "protocol/ts/ts_segment.hpp"
 
 #include "base/thread/thread_worker.hpp"
+#include "base/utils/utils.h"
+#include "config/app_config.h"
 #include "core/stream_session.hpp"
 
 #include "core/ts_media_source.hpp"
@@ -62,7 +66,6 @@ void HttpTsServerSession::start() {
         }
 
         auto source_name = publish_app->get_domain_name() + "/" + app_name_ + "/" + http_request_->get_path_param("stream");
-        const std::string ts_name = http_request_->get_path_param("seq") + ".ts";
         auto source = SourceManager::get_instance().get_source(publish_app->get_domain_name(), get_app_name(), get_stream_name());
         std::shared_ptr<HlsLiveMediaSource> hls_source;
         if (!source) {//todo : reply 404
@@ -98,7 +101,18 @@ void HttpTsServerSession::start() {
             }
 
             hls_source->update_last_access_time();
-            auto ts_seg = hls_source->get_ts_segment(ts_name);
+            // ll-hls partial segment, 命名为: 切片序号_part序号.ts
+            const std::string & seq = http_request_->get_path_param("seq");
+            auto part_pos = seq.find('_');
+            if (part_pos != std::string::npos) {
+                co_await serve_part(hls_source, publish_app, seq.substr(0, part_pos), seq.substr(part_pos + 1));
+                co_return;
+            }
+
+            // 切片命名为: 切片序号.ts，直接按序号查找
+            int64_t seqno = -1;
+            auto [ptr, ec] = std::from_chars(seq.data(), seq.data() + seq.size(), seqno);
+            auto ts_seg = (ec == std::errc() && ptr == seq.data() + seq.size()) ? hls_source->get_ts_segment(seqno) : nullptr;
             if (!ts_seg) {
                 http_response_->add_header("Connection", "close");
                 http_response_->add_header("Content-Length", "0");
@@ -107,21 +121,16 @@ void HttpTsServerSession::start() {
                 co_return;
             }
             
-            auto ts_datas = ts_seg->get_ts_data();
-            http_response_->add_header("Content-Type", "video/MP2T");
-            http_response_->add_header("Connection", "close");
-            http_response_->add_header("Access-Control-Allow-Origin", "*");
-            int64_t total_bytes = 0;
-            for (auto & ts_data : ts_datas) {
-                total_bytes += ts_data.size();
-            }
-
-            http_response_->add_header("Content-Length", std::to_string(total_bytes));
-            if (!co_await http_response_->write_header(200, "Ok")) {
+            // 切片完成时已生成好响应头，支持If-None-Match
+            auto ts_resp = ts_seg->get_http_response();
+            if (ts_resp->match(http_request_->get_header("If-None-Match"))) {
+                co_await http_response_->write_data(std::string_view(ts_resp->get_not_modified_head()));
                 co_return;
             }
-            
+
+            auto ts_datas = ts_seg->get_ts_data();
             std::vector<boost::asio::const_buffer> bufs;
+            bufs.push_back(boost::asio::buffer(ts_resp->get_head()));
             for (auto & ts_data : ts_datas) {
                 bufs.push_back(boost::asio::const_buffer((char*)ts_data.data(), ts_data.size()));
             }
@@ -135,6 +144,64 @@ void HttpTsServerSession::start() {
     });
 }
 
+boost::asio::awaitable<void> HttpTsServerSession::serve_part(std::shared_ptr<HlsLiveMediaSource> hls_source, std::shared_ptr<PublishApp> publish_app,
+                                                             const std::string & msn_str, const std::string & part_str) {
+    int64_t msn = -1;
+    int64_t part = -1;
+    try {
+        msn = std::stoll(msn_str);
+        part = std::stoll(part_str);
+    } catch (std::exception & e) {
+        msn = -1;
+    }
+
+    auto app_conf = publish_app->get_conf();
+    if (msn < 0 || part < 0 || !app_conf || !app_conf->hls_config().ll_hls_enabled()) {
+        http_response_->add_header("Connection", "close");
+        http_response_->add_header("Content-Length", "0");
+        http_response_->add_header("Access-Control-Allow-Origin", "*");
+        co_await http_response_->write_header(404, "Not Found");
+        co_return;
+    }
+
+    // preload hint指向的part可能还没生成，等待一段时间
+    std::vector<boost::asio::const_buffer> bufs;
+    int64_t wait_start = Utils::get_current_ms();
+    while (true) {
+        uint64_t m3u8_version = hls_source->get_m3u8_version();
+        auto ts_seg = hls_source->get_ts_segment_by_seqno(msn);
+        if (ts_seg && ts_seg->get_part_data(part, bufs)) {
+            break;
+        }
+
+        if (msn > hls_source->get_last_seqno() + 1 || (ts_seg && ts_seg->is_reaped()) ||
+            Utils::get_current_ms() - wait_start > 3 * app_conf->hls_config().ts_part_target_dur()) {
+            http_response_->add_header("Connection", "close");
+            http_response_->add_header("Content-Length", "0");
+            http_response_->add_header("Access-Control-Allow-Origin", "*");
+            co_await http_response_->write_header(404, "Not Found");
+            co_return;
+        }
+
+        // 新的part生成时会更新m3u8
+        co_await hls_source->wait_m3u8_update(worker_, m3u8_version, app_conf->hls_config().ts_part_target_dur());
+    }
+
+    int64_t total_bytes = 0;
+    for (auto & buf : bufs) {
+        total_bytes += buf.size();
+    }
+    http_response_->add_header("Content-Type", "video/MP2T");
+    http_response_->add_header("Connection", "close");
+    http_response_->add_header("Access-Control-Allow-Origin", "*");
+    http_response_->add_header("Content-Length", std::to_string(total_bytes));
+    if (!co_await http_response_->write_header(200, "Ok")) {
+        co_return;
+    }
+    co_await http_response_->write_data(bufs);
+    co_return;
+}
+
 void HttpTsServerSession::stop() {
     // todo: how to record 404 error to log.
     if (closed_.test_and_set()) {
@@ -10,6 +10,8 @@ class HttpRequest;
 class HttpResponse;
 class RtmpMediaSink;
 class ThreadWorker;
+class HlsLiveMediaSource;
+class PublishApp;
 class HttpTsServerSession : public StreamSession, public ObjTracker<HttpTsServerSession> {
 public:
     HttpTsServerSession(std::shared_ptr<HttpRequest> http_req, std::shared_ptr<HttpResponse> http_resp);
@@ -17,6 +19,8 @@ public:
     void start();
     void stop();
 private:
+    boost::asio::awaitable<void> serve_part(std::shared_ptr<HlsLiveMediaSource> hls_source, std::shared_ptr<PublishApp> publish_app,
+                                            const std::string & msn_str, const std::string & part_str);
     std::shared_ptr<RtmpMediaSink> rtmp_media_sink_;
     std::shared_ptr<HttpRequest> http_request_;
     std::shared_ptr<HttpResponse> http_response_;
@@ -71,6 +71,17 @@ bool HttpsLiveServer::register_route() {
         return false;
     }
 
+    // cmaf hls的音频/视频media playlist
+    ret = on_get("/:app/:stream/:id.m3u8", [](std::shared_ptr<HttpServerSession> session, std::shared_ptr<HttpRequest> req, std::shared_ptr<HttpResponse> resp)->boost::asio::awaitable<void> {
+        (void)session;
+        auto http_m3u8_session = std::make_shared<HttpM3u8ServerSession>(req, resp);
+        http_m3u8_session->start();
+        co_return;
+    });
+    if (!ret) {
+        return false;
+    }
+
     ret = on_get("/:app/:stream/:seq.ts", [](std::shared_ptr<HttpServerSession> session, std::shared_ptr<HttpRequest> req, std::shared_ptr<HttpResponse> resp)->boost::asio::awaitable<void> {
         (void)session;
         auto http_ts_session = std::make_shared<HttpTsServerSession>(req, resp);
@@ -18,6 +18,7 @@
 #include "log/log.h"
 #include "protocol/rtsp/rtsp_request.hpp"
 #include "protocol/rtsp/rtsp_response.hpp"
+#include "protocol/rtp/rtcp/rtcp_fb_pli.h"
 #include "protocol/sdp/sdp.hpp"
 #include "rtp_over_tcp_pkt.hpp"
 #include "server/session.hpp"
@@ -109,6 +110,9 @@ void RtspServerSession::start_recv_coroutine() {
                                 if (consumed2 < 0) {
                                     co_return;
                                 }
+                                video_channel_ = rtp_over_tcp_pkt_header.get_channel();
+                                video_ssrc_ = RtpHeader::parse_ssrc((uint8_t *)recv_buf_.get() + consumed1,
+                                                                    rtp_over_tcp_pkt_header.get_pkt_len());
                                 std::vector<std::shared_ptr<RtpPacket>> pkts = {video_pkt};
                                 co_await rtsp_media_source_->on_video_packets(pkts);
                             } else if (pt == rtsp_media_source_->get_audio_pt()) {
@@ -244,6 +248,27 @@ boost::asio::awaitable<bool> RtspServerSession::send_rtp_over_tcp_pkts(
     co_return true;
 }
 
+boost::asio::awaitable<bool> RtspServerSession::send_rtcp_pli() {
+    if (!is_tcp_transport_ || video_ssrc_ == 0) {// 只有tcp交织方式能把pli发回推流端，且要先收到视频
+        co_return true;
+    }
+
+    RtcpFbPli pli_pkt;
+    pli_pkt.set_ssrc(video_ssrc_);
+    pli_pkt.set_media_source_ssrc(video_ssrc_);
+    uint8_t buf[64];
+    auto pli_size = pli_pkt.encode(buf + 4, sizeof(buf) - 4);
+    if (pli_size <= 0) {
+        co_return true;
+    }
+    // rtcp走视频rtp通道的下一个交织通道
+    RtpOverTcpPktHeader rtp_over_tcp_pkt_header;
+    rtp_over_tcp_pkt_header.set_channel(video_channel_ + 1);
+    rtp_over_tcp_pkt_header.set_pkt_len(pli_size);
+    rtp_over_tcp_pkt_header.encode(buf, 4);
+    co_return co_await sock_->send(buf, 4 + pli_size);
+}
+
 void RtspServerSession::stop() {
     if (closed_.test_and_set()) {
         return;
@@ -262,6 +287,7 @@ void RtspServerSession::stop() {
             co_await wg_.wait();
 
             if (rtsp_media_source_) {
+                rtsp_media_source_->set_key_frame_requester(nullptr);
                 rtsp_media_source_->set_session(nullptr);
                 auto publish_app = rtsp_media_source_->get_app();
                 start_delayed_source_check_and_delete(publish_app->get_conf()->get_stream_resume_timeout(),
@@ -399,6 +425,7 @@ boost::asio::awaitable<bool> RtspServerSession::process_announce_req(std::shared
     rtsp_media_source_ = std::static_pointer_cast<RtspMediaSource>(media_source);
     rtsp_media_source_->set_source_info(get_domain_name(), get_app_name(), get_stream_name());
     rtsp_media_source_->set_session(self);
+    rtsp_media_source_->set_origin(true);
 
     auto err = co_await publish_app->on_publish(self);
     if (err.code != 0) {
@@ -442,6 +469,21 @@ boost::asio::awaitable<bool> RtspServerSession::process_announce_req(std::shared
         co_return false;
     }
     rtsp_media_source_->set_status(E_SOURCE_STATUS_OK);
+    std::weak_ptr<Session> weak_self = shared_from_this();
+    rtsp_media_source_->set_key_frame_requester([this, weak_self](uint32_t layers) {
+        (void)layers;
+        auto self = weak_self.lock();
+        if (!self) {
+            return;
+        }
+
+        boost::asio::co_spawn(get_worker()->get_io_context(), [this, self]() -> boost::asio::awaitable<void> {
+            boost::system::error_code ec;
+            co_await send_funcs_channel_.async_send(boost::system::error_code{},
+                                                    std::bind(&RtspServerSession::send_rtcp_pli, this),
+                                                    boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }, boost::asio::detached);
+    });
     publish_app->on_create_source(get_domain_name(), get_app_name(), get_stream_name(), rtsp_media_source_);
     co_return true;
 }
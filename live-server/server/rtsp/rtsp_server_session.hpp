@@ -52,6 +52,7 @@ private:
     void start_recv_coroutine();
     boost::asio::awaitable<bool> send_rtsp_resp(std::shared_ptr<RtspResponse> resp);
     boost::asio::awaitable<bool> send_rtp_over_tcp_pkts(std::vector<std::shared_ptr<RtpPacket>> pkts);
+    boost::asio::awaitable<bool> send_rtcp_pli();
 private:
     size_t recv_buf_size_ = 0;
     std::unique_ptr<char[]> recv_buf_;
@@ -75,6 +76,8 @@ private:
     uint64_t session_id_;
     bool is_publisher_ = false;
     bool is_player_ = false;
+    uint8_t video_channel_ = 0;
+    uint32_t video_ssrc_ = 0;
     
     boost::asio::experimental::channel<void(boost::system::error_code, std::function<boost::asio::awaitable<bool>()>)> send_funcs_channel_;
     boost::asio::steady_timer play_sdp_timeout_timer_;
@@ -18,6 +18,7 @@ using namespace boost::asio::experimental::awaitable_operators;
 #include "boringssl_session.h"
 #include "config/config.h"
 #include "dtls_cert.h"
+#include "dtls_handshake_pool.hpp"
 #include "spdlog/spdlog.h"
 
 
@@ -26,11 +27,15 @@ using namespace mms;
 
 DtlsBoringSSLSession::DtlsBoringSSLSession(ThreadWorker *worker, WebRtcServerSession &session)
     : worker_(worker),
-      timeout_timer_(worker->get_io_context()),
+      hs_worker_(DtlsHandshakePool::get_instance().get_worker()),
+      timeout_timer_(hs_worker_ ? hs_worker_->get_io_context() : worker->get_io_context()),
       session_(session),
       dtls_state_channel_(worker->get_io_context()),
       handshaking_coroutine_exited_(worker->get_io_context()) {
     encrypted_buf_ = new uint8_t[TLS_MAX_RECV_BUF];
+    if (!hs_worker_) {// 没有启动握手线程池时在会话自己的worker上握手
+        hs_worker_ = worker_;
+    }
 }
 
 DtlsBoringSSLSession::~DtlsBoringSSLSession() {
@@ -110,18 +115,32 @@ void DtlsBoringSSLSession::do_on_ssl_info(const SSL *ssl, int where, int ret) {
         spdlog::debug("DTLS handshake start");
     } else if ((where & SSL_CB_HANDSHAKE_DONE) != 0) {
         spdlog::debug("DTLS handshake done");
-        uint8_t material[SRTP_MASTER_KEY_LEN * 2] = {0};
+        // 根据协商出的SRTP profile确定主密钥和salt长度(RFC5764、RFC7714)
+        SRTPProtectionProfile profile = SRTP_AES128_CM_HMAC_SHA1_80;
+        const SRTP_PROTECTION_PROFILE *selected = SSL_get_selected_srtp_profile(ssl_);
+        if (selected) {
+            profile = (SRTPProtectionProfile)selected->id;
+        }
+
+        int srtp_key_len = 16;
+        int srtp_salt_len = 14;
+        if (profile == SRTP_AEAD_AES_128_GCM) {
+            srtp_salt_len = 12;
+        } else if (profile == SRTP_AEAD_AES_256_GCM) {
+            srtp_key_len = 32;
+            srtp_salt_len = 12;
+        }
+
+        uint8_t material[(32 + 12) * 2] = {0};
         static const std::string dtls_label = "EXTRACTOR-dtls_srtp";
-        auto ret = SSL_export_keying_material(ssl_, material, sizeof(material), dtls_label.c_str(),
+        auto ret = SSL_export_keying_material(ssl_, material, (srtp_key_len + srtp_salt_len) * 2, dtls_label.c_str(),
                                               dtls_label.size(), NULL, 0, 0);
         if (ret <= 0) {
             dtls_state_channel_.close();
             timeout_timer_.cancel();
             return;
         }
-        handshake_done_ = true;
-        int srtp_key_len = 16;
-        int srtp_salt_len = 14;
+        spdlog::debug("DTLS srtp profile:{}", selected ? selected->name : "none");
 
         size_t offset = 0;
         std::string client_master_key((char *)(material), srtp_key_len);
@@ -134,7 +153,9 @@ void DtlsBoringSSLSession::do_on_ssl_info(const SSL *ssl, int where, int ret) {
 
         srtp_recv_key_ = client_master_key + client_master_salt;
         srtp_send_key_ = server_master_key + server_master_salt;
-        handshake_done_cb_(SRTP_AES128_CM_HMAC_SHA1_80, srtp_recv_key_, srtp_send_key_);
+        srtp_profile_ = profile;
+        // 握手在握手线程上完成，回调放到会话自己的worker上做(notify_handshake_done)
+        handshake_done_ = true;
 
         dtls_state_channel_.close();
         timeout_timer_.cancel();
@@ -151,18 +172,95 @@ unsigned int DtlsBoringSSLSession::on_ssl_dtls_timer(SSL *ssl, unsigned int time
         return 2 * timer_us;
 }
 
+void DtlsBoringSSLSession::notify_handshake_done() {
+    if (!handshake_done_ || handshake_done_notified_) {
+        return;
+    }
+    handshake_done_notified_ = true;
+    if (handshake_done_cb_) {
+        handshake_done_cb_(srtp_profile_, srtp_recv_key_, srtp_send_key_);
+    }
+}
+
+boost::asio::awaitable<void> DtlsBoringSSLSession::run_in_handshake_worker(std::function<boost::asio::awaitable<void>()> f) {
+    if (hs_worker_ == worker_) {
+        co_await f();
+        co_return;
+    }
+
+    auto self(shared_from_this());
+    auto done_channel = std::make_shared<boost::asio::experimental::concurrent_channel<void(boost::system::error_code, bool)>>(worker_->get_io_context(), 1);
+    boost::asio::co_spawn(
+        hs_worker_->get_io_context(),
+        [self, f]() -> boost::asio::awaitable<void> {
+            co_await f();
+            co_return;
+        },
+        [done_channel](std::exception_ptr exp) {
+            (void)exp;
+            done_channel->try_send(boost::system::error_code{}, true);
+        });
+
+    boost::system::error_code ec;
+    co_await done_channel->async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    co_return;
+}
+
 boost::asio::awaitable<int32_t> DtlsBoringSSLSession::do_handshake(mode m,
                                                                    std::shared_ptr<DtlsCert> dtls_cert) {
     (void)m;
     dtls_cert_ = dtls_cert;
+    state_ = CONNECTING;
+    handshake_done_ = false;
+
+    // 握手名额已满时在这里排队，期间收到的DTLS包先缓存，拿到名额后再交给ssl
+    auto &hs_pool = DtlsHandshakePool::get_instance();
+    if (!co_await hs_pool.acquire(worker_, hs_waiter_)) {
+        spdlog::warn("dtls handshake not admitted, active:{}, queued:{}", hs_pool.get_active_handshakes(), hs_pool.get_queued_handshakes());
+        co_return -12;
+    }
+    hs_waiter_.reset();
+    DtlsHandshakePool::Permit hs_permit(hs_pool);
+
+    if (closed_.test(std::memory_order_acquire)) {
+        co_return -13;
+    }
+
+    int32_t ret = 0;
+    co_await run_in_handshake_worker([this, &ret]() -> boost::asio::awaitable<void> {
+        ret = co_await start_handshake();
+        co_return;
+    });
+
+    if (ret != 0) {
+        co_return ret;
+    }
+
+    boost::system::error_code ec;
+    co_await dtls_state_channel_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    auto self(shared_from_this());
+    boost::asio::post(hs_worker_->get_io_context(), [this, self]() {
+        timeout_timer_.cancel();
+    });
+    // 握手已结束，名额尽早交给排队的会话
+    hs_permit.release();
+    // 设置超时回调
+    // This function sets an optional callback function for controlling the timeout interval on the DTLS
+    // protocol. The callback function will be called by DTLS for every new DTLS packet that is sent.
+    // DTLS_set_timer_cb(ssl_, on_ssl_dtls_timer);
+    if (!handshake_done_) {
+        co_return -11;
+    }
+    notify_handshake_done();
+    co_return 0;
+}
+
+boost::asio::awaitable<int32_t> DtlsBoringSSLSession::start_handshake() {
     ssl_ctx_ = SSL_CTX_new(DTLS_method());
     if (!ssl_ctx_) {
         co_return -1;
     }
 
-    state_ = CONNECTING;
-    handshake_done_ = false;
-
     auto conf = Config::get_instance();
 
     if (!SSL_CTX_use_PrivateKey(ssl_ctx_, dtls_cert_->get_pkey())) {
@@ -194,7 +292,12 @@ boost::asio::awaitable<int32_t> DtlsBoringSSLSession::do_handshake(mode m,
 
     // For OpenSSL >= 1.0.2.
     // SSL_CTX_set_ecdh_auto(ssl_ctx_, 1);
-    ret = SSL_CTX_set_tlsext_use_srtp(ssl_ctx_, "SRTP_AES128_CM_SHA1_80");
+    // 作为服务端时按这里的顺序选择对端也支持的第一个profile，所以GCM放在前面
+    const char *srtp_profiles = "SRTP_AES128_CM_SHA1_80";
+    if (conf->get_webrtc_config().is_srtp_gcm_enabled()) {
+        srtp_profiles = "SRTP_AEAD_AES_256_GCM:SRTP_AEAD_AES_128_GCM:SRTP_AES128_CM_SHA1_80";
+    }
+    ret = SSL_CTX_set_tlsext_use_srtp(ssl_ctx_, srtp_profiles);
     if (0 != ret) {
         co_return -7;
     }
@@ -227,11 +330,19 @@ boost::asio::awaitable<int32_t> DtlsBoringSSLSession::do_handshake(mode m,
     SSL_set_ex_data(ssl_, 0, this);
     SSL_set_accept_state(ssl_);
     SSL_do_handshake(ssl_);
+    ssl_ready_ = true;
+    // 排队期间缓存的包
+    for (auto &pkt : pending_dtls_pkts_) {
+        if (!co_await do_process_dtls_packet((uint8_t *)pkt.data(), pkt.size())) {
+            break;
+        }
+    }
+    pending_dtls_pkts_.clear();
     // 启动定时器
     auto self(shared_from_this());
     handshake_coroutine_running_ = true;
     boost::asio::co_spawn(
-        worker_->get_io_context(),
+        hs_worker_->get_io_context(),
         [this]() -> boost::asio::awaitable<void> {
             boost::system::error_code ec;
             while (1) {
@@ -285,17 +396,6 @@ boost::asio::awaitable<int32_t> DtlsBoringSSLSession::do_handshake(mode m,
             handshake_coroutine_running_ = false;
             handshaking_coroutine_exited_.close();
         });
-
-    boost::system::error_code ec;
-    co_await dtls_state_channel_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
-    timeout_timer_.cancel();
-    // 设置超时回调
-    // This function sets an optional callback function for controlling the timeout interval on the DTLS
-    // protocol. The callback function will be called by DTLS for every new DTLS packet that is sent.
-    // DTLS_set_timer_cb(ssl_, on_ssl_dtls_timer);
-    if (!handshake_done_) {
-        co_return -11;
-    }
     co_return 0;
 }
 
@@ -304,9 +404,16 @@ boost::asio::awaitable<void> DtlsBoringSSLSession::close() {
         co_return;
     }
 
+    if (hs_waiter_) {// 还在排队
+        DtlsHandshakePool::get_instance().cancel(hs_waiter_);
+    }
+
     if (handshake_coroutine_running_) {
         boost::system::error_code ec;
-        timeout_timer_.cancel();
+        auto self(shared_from_this());
+        boost::asio::post(hs_worker_->get_io_context(), [this, self]() {
+            timeout_timer_.cancel();
+        });
         if (dtls_state_channel_.is_open()) {
             dtls_state_channel_.close();
         }
@@ -320,6 +427,23 @@ boost::asio::awaitable<bool> DtlsBoringSSLSession::process_dtls_packet(
     uint8_t *data, size_t len, UdpSocket *sock, const boost::asio::ip::udp::endpoint &remote_ep) {
     (void)sock;
     (void)remote_ep;
+    bool ret = true;
+    co_await run_in_handshake_worker([this, data, len, &ret]() -> boost::asio::awaitable<void> {
+        if (!ssl_ready_) {
+            if (pending_dtls_pkts_.size() < MAX_PENDING_DTLS_PKTS) {
+                pending_dtls_pkts_.emplace_back((char *)data, len);
+            }
+            co_return;
+        }
+        ret = co_await do_process_dtls_packet(data, len);
+        co_return;
+    });
+    // 回到会话worker后再初始化srtp，保证后面的srtp包处理时已经有密钥
+    notify_handshake_done();
+    co_return ret;
+}
+
+boost::asio::awaitable<bool> DtlsBoringSSLSession::do_process_dtls_packet(uint8_t *data, size_t len) {
     int written = BIO_write(bio_read_, data, len);
     if (written <= 0) {
         co_return false;
@@ -10,6 +10,8 @@
 #pragma once
 #include <functional>
 #include <atomic>
+#include <string>
+#include <vector>
 
 #include <boost/asio/ip/udp.hpp>
 #include <boost/asio/spawn.hpp>
@@ -22,6 +24,7 @@
 #include "openssl/dtls1.h"
 
 #include "define.h"
+#include "dtls_handshake_pool.hpp"
 #include "base/network/udp_socket.hpp"
 
 namespace mms {
@@ -55,10 +58,20 @@ public:
         handshake_done_cb_ = cb;
     }
 private:
+    boost::asio::awaitable<int32_t> start_handshake();
+    boost::asio::awaitable<bool> do_process_dtls_packet(uint8_t *data, size_t len);
+    // 在握手线程上执行f并等待完成，ssl_相关的操作都在握手线程上做
+    boost::asio::awaitable<void> run_in_handshake_worker(std::function<boost::asio::awaitable<void>()> f);
+    void notify_handshake_done();
     boost::asio::awaitable<void> send_pending_outgoing_dtls_packet();
     std::function<void(SRTPProtectionProfile profile, const std::string & srtp_recv_key, const std::string & srtp_send_key)> handshake_done_cb_;
 private:
     ThreadWorker * worker_ = nullptr;
+    ThreadWorker * hs_worker_ = nullptr;//握手线程，未启用握手线程池时等于worker_
+    std::shared_ptr<DtlsHandshakePool::Waiter> hs_waiter_;
+    static constexpr size_t MAX_PENDING_DTLS_PKTS = 16;
+    std::vector<std::string> pending_dtls_pkts_;//排队等握手名额期间收到的包
+    bool ssl_ready_ = false;
     mode mode_ = mode_server;
     SSL *ssl_ = nullptr;
     BIO *bio_read_    = nullptr;
@@ -68,6 +81,8 @@ private:
 
     DtlsState state_ = NEW;
     bool handshake_done_ = false;
+    bool handshake_done_notified_ = false;
+    SRTPProtectionProfile srtp_profile_ = SRTP_AES128_CM_HMAC_SHA1_80;
     boost::asio::steady_timer timeout_timer_;
     WebRtcServerSession & session_;
     std::shared_ptr<DtlsCert> dtls_cert_;
@@ -79,7 +94,7 @@ private:
 
     std::atomic_flag closed_ = ATOMIC_FLAG_INIT;
     boost::asio::experimental::concurrent_channel<void(boost::system::error_code, DtlsState)> dtls_state_channel_;
-    bool handshake_coroutine_running_ = false;
+    std::atomic<bool> handshake_coroutine_running_{false};
     boost::asio::experimental::concurrent_channel<void(boost::system::error_code, bool)> handshaking_coroutine_exited_;
 
     std::string srtp_recv_key_;
@@ -2,5 +2,7 @@
 #include <stdint.h>
 namespace mms {
 typedef uint16_t SRTPProtectionProfile;
-#define SRTP_AES128_CM_HMAC_SHA1_80 0x0001  //我们默认使用这种先
+#define SRTP_AES128_CM_HMAC_SHA1_80 0x0001  //兼容性最好，对端不支持GCM时使用
+#define SRTP_AEAD_AES_128_GCM       0x0007  //RFC7714，加密和认证一次完成，开销更小
+#define SRTP_AEAD_AES_256_GCM       0x0008
 };
\ No newline at end of file
@@ -7,9 +7,10 @@
 
 #include "dtls_cert.h"
 using namespace mms;
-bool DtlsCert::init(const std::string & domain)
+bool DtlsCert::init(const std::string & domain, KeyType key_type)
 {
     domain_ = domain;
+    key_type_ = key_type;
     if (!create_cert())
     {
         return false;
@@ -21,6 +22,7 @@ bool DtlsCert::init(const std::string & domain)
 DtlsCert::~DtlsCert()
 {
     // once you've successfully called EVP_PKEY_assign_RSA() you must not call RSA_free() on the underlying key or a double-free may result.
+    // ec_key_同理，由pkey_负责释放
     // if (rsa_)
     // {
     //     RSA_free(rsa_);
@@ -79,19 +81,8 @@ int add_ext(X509 *cert, int nid, char *value)
 }
 
 #define RSA_KEY_LENGTH 512
-bool DtlsCert::create_cert()
+bool DtlsCert::create_rsa_key()
 {
-    SSL_load_error_strings();
-    SSL_library_init();
-    OpenSSL_add_all_algorithms();
-    // 创建证书
-    certificate_ = X509_new();
-    X509_set_version(certificate_, 2);
-    // 生成随机序号
-    std::srand(time(nullptr));
-    int seq = std::rand() % 9999999;
-    ASN1_INTEGER_set(X509_get_serialNumber(certificate_), seq); // serial number
-    // 创建pkey
     rsa_ = RSA_new();
     bn_ = BN_new();
     pkey_ = EVP_PKEY_new();
@@ -99,11 +90,54 @@ bool DtlsCert::create_cert()
     int ret = RSA_generate_key_ex(rsa_, RSA_KEY_LENGTH, bn_, nullptr);
     if (ret != 1)
     {
+        RSA_free(rsa_);rsa_ = nullptr;
         BN_free(bn_);bn_ = nullptr;
         EVP_PKEY_free(pkey_);pkey_ = nullptr;
         return false;
     }
     EVP_PKEY_assign(pkey_, EVP_PKEY_RSA, reinterpret_cast<char *>(rsa_));
+    return true;
+}
+
+bool DtlsCert::create_ecdsa_key()
+{
+    ec_key_ = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
+    if (!ec_key_)
+    {
+        return false;
+    }
+    // 证书里只写曲线名，不展开曲线参数
+    EC_KEY_set_asn1_flag(ec_key_, OPENSSL_EC_NAMED_CURVE);
+    if (EC_KEY_generate_key(ec_key_) != 1)
+    {
+        EC_KEY_free(ec_key_);ec_key_ = nullptr;
+        return false;
+    }
+
+    pkey_ = EVP_PKEY_new();
+    EVP_PKEY_assign_EC_KEY(pkey_, ec_key_);
+    return true;
+}
+
+bool DtlsCert::create_cert()
+{
+    SSL_load_error_strings();
+    SSL_library_init();
+    OpenSSL_add_all_algorithms();
+    // 创建pkey
+    bool key_ok = key_type_ == KEY_TYPE_ECDSA ? create_ecdsa_key() : create_rsa_key();
+    if (!key_ok)
+    {
+        spdlog::error("create dtls {} key failed", key_type_ == KEY_TYPE_ECDSA ? "ecdsa" : "rsa");
+        return false;
+    }
+    // 创建证书
+    certificate_ = X509_new();
+    X509_set_version(certificate_, 2);
+    // 生成随机序号
+    std::srand(time(nullptr));
+    int seq = std::rand() % 9999999;
+    ASN1_INTEGER_set(X509_get_serialNumber(certificate_), seq); // serial number
     X509_set_pubkey(certificate_, pkey_);
     // 设置时长
     static const int expired_days = 365 * 10;
@@ -133,7 +167,8 @@ bool DtlsCert::create_cert()
 	// add_ext(certificate_, NID_subject_key_identifier, (char*)("hash"));
     // add_ext(certificate_, NID_authority_key_identifier, (char*)("keyid:always"));
     // 生成签名
-    ret = X509_sign(certificate_, pkey_, EVP_sha1()); // some hash type here
+    // ECDSA证书用sha256签名，RSA保持原来的sha1
+    int ret = X509_sign(certificate_, pkey_, key_type_ == KEY_TYPE_ECDSA ? EVP_sha256() : EVP_sha1());
     if (ret == 0)
     {
         BN_free(bn_);bn_ = nullptr;
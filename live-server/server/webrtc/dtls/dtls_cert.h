@@ -6,15 +6,27 @@
 #include "openssl/bio.h"
 #include "openssl/ssl.h"
 #include "openssl/x509.h"
+#include "openssl/ec.h"
 
 namespace mms
 {
     class DtlsCert
     {
+    public:
+        enum KeyType
+        {
+            KEY_TYPE_RSA = 0,
+            KEY_TYPE_ECDSA = 1,// P-256，签名和握手计算量比RSA小很多，浏览器默认也用它
+        };
     public:
         DtlsCert() = default;
         ~DtlsCert();
-        bool init(const std::string & domain);
+        bool init(const std::string & domain, KeyType key_type = KEY_TYPE_ECDSA);
+
+        KeyType get_key_type() const
+        {
+            return key_type_;
+        }
 
         const std::string &get_finger_print() const
         {
@@ -36,13 +48,17 @@ namespace mms
         }        
     private:
         std::string domain_;
+        KeyType key_type_ = KEY_TYPE_ECDSA;
         X509 *certificate_ = nullptr;
         RSA *rsa_ = nullptr;
+        EC_KEY *ec_key_ = nullptr;
         EVP_PKEY *pkey_ = nullptr;
         BIGNUM *bn_ = nullptr;
         std::string finger_print_;
         std::string der_;
     private:
         bool create_cert();
+        bool create_rsa_key();
+        bool create_ecdsa_key();
     };
 };
\ No newline at end of file
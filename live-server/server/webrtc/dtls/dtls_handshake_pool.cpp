@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <thread>
+
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "spdlog/spdlog.h"
+#include "base/thread/thread_worker.hpp"
+#include "dtls_handshake_pool.hpp"
+
+using namespace boost::asio::experimental::awaitable_operators;
+using namespace mms;
+
+DtlsHandshakePool & DtlsHandshakePool::get_instance() {
+    // 不析构，会话可能在进程退出时才释放名额
+    static DtlsHandshakePool *instance = new DtlsHandshakePool;
+    return *instance;
+}
+
+void DtlsHandshakePool::start(int32_t threads, int32_t max_handshakes, int32_t max_queued, int32_t queue_timeout_ms) {
+    max_handshakes_ = max_handshakes;
+    max_queued_ = max_queued;
+    queue_timeout_ms_ = queue_timeout_ms;
+    if (!workers_.empty()) {
+        return;
+    }
+
+    int32_t cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    for (int32_t i = 0; i < threads; i++) {
+        ThreadWorker *w = new ThreadWorker();
+        // 从最后一个核往前放，尽量避开前面几个核上的转发worker
+        w->set_cpu_core(cpu_count - 1 - (i % cpu_count));
+        w->start();
+        workers_.emplace_back(w);
+    }
+}
+
+void DtlsHandshakePool::stop() {
+    for (auto & w : workers_) {
+        w->stop();
+        delete w;
+    }
+    workers_.clear();
+}
+
+ThreadWorker *DtlsHandshakePool::get_worker() {
+    if (workers_.empty()) {
+        return nullptr;
+    }
+    uint64_t idx = using_worker_idx_++ % workers_.size();
+    return workers_[idx];
+}
+
+boost::asio::awaitable<bool> DtlsHandshakePool::acquire(ThreadWorker *worker, std::shared_ptr<Waiter> & waiter) {
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (max_handshakes_ <= 0 || active_handshakes_ < max_handshakes_) {
+            active_handshakes_++;
+            co_return true;
+        }
+
+        if ((int32_t)waiters_.size() >= max_queued_) {
+            rejected_handshakes_++;
+            spdlog::warn("dtls handshake queue full, active:{}, queued:{}", active_handshakes_, waiters_.size());
+            co_return false;
+        }
+        waiter = std::make_shared<Waiter>(worker->get_io_context());
+        waiters_.push_back(waiter);
+    }
+
+    boost::system::error_code ec;
+    boost::asio::steady_timer timer(worker->get_io_context());
+    timer.expires_after(std::chrono::milliseconds(queue_timeout_ms_));
+    co_await (waiter->ch_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec)) ||
+              timer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec)));
+
+    // 以granted_为准，超时和release同时发生时名额已经转给了本会话
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (waiter->granted_) {
+        co_return true;
+    }
+
+    auto it = std::find(waiters_.begin(), waiters_.end(), waiter);
+    if (it != waiters_.end()) {
+        waiters_.erase(it);
+        rejected_handshakes_++;
+    }
+    co_return false;
+}
+
+void DtlsHandshakePool::release() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (!waiters_.empty()) {
+        // 名额直接转给排在最前面的会话
+        auto waiter = waiters_.front();
+        waiters_.pop_front();
+        waiter->granted_ = true;
+        waiter->ch_.try_send(boost::system::error_code{}, true);
+        return;
+    }
+
+    if (active_handshakes_ > 0) {
+        active_handshakes_--;
+    }
+}
+
+void DtlsHandshakePool::cancel(std::shared_ptr<Waiter> waiter) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto it = std::find(waiters_.begin(), waiters_.end(), waiter);
+    if (it != waiters_.end()) {
+        waiters_.erase(it);
+    }
+    waiter->ch_.close();
+}
+
+int32_t DtlsHandshakePool::get_active_handshakes() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return active_handshakes_;
+}
+
+int32_t DtlsHandshakePool::get_queued_handshakes() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return (int32_t)waiters_.size();
+}
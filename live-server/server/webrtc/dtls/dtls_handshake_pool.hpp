@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+
+namespace mms {
+class ThreadWorker;
+// DTLS握手专用线程池
+// 握手中的密钥交换、签名等运算放到独立线程上执行，并限制同时进行的握手数，超出的按先后排队，
+// 避免大量播放端同时加入时握手挤占转发媒体的worker，增加已建立会话的延时
+class DtlsHandshakePool {
+public:
+    class Waiter {
+    public:
+        Waiter(boost::asio::io_context & io) : ch_(io, 1) {}
+    private:
+        friend class DtlsHandshakePool;
+        boost::asio::experimental::concurrent_channel<void(boost::system::error_code, bool)> ch_;
+        bool granted_ = false;//mtx_保护
+    };
+
+    // acquire成功后持有的握手名额，析构时归还，握手的任何退出路径都不会漏掉release
+    class Permit {
+    public:
+        Permit(DtlsHandshakePool & pool) : pool_(pool) {}
+        ~Permit() {
+            release();
+        }
+        Permit(const Permit &) = delete;
+        Permit & operator=(const Permit &) = delete;
+        // 提前归还，之后析构不再重复release
+        void release() {
+            if (held_) {
+                held_ = false;
+                pool_.release();
+            }
+        }
+    private:
+        DtlsHandshakePool & pool_;
+        bool held_ = true;
+    };
+
+    static DtlsHandshakePool & get_instance();
+
+    void start(int32_t threads, int32_t max_handshakes, int32_t max_queued, int32_t queue_timeout_ms);
+    void stop();
+    // 未启动时返回nullptr，握手在会话自己的worker上进行
+    ThreadWorker *get_worker();
+    // 申请一个握手名额，名额已满时在worker上排队等待，排队超时、队列已满或被cancel返回false
+    // 返回true后握手结束时必须调用release，一般用Permit保证
+    boost::asio::awaitable<bool> acquire(ThreadWorker *worker, std::shared_ptr<Waiter> & waiter);
+    void release();
+    void cancel(std::shared_ptr<Waiter> waiter);
+
+    int32_t get_active_handshakes();
+    int32_t get_queued_handshakes();
+    uint64_t get_rejected_handshakes() {
+        return rejected_handshakes_.load(std::memory_order_relaxed);
+    }
+private:
+    DtlsHandshakePool() = default;
+private:
+    std::vector<ThreadWorker*> workers_;
+    std::atomic<uint64_t> using_worker_idx_{0};
+
+    int32_t max_handshakes_ = 0;
+    int32_t max_queued_ = 0;
+    int32_t queue_timeout_ms_ = 5000;
+
+    std::mutex mtx_;
+    int32_t active_handshakes_ = 0;
+    std::deque<std::shared_ptr<Waiter>> waiters_;
+    std::atomic<uint64_t> rejected_handshakes_{0};
+};
+};
@@ -0,0 +1,40 @@
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include "rtp_send_queue.hpp"
+using namespace mms;
+
+RtpSendQueue::RtpSendQueue(boost::asio::io_context & io, size_t capacity) : ch_(io, capacity) {
+}
+
+bool RtpSendQueue::try_push(std::vector<std::shared_ptr<RtpPacket>> pkts, bool is_video) {
+    size_t count = pkts.size();
+    // 先计数，发送协程取出后立即减掉
+    pending_batches_++;
+    if (ch_.try_send(boost::system::error_code{}, std::move(pkts))) {
+        return true;
+    }
+
+    pending_batches_--;
+    dropped_batches_++;
+    if (is_video) {
+        dropped_video_pkts_ += count;
+    } else {
+        dropped_audio_pkts_ += count;
+    }
+    return false;
+}
+
+boost::asio::awaitable<std::vector<std::shared_ptr<RtpPacket>>> RtpSendQueue::pop(boost::system::error_code & ec) {
+    auto pkts = co_await ch_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    if (!ec) {
+        pending_batches_--;
+    }
+    co_return pkts;
+}
+
+void RtpSendQueue::close() {
+    if (ch_.is_open()) {
+        ch_.close();
+    }
+}
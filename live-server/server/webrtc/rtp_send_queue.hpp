@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
+
+#include "protocol/rtp/rtp_packet.h"
+
+namespace mms {
+// 播放者的rtp发送队列，源的分发协程放入，会话的发送协程取出
+// 放入不等待：某个播放者因节奏控制或拥塞发得慢，队列满时整批丢弃，不能阻塞源向其他播放者的分发
+class RtpSendQueue {
+public:
+    RtpSendQueue(boost::asio::io_context & io, size_t capacity);
+    // 队列已满或已关闭返回false，包被丢弃并计数
+    bool try_push(std::vector<std::shared_ptr<RtpPacket>> pkts, bool is_video);
+    // 队列关闭后ec非0
+    boost::asio::awaitable<std::vector<std::shared_ptr<RtpPacket>>> pop(boost::system::error_code & ec);
+    void close();
+    bool is_open() {
+        return ch_.is_open();
+    }
+
+    int32_t get_pending_batches() {
+        return pending_batches_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_dropped_batches() {
+        return dropped_batches_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_dropped_video_pkts() {
+        return dropped_video_pkts_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_dropped_audio_pkts() {
+        return dropped_audio_pkts_.load(std::memory_order_relaxed);
+    }
+private:
+    boost::asio::experimental::concurrent_channel<void(boost::system::error_code, std::vector<std::shared_ptr<RtpPacket>>)> ch_;
+    std::atomic<int32_t> pending_batches_{0};
+    std::atomic<uint64_t> dropped_batches_{0};
+    std::atomic<uint64_t> dropped_video_pkts_{0};
+    std::atomic<uint64_t> dropped_audio_pkts_{0};
+};
+};
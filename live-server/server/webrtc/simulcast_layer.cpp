@@ -0,0 +1,97 @@
+#include <arpa/inet.h>
+#include <algorithm>
+
+#include "simulcast_layer.hpp"
+using namespace mms;
+
+void SimulcastLayerSelector::update_target(const std::vector<int64_t> & layer_bps, int64_t estimated_bps, int64_t now_ms) {
+    layer_check_ms_ = now_ms;
+    target_layer_ = choose_layer(layer_bps, estimated_bps, now_ms);
+}
+
+int32_t SimulcastLayerSelector::choose_layer(const std::vector<int64_t> & layer_bps, int64_t estimated_bps, int64_t now_ms) {
+    if (fixed_layer_ >= 0) {
+        return fixed_layer_;
+    }
+
+    // 选不超过估计带宽的最高码率层，都超过则选最低码率层，没有带宽估计时选最高码率层
+    int32_t best = -1, lowest = -1;
+    int64_t best_bps = 0, lowest_bps = 0;
+    for (size_t i = 0; i < layer_bps.size(); i++) {
+        int64_t bps = layer_bps[i];
+        if (bps <= 0) {
+            continue;
+        }
+
+        if (lowest < 0 || bps < lowest_bps) {
+            lowest = i;
+            lowest_bps = bps;
+        }
+
+        if ((estimated_bps <= 0 || bps <= estimated_bps * LAYER_BW_RATIO) && bps > best_bps) {
+            best = i;
+            best_bps = bps;
+        }
+    }
+
+    if (best < 0) {
+        best = lowest >= 0 ? lowest : 0;
+    }
+
+    // 降层立即生效，升层需要带宽持续满足一段时间，避免来回切换
+    if (cur_layer_ >= 0 && best != cur_layer_ && cur_layer_ < (int32_t)layer_bps.size()) {
+        int64_t cur_bps = layer_bps[cur_layer_];
+        if (cur_bps > 0 && layer_bps[best] > cur_bps) {
+            if (layer_up_since_ms_ == 0) {
+                layer_up_since_ms_ = now_ms;
+            }
+
+            if (now_ms - layer_up_since_ms_ < LAYER_UP_DELAY_MS) {
+                return cur_layer_;
+            }
+        }
+    }
+    layer_up_since_ms_ = 0;
+    return best;
+}
+
+bool SimulcastRtpRewriter::rewrite(uint8_t *data, RtpPacket & pkt, int64_t now_ms) {
+    uint32_t src_ssrc = pkt.header_.ssrc;
+    uint16_t in_seq = pkt.get_seq_num();
+    uint32_t in_ts = pkt.get_timestamp();
+    if (src_ssrc != src_ssrc_) {
+        if (started_ && src_ssrc == prev_src_ssrc_) {// 切层前排队的旧层重传包，丢弃
+            return false;
+        }
+
+        if (started_) {
+            uint32_t ts_delta = std::max<int64_t>(1, (now_ms - last_out_ms_) * 90);
+            seq_offset_ = last_out_seq_ + 1 - in_seq;
+            ts_offset_ = last_out_ts_ + ts_delta - in_ts;
+        }
+        prev_src_ssrc_ = src_ssrc_;
+        src_ssrc_ = src_ssrc;
+        base_seq_ = in_seq + seq_offset_;
+    }
+
+    uint16_t out_seq = in_seq + seq_offset_;
+    uint32_t out_ts = in_ts + ts_offset_;
+    *(uint16_t *)(data + 2) = htons(out_seq);
+    *(uint32_t *)(data + 4) = htonl(out_ts);
+    *(uint32_t *)(data + 8) = htonl(ssrc_);
+    if (!started_ || (int16_t)(out_seq - last_out_seq_) > 0) {
+        last_out_seq_ = out_seq;
+        last_out_ts_ = out_ts;
+        last_out_ms_ = now_ms;
+    }
+    started_ = true;
+    return true;
+}
+
+bool SimulcastRtpRewriter::to_src_seq(uint16_t out_seq, uint16_t & src_seq) const {
+    if (!started_ || (int16_t)(out_seq - base_seq_) < 0) {
+        return false;
+    }
+    src_seq = out_seq - seq_offset_;
+    return true;
+}
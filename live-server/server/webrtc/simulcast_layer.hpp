@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#include "protocol/rtp/rtp_packet.h"
+
+namespace mms {
+// simulcast播放的选层：按各层码率和带宽估计(或固定的rid)选目标层，降层立即生效，升层要求带宽持续满足一段时间
+// 目标层与当前层不同时，由调用者在目标层的关键帧处调用switch_layer完成切换，之前继续发送当前层
+// 非线程安全，在源的线程中访问
+class SimulcastLayerSelector {
+public:
+    static constexpr int32_t LAYER_CHECK_INTERVAL_MS = 500;
+    static constexpr int32_t LAYER_UP_DELAY_MS = 3000;        // 升层要求带宽持续满足的时间
+    static constexpr double LAYER_BW_RATIO = 0.85;            // 层码率不超过估计带宽的该比例
+
+    void set_fixed_layer(int32_t layer) {
+        fixed_layer_ = layer;
+    }
+
+    bool is_fixed() const {
+        return fixed_layer_ >= 0;
+    }
+
+    // 到了重新选层的时间
+    bool need_check(int64_t now_ms) const {
+        return target_layer_ < 0 || now_ms - layer_check_ms_ >= LAYER_CHECK_INTERVAL_MS;
+    }
+    // layer_bps为各层码率，0表示该层还没有码率统计，estimated_bps为0表示没有带宽估计
+    void update_target(const std::vector<int64_t> & layer_bps, int64_t estimated_bps, int64_t now_ms);
+
+    // 该层是等待切换的目标层，需要确认是关键帧后调用switch_layer
+    bool is_switch_target(uint32_t layer) const {
+        return (int32_t)layer == target_layer_ && target_layer_ != cur_layer_;
+    }
+
+    bool is_sending(uint32_t layer) const {
+        return (int32_t)layer == cur_layer_;
+    }
+
+    void switch_layer(uint32_t layer) {
+        cur_layer_ = layer;
+    }
+
+    int32_t get_cur_layer() const {
+        return cur_layer_;
+    }
+
+    int32_t get_target_layer() const {
+        return target_layer_;
+    }
+private:
+    int32_t choose_layer(const std::vector<int64_t> & layer_bps, int64_t estimated_bps, int64_t now_ms);
+private:
+    int32_t fixed_layer_ = -1;
+    int32_t cur_layer_ = -1;
+    int32_t target_layer_ = -1;
+    int64_t layer_check_ms_ = 0;
+    int64_t layer_up_since_ms_ = 0;
+};
+
+// 切层后改写发给播放端的ssrc、序号和时间戳，播放端看到的是一路连续的流
+// 非线程安全，在发送协程中访问
+class SimulcastRtpRewriter {
+public:
+    void set_ssrc(uint32_t ssrc) {
+        ssrc_ = ssrc;
+    }
+
+    // data为pkt编码后的数据，原地改写，切层前排队的旧层包返回false，不应发送
+    bool rewrite(uint8_t *data, RtpPacket & pkt, int64_t now_ms);
+
+    bool is_started() const {
+        return started_;
+    }
+
+    // 当前层的原始ssrc
+    uint32_t get_src_ssrc() const {
+        return src_ssrc_;
+    }
+
+    // 播放端NACK中改写后的序号换算回当前层的原始序号，切层之前的包无法重传，返回false
+    bool to_src_seq(uint16_t out_seq, uint16_t & src_seq) const;
+private:
+    uint32_t ssrc_ = 0;
+    bool started_ = false;
+    uint32_t src_ssrc_ = 0;
+    uint32_t prev_src_ssrc_ = 0;
+    uint16_t seq_offset_ = 0;
+    uint32_t ts_offset_ = 0;
+    uint16_t base_seq_ = 0;                                   // 当前层第一个包改写后的序号，更早的包无法重传
+    uint16_t last_out_seq_ = 0;
+    uint32_t last_out_ts_ = 0;
+    int64_t last_out_ms_ = 0;
+};
+};
@@ -12,9 +12,19 @@ bool SRTPSession::init(SRTPProtectionProfile profile, const std::string &recv_ke
         srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&srtp_policy_.rtp);
         srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&srtp_policy_.rtcp);
         break;
-    default:
+    case SRTP_AEAD_AES_128_GCM:
+        srtp_crypto_policy_set_aes_gcm_128_16_auth(&srtp_policy_.rtp);
+        srtp_crypto_policy_set_aes_gcm_128_16_auth(&srtp_policy_.rtcp);
+        break;
+    case SRTP_AEAD_AES_256_GCM:
+        srtp_crypto_policy_set_aes_gcm_256_16_auth(&srtp_policy_.rtp);
+        srtp_crypto_policy_set_aes_gcm_256_16_auth(&srtp_policy_.rtcp);
         break;
+    default:
+        spdlog::error("unsupported srtp profile:{}", profile);
+        return false;
     }
+    profile_ = profile;
 
     if ((int)recv_key.size() != srtp_policy_.rtp.cipher_key_len) {
         spdlog::error("recv_key was not match, len:{}, expected:{}", recv_key.size(), srtp_policy_.rtp.cipher_key_len);
@@ -91,9 +101,22 @@ int32_t SRTPSession::protect_srtp(uint8_t *in, size_t in_len, uint8_t *out, size
         return -1;
     }
 
-    int inout_bytes = in_len;
     memcpy(out, in, in_len);
-    auto err = srtp_protect(send_ctx_, out, &inout_bytes);
+    return protect_srtp_inplace(out, in_len, out_len);
+}
+
+int32_t SRTPSession::protect_srtp_inplace(uint8_t *data, size_t len, size_t & out_len)
+{
+    if (!send_ctx_) {
+        return 0;
+    }
+
+    if (len + SRTP_MAX_TRAILER_LEN > SRTP_MAX_BUFFER_SIZE) {
+        return -1;
+    }
+
+    int inout_bytes = len;
+    auto err = srtp_protect(send_ctx_, data, &inout_bytes);
     if (err != srtp_err_status_ok) {
         spdlog::error("srtp_protect error, err:{}", (int)err);
         return -2;
@@ -102,6 +125,30 @@ int32_t SRTPSession::protect_srtp(uint8_t *in, size_t in_len, uint8_t *out, size
     return inout_bytes;
 }
 
+int32_t SRTPSession::protect_srtp_batch(std::vector<SRTPPacketBuf> & pkts)
+{
+    if (!send_ctx_) {
+        return 0;
+    }
+
+    int32_t count = 0;
+    for (auto & pkt : pkts) {
+        if (pkt.len + SRTP_MAX_TRAILER_LEN > SRTP_MAX_BUFFER_SIZE) {
+            return -1;
+        }
+
+        int inout_bytes = pkt.len;
+        auto err = srtp_protect(send_ctx_, pkt.data, &inout_bytes);
+        if (err != srtp_err_status_ok) {
+            spdlog::error("srtp_protect error, err:{}", (int)err);
+            return -2;
+        }
+        pkt.out_len = inout_bytes;
+        count++;
+    }
+    return count;
+}
+
 int32_t SRTPSession::protect_srtcp(uint8_t *in, size_t in_len, uint8_t *out, size_t & out_len)
 {
     if (!send_ctx_) {
@@ -121,3 +168,18 @@ int32_t SRTPSession::protect_srtcp(uint8_t *in, size_t in_len, uint8_t *out, siz
     out_len = inout_bytes;
     return inout_bytes;
 }
+
+const char *SRTPSession::get_profile_name(SRTPProtectionProfile profile)
+{
+    switch (profile)
+    {
+    case SRTP_AES128_CM_HMAC_SHA1_80:
+        return "SRTP_AES128_CM_SHA1_80";
+    case SRTP_AEAD_AES_128_GCM:
+        return "SRTP_AEAD_AES_128_GCM";
+    case SRTP_AEAD_AES_256_GCM:
+        return "SRTP_AEAD_AES_256_GCM";
+    default:
+        return "unknown";
+    }
+}
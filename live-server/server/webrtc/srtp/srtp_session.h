@@ -3,10 +3,19 @@
 #include "srtp2/srtp.h"
 #include "../dtls/define.h"
 #include <string>
+#include <vector>
 
 #define SRTP_MAX_BUFFER_SIZE 65535
 namespace mms
 {
+    // 批量加密时的单个包，data后面至少要留SRTP_MAX_TRAILER_LEN字节
+    struct SRTPPacketBuf
+    {
+        uint8_t *data = nullptr;
+        size_t len = 0;    // 明文长度
+        size_t out_len = 0;// 加密后长度
+    };
+
     class SRTPSession
     {
     public:
@@ -14,6 +23,10 @@ namespace mms
         int32_t unprotect_srtp(uint8_t *data, size_t len);
         int32_t unprotect_srtcp(uint8_t *data, size_t len);
         int32_t protect_srtp(uint8_t *in, size_t in_len, uint8_t *out, size_t & out_len);
+        // 原地加密，data后面至少要留SRTP_MAX_TRAILER_LEN字节给认证标签
+        int32_t protect_srtp_inplace(uint8_t *data, size_t len, size_t & out_len);
+        // 一次加密一批包（原地），返回成功加密的包数，出错返回负数
+        int32_t protect_srtp_batch(std::vector<SRTPPacketBuf> & pkts);
         int32_t protect_srtcp(uint8_t *in, size_t in_len, uint8_t *out, size_t & out_len);
         int32_t get_srtp_overhead() const 
         {
@@ -24,9 +37,17 @@ namespace mms
         {
             return srtp_policy_.rtcp.auth_tag_len;
         }
+
+        SRTPProtectionProfile get_profile() const
+        {
+            return profile_;
+        }
+
+        static const char *get_profile_name(SRTPProtectionProfile profile);
     private:
         srtp_t send_ctx_ = nullptr;
         srtp_t recv_ctx_ = nullptr;
         srtp_policy_t srtp_policy_;
+        SRTPProtectionProfile profile_ = SRTP_AES128_CM_HMAC_SHA1_80;
     };
 };
\ No newline at end of file
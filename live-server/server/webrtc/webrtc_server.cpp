@@ -4,6 +4,7 @@
 #include "config/config.h"
 
 #include "dtls/dtls_cert.h"
+#include "dtls/dtls_handshake_pool.hpp"
 #include "server/stun/protocol/stun_msg.h"
 #include "server/stun/protocol/stun_binding_response_msg.hpp"
 #include "server/stun/protocol/stun_mapped_address_attr.h"
@@ -46,6 +47,15 @@ bool WebRtcServer::start(const std::string & listen_ip, const std::string & exte
         return false;
     }
 
+    // DTLS握手放到专用线程上，并限制同时握手数，大量会话同时加入时不影响已有会话的转发
+    auto &webrtc_config = Config::get_instance()->get_webrtc_config();
+    if (webrtc_config.get_dtls_handshake_threads() > 0) {
+        DtlsHandshakePool::get_instance().start(webrtc_config.get_dtls_handshake_threads(),
+                                                webrtc_config.get_dtls_max_handshakes(),
+                                                webrtc_config.get_dtls_max_queued(),
+                                                webrtc_config.get_dtls_queue_timeout_ms());
+    }
+
     ret = UdpServer::start_listen(listen_ip, port);
     if (!ret) {
         return false;
@@ -74,8 +84,12 @@ bool WebRtcServer::init_srtp()
 bool WebRtcServer::init_certs()
 {
     std::string domain = "test.publish.com";
+    auto key_type = DtlsCert::KEY_TYPE_ECDSA;
+    if (Config::get_instance()->get_webrtc_config().get_dtls_cert_type() == "rsa") {
+        key_type = DtlsCert::KEY_TYPE_RSA;
+    }
     default_dtls_cert_ = std::make_shared<DtlsCert>();
-    if (!default_dtls_cert_->init(domain))
+    if (!default_dtls_cert_->init(domain, key_type))
     {
         CORE_ERROR("webrtc server init dtls cert failed");
         return false;
@@ -292,6 +306,23 @@ void WebRtcServer::on_webrtc_session_close(std::shared_ptr<WebRtcServerSession>
     
 }
 
+boost::asio::awaitable<Json::Value> WebRtcServer::get_sessions_json()
+{
+    std::vector<std::shared_ptr<WebRtcServerSession>> sessions;
+    {
+        std::lock_guard<std::mutex> lck(session_map_mtx_);
+        for (auto & p : ufrag_session_map_) {
+            sessions.push_back(p.second);
+        }
+    }
+
+    Json::Value v = Json::arrayValue;
+    for (auto & s : sessions) {
+        v.append(co_await s->sync_to_json());
+    }
+    co_return v;
+}
+
 void WebRtcServer::stop()
 {
 }
\ No newline at end of file
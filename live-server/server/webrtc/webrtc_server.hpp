@@ -8,6 +8,7 @@
 #include "srtp/srtp_session.h"
 #include "server/webrtc/webrtc_server.hpp"
 #include "server/webrtc/dtls/dtls_cert.h"
+#include "json/json.h"
 
 
 namespace mms {
@@ -51,6 +52,8 @@ public:
     boost::asio::awaitable<void> on_whep_patch(std::shared_ptr<HttpRequest> req,
                                                std::shared_ptr<HttpResponse> resp);
     static std::shared_ptr<DtlsCert> get_default_dtls_cert();
+    // 所有webrtc会话的统计，包括每个播放者的带宽估计
+    boost::asio::awaitable<Json::Value> get_sessions_json();
 
 private:
     boost::asio::awaitable<void> on_udp_socket_recv(UdpSocket *sock, std::unique_ptr<uint8_t[]> data,
@@ -1,8 +1,10 @@
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/experimental/awaitable_operators.hpp>
 #include <boost/asio/ip/udp.hpp>
 #include <iostream>
+#include <set>
 #include <variant>
 
 using namespace boost::asio::experimental::awaitable_operators;
@@ -26,10 +28,17 @@ using namespace boost::asio::experimental::awaitable_operators;
 #include "protocol/http/http_request.hpp"
 #include "protocol/http/http_response.hpp"
 #include "protocol/http/websocket/websocket_packet.hpp"
+#include "protocol/rtp/rtcp/rtcp_fb_nack.h"
 #include "protocol/rtp/rtcp/rtcp_fb_pli.h"
+#include "protocol/rtp/rtcp/rtcp_fb_twcc.h"
 #include "protocol/rtp/rtcp/rtcp_rr.hpp"
 #include "protocol/rtp/rtcp/rtcp_sr.h"
+#include "protocol/rtp/rtp_flexfec_encoder.h"
 #include "protocol/rtp/rtp_h264_packet.h"
+#include "protocol/rtp/rtp_history.h"
+#include "protocol/rtp/rtp_jitter_buffer.h"
+#include "protocol/rtp/twcc_bandwidth_estimator.h"
+#include "protocol/rtp/h264_rtp_pkt_info.h"
 #include "protocol/rtp/rtp_packet.h"
 #include "protocol/sdp/attribute/common/dir.hpp"
 #include "server/session.hpp"
@@ -48,14 +57,14 @@ WebRtcServerSession::WebRtcServerSession(ThreadWorker *worker)
       udp_msgs_channel_(worker->get_io_context()),
       alive_timeout_timer_(worker->get_io_context()),
       play_sdp_timeout_timer_(worker->get_io_context()),
-      send_rtp_pkts_channel_(worker->get_io_context()),
+      send_rtp_queue_(worker->get_io_context(), MAX_PENDING_RTP_BATCHES * 2),
       send_rtcp_fb_pkts_channel_(worker->get_io_context()),
       send_rtcp_pkts_channel_(worker->get_io_context()),
       send_funcs_channel_(worker->get_io_context()),
       send_pli_timer_(worker->get_io_context()),
+      pacing_timer_(worker->get_io_context()),
       wg_(worker) {
-    send_buf_ = std::make_unique<uint8_t[]>(1024 * 1024);
-    enc_buf_ = std::make_unique<uint8_t[]>(1024 * 1024);
+    rtp_out_buf_ = BlockPool::get_instance().alloc();
 
     local_ice_ufrag_ = Utils::get_rand_str(4);
     local_ice_pwd_ = Utils::get_rand_str(24);
@@ -181,23 +190,50 @@ boost::asio::awaitable<void> WebRtcServerSession::stop_process_recv_udp_msg() {
 }
 
 void WebRtcServerSession::start_pli_sender() {
+    // 关键帧请求由源按需合并、限速后回调过来，这里只负责发pli
+    std::weak_ptr<Session> weak_self = shared_from_this();
+    webrtc_media_source_->set_key_frame_requester([this, weak_self](uint32_t layers) {
+        auto self = weak_self.lock();
+        if (!self) {
+            return;
+        }
+
+        boost::asio::co_spawn(worker_->get_io_context(), [this, self, layers]() -> boost::asio::awaitable<void> {
+            co_await send_pli(layers);
+        }, boost::asio::detached);
+    });
+
+    if (!video_jitter_buffer_) {// 没有重排缓冲，无需tick
+        return;
+    }
+
     auto self(this->shared_from_this());
     wg_.add(1);
     boost::asio::co_spawn(
         worker_->get_io_context(),
         [this, self]() -> boost::asio::awaitable<void> {
             boost::system::error_code ec;
+            bool simulcast = webrtc_media_source_->is_simulcast();
+            uint32_t layer_count = simulcast ? webrtc_media_source_->get_simulcast_layer_count() : 1;
             while (1) {
-                send_pli_timer_.expires_after(std::chrono::milliseconds(2000)); // 2s发一次
+                // 按tick驱动重排缓冲超时输出和NACK，NACK恢复不了的丢包再请求关键帧
+                send_pli_timer_.expires_after(std::chrono::milliseconds(JITTER_BUFFER_TICK_MS));
                 co_await send_pli_timer_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
                 if (boost::asio::error::operation_aborted == ec) {
                     break;
                 }
 
-                std::shared_ptr<RtcpFbPli> pli_pkt = std::make_shared<RtcpFbPli>();
-                pli_pkt->set_ssrc(video_ssrc_);
-                pli_pkt->set_media_source_ssrc(video_ssrc_);
-                co_await send_rtcp_fb_pkts_channel_.async_send(boost::system::error_code{}, pli_pkt, boost::asio::use_awaitable);
+                int64_t now_ms = Utils::get_current_ms();
+                for (uint32_t layer = 0; layer < layer_count; layer++) {
+                    auto jitter_buffer = get_video_jitter_buffer(layer);
+                    if (jitter_buffer && co_await flush_jitter_buffer(jitter_buffer, get_video_layer_ssrc(layer), true, layer, now_ms)) {
+                        webrtc_media_source_->request_key_frame(MediaSource::KEY_FRAME_REASON_PACKET_LOST, layer);
+                    }
+                }
+
+                if (audio_jitter_buffer_) {
+                    co_await flush_jitter_buffer(audio_jitter_buffer_.get(), audio_ssrc_, false, 0, now_ms);
+                }
             }
             co_return;
         },
@@ -208,6 +244,110 @@ void WebRtcServerSession::start_pli_sender() {
         });
 }
 
+boost::asio::awaitable<void> WebRtcServerSession::send_pli(uint32_t layers) {
+    boost::system::error_code ec;
+    uint32_t layer_count = webrtc_media_source_->is_simulcast() ? webrtc_media_source_->get_simulcast_layer_count() : 1;
+    for (uint32_t layer = 0; layer < layer_count; layer++) {
+        uint32_t ssrc = get_video_layer_ssrc(layer);
+        if (!(layers & (1u << layer)) || ssrc == 0) {
+            continue;
+        }
+        std::shared_ptr<RtcpFbPli> pli_pkt = std::make_shared<RtcpFbPli>();
+        pli_pkt->set_ssrc(ssrc);
+        pli_pkt->set_media_source_ssrc(ssrc);
+        co_await send_rtcp_fb_pkts_channel_.async_send(boost::system::error_code{}, pli_pkt, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (ec) {
+            break;
+        }
+    }
+    co_return;
+}
+
+boost::asio::awaitable<bool> WebRtcServerSession::flush_jitter_buffer(RtpJitterBuffer *jitter_buffer, uint32_t ssrc, bool is_video, uint32_t layer, int64_t now_ms) {
+    std::vector<std::shared_ptr<RtpPacket>> pkts;
+    jitter_buffer->pop(now_ms, pkts);
+    if (!pkts.empty() && webrtc_media_source_) {
+        if (is_video) {
+            co_await forward_video_packets(layer, pkts);
+        } else {
+            co_await webrtc_media_source_->on_audio_packets(pkts);
+        }
+    }
+
+    std::vector<uint16_t> lost_seqs;
+    jitter_buffer->get_nack_seqs(now_ms, lost_seqs);
+    if (!lost_seqs.empty()) {
+        std::shared_ptr<RtcpFbNack> nack_pkt = std::make_shared<RtcpFbNack>();
+        nack_pkt->set_ssrc(ssrc);
+        nack_pkt->set_media_source_ssrc(ssrc);
+        for (auto seq : lost_seqs) {
+            nack_pkt->add_lost_seq(seq);
+        }
+        co_await send_rtcp_fb_pkts_channel_.async_send(boost::system::error_code{}, nack_pkt, boost::asio::use_awaitable);
+    }
+    co_return jitter_buffer->need_key_frame();
+}
+
+RtpJitterBuffer *WebRtcServerSession::get_video_jitter_buffer(uint32_t layer) {
+    if (layer == 0) {
+        return video_jitter_buffer_.get();
+    }
+
+    if (layer - 1 < simulcast_jitter_buffers_.size()) {
+        return simulcast_jitter_buffers_[layer - 1].get();
+    }
+    return nullptr;
+}
+
+uint32_t WebRtcServerSession::get_video_layer_ssrc(uint32_t layer) {
+    if (webrtc_media_source_ && webrtc_media_source_->is_simulcast()) {
+        return webrtc_media_source_->get_simulcast_layer_ssrc(layer);
+    }
+    return layer == 0 ? video_ssrc_ : 0;
+}
+
+int32_t WebRtcServerSession::find_video_layer(uint32_t ssrc, uint8_t *data, size_t len) {
+    if (!webrtc_media_source_->is_simulcast()) {
+        return ssrc == webrtc_media_source_->get_video_ssrc() ? 0 : -1;
+    }
+
+    auto it = simulcast_ssrc_layers_.find(ssrc);
+    if (it != simulcast_ssrc_layers_.end()) {
+        return it->second;
+    }
+
+    // 新出现的ssrc，通过rid扩展头确定是哪一层
+    RtpHeader header;
+    if (header.decode(data, len) < 0 || !header.rtp_header_extention) {
+        return -1;
+    }
+
+    auto rid = header.rtp_header_extention->get_element(webrtc_media_source_->get_rid_ext_id());
+    if (rid.empty()) {
+        return -1;
+    }
+
+    int32_t layer = webrtc_media_source_->find_simulcast_layer(std::string(rid));
+    if (layer < 0) {
+        return -1;
+    }
+
+    CORE_DEBUG("simulcast layer:{} rid:{} ssrc:{}", layer, rid, ssrc);
+    simulcast_ssrc_layers_[ssrc] = layer;
+    webrtc_media_source_->set_simulcast_layer_ssrc(layer, ssrc);
+    if (layer == 0) {
+        video_ssrc_ = ssrc;
+    }
+    return layer;
+}
+
+boost::asio::awaitable<bool> WebRtcServerSession::forward_video_packets(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> pkts) {
+    if (webrtc_media_source_->is_simulcast()) {
+        co_return co_await webrtc_media_source_->on_video_layer_packets(layer, pkts);
+    }
+    co_return co_await webrtc_media_source_->on_video_packets(pkts);
+}
+
 boost::asio::awaitable<void> WebRtcServerSession::stop_pli_sender() {
     send_pli_timer_.cancel();
     co_return;
@@ -220,29 +360,100 @@ void WebRtcServerSession::start_rtp_sender() {
         worker_->get_io_context(),
         [this, self]() -> boost::asio::awaitable<void> {
             boost::system::error_code ec;
+            std::vector<SRTPPacketBuf> srtp_bufs;
+            std::vector<uint16_t> twcc_seqs;
             while (1) {
-                auto rtp_pkts = co_await send_rtp_pkts_channel_.async_receive(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+                auto rtp_pkts = co_await send_rtp_queue_.pop(ec);
                 if (ec) {
                     break;
                 }
 
-                for (auto rtp_pkt : rtp_pkts) {
-                    // if (rtp_pkt->get_pt() == video_pt_) {
-                    //     spdlog::info("recv pt:{:x}, num:{}", rtp_pkt->get_pt(), rtp_pkt->get_seq_num());
-                    // }
+                uint8_t twcc_ext_id = twcc_ext_id_.load();
+                size_t i = 0;
+                while (i < rtp_pkts.size()) {
+                    // 共享的包只读，每个订阅者只在输出缓冲中写头部并拷贝一次负载，
+                    // 尽量多的包依次排进输出缓冲后一次批量原地加密，再逐个发送
+                    srtp_bufs.clear();
+                    twcc_seqs.clear();
+                    size_t offset = 0;
+                    for (; i < rtp_pkts.size(); i++) {
+                        auto &rtp_pkt = rtp_pkts[i];
+                        if (offset + SRTP_MAX_TRAILER_LEN >= RTP_OUT_BUF_SIZE) {
+                            break;
+                        }
+
+                        uint8_t *out = rtp_out_buf_.get() + offset;
+                        size_t out_limit = RTP_OUT_BUF_SIZE - offset - SRTP_MAX_TRAILER_LEN;
+                        int32_t rtp_size;
+                        if (twcc_ext_id != 0) {
+                            rtp_size = rtp_pkt->encode_with_twcc(out, out_limit, twcc_ext_id, twcc_seq_);
+                        } else {
+                            rtp_size = rtp_pkt->encode(out, out_limit);
+                        }
+
+                        if (rtp_size <= 0) {
+                            if (offset > 0) {// 剩余空间放不下，留到下一批
+                                break;
+                            }
+                            continue;
+                        }
 
-                    auto rtp_size = rtp_pkt->encode((uint8_t *)send_buf_.get(), 1024 * 1024);
-                    size_t enc_buf_size = 1024 * 1024;
-                    auto r = srtp_session_.protect_srtp((uint8_t *)send_buf_.get(), rtp_size, (uint8_t *)enc_buf_.get(), enc_buf_size);
+                        if (simulcast_play_ssrc_ != 0 && rtp_pkt->get_pt() == video_pt_ && !rtp_rewriter_.rewrite(out, *rtp_pkt, Utils::get_current_ms())) {
+                            continue;
+                        }
+
+                        if (video_fec_pt_ != 0 && rtp_pkt->get_header().ssrc == video_fec_ssrc_) {// 共享的FEC包改写为本会话的pt和序号
+                            out[1] = (out[1] & 0x80) | video_fec_pt_;
+                            *(uint16_t *)(out + 2) = htons(video_fec_seq_++);
+                            if (twcc_ext_id != 0) {
+                                xor_video_fec_twcc_seqs(out + rtp_size - rtp_pkt->payload_len_, rtp_pkt->payload_len_);
+                            }
+                            sent_fec_pkts_++;
+                        } else if (video_fec_pt_ != 0 && twcc_ext_id != 0 && rtp_pkt->get_header().ssrc == video_media_ssrc_) {
+                            auto &sent = fec_twcc_seqs_[rtp_pkt->get_seq_num() % FEC_TWCC_SEQS];
+                            sent.valid = true;
+                            sent.seq = rtp_pkt->get_seq_num();
+                            sent.twcc_seq = twcc_seq_;
+                            sent.csrc = rtp_pkt->get_header().csrc;
+                        }
+
+                        SRTPPacketBuf buf;
+                        buf.data = out;
+                        buf.len = rtp_size;
+                        srtp_bufs.push_back(buf);
+                        if (twcc_ext_id != 0) {
+                            twcc_seqs.push_back(twcc_seq_);
+                            twcc_seq_++;
+                        }
+                        offset += rtp_size + SRTP_MAX_TRAILER_LEN;
+                    }
+
+                    if (srtp_bufs.empty()) {
+                        continue;
+                    }
+
+                    auto r = srtp_session_.protect_srtp_batch(srtp_bufs);
                     if (r < 0) {
-                        spdlog::error("protect srtp failed, rtp_size:{}, ret:{}, seq:{}, pt:{:x}", rtp_size, r, rtp_pkt->get_seq_num(), rtp_pkt->get_pt());
+                        spdlog::error("protect srtp failed, batch size:{}, ret:{}", srtp_bufs.size(), r);
                         co_return;
                     } else if (r == 0) {
                         continue;
                     }
 
-                    if (!co_await send_rtp_socket_->send_to(enc_buf_.get(), enc_buf_size, peer_ep)) {
-                        co_return;
+                    for (size_t j = 0; j < srtp_bufs.size(); j++) {
+                        auto &buf = srtp_bufs[j];
+                        if (twcc_ext_id != 0) {
+                            if (!co_await wait_pacing(buf.out_len)) {
+                                co_return;
+                            }
+                            bwe_->on_packet_sent(twcc_seqs[j], buf.out_len, Utils::get_current_us());
+                        }
+
+                        if (!co_await send_rtp_socket_->send_to(buf.data, buf.out_len, peer_ep)) {
+                            co_return;
+                        }
+                        sent_rtp_pkts_++;
+                        sent_rtp_bytes_ += buf.out_len;
                     }
                     update_active_timestamp();
                 }
@@ -256,10 +467,252 @@ void WebRtcServerSession::start_rtp_sender() {
         });
 }
 
-boost::asio::awaitable<void> WebRtcServerSession::stop_rtp_sender() {
-    if (send_rtp_pkts_channel_.is_open()) {
-        send_rtp_pkts_channel_.close();
+boost::asio::awaitable<void> WebRtcServerSession::process_rtcp_nack(uint8_t *data, size_t len) {
+    RtcpFbNack nack;
+    if (nack.decode(data, len) <= 0) {
+        co_return;
+    }
+
+    std::shared_ptr<RtpHistory> history;
+    auto media_ssrc = nack.get_header().get_media_source_ssrc();
+    bool simulcast_nack = simulcast_play_ssrc_ != 0 && media_ssrc == simulcast_play_ssrc_;
+    if (simulcast_nack) {// 播放端看到的是改写后的序号，只能重传当前层的包
+        auto source = play_source_.lock();
+        if (source && rtp_rewriter_.is_started()) {
+            history = source->get_simulcast_rtp_history_by_ssrc(rtp_rewriter_.get_src_ssrc());
+        }
+    } else if (video_rtp_history_ && video_rtp_history_->get_ssrc() == media_ssrc) {
+        history = video_rtp_history_;
+    } else if (audio_rtp_history_ && audio_rtp_history_->get_ssrc() == media_ssrc) {
+        history = audio_rtp_history_;
     }
+
+    if (!history) {
+        co_return;
+    }
+
+    auto & lost_seqs = nack.get_lost_seqs();
+    history->nack_recv_count_++;
+    history->nack_seq_count_ += lost_seqs.size();
+
+    int64_t now_ms = Utils::get_current_ms();
+    if (nack_tokens_update_ms_ != 0) {
+        nack_tokens_ += (now_ms - nack_tokens_update_ms_) * NACK_RETRANS_PKTS_PER_SEC / 1000.0;
+        nack_tokens_ = std::min<double>(nack_tokens_, NACK_RETRANS_PKTS_PER_SEC);
+    }
+    nack_tokens_update_ms_ = now_ms;
+
+    std::vector<std::shared_ptr<RtpPacket>> retrans_pkts;
+    uint32_t miss_count = 0;
+    for (auto seq : lost_seqs) {
+        if (simulcast_nack && !rtp_rewriter_.to_src_seq(seq, seq)) {
+            history->miss_count_++;
+            miss_count++;
+            continue;
+        }
+
+        auto pkt = history->get(seq);
+        if (!pkt) {
+            history->miss_count_++;
+            miss_count++;
+            continue;
+        }
+
+        if (nack_tokens_ < 1) {
+            history->rate_limited_count_++;
+            continue;
+        }
+        nack_tokens_ -= 1;
+        retrans_pkts.push_back(pkt);
+    }
+
+    if (miss_count > 0 && history != audio_rtp_history_) {// 历史里已经没有了，重传救不回来，只能等关键帧
+        request_play_key_frame(MediaSource::KEY_FRAME_REASON_PACKET_LOST);
+    }
+
+    if (retrans_pkts.empty()) {
+        co_return;
+    }
+
+    history->retrans_count_ += retrans_pkts.size();
+    // 没有协商rtx，原样重发，srtp已开启allow_repeat_tx，发送队列满时不重传
+    send_rtp_queue_.try_push(std::move(retrans_pkts), history != audio_rtp_history_);
+    co_return;
+}
+
+boost::asio::awaitable<bool> WebRtcServerSession::wait_pacing(size_t bytes) {
+    int64_t bps = estimated_bps_.load();
+    if (bps <= 0) {
+        co_return true;
+    }
+
+    // 令牌桶，最多积累40ms的发送量
+    double bytes_per_us = bps * PACING_FACTOR / 8 / 1000000;
+    double max_budget = std::max<double>(bytes_per_us * 40000, 16 * 1024);
+    int64_t now_us = Utils::get_current_us();
+    if (pacing_update_us_ != 0) {
+        pacing_budget_bytes_ = std::min(max_budget, pacing_budget_bytes_ + (now_us - pacing_update_us_) * bytes_per_us);
+    }
+    pacing_update_us_ = now_us;
+    pacing_budget_bytes_ -= bytes;
+    if (pacing_budget_bytes_ >= 0) {
+        co_return true;
+    }
+
+    int64_t wait_us = std::min<int64_t>(-pacing_budget_bytes_ / bytes_per_us, 100000);
+    if (wait_us < 1000) {
+        co_return true;
+    }
+
+    boost::system::error_code ec;
+    pacing_timer_.expires_after(std::chrono::microseconds(wait_us));
+    co_await pacing_timer_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+    if (ec) {
+        co_return false;
+    }
+    co_return true;
+}
+
+bool WebRtcServerSession::contains_key_frame(const std::vector<std::shared_ptr<RtpPacket>> & pkts) {
+    for (auto & pkt : pkts) {
+        auto payload = pkt->get_payload();
+        H264RtpPktInfo pkt_info;
+        if (pkt_info.parse(payload.data(), payload.size()) < 0) {
+            continue;
+        }
+
+        if (pkt_info.is_single_nalu() || (pkt_info.get_type() == H264_RTP_PAYLOAD_FU_A && pkt_info.is_start_fu())) {
+            if (pkt_info.get_nalu_type() == H264NaluTypeIDR || pkt_info.get_nalu_type() == H264NaluTypeSPS) {
+                return true;
+            }
+        } else if (pkt_info.is_stap_a()) {
+            size_t pos = 1;
+            while (pos + 2 < payload.size()) {
+                uint16_t nalu_size = ntohs(*(uint16_t *)(payload.data() + pos));
+                uint8_t nalu_type = payload[pos + 2] & 0x1F;
+                if (nalu_type == H264NaluTypeIDR || nalu_type == H264NaluTypeSPS) {
+                    return true;
+                }
+                pos += 2 + nalu_size;
+            }
+        }
+    }
+    return false;
+}
+
+bool WebRtcServerSession::should_send_video(const std::vector<std::shared_ptr<RtpPacket>> & pkts) {
+    // 统计源码率
+    int64_t now_ms = Utils::get_current_ms();
+    for (auto & pkt : pkts) {
+        video_in_bytes_ += pkt->payload_len_ + 12;
+    }
+
+    if (video_in_begin_ms_ == 0) {
+        video_in_begin_ms_ = now_ms;
+    } else if (now_ms - video_in_begin_ms_ >= 1000) {
+        video_source_bps_ = video_in_bytes_ * 8 * 1000 / (now_ms - video_in_begin_ms_);
+        video_in_bytes_ = 0;
+        video_in_begin_ms_ = now_ms;
+    }
+
+    // 丢帧后必须等到关键帧才能恢复，否则后续帧无法解码
+    bool is_key = contains_key_frame(pkts);
+    if (drop_until_key_frame_) {
+        if (!is_key) {
+            dropped_video_pkts_ += pkts.size();
+            return false;
+        }
+        drop_until_key_frame_ = false;
+    }
+
+    if (is_key) {
+        return true;
+    }
+
+    int64_t estimated_bps = estimated_bps_.load();
+    bool congested = send_rtp_queue_.get_pending_batches() >= MAX_PENDING_RTP_BATCHES ||
+                     (estimated_bps > 0 && estimated_bps < video_source_bps_.load() * CONGESTED_RATIO);
+    if (congested) {
+        drop_until_key_frame_ = true;
+        dropped_video_pkts_ += pkts.size();
+        return false;
+    }
+    return true;
+}
+
+void WebRtcServerSession::send_video_pkts(std::vector<std::shared_ptr<RtpPacket>> pkts) {
+    if (send_rtp_queue_.try_push(std::move(pkts), true)) {
+        return;
+    }
+
+    // 队列满说明发送跟不上，丢了帧之后要等关键帧才能恢复
+    if (!drop_until_key_frame_) {
+        drop_until_key_frame_ = true;
+        request_play_key_frame(MediaSource::KEY_FRAME_REASON_PACKET_LOST);
+    }
+}
+
+void WebRtcServerSession::request_play_key_frame(MediaSource::KeyFrameReason reason) {
+    auto source = play_source_.lock();
+    if (!source) {
+        return;
+    }
+    int32_t layer = sending_layer_.load();
+    source->request_key_frame(reason, layer >= 0 ? layer : 0);
+}
+
+bool WebRtcServerSession::select_video_layer(uint32_t layer, const std::vector<std::shared_ptr<RtpPacket>> & pkts) {
+    auto source = play_source_.lock();
+    if (!source) {
+        return false;
+    }
+
+    int64_t now_ms = Utils::get_current_ms();
+    if (layer_selector_.need_check(now_ms)) {
+        std::vector<int64_t> layer_bps(source->get_simulcast_layer_count());
+        for (size_t i = 0; i < layer_bps.size(); i++) {
+            layer_bps[i] = source->get_simulcast_layer_bps(i);
+        }
+        layer_selector_.update_target(layer_bps, estimated_bps_.load(), now_ms);
+    }
+
+    if (!layer_selector_.is_switch_target(layer)) {
+        // 目标层的关键帧到来之前继续发送当前层
+        return layer_selector_.is_sending(layer);
+    }
+
+    // 只能从关键帧开始切到目标层
+    if (!contains_key_frame(pkts)) {
+        source->request_key_frame(MediaSource::KEY_FRAME_REASON_LAYER_SWITCH, layer);
+        return false;
+    }
+
+    CORE_DEBUG("session:{} switch simulcast layer {} -> {}", get_session_name(), layer_selector_.get_cur_layer(), layer);
+    layer_selector_.switch_layer(layer);
+    sending_layer_ = layer;
+    layer_switch_count_++;
+    drop_until_key_frame_ = false;
+    return true;
+}
+
+boost::asio::awaitable<void> WebRtcServerSession::process_rtcp_twcc(uint8_t *data, size_t len) {
+    if (!bwe_ || twcc_ext_id_.load() == 0) {
+        co_return;
+    }
+
+    RtcpFbTwcc twcc;
+    if (twcc.decode(data, len) <= 0) {
+        co_return;
+    }
+
+    bwe_->on_feedback(twcc.get_packet_status(), Utils::get_current_ms());
+    estimated_bps_ = bwe_->get_estimated_bps();
+    co_return;
+}
+
+boost::asio::awaitable<void> WebRtcServerSession::stop_rtp_sender() {
+    pacing_timer_.cancel();
+    send_rtp_queue_.close();
     co_return;
 }
 
@@ -401,10 +854,16 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_whip_req(std::shared_p
 
     auto self(std::static_pointer_cast<StreamSession>(shared_from_this()));
     is_publisher_ = true;
+    auto jitter_buffer_ms = Config::get_instance()->get_webrtc_config().get_jitter_buffer_ms();
+    if (jitter_buffer_ms > 0) {
+        video_jitter_buffer_ = std::make_unique<RtpJitterBuffer>(jitter_buffer_ms);
+        audio_jitter_buffer_ = std::make_unique<RtpJitterBuffer>(jitter_buffer_ms);
+    }
     webrtc_media_source_ = std::make_shared<WebRtcMediaSource>(get_worker(), std::weak_ptr<StreamSession>(self), publish_app);
     webrtc_media_source_->set_source_info(get_domain_name(), get_app_name(), get_stream_name());
     webrtc_media_source_->set_status(E_SOURCE_STATUS_OK);
     webrtc_media_source_->set_session(self);
+    webrtc_media_source_->set_origin(true);
     std::string answer_sdp = webrtc_media_source_->process_publish_sdp(sdp);
     if (answer_sdp.empty()) {
         CORE_ERROR("process publish sdp failed");
@@ -418,6 +877,11 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_whip_req(std::shared_p
 
     video_ssrc_ = webrtc_media_source_->get_video_ssrc();
     audio_ssrc_ = webrtc_media_source_->get_audio_ssrc();
+    for (size_t layer = 1; layer < webrtc_media_source_->get_simulcast_layer_count(); layer++) {
+        simulcast_jitter_buffers_.emplace_back(jitter_buffer_ms > 0 ? std::make_unique<RtpJitterBuffer>(jitter_buffer_ms) : nullptr);
+    }
+    // 编码信息在sdp中已确定，直接预热桥，第一个播放者到来时切片已经生成
+    publish_app->prewarm_bridges(webrtc_media_source_);
     start_process_recv_udp_msg();
 
     resp->add_header("Content-Type", "application/sdp");
@@ -521,16 +985,51 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_whep_req(std::shared_p
 
     auto webrtc_media_source = std::static_pointer_cast<WebRtcMediaSource>(source);
     is_player_ = true;
+    video_rtp_history_ = webrtc_media_source->get_video_rtp_history();
+    audio_rtp_history_ = webrtc_media_source->get_audio_rtp_history();
     rtp_media_sink_ = std::make_shared<RtpMediaSink>(get_worker());
     rtp_media_sink_->on_close([this, self]() { stop(); });
 
+    bwe_ = std::make_unique<TwccBandwidthEstimator>(TWCC_START_BPS);
+    play_source_ = webrtc_media_source;
+    if (webrtc_media_source->is_simulcast()) {
+        simulcast_play_ssrc_ = webrtc_media_source->get_simulcast_play_ssrc();
+        rtp_rewriter_.set_ssrc(simulcast_play_ssrc_);
+        video_pt_ = webrtc_media_source->get_video_pt();
+        auto rid = get_param("rid");
+        if (rid) {// 指定了层则固定播放该层
+            layer_selector_.set_fixed_layer(webrtc_media_source->find_simulcast_layer(rid.value().get()));
+        }
+
+        rtp_media_sink_->set_video_layer_pkts_cb([this](uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> rtp_pkts) -> boost::asio::awaitable<bool> {
+            if (!select_video_layer(layer, rtp_pkts) || !should_send_video(rtp_pkts)) {
+                co_return true;
+            }
+            send_video_pkts(std::move(rtp_pkts));
+            co_return true;
+        });
+    }
     rtp_media_sink_->set_video_pkts_cb([this](std::vector<std::shared_ptr<RtpPacket>> rtp_pkts) -> boost::asio::awaitable<bool> {
-        co_await send_rtp_pkts_channel_.async_send(boost::system::error_code{}, rtp_pkts, boost::asio::use_awaitable);
+        if (!should_send_video(rtp_pkts)) {
+            co_return true;
+        }
+
+        int32_t fec_level = video_fec_level_.load();
+        if (fec_level > 0) {// 冗余包由源按等级生成，跟在所保护的媒体包后面发送
+            auto source = play_source_.lock();
+            if (source) {
+                std::vector<std::shared_ptr<RtpPacket>> fec_pkts;
+                source->get_video_fec_packets(fec_level, rtp_pkts, fec_pkts);
+                rtp_pkts.insert(rtp_pkts.end(), fec_pkts.begin(), fec_pkts.end());
+            }
+        }
+        send_video_pkts(std::move(rtp_pkts));
         co_return true;
     });
 
+    // 回调在源的分发协程中执行，只能放入发送队列，不能等待本会话发送
     rtp_media_sink_->set_audio_pkts_cb([this](std::vector<std::shared_ptr<RtpPacket>> rtp_pkts) -> boost::asio::awaitable<bool> {
-        co_await send_rtp_pkts_channel_.async_send(boost::system::error_code{}, rtp_pkts, boost::asio::use_awaitable);
+        send_rtp_queue_.try_push(std::move(rtp_pkts), false);
         co_return true;
     });
 
@@ -566,13 +1065,20 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_whep_req(std::shared_p
         co_return false;
     }
 
-    auto &medias = play_sdp->get_media_sdps();
+    // 每个播放者一份，ice信息和扩展头各不相同
+    Sdp offer_sdp = *play_sdp;
+    auto &medias = offer_sdp.get_media_sdps();
     for (auto &media : medias) {
         media.set_ice_ufrag(IceUfrag(local_ice_ufrag_));
         media.set_ice_pwd(IcePwd(local_ice_pwd_));
+        media.add_extmap(Extmap(TWCC_EXT_ID, EXTMAP_URI_TWCC));
     }
 
-    auto body = play_sdp->to_string();
+    if (Config::get_instance()->get_webrtc_config().is_fec_enabled() && simulcast_play_ssrc_ == 0) {
+        add_video_fec_offer(offer_sdp, webrtc_media_source->get_video_fec_ssrc());
+    }
+
+    auto body = offer_sdp.to_string();
     resp->add_header("Access-Control-Allow-Origin", "*");
     resp->add_header("Content-Type", "application/sdp");
     resp->add_header("Access-Control-Expose-Headers", "ETag");
@@ -619,6 +1125,35 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_whep_patch_req(std::sh
     }
 
     remote_ice_pwd_ = remote_ice_pwd.value().getPwd();
+    // 对端接受了transport-cc扩展才开启带宽估计
+    for (auto &media : remote_sdp_.get_media_sdps()) {
+        for (auto &ext : media.get_extmap()) {
+            if (ext.uri == EXTMAP_URI_TWCC) {
+                twcc_ext_id_ = (uint8_t)std::atoi(ext.value.c_str());
+            }
+        }
+    }
+
+    // FEC按源统一的transport-cc扩展头格式计算，对端改了扩展头id则不开启
+    bool fec_accepted = false;
+    if (video_fec_pt_ != 0 && twcc_ext_id_.load() == TWCC_EXT_ID) {
+        for (auto &media : remote_sdp_.get_media_sdps()) {
+            if (media.get_media() != "video") {
+                continue;
+            }
+
+            for (auto &p : media.get_payloads()) {
+                if (p.second.get_pt() == video_fec_pt_ && boost::iequals(p.second.get_encoding_name(), "flexfec-03")) {
+                    fec_accepted = true;
+                }
+            }
+        }
+    }
+
+    if (!fec_accepted) {
+        video_fec_pt_ = 0;
+    }
+
     resp->add_header("Access-Control-Allow-Origin", "*");
     if (!co_await resp->write_header(204, "No Content")) {
         resp->close();
@@ -709,7 +1244,7 @@ void WebRtcServerSession::on_dtls_handshake_done(SRTPProtectionProfile profile,
     if (!srtp_session_.init(profile, srtp_recv_key, srtp_send_key)) {
         spdlog::error("srtp session init failed");
     } else {
-        spdlog::info("srtp session init succeed!!!");
+        spdlog::info("srtp session init succeed, profile:{}", SRTPSession::get_profile_name(profile));
     }
 }
 
@@ -727,55 +1262,102 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_srtp_packet(std::uniqu
             co_return false;
         }
 
-        auto pt = RtcpHeader::parse_pt(data, len);
-        switch (pt) {
-            case PT_RTCP_SR: {
-                RtcpSr rtcp_sr;
-                int32_t consumed = rtcp_sr.decode(data, len);
-                if (consumed <= 0) {
-                    co_return false;
-                }
+        // 复合包，逐个处理
+        uint8_t *rtcp_data = data;
+        size_t left = out_len;
+        while (left >= 4) {
+            size_t rtcp_len = ((size_t)ntohs(*(uint16_t*)(rtcp_data + 2)) + 1) * 4;
+            if (rtcp_len > left) {
+                break;
+            }
+            uint8_t *pkt = rtcp_data;
+            rtcp_data += rtcp_len;
+            left -= rtcp_len;
+
+            auto pt = RtcpHeader::parse_pt(pkt, rtcp_len);
+            switch (pt) {
+                case PT_RTCP_SR: {
+                    RtcpSr rtcp_sr;
+                    int32_t consumed = rtcp_sr.decode(pkt, rtcp_len);
+                    if (consumed <= 0) {
+                        co_return false;
+                    }
 
-                auto ntp = Utils::get_ntp_time();
-                if (rtcp_sr.header_.sender_ssrc == video_ssrc_) {
-                    recv_sr_packets_[video_ssrc_] = rtcp_sr;
-                    std::shared_ptr<RtcpRR> rtcp_rr = std::make_shared<RtcpRR>();
-                    rtcp_rr->set_ssrc(video_ssrc_);
-                    ReceptionReportBlock report;
-                    report.ssrc = video_ssrc_;
-                    report.fraction_lost = 0;
-                    report.cumulative_number_of_packets_lost = 0;
-                    report.extended_highest_sequence_number_received = video_extended_highest_sequence_number_received_;
-                    report.interarrival_jitter = video_interarrival_jitter_;
-                    report.last_SR = video_last_sr_ntp_ >> 16;
-                    report.delay_since_last_SR = (ntp >> 16) - (video_last_sr_sys_ntp_ >> 16);
-                    rtcp_rr->add_reception_report_block(report);
-                    video_last_sr_ntp_ = ((uint64_t)rtcp_sr.ntp_timestamp_sec_ << 32) | (rtcp_sr.ntp_timestamp_psec_);
-                    video_last_sr_sys_ntp_ = ntp;
-                    co_await send_rtcp_pkts_channel_.async_send(boost::system::error_code{}, rtcp_rr, boost::asio::use_awaitable);
-                } else if (rtcp_sr.header_.sender_ssrc == audio_ssrc_) {
-                    recv_sr_packets_[audio_ssrc_] = rtcp_sr;
-                    std::shared_ptr<RtcpRR> rtcp_rr = std::make_shared<RtcpRR>();
-                    rtcp_rr->set_ssrc(audio_ssrc_);
-                    ReceptionReportBlock report;
-                    report.ssrc = audio_ssrc_;
-                    report.fraction_lost = 0;
-                    report.cumulative_number_of_packets_lost = 0;
-                    report.extended_highest_sequence_number_received = audio_extended_highest_sequence_number_received_;
-                    report.interarrival_jitter = audio_interarrival_jitter_;
-                    report.last_SR = audio_last_sr_ntp_ >> 16;
-                    report.delay_since_last_SR = (ntp >> 16) - (audio_last_sr_sys_ntp_ >> 16);
-                    rtcp_rr->add_reception_report_block(report);
-                    audio_last_sr_ntp_ = ((uint64_t)rtcp_sr.ntp_timestamp_sec_ << 32) | (rtcp_sr.ntp_timestamp_psec_);
-                    audio_last_sr_sys_ntp_ = ntp;
-                    co_await send_rtcp_pkts_channel_.async_send(boost::system::error_code{}, rtcp_rr, boost::asio::use_awaitable);
-                    // spdlog::info("audio rtp time:{}", rtcp_sr.rtp_time_/48000);
+                    auto ntp = Utils::get_ntp_time();
+                    if (rtcp_sr.header_.sender_ssrc == video_ssrc_) {
+                        recv_sr_packets_[video_ssrc_] = rtcp_sr;
+                        std::shared_ptr<RtcpRR> rtcp_rr = std::make_shared<RtcpRR>();
+                        rtcp_rr->set_ssrc(video_ssrc_);
+                        ReceptionReportBlock report;
+                        report.ssrc = video_ssrc_;
+                        report.fraction_lost = 0;
+                        report.cumulative_number_of_packets_lost = 0;
+                        report.extended_highest_sequence_number_received = video_extended_highest_sequence_number_received_;
+                        report.interarrival_jitter = video_interarrival_jitter_;
+                        report.last_SR = video_last_sr_ntp_ >> 16;
+                        report.delay_since_last_SR = (ntp >> 16) - (video_last_sr_sys_ntp_ >> 16);
+                        rtcp_rr->add_reception_report_block(report);
+                        video_last_sr_ntp_ = ((uint64_t)rtcp_sr.ntp_timestamp_sec_ << 32) | (rtcp_sr.ntp_timestamp_psec_);
+                        video_last_sr_sys_ntp_ = ntp;
+                        co_await send_rtcp_pkts_channel_.async_send(boost::system::error_code{}, rtcp_rr, boost::asio::use_awaitable);
+                    } else if (rtcp_sr.header_.sender_ssrc == audio_ssrc_) {
+                        recv_sr_packets_[audio_ssrc_] = rtcp_sr;
+                        std::shared_ptr<RtcpRR> rtcp_rr = std::make_shared<RtcpRR>();
+                        rtcp_rr->set_ssrc(audio_ssrc_);
+                        ReceptionReportBlock report;
+                        report.ssrc = audio_ssrc_;
+                        report.fraction_lost = 0;
+                        report.cumulative_number_of_packets_lost = 0;
+                        report.extended_highest_sequence_number_received = audio_extended_highest_sequence_number_received_;
+                        report.interarrival_jitter = audio_interarrival_jitter_;
+                        report.last_SR = audio_last_sr_ntp_ >> 16;
+                        report.delay_since_last_SR = (ntp >> 16) - (audio_last_sr_sys_ntp_ >> 16);
+                        rtcp_rr->add_reception_report_block(report);
+                        audio_last_sr_ntp_ = ((uint64_t)rtcp_sr.ntp_timestamp_sec_ << 32) | (rtcp_sr.ntp_timestamp_psec_);
+                        audio_last_sr_sys_ntp_ = ntp;
+                        co_await send_rtcp_pkts_channel_.async_send(boost::system::error_code{}, rtcp_rr, boost::asio::use_awaitable);
+                        // spdlog::info("audio rtp time:{}", rtcp_sr.rtp_time_/48000);
+                    }
+
+                    break;
                 }
+                case PT_RTCP_RR: {
+                    if (video_fec_pt_ == 0) {
+                        break;
+                    }
 
-                break;
-            }
-            default: {
-                break;
+                    RtcpRR rtcp_rr;
+                    int32_t consumed = rtcp_rr.decode(pkt, rtcp_len);
+                    if (consumed <= 0) {
+                        break;
+                    }
+
+                    for (auto &report : rtcp_rr.get_reception_report_blocks()) {
+                        if ((uint32_t)report.ssrc == video_media_ssrc_) {
+                            update_video_fec_level(report.fraction_lost);
+                        }
+                    }
+                    break;
+                }
+                case PT_PSFB: {
+                    // 播放端解码出错，向源请求关键帧，由源合并限速
+                    uint8_t fmt = pkt[0] & 0x1F;
+                    if (is_player_ && (fmt == FMT_PLI || fmt == FMT_FIR)) {
+                        request_play_key_frame(MediaSource::KEY_FRAME_REASON_DECODE_ERROR);
+                    }
+                    break;
+                }
+                case PT_RTPFB: {
+                    if ((pkt[0] & 0x1F) == FMT_GENERIC_NACK) {
+                        co_await process_rtcp_nack(pkt, rtcp_len);
+                    } else if ((pkt[0] & 0x1F) == FMT_TWCC) {
+                        co_await process_rtcp_twcc(pkt, rtcp_len);
+                    }
+                    break;
+                }
+                default: {
+                    break;
+                }
             }
         }
     } else if (RtpHeader::is_rtp(data, len)) {
@@ -784,6 +1366,10 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_srtp_packet(std::uniqu
             co_return false;
         }
 
+        if (!webrtc_media_source_) {// 播放端不接收媒体
+            co_return true;
+        }
+
         auto ssrc = RtpHeader::parse_ssrc(data, out_len); // todo 改成用ssrc来区分
         if (ssrc == webrtc_media_source_->get_audio_ssrc()) {
             std::shared_ptr<RtpPacket> rtp_pkt = std::make_shared<RtpPacket>();
@@ -806,15 +1392,45 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_srtp_packet(std::uniqu
             audio_recv_rtp_ts_ = rtp_pkt->get_timestamp();
             audio_extended_highest_sequence_number_received_ = rtp_pkt->get_seq_num(); // todo add 1 to high byte
             std::vector<std::shared_ptr<RtpPacket>> pkts;
-            pkts.push_back(rtp_pkt);
+            if (audio_jitter_buffer_) {
+                int64_t now_ms = Utils::get_current_ms();
+                audio_jitter_buffer_->push(rtp_pkt, now_ms);
+                audio_jitter_buffer_->pop(now_ms, pkts);
+                if (pkts.empty()) {
+                    co_return true;
+                }
+            } else {
+                pkts.push_back(rtp_pkt);
+            }
             co_return co_await webrtc_media_source_->on_audio_packets(pkts);
-        } else if (ssrc == webrtc_media_source_->get_video_ssrc()) {
+        } else {
+            int32_t layer = find_video_layer(ssrc, data, out_len);
+            if (layer < 0) {
+                co_return true;
+            }
+
             std::shared_ptr<RtpPacket> rtp_pkt = std::make_shared<RtpPacket>();
             int32_t consumed = rtp_pkt->decode_and_store(data, out_len);
             if (consumed < 0) {
                 co_return false;
             }
 
+            std::vector<std::shared_ptr<RtpPacket>> pkts;
+            if (layer != 0) {// 非主层只做重排，统计信息只针对主层
+                auto jitter_buffer = get_video_jitter_buffer(layer);
+                if (jitter_buffer) {
+                    int64_t now_ms = Utils::get_current_ms();
+                    jitter_buffer->push(rtp_pkt, now_ms);
+                    jitter_buffer->pop(now_ms, pkts);
+                    if (pkts.empty()) {
+                        co_return true;
+                    }
+                } else {
+                    pkts.push_back(rtp_pkt);
+                }
+                co_return co_await forward_video_packets(layer, pkts);
+            }
+
             if (first_rtp_video_ts_ == 0) {
                 first_rtp_video_ts_ = rtp_pkt->get_timestamp();
             }
@@ -841,14 +1457,225 @@ boost::asio::awaitable<bool> WebRtcServerSession::process_srtp_packet(std::uniqu
             video_recv_in_timestamp_units_ = now_ms_in_timestamp_units;
             video_recv_rtp_ts_ = rtp_pkt->get_timestamp();
             video_extended_highest_sequence_number_received_ = rtp_pkt->get_seq_num(); // todo add 1 to high byte
-            std::vector<std::shared_ptr<RtpPacket>> pkts;
-            pkts.push_back(rtp_pkt);
-            co_return co_await webrtc_media_source_->on_video_packets(pkts);
+            if (video_jitter_buffer_) {
+                int64_t now_ms = Utils::get_current_ms();
+                video_jitter_buffer_->push(rtp_pkt, now_ms);
+                video_jitter_buffer_->pop(now_ms, pkts);
+                if (pkts.empty()) {
+                    co_return true;
+                }
+            } else {
+                pkts.push_back(rtp_pkt);
+            }
+            co_return co_await forward_video_packets(0, pkts);
         }
     }
     co_return true;
 }
 
+Json::Value WebRtcServerSession::to_json() {
+    Json::Value v;
+    v["domain"] = get_domain_name();
+    v["app"] = get_app_name();
+    v["stream"] = get_stream_name();
+    v["role"] = is_publisher_ ? "publisher" : (is_player_ ? "player" : "unknown");
+    v["srtp_profile"] = SRTPSession::get_profile_name(srtp_session_.get_profile());
+    if (is_player_) {
+        v["sent_pkts"] = (Json::UInt64)sent_rtp_pkts_;
+        v["sent_bytes"] = (Json::UInt64)sent_rtp_bytes_;
+        v["dropped_video_pkts"] = (Json::UInt64)dropped_video_pkts_.load();
+        v["pending_batches"] = send_rtp_queue_.get_pending_batches();
+        Json::Value queue_drop;
+        queue_drop["batches"] = (Json::UInt64)send_rtp_queue_.get_dropped_batches();
+        queue_drop["video_pkts"] = (Json::UInt64)send_rtp_queue_.get_dropped_video_pkts();
+        queue_drop["audio_pkts"] = (Json::UInt64)send_rtp_queue_.get_dropped_audio_pkts();
+        v["queue_full_dropped"] = queue_drop;
+        v["video_source_bps"] = (Json::Int64)video_source_bps_.load();
+        Json::Value bwe;
+        bwe["enabled"] = twcc_ext_id_.load() != 0;
+        if (bwe_ && bwe_->has_feedback()) {
+            bwe["estimated_bps"] = (Json::Int64)bwe_->get_estimated_bps();
+            bwe["acked_bps"] = (Json::Int64)bwe_->get_acked_bps();
+            bwe["loss_rate"] = bwe_->get_loss_rate();
+            bwe["delay_trend"] = bwe_->get_delay_trend();
+            bwe["delay_state"] = (int32_t)bwe_->get_delay_state();
+            bwe["pacing_bps"] = (Json::Int64)(bwe_->get_estimated_bps() * PACING_FACTOR);
+        }
+        v["bwe"] = bwe;
+        auto source = play_source_.lock();
+        if (source && simulcast_play_ssrc_ != 0) {
+            Json::Value simulcast;
+            int32_t layer = sending_layer_.load();
+            simulcast["rid"] = layer >= 0 ? source->get_simulcast_rid(layer) : "";
+            simulcast["fixed"] = layer_selector_.is_fixed();
+            simulcast["switches"] = (Json::UInt64)layer_switch_count_.load();
+            v["simulcast"] = simulcast;
+        }
+
+        Json::Value fec;
+        fec["enabled"] = video_fec_pt_ != 0;
+        fec["level"] = video_fec_level_.load();
+        fec["rr_loss"] = video_rr_loss_;
+        fec["sent_fec_pkts"] = (Json::UInt64)sent_fec_pkts_;
+        v["fec"] = fec;
+    }
+
+    auto jitter_to_json = [](RtpJitterBuffer *jitter_buffer) {
+        Json::Value j;
+        j["recv"] = (Json::UInt64)jitter_buffer->get_recv_count();
+        j["nack"] = (Json::UInt64)jitter_buffer->get_nack_count();
+        j["recovered"] = (Json::UInt64)jitter_buffer->get_recovered_count();
+        j["lost"] = (Json::UInt64)jitter_buffer->get_lost_count();
+        return j;
+    };
+
+    if (video_jitter_buffer_) {
+        v["video_jitter_buffer"] = jitter_to_json(video_jitter_buffer_.get());
+    }
+
+    if (audio_jitter_buffer_) {
+        v["audio_jitter_buffer"] = jitter_to_json(audio_jitter_buffer_.get());
+    }
+    return v;
+}
+
+boost::asio::awaitable<Json::Value> WebRtcServerSession::sync_to_json() {
+    auto self(shared_from_this());
+    WaitGroup wg(worker_);
+    std::shared_ptr<Json::Value> result = std::make_shared<Json::Value>();
+    wg.add(1);
+    boost::asio::co_spawn(worker_->get_io_context(), [this, self, result]()->boost::asio::awaitable<void> {
+        *result = to_json();
+        co_return;
+    }, [this, self, &wg](std::exception_ptr exp) {
+        (void)exp;
+        wg.done();
+    });
+
+    co_await wg.wait();
+    co_return *result;
+}
+
+void WebRtcServerSession::add_video_fec_offer(Sdp &offer_sdp, uint32_t fec_ssrc) {
+    // 选一个所有媒体都没有用到的动态pt
+    std::set<uint32_t> used_pts;
+    for (auto &media : offer_sdp.get_media_sdps()) {
+        for (auto &p : media.get_payloads()) {
+            used_pts.insert(p.second.get_pt());
+        }
+    }
+
+    uint8_t fec_pt = 0;
+    for (uint32_t pt = 96; pt <= 127; pt++) {
+        if (used_pts.find(pt) == used_pts.end()) {
+            fec_pt = (uint8_t)pt;
+            break;
+        }
+    }
+
+    if (fec_pt == 0) {
+        return;
+    }
+
+    for (auto &media : offer_sdp.get_media_sdps()) {
+        if (media.get_media() != "video") {
+            continue;
+        }
+
+        // 有ssrc-group时第一个是主流ssrc，否则只能有一个ssrc
+        std::optional<Ssrc> media_ssrc;
+        auto ssrc_group = media.get_ssrc_group();
+        if (ssrc_group && !ssrc_group->get_ssrc_ids().empty()) {
+            auto it = media.get_ssrcs().find(ssrc_group->get_ssrc_ids()[0]);
+            if (it != media.get_ssrcs().end()) {
+                media_ssrc = it->second;
+            }
+        } else if (media.get_ssrcs().size() == 1) {
+            media_ssrc = media.get_ssrcs().begin()->second;
+        }
+
+        if (!media_ssrc) {
+            return;
+        }
+
+        media.add_fmt(fec_pt);
+        Payload fec_payload(fec_pt, "flexfec-03", 90000, {});
+        Fmtp fmtp;
+        fmtp.set_pt(fec_pt);
+        fmtp.add_param("repair-window", "10000000");
+        fec_payload.add_fmtp(fmtp);
+        media.add_payload(fec_payload);
+
+        Ssrc fec_ssrc_info(fec_ssrc, media_ssrc->get_cname(), media_ssrc->get_mslabel(), media_ssrc->get_label());
+        media.add_ssrc(fec_ssrc_info);
+        // 服务端不发rtx，FID分组直接换成FEC-FR分组
+        SsrcGroup fec_group;
+        fec_group.semantics = "FEC-FR";
+        fec_group.add_ssrc(*media_ssrc);
+        fec_group.add_ssrc(fec_ssrc_info);
+        media.set_ssrc_group(fec_group);
+
+        video_fec_pt_ = fec_pt;
+        video_fec_ssrc_ = fec_ssrc;
+        video_media_ssrc_ = media_ssrc->get_id();
+        return;
+    }
+}
+
+void WebRtcServerSession::xor_video_fec_twcc_seqs(uint8_t *fec_payload, size_t len) {
+    uint16_t base_seq, mask;
+    if (!RtpFlexFecEncoder::get_protected_seqs(fec_payload, len, base_seq, mask)) {
+        return;
+    }
+
+    // 冗余包跟在所保护的包后面发送，没发给本会话的包(如订阅前的)保持按0计算
+    for (uint16_t offset = 0; offset < RtpFlexFecEncoder::MAX_GROUP_PKTS; offset++) {
+        if (!(mask & (1 << (14 - offset)))) {
+            continue;
+        }
+
+        uint16_t seq = base_seq + offset;
+        auto &sent = fec_twcc_seqs_[seq % FEC_TWCC_SEQS];
+        if (sent.valid && sent.seq == seq) {
+            RtpFlexFecEncoder::xor_twcc_seq(fec_payload, len, sent.csrc, sent.twcc_seq);
+        }
+    }
+}
+
+void WebRtcServerSession::update_video_fec_level(uint8_t fraction_lost) {
+    video_rr_loss_ = video_rr_loss_ * 0.7 + (fraction_lost / 256.0) * 0.3;
+    int32_t cur_level = video_fec_level_.load();
+    int32_t target_level = WebRtcMediaSource::get_video_fec_level_by_loss(video_rr_loss_);
+    int32_t new_level = cur_level;
+    int64_t now_ms = Utils::get_current_ms();
+    if (target_level > cur_level) {// 丢包变多马上升级
+        new_level = target_level;
+        fec_level_down_since_ms_ = 0;
+    } else if (target_level < cur_level) {// 持续低于当前等级才逐级下降
+        if (fec_level_down_since_ms_ == 0) {
+            fec_level_down_since_ms_ = now_ms;
+        } else if (now_ms - fec_level_down_since_ms_ >= FEC_LEVEL_DOWN_MS) {
+            new_level = cur_level - 1;
+            fec_level_down_since_ms_ = now_ms;
+        }
+    } else {
+        fec_level_down_since_ms_ = 0;
+    }
+
+    if (new_level == cur_level) {
+        return;
+    }
+
+    auto source = play_source_.lock();
+    if (!source) {
+        return;
+    }
+
+    source->update_video_fec_level(cur_level, new_level);
+    video_fec_level_ = new_level;
+    spdlog::debug("webrtc player fec level {} -> {}, rr loss:{:.3f}", cur_level, new_level, video_rr_loss_);
+}
+
 bool WebRtcServerSession::find_key_frame(uint32_t timestamp, std::shared_ptr<RtpH264NALU> &nalu) {
     (void)timestamp;
     bool is_key = false;
@@ -934,6 +1761,12 @@ void WebRtcServerSession::stop() {
             boost::system::error_code ec;
             play_sdp_timeout_timer_.cancel();
 
+            int32_t fec_level = video_fec_level_.exchange(0);
+            auto source = play_source_.lock();
+            if (source && fec_level > 0) {
+                source->update_video_fec_level(fec_level, 0);
+            }
+
             if (rtp_media_sink_) {
                 rtp_media_sink_->on_close({});
                 rtp_media_sink_->set_video_pkts_cb({});
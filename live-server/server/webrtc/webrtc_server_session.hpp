@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <memory>
 #include <map>
 #include <future>
@@ -12,12 +14,16 @@
 
 #include "udp_msg_demultiplex.hpp"
 #include "core/stream_session.hpp"
+#include "core/media_source.hpp"
 #include "protocol/sdp/sdp.hpp"
 #include "base/network/udp_socket.hpp"
 #include "srtp/srtp_session.h"
+#include "rtp_send_queue.hpp"
+#include "simulcast_layer.hpp"
 
 #include "protocol/rtp/rtp_h264_depacketizer.h"
 #include "protocol/rtp/rtcp/rtcp_sr.h"
+#include "base/block_pool.h"
 #include "base/utils/utils.h"
 #include "base/wait_group.h"
 
@@ -38,11 +44,17 @@ class ThreadWorker;
 class UdpSocket;
 class StunMsg;
 class RtpMediaSink;
+class RtpHistory;
+class RtpJitterBuffer;
+class TwccBandwidthEstimator;
 class DtlsCert;
 class HttpRequest;
 class HttpResponse;
 
 class WebRtcServerSession  : public StreamSession, public ObjTracker<WebRtcServerSession> {
+public:
+    // 播放端transport-cc扩展头id，源按该id的线路格式计算FEC
+    static constexpr uint8_t TWCC_EXT_ID = 3;
 public:
     WebRtcServerSession(ThreadWorker *worker);
     virtual ~WebRtcServerSession();
@@ -52,6 +64,8 @@ public:
 
     void start() override;
     void stop() override;
+    Json::Value to_json() override;
+    boost::asio::awaitable<Json::Value> sync_to_json();
     
     ThreadWorker *get_worker() {
         return worker_;
@@ -117,6 +131,8 @@ private:
     void start_process_recv_udp_msg();
     boost::asio::awaitable<void> stop_process_recv_udp_msg();
     void start_pli_sender();
+    boost::asio::awaitable<void> send_pli(uint32_t layers);
+    void request_play_key_frame(MediaSource::KeyFrameReason reason);
     boost::asio::awaitable<void> stop_pli_sender();
     void start_rtp_sender();
     boost::asio::awaitable<void> stop_rtp_sender();
@@ -124,9 +140,24 @@ private:
     boost::asio::awaitable<void> stop_rtcp_fb_sender();
     void start_rtcp_sender();
     boost::asio::awaitable<void> stop_rtcp_sender();
+    boost::asio::awaitable<void> process_rtcp_nack(uint8_t *data, size_t len);
+    boost::asio::awaitable<void> process_rtcp_twcc(uint8_t *data, size_t len);
+    boost::asio::awaitable<bool> wait_pacing(size_t bytes);
+    bool should_send_video(const std::vector<std::shared_ptr<RtpPacket>> & pkts);
+    void send_video_pkts(std::vector<std::shared_ptr<RtpPacket>> pkts);
+    static bool contains_key_frame(const std::vector<std::shared_ptr<RtpPacket>> & pkts);
+    boost::asio::awaitable<bool> flush_jitter_buffer(RtpJitterBuffer *jitter_buffer, uint32_t ssrc, bool is_video, uint32_t layer, int64_t now_ms);
+    int32_t find_video_layer(uint32_t ssrc, uint8_t *data, size_t len);
+    RtpJitterBuffer *get_video_jitter_buffer(uint32_t layer);
+    uint32_t get_video_layer_ssrc(uint32_t layer);
+    boost::asio::awaitable<bool> forward_video_packets(uint32_t layer, std::vector<std::shared_ptr<RtpPacket>> pkts);
+    bool select_video_layer(uint32_t layer, const std::vector<std::shared_ptr<RtpPacket>> & pkts);
 
     boost::asio::awaitable<int32_t> process_stun_binding_req(std::shared_ptr<StunMsg> stun_msg, UdpSocket *sock, const boost::asio::ip::udp::endpoint &remote_ep);
     void on_dtls_handshake_done(SRTPProtectionProfile profile, const std::string & srtp_recv_key, const std::string & srtp_send_key);
+    void add_video_fec_offer(Sdp & offer_sdp, uint32_t fec_ssrc);
+    void update_video_fec_level(uint8_t fraction_lost);
+    void xor_video_fec_twcc_seqs(uint8_t *fec_payload, size_t len);
     bool find_key_frame(uint32_t timestamp, std::shared_ptr<RtpH264NALU> & nalu);
 private:
     ThreadWorker *worker_;
@@ -173,10 +204,11 @@ private:
     boost::asio::ip::udp::endpoint peer_ep;
     
     
-    std::unique_ptr<uint8_t[]> send_buf_;
-    std::unique_ptr<uint8_t[]> enc_buf_;
+    // rtp输出缓冲从BlockPool中取，会话结束后归还复用
+    static constexpr size_t RTP_OUT_BUF_SIZE = BlockPool::BLOCK_SIZE;
+    std::shared_ptr<uint8_t[]> rtp_out_buf_;
 
-    boost::asio::experimental::concurrent_channel<void(boost::system::error_code, std::vector<std::shared_ptr<RtpPacket>>)> send_rtp_pkts_channel_;
+    RtpSendQueue send_rtp_queue_;
     
     boost::asio::experimental::concurrent_channel<void(boost::system::error_code, std::shared_ptr<RtcpFbPacket>)> send_rtcp_fb_pkts_channel_;
 
@@ -217,6 +249,73 @@ private:
 
     uint64_t video_last_sr_sys_ntp_ = 0;
     uint64_t audio_last_sr_sys_ntp_ = 0;
+
+    // 播放端NACK重传，历史由源共享，重传按令牌桶限速
+    static constexpr int32_t NACK_RETRANS_PKTS_PER_SEC = 500;
+    std::shared_ptr<RtpHistory> video_rtp_history_;
+    std::shared_ptr<RtpHistory> audio_rtp_history_;
+    double nack_tokens_ = NACK_RETRANS_PKTS_PER_SEC;
+    int64_t nack_tokens_update_ms_ = 0;
+
+    // 推流端重排缓冲，丢包先NACK，超时未恢复再请求关键帧
+    static constexpr int32_t JITTER_BUFFER_TICK_MS = 10;
+    std::unique_ptr<RtpJitterBuffer> video_jitter_buffer_;
+    std::unique_ptr<RtpJitterBuffer> audio_jitter_buffer_;
+    // simulcast推流，ssrc通过rid扩展头映射到层，主层沿用video_ssrc_和video_jitter_buffer_
+    std::unordered_map<uint32_t, uint32_t> simulcast_ssrc_layers_;
+    std::vector<std::unique_ptr<RtpJitterBuffer>> simulcast_jitter_buffers_; // 第1层开始，下标为层号-1
+
+    // 播放端transport-cc带宽估计，驱动发送节奏(pacing)和丢帧
+    static constexpr int64_t TWCC_START_BPS = 2 * 1000 * 1000;
+    static constexpr int32_t MAX_PENDING_RTP_BATCHES = 32;    // 发送队列积压超过该值开始丢帧
+    static constexpr double PACING_FACTOR = 1.5;              // 发送速率为估计带宽的倍数
+    static constexpr double CONGESTED_RATIO = 0.7;            // 估计带宽低于源码率的该比例时丢帧
+    std::atomic<uint8_t> twcc_ext_id_{0};                     // 0表示对端没有协商transport-cc
+    uint16_t twcc_seq_ = 0;
+    std::unique_ptr<TwccBandwidthEstimator> bwe_;
+    std::atomic<int64_t> estimated_bps_{0};
+    boost::asio::steady_timer pacing_timer_;
+    double pacing_budget_bytes_ = 0;
+    int64_t pacing_update_us_ = 0;
+    uint64_t sent_rtp_pkts_ = 0;
+    uint64_t sent_rtp_bytes_ = 0;
+    // 以下在源的线程中访问
+    bool drop_until_key_frame_ = false;
+    int64_t video_in_bytes_ = 0;
+    int64_t video_in_begin_ms_ = 0;
+    std::atomic<int64_t> video_source_bps_{0};
+    std::atomic<uint64_t> dropped_video_pkts_{0};
+
+    // simulcast播放，按带宽估计或rid参数选择一层，只在关键帧处切换，只有选中层的包会加密发送
+    std::weak_ptr<WebRtcMediaSource> play_source_;
+    uint32_t simulcast_play_ssrc_ = 0;
+    // 以下在源的线程中访问
+    SimulcastLayerSelector layer_selector_;
+    std::atomic<int32_t> sending_layer_{-1};
+    std::atomic<uint64_t> layer_switch_count_{0};
+    // 在发送协程中访问
+    SimulcastRtpRewriter rtp_rewriter_;
+
+    // 播放端FlexFEC，冗余包由源按保护等级生成并共享，等级按RR丢包率调整
+    static constexpr int64_t FEC_LEVEL_DOWN_MS = 5000;        // 降级要求丢包率持续低于当前等级的时间
+    uint8_t video_fec_pt_ = 0;                                // 0表示对端没有接受flexfec
+    uint32_t video_fec_ssrc_ = 0;
+    uint32_t video_media_ssrc_ = 0;
+    std::atomic<int32_t> video_fec_level_{0};
+    double video_rr_loss_ = 0;
+    int64_t fec_level_down_since_ms_ = 0;
+    // 以下在发送协程中访问，改写为本会话协商的pt和序号
+    uint16_t video_fec_seq_ = 0;
+    uint64_t sent_fec_pkts_ = 0;
+    // 最近发出的视频包的transport-cc序号，按媒体序号索引，共享的冗余包按序号0计算，发送前异或进实际的序号
+    static constexpr size_t FEC_TWCC_SEQS = 64;
+    struct SentTwccSeq {
+        bool valid = false;
+        uint16_t seq = 0;
+        uint16_t twcc_seq = 0;
+        uint8_t csrc = 0;
+    };
+    std::array<SentTwccSeq, FEC_TWCC_SEQS> fec_twcc_seqs_;
     WaitGroup wg_;
 };
 
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <thread>
+
+#include "spdlog/spdlog.h"
+#include "base/thread/thread_worker.hpp"
+#include "audio_transcode_service.hpp"
+
+using namespace mms;
+
+AudioTranscodeService & AudioTranscodeService::get_instance() {
+    // 不析构，桥可能在进程退出时才释放转码
+    static AudioTranscodeService *instance = new AudioTranscodeService;
+    return *instance;
+}
+
+void AudioTranscodeService::start(int32_t threads) {
+    if (!workers_.empty()) {
+        return;
+    }
+
+    int32_t cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    for (int32_t i = 0; i < threads; i++) {
+        ThreadWorker *w = new ThreadWorker();
+        // 从最后一个核往前放，尽量避开前面几个核上的转发worker
+        w->set_cpu_core(cpu_count - 1 - (i % cpu_count));
+        w->start();
+        workers_.emplace_back(w);
+    }
+}
+
+void AudioTranscodeService::stop() {
+    for (auto & w : workers_) {
+        w->stop();
+        delete w;
+    }
+    workers_.clear();
+}
+
+ThreadWorker *AudioTranscodeService::get_worker() {
+    if (workers_.empty()) {
+        return nullptr;
+    }
+    uint64_t idx = using_worker_idx_++ % workers_.size();
+    return workers_[idx];
+}
+
+std::shared_ptr<AudioTranscoder> AudioTranscodeService::get_or_create(const std::string & key, AudioTranscoder::Type type, ThreadWorker *caller_worker) {
+    std::string full_key = key + (type == AudioTranscoder::AAC_TO_OPUS ? "/aac-opus" : "/opus-aac");
+    std::lock_guard<std::mutex> lck(mtx_);
+    for (auto it = transcoders_.begin(); it != transcoders_.end();) {
+        if (it->second.expired()) {
+            it = transcoders_.erase(it);
+        } else {
+            it++;
+        }
+    }
+
+    auto it = transcoders_.find(full_key);
+    if (it != transcoders_.end()) {
+        auto transcoder = it->second.lock();
+        if (transcoder) {
+            return transcoder;
+        }
+    }
+
+    ThreadWorker *worker = get_worker();
+    auto transcoder = std::make_shared<AudioTranscoder>(worker ? worker : caller_worker, type, full_key);
+    transcoders_[full_key] = transcoder;
+    return transcoder;
+}
+
+Json::Value AudioTranscodeService::to_json() {
+    Json::Value v;
+    v["threads"] = (Json::UInt64)workers_.size();
+    uint64_t cpu_us = 0;
+    int64_t out_ms = 0;
+    Json::Value streams(Json::arrayValue);
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        for (auto & p : transcoders_) {
+            auto transcoder = p.second.lock();
+            if (!transcoder) {
+                continue;
+            }
+            auto t = transcoder->to_json();
+            cpu_us += t["cpu_us"].asUInt64();
+            out_ms += t["out_ms"].asInt64();
+            streams.append(t);
+        }
+    }
+    v["streams"] = streams;
+    // 每个核能实时转码的流数 = 转出的音频时长 / 消耗的cpu时间
+    v["streams_per_core"] = cpu_us > 0 ? (double)out_ms * 1000 / cpu_us : 0.0;
+    return v;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "json/json.h"
+#include "audio_transcoder.hpp"
+
+namespace mms {
+class ThreadWorker;
+// 音频转码服务
+// 转码放到独立的线程池，每路流的转码固定在一个线程上保证顺序，按流和转码类型登记，同一路流只转一次
+class AudioTranscodeService {
+public:
+    static AudioTranscodeService & get_instance();
+
+    void start(int32_t threads);
+    void stop();
+    // 没有启动转码线程时，转码在调用者的worker上进行
+    std::shared_ptr<AudioTranscoder> get_or_create(const std::string & key, AudioTranscoder::Type type, ThreadWorker *caller_worker);
+
+    Json::Value to_json();
+private:
+    AudioTranscodeService() = default;
+    ThreadWorker *get_worker();
+private:
+    std::vector<ThreadWorker*> workers_;
+    std::atomic<uint64_t> using_worker_idx_{0};
+
+    std::mutex mtx_;
+    std::unordered_map<std::string, std::weak_ptr<AudioTranscoder>> transcoders_;
+};
+};
@@ -0,0 +1,377 @@
+#include <time.h>
+#include <algorithm>
+
+#include <boost/asio/post.hpp>
+
+#include "spdlog/spdlog.h"
+#include "opus/opus.h"
+extern "C" {
+    #include "libswresample/swresample.h"
+}
+
+#include "audio_transcoder.hpp"
+#include "pcm_ring_buffer.hpp"
+#include "base/thread/thread_worker.hpp"
+#include "codec/aac/aac_decoder.hpp"
+#include "codec/aac/aac_encoder.hpp"
+#include "codec/opus/opus_encoder.hpp"
+
+using namespace mms;
+
+namespace {
+constexpr int32_t OUT_CHANNELS = 2;
+
+int64_t thread_cpu_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+SwrContext *create_swr(int32_t in_sample_rate, int32_t in_channels, int32_t out_sample_rate) {
+    SwrContext *swr = nullptr;
+    AVChannelLayout out_ch_layout;
+    AVChannelLayout in_ch_layout;
+    av_channel_layout_default(&out_ch_layout, OUT_CHANNELS);
+    av_channel_layout_default(&in_ch_layout, in_channels);
+    int ret = swr_alloc_set_opts2(&swr, &out_ch_layout, AV_SAMPLE_FMT_S16, out_sample_rate,
+                                  &in_ch_layout, AV_SAMPLE_FMT_S16, in_sample_rate, 0, NULL);
+    if (ret < 0 || swr_init(swr) < 0) {
+        spdlog::error("swr init failed");
+        swr_free(&swr);
+        return nullptr;
+    }
+    return swr;
+}
+
+// 重采样到环里，空间连续时直接写进环，跨环尾时先写到临时缓冲再拷进去
+bool resample_to_ring(SwrContext *swr, const int16_t *pcm, int32_t in_samples, PcmRingBuffer & ring, std::vector<int16_t> & tmp) {
+    int32_t max_out = swr_get_out_samples(swr, in_samples);
+    if (max_out <= 0) {
+        return true;
+    }
+
+    size_t contiguous;
+    int16_t *dst = ring.write_ptr(contiguous);
+    bool direct = contiguous >= (size_t)max_out * OUT_CHANNELS;
+    if (!direct && tmp.size() < (size_t)max_out * OUT_CHANNELS) {
+        tmp.resize(max_out * OUT_CHANNELS);
+    }
+
+    uint8_t *data_out[1] = {(uint8_t *)(direct ? dst : tmp.data())};
+    const uint8_t *data_in[1] = {(const uint8_t *)pcm};
+    int32_t out_samples = swr_convert(swr, data_out, max_out, data_in, in_samples);
+    if (out_samples <= 0) {
+        return out_samples == 0;
+    }
+
+    if (direct) {
+        ring.commit(out_samples * OUT_CHANNELS);
+        return true;
+    }
+    return ring.write(tmp.data(), out_samples * OUT_CHANNELS);
+}
+
+// aac(任意采样率、通道) -> 48k双声道pcm -> 20ms一帧的opus
+class AacToOpusPipeline : public AudioTranscoder::Pipeline {
+public:
+    static constexpr int32_t OPUS_SAMPLE_RATE = 48000;
+    static constexpr int32_t SAMPLES_20MS = 48 * 20;
+
+    ~AacToOpusPipeline() {
+        if (swr_) {
+            swr_free(&swr_);
+        }
+    }
+
+    bool init(const std::string & config, int32_t sample_rate, int32_t channels) override {
+        (void)sample_rate;
+        (void)channels;
+        if (!decoder_.init(config)) {
+            spdlog::error("init aac decoder failed");
+            return false;
+        }
+
+        in_channels_ = std::max<int32_t>(1, decoder_.get_channels());
+        swr_ = create_swr(decoder_.get_sample_rate(), in_channels_, OPUS_SAMPLE_RATE);
+        if (!swr_) {
+            return false;
+        }
+        return encoder_.init(OPUS_SAMPLE_RATE, OUT_CHANNELS);
+    }
+
+    void process(const AudioTranscoder::Frame & in, std::vector<AudioTranscoder::Frame> & out) override {
+        auto pcm = decoder_.decode((uint8_t *)in.data.data(), in.data.size());
+        if (pcm.empty()) {
+            return;
+        }
+
+        int32_t in_samples = pcm.size() / (2 * in_channels_);
+        if (!resample_to_ring(swr_, (const int16_t *)pcm.data(), in_samples, ring_, tmp_)) {
+            spdlog::warn("aac to opus pcm ring overflow, drop {} samples", ring_.size());
+            ring_.clear();
+            return;
+        }
+
+        // frame_size为每个通道的样本数，48k 20ms为960
+        const int16_t *frame;
+        while ((frame = ring_.peek(SAMPLES_20MS * OUT_CHANNELS)) != nullptr) {
+            auto opus_bytes = encoder_.encode((uint8_t *)frame, SAMPLES_20MS, opus_data_, sizeof(opus_data_));
+            ring_.consume(SAMPLES_20MS * OUT_CHANNELS);
+            if (opus_bytes > 0) {
+                AudioTranscoder::Frame f;
+                f.data.assign((char *)opus_data_, opus_bytes);
+                f.pts = frame_count_ * SAMPLES_20MS;
+                out.emplace_back(std::move(f));
+            }
+            frame_count_++;
+        }
+    }
+
+    int64_t get_out_duration_ms() override {
+        return frame_count_ * 20;
+    }
+private:
+    AACDecoder decoder_;
+    SwrContext *swr_ = nullptr;
+    MOpusEncoder encoder_;
+    int32_t in_channels_ = 2;
+    PcmRingBuffer ring_{OPUS_SAMPLE_RATE * OUT_CHANNELS, SAMPLES_20MS * OUT_CHANNELS};
+    std::vector<int16_t> tmp_;
+    uint8_t opus_data_[4000];
+    int64_t frame_count_ = 0;
+};
+
+// opus -> 44.1k双声道pcm -> aac
+class OpusToAacPipeline : public AudioTranscoder::Pipeline {
+public:
+    static constexpr int32_t AAC_SAMPLE_RATE = 44100;
+    static constexpr int32_t MAX_OPUS_FRAME_SAMPLES = 5760; // 48k 120ms
+
+    ~OpusToAacPipeline() {
+        if (swr_) {
+            swr_free(&swr_);
+        }
+
+        if (decoder_) {
+            opus_decoder_destroy(decoder_);
+        }
+    }
+
+    bool init(const std::string & config, int32_t sample_rate, int32_t channels) override {
+        (void)config;
+        int error = 0;
+        in_sample_rate_ = sample_rate;
+        in_channels_ = std::max<int32_t>(1, channels);
+        decoder_ = opus_decoder_create(in_sample_rate_, in_channels_, &error);
+        if (!decoder_ || error != OPUS_OK) {
+            spdlog::error("create opus decoder failed, code:{}", error);
+            return false;
+        }
+
+        swr_ = create_swr(in_sample_rate_, in_channels_, AAC_SAMPLE_RATE);
+        if (!swr_) {
+            return false;
+        }
+
+        if (!encoder_.init(AAC_SAMPLE_RATE, OUT_CHANNELS)) {
+            spdlog::error("init aac encoder failed");
+            return false;
+        }
+        decoded_pcm_.resize(MAX_OPUS_FRAME_SAMPLES * in_channels_);
+        return true;
+    }
+
+    std::string get_out_config() override {
+        return encoder_.get_specific_configuration();
+    }
+
+    void process(const AudioTranscoder::Frame & in, std::vector<AudioTranscoder::Frame> & out) override {
+        int32_t in_samples = opus_decode(decoder_, (const uint8_t *)in.data.data(), in.data.size(),
+                                         decoded_pcm_.data(), MAX_OPUS_FRAME_SAMPLES, 0);
+        if (in_samples <= 0) {
+            return;
+        }
+
+        if (!resample_to_ring(swr_, decoded_pcm_.data(), in_samples, ring_, tmp_)) {
+            spdlog::warn("opus to aac pcm ring overflow, drop {} samples", ring_.size());
+            ring_.clear();
+            return;
+        }
+
+        // 环里的pcm截止到本帧结束，据此推算每个aac帧起始的rtp时间戳
+        int64_t end_ts = in.pts + (int64_t)in_samples * 48000 / in_sample_rate_;
+        size_t frame_samples = encoder_.get_input_samples();
+        const int16_t *frame;
+        while ((frame = ring_.peek(frame_samples)) != nullptr) {
+            int64_t pts = end_ts - (int64_t)(ring_.size() / OUT_CHANNELS) * 48000 / AAC_SAMPLE_RATE;
+            auto aac_bytes = encoder_.encode_frame(frame, aac_data_, sizeof(aac_data_));
+            ring_.consume(frame_samples);
+            frame_count_++;
+            if (aac_bytes > 0) {
+                AudioTranscoder::Frame f;
+                f.data.assign((char *)aac_data_, aac_bytes);
+                f.pts = pts;
+                out.emplace_back(std::move(f));
+            }
+        }
+    }
+
+    int64_t get_out_duration_ms() override {
+        return frame_count_ * encoder_.get_input_samples() / OUT_CHANNELS * 1000 / AAC_SAMPLE_RATE;
+    }
+private:
+    OpusDecoder *decoder_ = nullptr;
+    int32_t in_sample_rate_ = 48000;
+    int32_t in_channels_ = 2;
+    SwrContext *swr_ = nullptr;
+    AACEncoder encoder_;
+    std::vector<opus_int16> decoded_pcm_;
+    PcmRingBuffer ring_{AAC_SAMPLE_RATE * OUT_CHANNELS, 2048 * OUT_CHANNELS};
+    std::vector<int16_t> tmp_;
+    uint8_t aac_data_[8192];
+    int64_t frame_count_ = 0;
+};
+};
+
+AudioTranscoder::AudioTranscoder(ThreadWorker *worker, Type type, const std::string & key) : worker_(worker), type_(type), key_(key) {
+
+}
+
+AudioTranscoder::~AudioTranscoder() {
+    spdlog::debug("destroy audio transcoder:{}, out:{}ms, cpu:{}us", key_, out_duration_ms_.load(), cpu_us_.load());
+}
+
+void AudioTranscoder::attach(void *owner, const OutputCb & cb) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    for (auto & p : outputs_) {
+        if (p.first == owner) {
+            p.second = cb;
+            return;
+        }
+    }
+    outputs_.emplace_back(owner, cb);
+}
+
+void AudioTranscoder::detach(void *owner) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    for (auto it = outputs_.begin(); it != outputs_.end(); it++) {
+        if (it->first == owner) {
+            outputs_.erase(it);
+            break;
+        }
+    }
+}
+
+bool AudioTranscoder::is_feeder(void *owner) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return !outputs_.empty() && outputs_[0].first == owner;
+}
+
+bool AudioTranscoder::configure(void *owner, const std::string & config, int32_t sample_rate, int32_t channels) {
+    if (!is_feeder(owner)) {// 其他桥复用已有的转码
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (configured_) {
+            return true;
+        }
+    }
+
+    std::shared_ptr<Pipeline> pipeline;
+    if (type_ == AAC_TO_OPUS) {
+        pipeline = std::make_shared<AacToOpusPipeline>();
+    } else {
+        pipeline = std::make_shared<OpusToAacPipeline>();
+    }
+
+    if (!pipeline->init(config, sample_rate, channels)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        out_config_ = pipeline->get_out_config();
+        configured_ = true;
+    }
+
+    auto self(shared_from_this());
+    boost::asio::post(worker_->get_io_context(), [this, self, pipeline]() {
+        if (pipeline_) {
+            out_duration_base_ms_ += pipeline_->get_out_duration_ms();
+        }
+        pipeline_ = pipeline;
+    });
+    return true;
+}
+
+void AudioTranscoder::feed(void *owner, Frame frame) {
+    if (!is_feeder(owner)) {
+        return;
+    }
+
+    if (pending_frames_.load(std::memory_order_relaxed) >= MAX_PENDING_FRAMES) {
+        dropped_frames_++;
+        return;
+    }
+    pending_frames_++;
+    in_frames_++;
+
+    auto self(shared_from_this());
+    boost::asio::post(worker_->get_io_context(), [this, self, frame = std::move(frame)]() {
+        pending_frames_--;
+        process(frame);
+    });
+}
+
+void AudioTranscoder::process(const Frame & frame) {
+    if (!pipeline_) {
+        return;
+    }
+
+    int64_t start_us = thread_cpu_us();
+    auto frames = std::make_shared<std::vector<Frame>>();
+    pipeline_->process(frame, *frames);
+    if (type_ == AAC_TO_OPUS) {// 重建链路后时间戳接着之前的
+        for (auto & f : *frames) {
+            f.pts += out_duration_base_ms_ * 48;
+        }
+    }
+    cpu_us_ += thread_cpu_us() - start_us;
+    out_duration_ms_ = out_duration_base_ms_ + pipeline_->get_out_duration_ms();
+    if (frames->empty()) {
+        return;
+    }
+    out_frames_ += frames->size();
+
+    std::vector<OutputCb> cbs;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        for (auto & p : outputs_) {
+            cbs.push_back(p.second);
+        }
+    }
+
+    for (auto & cb : cbs) {
+        cb(frames);
+    }
+}
+
+std::string AudioTranscoder::get_out_config() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return out_config_;
+}
+
+Json::Value AudioTranscoder::to_json() {
+    Json::Value v;
+    v["key"] = key_;
+    v["type"] = type_ == AAC_TO_OPUS ? "aac-opus" : "opus-aac";
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        v["outputs"] = (Json::UInt64)outputs_.size();
+    }
+    v["in_frames"] = (Json::UInt64)in_frames_.load();
+    v["out_frames"] = (Json::UInt64)out_frames_.load();
+    v["dropped_frames"] = (Json::UInt64)dropped_frames_.load();
+    v["pending_frames"] = pending_frames_.load();
+    v["out_ms"] = (Json::Int64)out_duration_ms_.load();
+    v["cpu_us"] = (Json::UInt64)cpu_us_.load();
+    return v;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+
+namespace mms {
+class ThreadWorker;
+// 单路流的音频转码(AAC<->Opus)，在转码线程上执行解码、重采样和编码，不占用转发媒体的worker
+// 同一路流的转码只做一次，多个桥共享，只有最先attach的桥送数据，输出回调给所有attach的桥
+class AudioTranscoder : public std::enable_shared_from_this<AudioTranscoder> {
+public:
+    enum Type {
+        AAC_TO_OPUS = 0,
+        OPUS_TO_AAC = 1,
+    };
+
+    struct Frame {
+        std::string data;
+        // AAC_TO_OPUS：输入不使用，输出为转码开始后的48k采样数
+        // OPUS_TO_AAC：输入输出都是opus的rtp时间戳(48k时钟)，各个桥按自己收到的第一个音频包换算，共享转码不影响音视频同步
+        int64_t pts = 0;
+    };
+    using OutputCb = std::function<void(std::shared_ptr<std::vector<Frame>> frames)>;
+
+    class Pipeline {
+    public:
+        virtual ~Pipeline() = default;
+        virtual bool init(const std::string & config, int32_t sample_rate, int32_t channels) = 0;
+        virtual void process(const Frame & in, std::vector<Frame> & out) = 0;
+        // 输出编码器的配置，OPUS_TO_AAC为AudioSpecificConfig
+        virtual std::string get_out_config() {
+            return "";
+        }
+        // 输出的音频时长
+        virtual int64_t get_out_duration_ms() = 0;
+    };
+
+    AudioTranscoder(ThreadWorker *worker, Type type, const std::string & key);
+    virtual ~AudioTranscoder();
+
+    Type get_type() const {
+        return type_;
+    }
+
+    const std::string & get_key() const {
+        return key_;
+    }
+
+    void attach(void *owner, const OutputCb & cb);
+    void detach(void *owner);
+    // 参数变化(如新的aac sequence header)时重建转码链路，config对AAC_TO_OPUS为AudioSpecificConfig
+    // 只有送数据的桥能重建，其他桥在还没配置过时才生效
+    // 编码器在调用线程上创建好再交给转码线程，返回时即可取get_out_config
+    bool configure(void *owner, const std::string & config, int32_t sample_rate, int32_t channels);
+    void feed(void *owner, Frame frame);
+    std::string get_out_config();
+    // OPUS_TO_AAC输出的rtp时间戳换算成相对first_rtp_ts的毫秒，早于first_rtp_ts(本桥加入之前缓冲的pcm)返回-1
+    static int64_t rtp_ts_to_ms(int64_t pts, uint32_t first_rtp_ts) {
+        int32_t diff = (int32_t)((uint32_t)pts - first_rtp_ts);
+        return diff < 0 ? -1 : diff / 48;
+    }
+
+    Json::Value to_json();
+private:
+    bool is_feeder(void *owner);
+    void process(const Frame & frame);
+private:
+    ThreadWorker *worker_;
+    Type type_;
+    std::string key_;
+
+    std::mutex mtx_;
+    std::vector<std::pair<void *, OutputCb>> outputs_; // 第一个为送数据的桥
+    std::string out_config_;
+    bool configured_ = false;
+
+    std::shared_ptr<Pipeline> pipeline_; // 只在worker_上访问
+    int64_t out_duration_base_ms_ = 0; // 之前的链路累计的输出时长，worker_上访问
+
+    static constexpr int32_t MAX_PENDING_FRAMES = 500; // 转码线程积压超过约10s的输入后丢弃
+    std::atomic<int32_t> pending_frames_{0};
+    std::atomic<uint64_t> dropped_frames_{0};
+    std::atomic<uint64_t> in_frames_{0};
+    std::atomic<uint64_t> out_frames_{0};
+    std::atomic<uint64_t> cpu_us_{0};
+    std::atomic<int64_t> out_duration_ms_{0};
+};
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+
+namespace mms {
+// 交织的16位pcm环形缓冲，按样本(所有通道合计)计数
+// 重采样直接写进环里，编码按帧从环里取，取帧跨过环尾时才拷贝一次拼成连续的一帧，不再整体memmove
+class PcmRingBuffer {
+public:
+    PcmRingBuffer(size_t capacity, size_t max_frame) : capacity_(capacity), max_frame_(max_frame) {
+        buf_ = std::make_unique<int16_t[]>(capacity_);
+        frame_buf_ = std::make_unique<int16_t[]>(max_frame_);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t space() const {
+        return capacity_ - size_;
+    }
+
+    // 可连续写入的位置和长度，写完调用commit
+    int16_t *write_ptr(size_t & contiguous) {
+        size_t w = (read_pos_ + size_) % capacity_;
+        contiguous = std::min(space(), capacity_ - w);
+        return buf_.get() + w;
+    }
+
+    void commit(size_t samples) {
+        size_ += samples;
+    }
+
+    bool write(const int16_t *data, size_t samples) {
+        if (samples > space()) {
+            return false;
+        }
+
+        while (samples > 0) {
+            size_t contiguous;
+            int16_t *p = write_ptr(contiguous);
+            size_t n = std::min(contiguous, samples);
+            memcpy(p, data, n * sizeof(int16_t));
+            commit(n);
+            data += n;
+            samples -= n;
+        }
+        return true;
+    }
+
+    // 取连续的一帧，不足一帧或超过max_frame返回nullptr，用完调用consume
+    const int16_t *peek(size_t samples) {
+        if (samples > size_ || samples > max_frame_) {
+            return nullptr;
+        }
+
+        if (read_pos_ + samples <= capacity_) {
+            return buf_.get() + read_pos_;
+        }
+
+        size_t first = capacity_ - read_pos_;
+        memcpy(frame_buf_.get(), buf_.get() + read_pos_, first * sizeof(int16_t));
+        memcpy(frame_buf_.get() + first, buf_.get(), (samples - first) * sizeof(int16_t));
+        return frame_buf_.get();
+    }
+
+    void consume(size_t samples) {
+        samples = std::min(samples, size_);
+        read_pos_ = (read_pos_ + samples) % capacity_;
+        size_ -= samples;
+    }
+
+    void clear() {
+        read_pos_ = 0;
+        size_ = 0;
+    }
+private:
+    std::unique_ptr<int16_t[]> buf_;
+    std::unique_ptr<int16_t[]> frame_buf_;
+    size_t capacity_;
+    size_t max_frame_;
+    size_t read_pos_ = 0;
+    size_t size_ = 0;
+};
+};
@@ -0,0 +1,242 @@
+// Annex-B扫描：各个simd实现与逐字节实现结果一致，起始码切分及长度前缀<->Annex-B互转
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "codec/annexb.hpp"
+#include "codec/media_frame.hpp"
+
+using namespace mms;
+
+namespace {
+const char *IMPLS[] = {"scalar", "sse2", "avx2"};
+
+// 逐字节的参考实现
+const uint8_t *ref_find_zero_pair(const uint8_t *p, const uint8_t *end) {
+    for (; p + 1 < end; p++) {
+        if (p[0] == 0x00 && p[1] == 0x00) {
+            return p;
+        }
+    }
+    return end;
+}
+
+// 按标准的做法：连续两个以上的0之后的03去掉，去掉后重新计数
+std::string ref_remove_emulation_prevention(std::string_view in) {
+    std::string out;
+    int32_t zeros = 0;
+    for (auto c : in) {
+        if (zeros >= 2 && c == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        zeros = c == 0x00 ? zeros + 1 : 0;
+        out.push_back(c);
+    }
+    return out;
+}
+
+std::string join(const std::vector<std::string_view> & segs) {
+    std::string s;
+    for (auto & seg : segs) {
+        s.append(seg);
+    }
+    return s;
+}
+
+// zero_percent为每个字节取0的百分比，越大00 00越密集
+std::string random_bytes(std::mt19937 & rng, size_t len, int32_t zero_percent) {
+    std::string s(len, '\0');
+    for (auto & c : s) {
+        c = (int32_t)(rng() % 100) < zero_percent ? 0x00 : (char)(rng() % 255 + 1);
+    }
+    return s;
+}
+
+// 不含00 00的nalu，相当于已经加了防竞争字节
+std::string random_nalu(std::mt19937 & rng, size_t len) {
+    std::string s = random_bytes(rng, len, 20);
+    s[0] = 0x65;
+    for (size_t i = 1; i < s.size(); i++) {
+        if (s[i] == 0x00 && s[i - 1] == 0x00) {
+            s[i] = 0x03;
+        }
+    }
+    if (s.back() == 0x00) {
+        s.back() = 0x80;
+    }
+    return s;
+}
+
+class AnnexbTest : public testing::Test {
+protected:
+    void TearDown() override {
+        set_annexb_scan_impl(default_impl_.c_str());
+    }
+
+    // 遍历cpu支持的实现
+    template <typename F>
+    void for_each_impl(F f) {
+        int32_t tested = 0;
+        for (auto name : IMPLS) {
+            if (!set_annexb_scan_impl(name)) {
+                continue;
+            }
+            SCOPED_TRACE(name);
+            f();
+            tested++;
+        }
+        EXPECT_GE(tested, 1);
+    }
+
+    std::string default_impl_ = annexb_scan_impl();
+};
+};
+
+TEST_F(AnnexbTest, DefaultImplIsSupported) {
+    EXPECT_TRUE(set_annexb_scan_impl(annexb_scan_impl()));
+    EXPECT_TRUE(set_annexb_scan_impl("scalar"));
+    EXPECT_FALSE(set_annexb_scan_impl("neon512"));
+    EXPECT_STREQ(annexb_scan_impl(), "scalar");
+}
+
+// 单个00 00出现在每个位置，覆盖跨16/32字节块边界及非对齐起始地址
+TEST_F(AnnexbTest, ZeroPairAtEveryPosition) {
+    for_each_impl([]() {
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t len = 2; len <= 100; len++) {
+                for (size_t pos = 0; pos + 1 < len; pos++) {
+                    std::string buf(offset + len, '\xff');
+                    buf[offset + pos] = 0x00;
+                    buf[offset + pos + 1] = 0x00;
+                    const uint8_t *p = (const uint8_t *)buf.data() + offset;
+                    ASSERT_EQ(find_zero_pair(p, p + len) - p, (ptrdiff_t)pos) << "offset " << offset << " len " << len;
+                }
+            }
+        }
+    });
+}
+
+// 单个00紧挨在块边界前后，不能误判为00 00
+TEST_F(AnnexbTest, SingleZeroAtBlockBoundary) {
+    for_each_impl([]() {
+        for (size_t pos : {14, 15, 16, 17, 30, 31, 32, 33, 63, 64}) {
+            std::string buf(97, '\x01');
+            buf[pos] = 0x00;
+            const uint8_t *p = (const uint8_t *)buf.data();
+            ASSERT_EQ(find_zero_pair(p, p + buf.size()), p + buf.size()) << "pos " << pos;
+            // 连续的00跨越边界
+            buf[pos + 1] = 0x00;
+            ASSERT_EQ(find_zero_pair(p, p + buf.size()), p + pos) << "pos " << pos;
+        }
+    });
+}
+
+TEST_F(AnnexbTest, RandomAgainstReference) {
+    std::mt19937 rng(12345);
+    for_each_impl([&rng]() {
+        for (int32_t round = 0; round < 2000; round++) {
+            size_t len = rng() % 300;
+            auto buf = random_bytes(rng, len, round % 60);
+            const uint8_t *p = (const uint8_t *)buf.data();
+            const uint8_t *end = p + buf.size();
+            // 逐个找出所有00 00，每次从上一个之后开始
+            const uint8_t *q = p;
+            while (true) {
+                const uint8_t *expected = ref_find_zero_pair(q, end);
+                ASSERT_EQ(find_zero_pair(q, end), expected) << "round " << round;
+                if (expected == end) {
+                    break;
+                }
+                q = expected + 1;
+            }
+            std::string removed;
+            remove_emulation_prevention(buf, removed);
+            ASSERT_EQ(removed, ref_remove_emulation_prevention(buf)) << "round " << round;
+        }
+    });
+}
+
+TEST_F(AnnexbTest, FindStartCode) {
+    for_each_impl([]() {
+        std::string buf("\x11\x00\x00\x02\x00\x00\x00\x01\x65\x00\x00\x01\x41", 13);
+        const uint8_t *p = (const uint8_t *)buf.data();
+        const uint8_t *end = p + buf.size();
+        int32_t sc_len = 0;
+        const uint8_t *q = find_start_code(p, end, sc_len);
+        ASSERT_EQ(q - p, 4);
+        EXPECT_EQ(sc_len, 4);
+        q = find_start_code(q + sc_len, end, sc_len);
+        ASSERT_EQ(q - p, 9);
+        EXPECT_EQ(sc_len, 3);
+        EXPECT_EQ(find_start_code(q + sc_len, end, sc_len), end);
+        // 末尾不完整的起始码
+        std::string tail("\x65\x00\x00", 3);
+        p = (const uint8_t *)tail.data();
+        EXPECT_EQ(find_start_code(p, p + tail.size(), sc_len), p + tail.size());
+    });
+}
+
+TEST_F(AnnexbTest, SplitAnnexb) {
+    std::mt19937 rng(678);
+    for_each_impl([&rng]() {
+        for (int32_t round = 0; round < 500; round++) {
+            std::vector<std::string> nalus;
+            std::string stream;
+            int32_t count = rng() % 8 + 1;
+            for (int32_t i = 0; i < count; i++) {
+                nalus.emplace_back(random_nalu(rng, rng() % 200 + 1));
+                stream.append(rng() % 2 ? std::string("\x00\x00\x00\x01", 4) : std::string("\x00\x00\x01", 3));
+                stream.append(nalus.back());
+                if (rng() % 4 == 0) {// trailing_zero_8bits
+                    stream.append(rng() % 3 + 1, '\x00');
+                }
+            }
+
+            std::vector<std::string_view> out;
+            split_annexb(stream, out);
+            ASSERT_EQ(out.size(), nalus.size()) << "round " << round;
+            for (size_t i = 0; i < nalus.size(); i++) {
+                ASSERT_EQ(out[i], nalus[i]) << "round " << round << " nalu " << i;
+            }
+        }
+    });
+}
+
+// avcc -> nalu列表 -> Annex-B -> nalu列表 -> avcc，数据不变
+TEST_F(AnnexbTest, LengthPrefixedRoundTrip) {
+    std::mt19937 rng(91011);
+    for_each_impl([&rng]() {
+        for (int32_t round = 0; round < 200; round++) {
+            std::string avcc;
+            int32_t count = rng() % 10 + 1;
+            for (int32_t i = 0; i < count; i++) {
+                auto nalu = random_nalu(rng, rng() % 3000 + 1);
+                uint32_t len = nalu.size();
+                avcc.push_back((char)(len >> 24));
+                avcc.push_back((char)(len >> 16));
+                avcc.push_back((char)(len >> 8));
+                avcc.push_back((char)len);
+                avcc.append(nalu);
+            }
+
+            std::vector<std::string_view> nalus;
+            ASSERT_EQ(split_nalus((const uint8_t *)avcc.data(), avcc.size(), 4, nalus), (int32_t)avcc.size());
+            std::vector<std::string_view> annexb_segs;
+            append_annexb_segs(nalus, annexb_segs);
+            std::string annexb = join(annexb_segs);
+
+            std::vector<std::string_view> nalus2;
+            split_annexb(annexb, nalus2);
+            ASSERT_EQ(nalus2.size(), nalus.size());
+            std::string len_buf;
+            std::vector<std::string_view> avcc_segs;
+            append_length_prefixed_segs(nalus2, len_buf, avcc_segs);
+            ASSERT_EQ(join(avcc_segs), avcc) << "round " << round;
+        }
+    });
+}
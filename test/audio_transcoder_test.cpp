@@ -0,0 +1,137 @@
+// AudioTranscoder两条转码链路的输出帧和时间戳
+#include <math.h>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <gtest/gtest.h>
+
+#include "base/thread/thread_worker.hpp"
+#include "codec/aac/aac_encoder.hpp"
+#include "codec/opus/opus_encoder.hpp"
+#include "transcode/audio_transcoder.hpp"
+
+using namespace mms;
+
+namespace {
+// 交织的双声道正弦波
+std::vector<int16_t> make_pcm(int32_t sample_rate, int32_t seconds) {
+    std::vector<int16_t> pcm((size_t)sample_rate * seconds * 2);
+    for (size_t i = 0; i < pcm.size() / 2; i++) {
+        int16_t v = (int16_t)(8000 * sin(2 * M_PI * 440 * i / sample_rate));
+        pcm[2 * i] = v;
+        pcm[2 * i + 1] = v;
+    }
+    return pcm;
+}
+
+class AudioTranscoderTest : public testing::Test {
+protected:
+    void SetUp() override {
+        worker_.start();
+    }
+
+    void TearDown() override {
+        worker_.stop();
+    }
+
+    void drain() {
+        std::promise<void> done;
+        boost::asio::post(worker_.get_io_context(), [&done]() {
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+
+    ThreadWorker worker_;
+};
+};
+
+TEST_F(AudioTranscoderTest, AacToOpus) {
+    AACEncoder encoder;
+    ASSERT_TRUE(encoder.init(44100, 2));
+    auto pcm = make_pcm(44100, 2);
+    size_t frame_samples = encoder.get_input_samples();
+    std::vector<AudioTranscoder::Frame> in;
+    uint8_t buf[8192];
+    for (size_t off = 0; off + frame_samples <= pcm.size(); off += frame_samples) {
+        int32_t bytes = encoder.encode_frame(pcm.data() + off, buf, sizeof(buf));
+        if (bytes > 0) {
+            AudioTranscoder::Frame f;
+            f.data.assign((char *)buf, bytes);
+            in.emplace_back(std::move(f));
+        }
+    }
+    ASSERT_FALSE(in.empty());
+
+    auto transcoder = std::make_shared<AudioTranscoder>(&worker_, AudioTranscoder::AAC_TO_OPUS, "test");
+    std::vector<AudioTranscoder::Frame> out;
+    std::mutex mtx;
+    transcoder->attach(this, [&out, &mtx](std::shared_ptr<std::vector<AudioTranscoder::Frame>> fs) {
+        std::lock_guard<std::mutex> lck(mtx);
+        out.insert(out.end(), fs->begin(), fs->end());
+    });
+    ASSERT_TRUE(transcoder->configure(this, encoder.get_specific_configuration(), 44100, 2));
+    for (auto & f : in) {
+        transcoder->feed(this, f);
+    }
+    drain();
+    transcoder->detach(this);
+
+    // 每帧20ms，时间戳按48k连续递增，编解码延时会少几帧
+    std::lock_guard<std::mutex> lck(mtx);
+    ASSERT_GE(out.size(), 90u);
+    ASSERT_LE(out.size(), 100u);
+    for (size_t i = 0; i < out.size(); i++) {
+        EXPECT_FALSE(out[i].data.empty());
+        EXPECT_EQ(out[i].pts, (int64_t)i * 960);
+    }
+    EXPECT_EQ(transcoder->to_json()["out_ms"].asInt64(), (int64_t)out.size() * 20);
+}
+
+TEST_F(AudioTranscoderTest, OpusToAac) {
+    MOpusEncoder encoder;
+    ASSERT_TRUE(encoder.init(48000, 2));
+    auto pcm = make_pcm(48000, 2);
+    std::vector<AudioTranscoder::Frame> in;
+    uint8_t buf[4000];
+    for (size_t off = 0; off + 960 * 2 <= pcm.size(); off += 960 * 2) {
+        int32_t bytes = encoder.encode((uint8_t *)(pcm.data() + off), 960, buf, sizeof(buf));
+        ASSERT_GT(bytes, 0);
+        AudioTranscoder::Frame f;
+        f.data.assign((char *)buf, bytes);
+        // 任意的起始rtp时间戳
+        f.pts = 123456 + (int64_t)in.size() * 960;
+        in.emplace_back(std::move(f));
+    }
+
+    auto transcoder = std::make_shared<AudioTranscoder>(&worker_, AudioTranscoder::OPUS_TO_AAC, "test");
+    std::vector<AudioTranscoder::Frame> out;
+    std::mutex mtx;
+    transcoder->attach(this, [&out, &mtx](std::shared_ptr<std::vector<AudioTranscoder::Frame>> fs) {
+        std::lock_guard<std::mutex> lck(mtx);
+        out.insert(out.end(), fs->begin(), fs->end());
+    });
+    ASSERT_TRUE(transcoder->configure(this, "", 48000, 2));
+    // 44.1k双声道的AudioSpecificConfig
+    EXPECT_EQ(transcoder->get_out_config().size(), 2u);
+    for (auto & f : in) {
+        transcoder->feed(this, f);
+    }
+    drain();
+    transcoder->detach(this);
+
+    // 2s共约86个1024样本的aac帧，输出时间戳仍是输入的rtp时钟，相邻帧相差约1024*48000/44100
+    std::lock_guard<std::mutex> lck(mtx);
+    ASSERT_GE(out.size(), 80u);
+    ASSERT_LE(out.size(), 87u);
+    EXPECT_GE(out[0].pts, 123456);
+    for (size_t i = 1; i < out.size(); i++) {
+        int64_t diff = out[i].pts - out[i - 1].pts;
+        EXPECT_GE(diff, 1110) << "at " << i;
+        EXPECT_LE(diff, 1120) << "at " << i;
+    }
+}
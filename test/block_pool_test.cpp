@@ -0,0 +1,161 @@
+// BlockPool的引用计数及复用，以及ts/mp4切片的数据块在切片释放后归还到池中
+// 池是进程内单例，只比较前后的变化量
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/block_pool.h"
+#include "protocol/mp4/m4s_segment.h"
+#include "protocol/ts/ts_segment.hpp"
+
+using namespace mms;
+
+namespace {
+std::string join(const std::vector<std::string_view> & bufs) {
+    std::string s;
+    for (auto & b : bufs) {
+        s.append(b);
+    }
+    return s;
+}
+
+std::string make_data(size_t n, uint8_t seed) {
+    std::string s(n, '\0');
+    for (size_t i = 0; i < n; i++) {
+        s[i] = (char)(seed + i * 7);
+    }
+    return s;
+}
+};
+
+TEST(BlockPoolTest, ReuseAfterLastReference) {
+    auto & pool = BlockPool::get_instance();
+    size_t used = pool.get_used_blocks();
+
+    auto block = pool.alloc();
+    ASSERT_NE(block, nullptr);
+    uint8_t *raw = block.get();
+    EXPECT_EQ(pool.get_used_blocks(), used + 1);
+
+    // 还有其他引用时不回收
+    auto copy = block;
+    block.reset();
+    EXPECT_EQ(pool.get_used_blocks(), used + 1);
+
+    size_t free_blocks = pool.get_free_blocks();
+    copy.reset();
+    EXPECT_EQ(pool.get_used_blocks(), used);
+    EXPECT_EQ(pool.get_free_blocks(), free_blocks + 1);
+
+    // 最近归还的块最先被复用
+    auto again = pool.alloc();
+    EXPECT_EQ(again.get(), raw);
+    EXPECT_EQ(pool.get_free_blocks(), free_blocks);
+}
+
+TEST(BlockPoolTest, TsSegmentReturnsBlocks) {
+    auto & pool = BlockPool::get_instance();
+    size_t used = pool.get_used_blocks();
+    const size_t pkts_per_block = BlockPool::BLOCK_SIZE / 188;
+    const size_t pkt_count = pkts_per_block * 2 + 10;
+
+    std::string expected;
+    {
+        auto seg = std::make_shared<TsSegment>();
+        for (size_t i = 0; i < pkt_count; i++) {
+            auto pkt = seg->alloc_ts_packet();
+            auto data = make_data(188, (uint8_t)i);
+            memcpy((char *)pkt.data(), data.data(), 188);
+            expected.append(data);
+        }
+        EXPECT_EQ(seg->get_ts_bytes(), (int64_t)(pkt_count * 188));
+        // 每块放整数个ts包
+        auto bufs = seg->get_ts_data();
+        ASSERT_EQ(bufs.size(), 3u);
+        EXPECT_EQ(bufs[0].size(), pkts_per_block * 188);
+        EXPECT_EQ(bufs[2].size(), 10u * 188);
+        EXPECT_EQ(join(bufs), expected);
+        EXPECT_EQ(pool.get_used_blocks(), used + 3);
+
+        // 切片释放后所有块归还到池中
+        size_t free_blocks = pool.get_free_blocks();
+        seg.reset();
+        EXPECT_EQ(pool.get_used_blocks(), used);
+        EXPECT_EQ(pool.get_free_blocks(), free_blocks + 3);
+    }
+
+    // 新切片复用刚归还的块，不再新申请
+    size_t free_blocks = pool.get_free_blocks();
+    auto seg = std::make_shared<TsSegment>();
+    EXPECT_EQ(pool.get_free_blocks(), free_blocks - 1);
+    EXPECT_EQ(pool.get_used_blocks(), used + 1);
+}
+
+TEST(BlockPoolTest, Mp4SegmentAcrossBlocks) {
+    auto & pool = BlockPool::get_instance();
+    size_t used = pool.get_used_blocks();
+    std::string expected;
+    {
+        Mp4Segment seg;
+        // box头部要求连续空间
+        auto header = seg.alloc_buffer(8);
+        memcpy((char *)header.data(), "\x00\x02\x49\xf8mdat", 8);
+        expected.append(header);
+
+        // mdat负载跨块存放
+        auto payload = make_data(BlockPool::BLOCK_SIZE * 2, 1);
+        seg.append(payload);
+        expected.append(payload);
+        EXPECT_EQ(pool.get_used_blocks(), used + 3);
+
+        // 超过块大小的连续空间单独分配，不占用池
+        auto big = seg.alloc_buffer(BlockPool::BLOCK_SIZE + 1);
+        auto big_data = make_data(big.size(), 2);
+        memcpy((char *)big.data(), big_data.data(), big.size());
+        expected.append(big_data);
+        EXPECT_EQ(pool.get_used_blocks(), used + 3);
+
+        EXPECT_EQ(seg.get_bytes(), (int64_t)expected.size());
+        EXPECT_EQ(join(seg.get_used_bufs()), expected);
+        EXPECT_EQ(join(seg.get_used_bufs(100)), expected.substr(100));
+        EXPECT_EQ(join(seg.get_used_bufs(BlockPool::BLOCK_SIZE + 3)), expected.substr(BlockPool::BLOCK_SIZE + 3));
+        EXPECT_TRUE(seg.get_used_bufs(expected.size()).empty());
+    }
+    EXPECT_EQ(pool.get_used_blocks(), used);
+}
+
+TEST(BlockPoolTest, Mp4SegmentMergeChunks) {
+    auto & pool = BlockPool::get_instance();
+    size_t used = pool.get_used_blocks();
+    {
+        Mp4Segment seg;
+        auto c1 = std::make_shared<const std::string>(make_data(40000, 3));
+        auto c2 = std::make_shared<const std::string>(make_data(40000, 4));
+        seg.add_chunk(c1);
+        seg.add_chunk(c2);
+
+        // 读者拿到的是chunk的引用
+        std::vector<std::shared_ptr<const std::string>> chunks;
+        EXPECT_FALSE(seg.get_chunks(0, chunks));
+        ASSERT_EQ(chunks.size(), 2u);
+        EXPECT_EQ(chunks[0], c1);
+        EXPECT_EQ(c1.use_count(), 3);
+
+        // 合并进池中的块后释放chunk，正在发送的读者仍持有引用
+        seg.merge_chunks();
+        seg.set_reaped();
+        EXPECT_EQ(c1.use_count(), 2);
+        EXPECT_EQ(pool.get_used_blocks(), used + 2);
+        EXPECT_EQ(join(seg.get_used_bufs()), *c1 + *c2);
+
+        chunks.clear();
+        EXPECT_TRUE(seg.get_chunks(0, chunks));
+        EXPECT_TRUE(chunks.empty());
+    }
+    EXPECT_EQ(pool.get_used_blocks(), used);
+}
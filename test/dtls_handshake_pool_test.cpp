@@ -0,0 +1,198 @@
+// DtlsHandshakePool的名额、排队、取消及Permit归还
+// 池是进程内单例，每个用例结束时名额和队列都必须归零，否则会影响后面的用例
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_future.hpp>
+#include <gtest/gtest.h>
+
+#include "base/thread/thread_worker.hpp"
+#include "server/webrtc/dtls/dtls_handshake_pool.hpp"
+
+using namespace mms;
+
+namespace {
+enum ExitPath {
+    EXIT_EARLY = 0,// 对应会话已关闭等提前返回
+    EXIT_EXCEPTION,// 握手协程抛异常
+    EXIT_RELEASE_EARLY,// 握手结束先归还名额，再做其他事
+};
+
+// 与DtlsBoringSSLSession::do_handshake相同的名额用法
+boost::asio::awaitable<int32_t> fake_handshake(DtlsHandshakePool & pool, ThreadWorker *worker, ExitPath exit_path) {
+    std::shared_ptr<DtlsHandshakePool::Waiter> waiter;
+    if (!co_await pool.acquire(worker, waiter)) {
+        co_return -1;
+    }
+    DtlsHandshakePool::Permit permit(pool);
+
+    if (exit_path == EXIT_EARLY) {
+        co_return -13;
+    }
+
+    if (exit_path == EXIT_EXCEPTION) {
+        throw std::runtime_error("handshake failed");
+    }
+
+    permit.release();
+    co_return 0;
+}
+
+class DtlsHandshakePoolTest : public testing::Test {
+protected:
+    void SetUp() override {
+        worker_.start();
+    }
+
+    void TearDown() override {
+        EXPECT_EQ(pool_.get_active_handshakes(), 0);
+        EXPECT_EQ(pool_.get_queued_handshakes(), 0);
+        worker_.stop();
+    }
+
+    std::future<bool> acquire(std::shared_ptr<DtlsHandshakePool::Waiter> & waiter) {
+        return boost::asio::co_spawn(worker_.get_io_context(), pool_.acquire(&worker_, waiter), boost::asio::use_future);
+    }
+
+    // acquire在worker线程上执行，等到队列长度达到n
+    bool wait_queued(int32_t n) {
+        for (int i = 0; i < 1000; i++) {
+            if (pool_.get_queued_handshakes() == n) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    static bool is_ready(std::future<bool> & f) {
+        return f.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+    }
+
+    ThreadWorker worker_;
+    DtlsHandshakePool & pool_ = DtlsHandshakePool::get_instance();
+};
+};
+
+TEST_F(DtlsHandshakePoolTest, QueueFullRejected) {
+    pool_.start(0, 1, 1, 5000);
+    std::shared_ptr<DtlsHandshakePool::Waiter> w1, w2, w3;
+    ASSERT_TRUE(acquire(w1).get());
+    EXPECT_EQ(w1, nullptr);
+    EXPECT_EQ(pool_.get_active_handshakes(), 1);
+
+    auto f2 = acquire(w2);
+    ASSERT_TRUE(wait_queued(1));
+    EXPECT_NE(w2, nullptr);
+
+    // 名额和队列都满了，立即拒绝，不进队列
+    uint64_t rejected = pool_.get_rejected_handshakes();
+    EXPECT_FALSE(acquire(w3).get());
+    EXPECT_EQ(w3, nullptr);
+    EXPECT_EQ(pool_.get_rejected_handshakes(), rejected + 1);
+    EXPECT_EQ(pool_.get_queued_handshakes(), 1);
+
+    // 名额直接转给排队的会话，占用数不变
+    pool_.release();
+    ASSERT_TRUE(is_ready(f2));
+    EXPECT_TRUE(f2.get());
+    EXPECT_EQ(pool_.get_active_handshakes(), 1);
+    EXPECT_EQ(pool_.get_queued_handshakes(), 0);
+
+    pool_.release();
+}
+
+TEST_F(DtlsHandshakePoolTest, ReleaseGrantsInOrder) {
+    pool_.start(0, 1, 4, 5000);
+    std::shared_ptr<DtlsHandshakePool::Waiter> w1, w2, w3;
+    ASSERT_TRUE(acquire(w1).get());
+    auto f2 = acquire(w2);
+    ASSERT_TRUE(wait_queued(1));
+    auto f3 = acquire(w3);
+    ASSERT_TRUE(wait_queued(2));
+
+    pool_.release();
+    ASSERT_TRUE(is_ready(f2));
+    EXPECT_TRUE(f2.get());
+    EXPECT_EQ(f3.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+    pool_.release();
+    ASSERT_TRUE(is_ready(f3));
+    EXPECT_TRUE(f3.get());
+
+    pool_.release();
+}
+
+TEST_F(DtlsHandshakePoolTest, CancelWhileQueued) {
+    pool_.start(0, 1, 4, 5000);
+    std::shared_ptr<DtlsHandshakePool::Waiter> w1, w2;
+    ASSERT_TRUE(acquire(w1).get());
+    auto f2 = acquire(w2);
+    ASSERT_TRUE(wait_queued(1));
+
+    // 会话关闭时取消排队，不算作拒绝
+    uint64_t rejected = pool_.get_rejected_handshakes();
+    pool_.cancel(w2);
+    ASSERT_TRUE(is_ready(f2));
+    EXPECT_FALSE(f2.get());
+    EXPECT_EQ(pool_.get_queued_handshakes(), 0);
+    EXPECT_EQ(pool_.get_rejected_handshakes(), rejected);
+
+    // 已取消的会话不会再拿到名额
+    pool_.release();
+    EXPECT_EQ(pool_.get_active_handshakes(), 0);
+}
+
+TEST_F(DtlsHandshakePoolTest, QueueTimeout) {
+    pool_.start(0, 1, 4, 50);
+    std::shared_ptr<DtlsHandshakePool::Waiter> w1, w2;
+    ASSERT_TRUE(acquire(w1).get());
+
+    uint64_t rejected = pool_.get_rejected_handshakes();
+    auto f2 = acquire(w2);
+    ASSERT_TRUE(is_ready(f2));
+    EXPECT_FALSE(f2.get());
+    EXPECT_EQ(pool_.get_queued_handshakes(), 0);
+    EXPECT_EQ(pool_.get_rejected_handshakes(), rejected + 1);
+
+    pool_.release();
+}
+
+TEST_F(DtlsHandshakePoolTest, PermitReleasedOnEveryExitPath) {
+    pool_.start(0, 2, 4, 5000);
+    // 先占住一个名额，重复release时占用数会变成0，能被发现
+    std::shared_ptr<DtlsHandshakePool::Waiter> w1;
+    ASSERT_TRUE(acquire(w1).get());
+
+    auto run = [this](ExitPath exit_path) {
+        return boost::asio::co_spawn(worker_.get_io_context(), fake_handshake(pool_, &worker_, exit_path), boost::asio::use_future);
+    };
+
+    EXPECT_EQ(run(EXIT_EARLY).get(), -13);
+    EXPECT_EQ(pool_.get_active_handshakes(), 1);
+
+    EXPECT_THROW(run(EXIT_EXCEPTION).get(), std::runtime_error);
+    EXPECT_EQ(pool_.get_active_handshakes(), 1);
+
+    EXPECT_EQ(run(EXIT_RELEASE_EARLY).get(), 0);
+    EXPECT_EQ(pool_.get_active_handshakes(), 1);
+
+    pool_.release();
+}
+
+TEST_F(DtlsHandshakePoolTest, PermitHandsSlotToQueued) {
+    pool_.start(0, 1, 4, 5000);
+    std::shared_ptr<DtlsHandshakePool::Waiter> w1;
+    ASSERT_TRUE(acquire(w1).get());
+    auto f2 = boost::asio::co_spawn(worker_.get_io_context(), fake_handshake(pool_, &worker_, EXIT_EARLY), boost::asio::use_future);
+    ASSERT_TRUE(wait_queued(1));
+
+    // 排队的握手拿到名额后提前返回，名额随Permit析构归还
+    pool_.release();
+    ASSERT_EQ(f2.wait_for(std::chrono::seconds(2)), std::future_status::ready);
+    EXPECT_EQ(f2.get(), -13);
+    EXPECT_EQ(pool_.get_active_handshakes(), 0);
+}
@@ -0,0 +1,256 @@
+// FlexFEC各保护等级下每个冗余包恢复一个丢失的媒体包，包括订阅者发送时异或进transport-cc序号的修正
+// 发送端与WebRtcServerSession相同：媒体包带transport-cc扩展发出，冗余包按所保护的包实际发出的序号调用xor_twcc_seq
+// 接收端按draft-ietf-payload-flexible-fec-scheme-03恢复，与浏览器的做法相同
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "protocol/rtp/rtp_flexfec_encoder.h"
+
+using namespace mms;
+
+namespace {
+const uint8_t TWCC_EXT_ID = 3;// 与WebRtcServerSession::TWCC_EXT_ID相同
+const uint32_t MEDIA_SSRC = 0x1234;
+const uint32_t FEC_SSRC = 0x5678;
+const uint16_t FIRST_SEQ = 65500;// 跨过序号回绕
+const uint16_t FIRST_TWCC_SEQ = 40000;
+
+struct Level {
+    size_t group_pkts;
+    size_t fec_pkts;
+};
+// 与webrtc_media_source.cpp中VIDEO_FEC_LEVEL_TABLE的1-4级相同
+const Level LEVELS[] = {{10, 1}, {10, 2}, {9, 3}, {8, 4}};
+
+struct FecPkt {
+    std::string payload;
+    uint16_t base_seq = 0;
+    uint16_t mask = 0;
+};
+
+struct Sent {
+    std::map<uint16_t, std::string> media;// 序号 -> 发出的包
+    std::vector<FecPkt> fecs;
+    std::map<uint16_t, uint16_t> twcc_seqs;// 媒体序号 -> transport-cc序号
+    size_t media_count = 0;
+};
+
+std::shared_ptr<RtpPacket> make_pkt(uint16_t seq, uint32_t ts, bool marker, uint8_t csrc) {
+    auto pkt = std::make_shared<RtpPacket>();
+    auto & header = pkt->get_header();
+    header.pt = 96;
+    header.marker = marker;
+    header.seqnum = seq;
+    header.timestamp = ts;
+    header.ssrc = MEDIA_SSRC;
+    header.csrc = csrc;
+    for (uint8_t i = 0; i < csrc; i++) {
+        header.csrcs.push_back(0x1000 + i);
+    }
+    // 负载长度各不相同，恢复时依赖长度恢复字段
+    size_t len = 100 + (seq * 37) % 1100;
+    pkt->payload_ = new char[len];
+    pkt->payload_len_ = len;
+    for (size_t i = 0; i < len; i++) {
+        pkt->payload_[i] = (char)(seq + i * 7);
+    }
+    return pkt;
+}
+
+// 按帧生成媒体包送入编码器，模拟一个订阅者发送：媒体包及冗余包都占用transport-cc序号
+Sent send(const Level & level, uint8_t csrc, bool xor_twcc) {
+    Sent sent;
+    RtpFlexFecEncoder encoder(FEC_SSRC, TWCC_EXT_ID, level.group_pkts, level.fec_pkts);
+    // 每帧的包数，包括不足MIN_GROUP_PKTS的小帧
+    const std::vector<int32_t> frame_pkts{14, 1, 2, 5, 3, 9, 1, 1, 1, 12, 4, 7};
+    uint16_t seq = FIRST_SEQ;
+    uint16_t twcc_seq = FIRST_TWCC_SEQ;
+    auto & twcc_seqs = sent.twcc_seqs;
+    uint8_t buf[1500];
+    std::vector<std::shared_ptr<RtpPacket>> fec_pkts;
+    auto send_fec_pkts = [&]() {
+        for (auto & fec_pkt : fec_pkts) {
+            FecPkt f;
+            f.payload.assign(fec_pkt->payload_, fec_pkt->payload_len_);
+            uint8_t *p = (uint8_t *)f.payload.data();
+            EXPECT_TRUE(RtpFlexFecEncoder::get_protected_seqs(p, f.payload.size(), f.base_seq, f.mask));
+            if (xor_twcc) {
+                for (uint16_t offset = 0; offset < RtpFlexFecEncoder::MAX_GROUP_PKTS; offset++) {
+                    if (f.mask & (1 << (14 - offset))) {
+                        RtpFlexFecEncoder::xor_twcc_seq(p, f.payload.size(), csrc, twcc_seqs[f.base_seq + offset]);
+                    }
+                }
+            }
+            sent.fecs.push_back(std::move(f));
+            twcc_seq++;
+        }
+        fec_pkts.clear();
+    };
+
+    uint32_t ts = 0;
+    for (int32_t round = 0; round < 3; round++) {
+        for (auto count : frame_pkts) {
+            for (int32_t i = 0; i < count; i++) {
+                auto pkt = make_pkt(seq, ts, i == count - 1, csrc);
+                int32_t len = pkt->encode_with_twcc(buf, sizeof(buf), TWCC_EXT_ID, twcc_seq);
+                EXPECT_GT(len, 0);
+                sent.media[seq] = std::string((char *)buf, len);
+                twcc_seqs[seq] = twcc_seq;
+                twcc_seq++;
+                seq++;
+                sent.media_count++;
+                encoder.add_packet(pkt, fec_pkts);
+                send_fec_pkts();
+            }
+            ts += 3000;
+        }
+    }
+    encoder.flush(fec_pkts);
+    send_fec_pkts();
+    return sent;
+}
+
+std::vector<uint16_t> protected_seqs(const FecPkt & f) {
+    std::vector<uint16_t> seqs;
+    for (uint16_t offset = 0; offset < RtpFlexFecEncoder::MAX_GROUP_PKTS; offset++) {
+        if (f.mask & (1 << (14 - offset))) {
+            seqs.push_back(f.base_seq + offset);
+        }
+    }
+    return seqs;
+}
+
+// 接收端恢复：冗余包与同组其余收到的包逐字节异或
+std::string recover(const FecPkt & f, const std::map<uint16_t, std::string> & received, uint16_t lost_seq) {
+    const uint8_t *fec = (const uint8_t *)f.payload.data();
+    uint8_t b0 = fec[0];
+    uint8_t b1 = fec[1];
+    uint16_t len_recovery = ntohs(*(uint16_t *)(fec + 2));
+    uint8_t ts[4] = {fec[4], fec[5], fec[6], fec[7]};
+    std::string body = f.payload.substr(RtpFlexFecEncoder::FEC_HEADER_SIZE);
+    for (auto seq : protected_seqs(f)) {
+        if (seq == lost_seq) {
+            continue;
+        }
+        auto it = received.find(seq);
+        if (it == received.end()) {
+            return "";
+        }
+        const uint8_t *src = (const uint8_t *)it->second.data();
+        size_t len = it->second.size();
+        b0 ^= src[0];
+        b1 ^= src[1];
+        len_recovery ^= (uint16_t)(len - 12);
+        for (int32_t i = 0; i < 4; i++) {
+            ts[i] ^= src[4 + i];
+        }
+        for (size_t i = 12; i < len && i - 12 < body.size(); i++) {
+            body[i - 12] ^= src[i];
+        }
+    }
+
+    if (len_recovery > body.size()) {
+        return "";
+    }
+    std::string pkt(12 + len_recovery, '\0');
+    uint8_t *p = (uint8_t *)pkt.data();
+    p[0] = 0x80 | (b0 & 0x3f);
+    p[1] = b1;
+    *(uint16_t *)(p + 2) = htons(lost_seq);
+    memcpy(p + 4, ts, 4);
+    memcpy(p + 8, fec + 12, 4);
+    memcpy(p + 12, body.data(), len_recovery);
+    return pkt;
+}
+
+// 每个冗余包所保护的包中丢一个，返回能恢复且与发出的包一致的个数
+size_t drop_and_recover(const Sent & sent, size_t & lost_count) {
+    std::map<uint16_t, std::string> received = sent.media;
+    std::vector<uint16_t> lost;
+    for (size_t i = 0; i < sent.fecs.size(); i++) {
+        auto seqs = protected_seqs(sent.fecs[i]);
+        uint16_t seq = seqs[i % seqs.size()];
+        received.erase(seq);
+        lost.push_back(seq);
+    }
+    lost_count = lost.size();
+
+    size_t recovered = 0;
+    for (size_t i = 0; i < sent.fecs.size(); i++) {
+        auto pkt = recover(sent.fecs[i], received, lost[i]);
+        if (pkt == sent.media.at(lost[i])) {
+            recovered++;
+        }
+    }
+    return recovered;
+}
+};
+
+TEST(FlexFecTest, MaskCoversEveryPacketOnce) {
+    for (auto & level : LEVELS) {
+        auto sent = send(level, 0, true);
+        std::multiset<uint16_t> covered;
+        for (auto & f : sent.fecs) {
+            auto seqs = protected_seqs(f);
+            ASSERT_FALSE(seqs.empty());
+            // 同一组的冗余包按序号交织，间隔为该组的冗余包数
+            for (size_t i = 1; i < seqs.size(); i++) {
+                EXPECT_EQ((uint16_t)(seqs[i] - seqs[i - 1]), (uint16_t)(seqs[1] - seqs[0]));
+            }
+            covered.insert(seqs.begin(), seqs.end());
+        }
+        EXPECT_EQ(covered.size(), sent.media_count);
+        for (auto & it : sent.media) {
+            EXPECT_EQ(covered.count(it.first), 1u);
+        }
+        // 冗余比例不低于设定值，小帧合并成组后不会远超
+        double ratio = (double)sent.fecs.size() / sent.media_count;
+        EXPECT_GE(ratio, (double)level.fec_pkts / level.group_pkts);
+        EXPECT_LT(ratio, (double)level.fec_pkts / level.group_pkts * 1.6);
+        printf("group %zu fec %zu: %zu media pkts, %zu fec pkts\n", level.group_pkts, level.fec_pkts,
+               sent.media_count, sent.fecs.size());
+    }
+}
+
+TEST(FlexFecTest, RecoverOneLostPerFecPacket) {
+    for (auto & level : LEVELS) {
+        auto sent = send(level, 0, true);
+        size_t lost = 0;
+        EXPECT_EQ(drop_and_recover(sent, lost), lost) << "group " << level.group_pkts << " fec " << level.fec_pkts;
+        EXPECT_EQ(lost, sent.fecs.size());
+    }
+}
+
+TEST(FlexFecTest, RecoverWithCsrc) {
+    // transport-cc序号的位置在csrc之后
+    auto sent = send(LEVELS[1], 2, true);
+    size_t lost = 0;
+    EXPECT_EQ(drop_and_recover(sent, lost), lost);
+}
+
+TEST(FlexFecTest, WithoutTwccXorRecoveredPacketDiffers) {
+    // 不修正时冗余包按transport-cc序号0计算，恢复出的包与接收端该收到的包不一致，
+    // 只有所保护的包的transport-cc序号异或恰好为0时(如对齐的4个连续序号)才碰巧一致
+    for (auto & level : LEVELS) {
+        auto sent = send(level, 0, false);
+        size_t lucky = 0;
+        for (auto & f : sent.fecs) {
+            uint16_t x = 0;
+            for (auto seq : protected_seqs(f)) {
+                x ^= sent.twcc_seqs[seq];
+            }
+            lucky += x == 0;
+        }
+        size_t lost = 0;
+        EXPECT_EQ(drop_and_recover(sent, lost), lucky);
+        EXPECT_LT(lucky * 2, lost);
+    }
+}
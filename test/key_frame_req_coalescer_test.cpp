@@ -0,0 +1,124 @@
+// 源的关键帧请求合并：窗口内的请求合并、两次请求的最小间隔、兜底请求
+// 定时器由测试按MediaSource::request_key_frame/on_key_frame_timer的用法模拟
+#include <stdint.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/key_frame_req_coalescer.hpp"
+
+using namespace mms;
+
+namespace {
+// AppConf的默认值
+const int32_t WINDOW_MS = 100;
+const int32_t MIN_INTERVAL_MS = 1000;
+const int32_t MAX_INTERVAL_MS = 4000;
+const int64_t START_MS = 1000000;
+
+// 按时间顺序投递请求，定时器到期时取出层并记为一次实际请求
+struct Driver {
+    KeyFrameReqCoalescer coalescer;
+    int64_t timer_at = -1;
+    std::vector<int64_t> sent_ms;
+    std::vector<uint32_t> sent_layers;
+
+    void run_until(int64_t now_ms) {
+        if (timer_at >= 0 && timer_at <= now_ms) {
+            int64_t fire_ms = timer_at;
+            timer_at = -1;
+            uint32_t layers = coalescer.take_layers();
+            if (layers != 0) {
+                coalescer.on_sent(fire_ms);
+                sent_ms.push_back(fire_ms);
+                sent_layers.push_back(layers);
+            }
+        }
+    }
+
+    void request(int64_t now_ms, uint32_t layer = 0) {
+        run_until(now_ms);
+        int64_t delay = coalescer.add_request(layer, now_ms, WINDOW_MS, MIN_INTERVAL_MS);
+        if (delay >= 0) {
+            timer_at = now_ms + delay;
+        }
+    }
+};
+};
+
+TEST(KeyFrameReqCoalescerTest, MergesRequestsInWindow) {
+    KeyFrameReqCoalescer c;
+    EXPECT_EQ(c.add_request(0, START_MS, WINDOW_MS, MIN_INTERVAL_MS), WINDOW_MS);
+    EXPECT_TRUE(c.is_pending());
+    // 窗口内的请求合并，不同层合并到掩码中
+    EXPECT_EQ(c.add_request(2, START_MS + 30, WINDOW_MS, MIN_INTERVAL_MS), -1);
+    EXPECT_EQ(c.add_request(0, START_MS + 60, WINDOW_MS, MIN_INTERVAL_MS), -1);
+    EXPECT_EQ(c.take_layers(), 0b101u);
+    EXPECT_FALSE(c.is_pending());
+    // 取出后清空
+    EXPECT_EQ(c.take_layers(), 0u);
+}
+
+TEST(KeyFrameReqCoalescerTest, MinInterval) {
+    KeyFrameReqCoalescer c;
+    c.add_request(0, START_MS, WINDOW_MS, MIN_INTERVAL_MS);
+    c.take_layers();
+    c.on_sent(START_MS + WINDOW_MS);
+    EXPECT_EQ(c.get_last_sent_ms(), START_MS + WINDOW_MS);
+
+    // 距上次请求200ms，要等到满1s
+    EXPECT_EQ(c.add_request(0, START_MS + WINDOW_MS + 200, WINDOW_MS, MIN_INTERVAL_MS), MIN_INTERVAL_MS - 200);
+    c.take_layers();
+
+    // 间隔已满足时只等合并窗口
+    c.on_sent(START_MS + 2000);
+    EXPECT_EQ(c.add_request(1, START_MS + 2000 + MIN_INTERVAL_MS + 500, WINDOW_MS, MIN_INTERVAL_MS), WINDOW_MS);
+}
+
+TEST(KeyFrameReqCoalescerTest, BurstFromManyPlayers) {
+    // 3s内100个播放者各请求一次，分布在3层
+    Driver d;
+    for (int32_t i = 0; i < 100; i++) {
+        d.request(START_MS + i * 30, i % 3);
+    }
+    d.run_until(START_MS + 10000);
+
+    ASSERT_FALSE(d.sent_ms.empty());
+    // 第一次在窗口结束时发出
+    EXPECT_EQ(d.sent_ms[0], START_MS + WINDOW_MS);
+    for (size_t i = 1; i < d.sent_ms.size(); i++) {
+        EXPECT_GE(d.sent_ms[i] - d.sent_ms[i - 1], MIN_INTERVAL_MS);
+    }
+    // 100次请求合并成4次：100ms、1100ms、2100ms，以及2970ms的最后一批在3100ms
+    EXPECT_EQ(d.sent_ms.size(), 4u);
+    EXPECT_EQ(d.sent_ms.back(), START_MS + 3 * MIN_INTERVAL_MS + WINDOW_MS);
+    for (auto layers : d.sent_layers) {
+        EXPECT_NE(layers, 0u);
+        EXPECT_EQ(layers & ~0b111u, 0u);
+    }
+}
+
+TEST(KeyFrameReqCoalescerTest, SparseRequestsAreNotDelayed) {
+    Driver d;
+    d.request(START_MS);
+    d.request(START_MS + 5000);
+    d.request(START_MS + 7000);
+    d.run_until(START_MS + 20000);
+    EXPECT_EQ(d.sent_ms, (std::vector<int64_t>{START_MS + WINDOW_MS, START_MS + 5000 + WINDOW_MS, START_MS + 7000 + WINDOW_MS}));
+}
+
+TEST(KeyFrameReqCoalescerTest, Periodic) {
+    KeyFrameReqCoalescer c;
+    c.on_sent(START_MS);
+    EXPECT_FALSE(c.is_periodic_due(START_MS + MAX_INTERVAL_MS - 1, MAX_INTERVAL_MS));
+    EXPECT_TRUE(c.is_periodic_due(START_MS + MAX_INTERVAL_MS, MAX_INTERVAL_MS));
+    EXPECT_EQ(c.get_periodic_delay(START_MS + 1000, MAX_INTERVAL_MS), MAX_INTERVAL_MS - 1000);
+    // 已经超过时不小于100ms，避免空转
+    EXPECT_EQ(c.get_periodic_delay(START_MS + MAX_INTERVAL_MS + 500, MAX_INTERVAL_MS), 100);
+
+    // 有等待中的请求时不另发兜底请求
+    c.add_request(0, START_MS + MAX_INTERVAL_MS, WINDOW_MS, MIN_INTERVAL_MS);
+    EXPECT_FALSE(c.is_periodic_due(START_MS + MAX_INTERVAL_MS + 10, MAX_INTERVAL_MS));
+    c.take_layers();
+    EXPECT_TRUE(c.is_periodic_due(START_MS + MAX_INTERVAL_MS + 10, MAX_INTERVAL_MS));
+}
@@ -0,0 +1,318 @@
+// 本机udp回环上的丢包注入，对比NACK重传与只靠关键帧请求恢复时播放端的卡顿时长
+// 发送端与WebRtcServerSession::process_rtcp_nack相同：按NACK中的序号到RtpHistory找包原样重传，收到PLI时下一帧出关键帧
+// 接收端(代替播放器)用RtpJitterBuffer重排并按缺口生成NACK，缺口最终补不上时发PLI
+// 时钟是模拟的，两个方向的链路都按概率丢包并加固定单向时延，包通过真实的udp socket收发
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "protocol/rtp/rtp_history.h"
+#include "protocol/rtp/rtp_jitter_buffer.h"
+#include "protocol/rtp/rtcp/rtcp_define.h"
+#include "protocol/rtp/rtcp/rtcp_fb_nack.h"
+#include "protocol/rtp/rtcp/rtcp_fb_pli.h"
+
+using namespace mms;
+
+namespace {
+const int32_t TICK_MS = 10;              // 与WebRtcServerSession::JITTER_BUFFER_TICK_MS相同
+const int32_t JITTER_BUFFER_MS = 100;    // webrtc配置jitter_buffer_ms的默认值
+const int32_t ONE_WAY_DELAY_MS = 20;
+const int32_t FPS = 30;
+const int32_t GOP_FRAMES = 60;
+const int32_t KEY_FRAME_PKTS = 20;
+const int32_t FRAME_PKTS = 5;
+const int32_t PKT_PAYLOAD_BYTES = 1000;
+const int32_t PLI_MIN_INTERVAL_MS = 300;
+// 两帧渲染间隔超过这个值算一次卡顿，整段间隔计入卡顿时长
+const int32_t FREEZE_GAP_MS = 200;
+const uint32_t SSRC = 0x1234;
+
+class UdpPeer {
+public:
+    UdpPeer() {
+        fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(fd_, (sockaddr *)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr_);
+        getsockname(fd_, (sockaddr *)&addr_, &len);
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    }
+
+    ~UdpPeer() {
+        close(fd_);
+    }
+
+    bool is_ok() const {
+        return fd_ >= 0 && addr_.sin_port != 0;
+    }
+
+    void send_to(const UdpPeer & peer, const std::string & data) {
+        sendto(fd_, data.data(), data.size(), 0, (const sockaddr *)&peer.addr_, sizeof(peer.addr_));
+    }
+
+    bool recv(std::string & data) {
+        char buf[2048];
+        ssize_t n = ::recv(fd_, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        data.assign(buf, n);
+        return true;
+    }
+private:
+    int fd_ = -1;
+    sockaddr_in addr_{};
+};
+
+// 单向链路：按概率丢包，未丢的包延迟固定时长后才真正写到socket
+class LossyLink {
+public:
+    LossyLink(UdpPeer & from, UdpPeer & to, double loss, uint32_t seed) : from_(from), to_(to), loss_(loss), rng_(seed) {
+    }
+
+    void send(int64_t now_ms, std::string data) {
+        if (std::uniform_real_distribution<double>(0, 1)(rng_) < loss_) {
+            dropped_++;
+            return;
+        }
+        queue_.push_back({now_ms + ONE_WAY_DELAY_MS, std::move(data)});
+    }
+
+    void flush(int64_t now_ms) {
+        while (!queue_.empty() && queue_.front().first <= now_ms) {
+            from_.send_to(to_, queue_.front().second);
+            queue_.pop_front();
+        }
+    }
+
+    uint64_t get_dropped() const {
+        return dropped_;
+    }
+private:
+    UdpPeer & from_;
+    UdpPeer & to_;
+    double loss_;
+    std::mt19937 rng_;
+    std::deque<std::pair<int64_t, std::string>> queue_;
+    uint64_t dropped_ = 0;
+};
+
+std::string encode_rtp(RtpPacket & pkt) {
+    std::string data(1500, '\0');
+    int32_t len = pkt.encode((uint8_t *)data.data(), data.size());
+    data.resize(len > 0 ? len : 0);
+    return data;
+}
+
+template <typename T>
+std::string encode_rtcp(T & pkt) {
+    std::string data(1500, '\0');
+    int32_t len = pkt.encode((uint8_t *)data.data(), data.size());
+    data.resize(len > 0 ? len : 0);
+    return data;
+}
+
+struct Result {
+    int64_t freeze_ms = 0;
+    int32_t freeze_count = 0;
+    int32_t frames_sent = 0;
+    int32_t frames_rendered = 0;
+    uint64_t retrans = 0;
+    uint64_t plis = 0;
+    uint64_t lost = 0;
+    uint64_t recovered = 0;
+};
+
+Result run(bool enable_nack, double loss, int32_t duration_ms) {
+    Result r;
+    UdpPeer sender_sock;
+    UdpPeer receiver_sock;
+    EXPECT_TRUE(sender_sock.is_ok());
+    EXPECT_TRUE(receiver_sock.is_ok());
+    // 两个方向使用不同的丢包序列，两种模式下相同
+    LossyLink down(sender_sock, receiver_sock, loss, 1);
+    LossyLink up(receiver_sock, sender_sock, loss, 2);
+
+    // 发送端
+    RtpHistory history(1024);
+    uint16_t seq = 0;
+    int32_t frame_index = 0;
+    bool force_key = false;
+
+    // 接收端
+    RtpJitterBuffer jitter_buffer(JITTER_BUFFER_MS);
+    int64_t last_pli_ms = -PLI_MIN_INTERVAL_MS;
+    bool has_last_seq = false;
+    uint16_t last_seq = 0;
+    bool broken = true;// 收到第一个关键帧之前不能解码
+    bool cur_ok = false;
+    int64_t last_render_ms = -1;
+
+    std::string data;
+    for (int64_t now_ms = 0; now_ms < duration_ms; now_ms += TICK_MS) {
+        // 发送端：处理rtcp，再按帧率发视频
+        while (sender_sock.recv(data)) {
+            if ((uint8_t)data[1] == PT_RTPFB) {
+                RtcpFbNack nack;
+                if (nack.decode((uint8_t *)data.data(), data.size()) <= 0) {
+                    continue;
+                }
+                for (auto lost_seq : nack.get_lost_seqs()) {
+                    auto pkt = history.get(lost_seq);
+                    if (pkt) {
+                        down.send(now_ms, encode_rtp(*pkt));
+                        r.retrans++;
+                    }
+                }
+            } else if ((uint8_t)data[1] == PT_PSFB) {
+                force_key = true;
+            }
+        }
+
+        while (frame_index * 1000 / FPS <= now_ms) {
+            bool is_key = frame_index % GOP_FRAMES == 0 || force_key;
+            force_key = false;
+            int32_t pkt_count = is_key ? KEY_FRAME_PKTS : FRAME_PKTS;
+            for (int32_t i = 0; i < pkt_count; i++) {
+                auto pkt = std::make_shared<RtpPacket>();
+                auto & header = pkt->get_header();
+                header.pt = 96;
+                header.marker = i == pkt_count - 1;
+                header.seqnum = seq++;
+                header.timestamp = frame_index * (90000 / FPS);
+                header.ssrc = SSRC;
+                // 负载开头：关键帧标记、帧内序号
+                pkt->payload_ = new char[PKT_PAYLOAD_BYTES];
+                pkt->payload_len_ = PKT_PAYLOAD_BYTES;
+                memset(pkt->payload_, 0xab, PKT_PAYLOAD_BYTES);
+                pkt->payload_[0] = is_key;
+                pkt->payload_[1] = (char)i;
+                history.put(pkt);
+                down.send(now_ms, encode_rtp(*pkt));
+            }
+            frame_index++;
+            r.frames_sent++;
+        }
+        down.flush(now_ms);
+
+        // 接收端：收包进重排缓冲，按序取出后组帧解码
+        while (receiver_sock.recv(data)) {
+            auto pkt = std::make_shared<RtpPacket>();
+            if (pkt->decode_and_store((uint8_t *)data.data(), data.size()) <= 0) {
+                continue;
+            }
+            jitter_buffer.push(pkt, now_ms);
+        }
+
+        std::vector<std::shared_ptr<RtpPacket>> pkts;
+        jitter_buffer.pop(now_ms, pkts);
+        for (auto & pkt : pkts) {
+            uint16_t s = pkt->get_seq_num();
+            if (has_last_seq && s != (uint16_t)(last_seq + 1)) {
+                // 缺口被跳过，参考链断开，直到下一个完整的关键帧
+                broken = true;
+                cur_ok = false;
+            }
+            has_last_seq = true;
+            last_seq = s;
+
+            auto payload = pkt->get_payload();
+            bool is_key = payload[0] != 0;
+            if (payload[1] == 0) {
+                cur_ok = true;
+            }
+
+            if (pkt->get_header().marker) {
+                if (cur_ok && (is_key || !broken)) {
+                    if (is_key) {
+                        broken = false;
+                    }
+                    if (last_render_ms >= 0 && now_ms - last_render_ms > FREEZE_GAP_MS) {
+                        r.freeze_ms += now_ms - last_render_ms;
+                        r.freeze_count++;
+                    }
+                    last_render_ms = now_ms;
+                    r.frames_rendered++;
+                }
+                cur_ok = false;
+            }
+        }
+
+        if (enable_nack) {
+            std::vector<uint16_t> lost_seqs;
+            jitter_buffer.get_nack_seqs(now_ms, lost_seqs);
+            if (!lost_seqs.empty()) {
+                RtcpFbNack nack;
+                nack.set_ssrc(1);
+                nack.set_media_source_ssrc(SSRC);
+                for (auto s : lost_seqs) {
+                    nack.add_lost_seq(s);
+                }
+                up.send(now_ms, encode_rtcp(nack));
+            }
+        }
+
+        if (jitter_buffer.need_key_frame() && now_ms - last_pli_ms >= PLI_MIN_INTERVAL_MS) {
+            RtcpFbPli pli;
+            pli.set_ssrc(1);
+            pli.set_media_source_ssrc(SSRC);
+            up.send(now_ms, encode_rtcp(pli));
+            last_pli_ms = now_ms;
+            r.plis++;
+        }
+        up.flush(now_ms);
+    }
+
+    r.lost = jitter_buffer.get_lost_count();
+    r.recovered = jitter_buffer.get_recovered_count();
+    printf("nack %s, loss %.1f%%: frames %d/%d rendered, freeze %lld ms in %d freezes, retrans %llu, pli %llu, "
+           "skipped pkts %llu, recovered pkts %llu\n",
+           enable_nack ? "on" : "off", loss * 100, r.frames_rendered, r.frames_sent, (long long)r.freeze_ms, r.freeze_count,
+           (unsigned long long)r.retrans, (unsigned long long)r.plis, (unsigned long long)r.lost,
+           (unsigned long long)r.recovered);
+    return r;
+}
+};
+
+TEST(NackLoopbackTest, NoLossNoFreeze) {
+    auto r = run(true, 0, 10000);
+    EXPECT_EQ(r.freeze_ms, 0);
+    EXPECT_EQ(r.retrans, 0u);
+    EXPECT_EQ(r.plis, 0u);
+    // 最后几帧还在链路及重排缓冲中
+    EXPECT_GE(r.frames_rendered, r.frames_sent - 5);
+}
+
+TEST(NackLoopbackTest, NackReducesFreezeTime) {
+    const int32_t duration_ms = 60000;
+    for (double loss : {0.01, 0.03}) {
+        auto without_nack = run(false, loss, duration_ms);
+        auto with_nack = run(true, loss, duration_ms);
+
+        // 不重传时每个丢包都要等到关键帧才能恢复
+        EXPECT_GT(without_nack.freeze_ms, 0);
+        EXPECT_GT(without_nack.plis, 0u);
+        EXPECT_EQ(without_nack.retrans, 0u);
+
+        EXPECT_GT(with_nack.retrans, 0u);
+        EXPECT_GT(with_nack.recovered, 0u);
+        EXPECT_LT(with_nack.lost, without_nack.lost / 5);
+        EXPECT_LT(with_nack.freeze_ms * 5, without_nack.freeze_ms);
+        EXPECT_GT(with_nack.frames_rendered, without_nack.frames_rendered);
+    }
+}
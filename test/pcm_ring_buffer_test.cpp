@@ -0,0 +1,176 @@
+// PcmRingBuffer的写入、取帧及跨环尾的处理
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "transcode/pcm_ring_buffer.hpp"
+
+using namespace mms;
+
+namespace {
+// 从start开始递增的样本，方便检查顺序
+std::vector<int16_t> make_samples(int16_t start, size_t n) {
+    std::vector<int16_t> v(n);
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (int16_t)(start + i);
+    }
+    return v;
+}
+
+void expect_samples(const int16_t *p, int16_t start, size_t n) {
+    ASSERT_NE(p, nullptr);
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_EQ(p[i], (int16_t)(start + i)) << "at " << i;
+    }
+}
+};
+
+TEST(PcmRingBufferTest, WriteAndPeekContiguous) {
+    PcmRingBuffer ring(10, 6);
+    auto s = make_samples(0, 4);
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+    EXPECT_EQ(ring.size(), 4u);
+    EXPECT_EQ(ring.space(), 6u);
+
+    EXPECT_EQ(ring.peek(5), nullptr);
+    expect_samples(ring.peek(4), 0, 4);
+    // peek不消耗
+    expect_samples(ring.peek(3), 0, 3);
+    ring.consume(3);
+    EXPECT_EQ(ring.size(), 1u);
+    expect_samples(ring.peek(1), 3, 1);
+}
+
+TEST(PcmRingBufferTest, PeekAcrossWrap) {
+    PcmRingBuffer ring(10, 6);
+    auto s = make_samples(0, 8);
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+    ring.consume(6);
+
+    // 读位置6，剩2个，再写6个时2个写在环尾，4个绕回环头
+    s = make_samples(8, 6);
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+    EXPECT_EQ(ring.size(), 8u);
+
+    // 跨环尾的一帧拼成连续的
+    expect_samples(ring.peek(6), 6, 6);
+    ring.consume(6);
+    expect_samples(ring.peek(2), 12, 2);
+    ring.consume(2);
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+TEST(PcmRingBufferTest, WritePtrAndCommitAtWrap) {
+    PcmRingBuffer ring(10, 6);
+    auto s = make_samples(0, 8);
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+    ring.consume(6);
+
+    // 写位置8，到环尾只能连续写2个
+    size_t contiguous = 0;
+    int16_t *p = ring.write_ptr(contiguous);
+    ASSERT_EQ(contiguous, 2u);
+    p[0] = 8;
+    p[1] = 9;
+    ring.commit(2);
+
+    // 绕回环头，可写到读位置为止
+    p = ring.write_ptr(contiguous);
+    ASSERT_EQ(contiguous, 6u);
+    for (size_t i = 0; i < contiguous; i++) {
+        p[i] = (int16_t)(10 + i);
+    }
+    ring.commit(contiguous);
+    EXPECT_EQ(ring.space(), 0u);
+
+    ring.write_ptr(contiguous);
+    EXPECT_EQ(contiguous, 0u);
+
+    expect_samples(ring.peek(6), 6, 6);
+    ring.consume(6);
+    EXPECT_EQ(ring.peek(6), nullptr);
+    expect_samples(ring.peek(4), 12, 4);
+}
+
+TEST(PcmRingBufferTest, RejectOverflowAndOversizedFrame) {
+    PcmRingBuffer ring(10, 6);
+    auto s = make_samples(0, 8);
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+
+    // 空间不够时整体不写
+    EXPECT_FALSE(ring.write(s.data(), 3));
+    EXPECT_EQ(ring.size(), 8u);
+
+    // 超过max_frame的帧取不出来
+    EXPECT_EQ(ring.peek(7), nullptr);
+    expect_samples(ring.peek(6), 0, 6);
+}
+
+TEST(PcmRingBufferTest, ConsumeAndClear) {
+    PcmRingBuffer ring(10, 6);
+    auto s = make_samples(0, 5);
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+    ring.consume(100);
+    EXPECT_EQ(ring.size(), 0u);
+    EXPECT_EQ(ring.space(), 10u);
+
+    ASSERT_TRUE(ring.write(s.data(), s.size()));
+    ring.clear();
+    EXPECT_EQ(ring.size(), 0u);
+
+    // clear后从环头开始写
+    size_t contiguous = 0;
+    ring.write_ptr(contiguous);
+    EXPECT_EQ(contiguous, 10u);
+}
+
+// 随机交替写入、取帧，和deque的结果比较，覆盖各种跨环尾的位置
+TEST(PcmRingBufferTest, RandomAgainstDeque) {
+    const size_t capacity = 97;
+    const size_t max_frame = 40;
+    PcmRingBuffer ring(capacity, max_frame);
+    std::deque<int16_t> ref;
+    int16_t next = 0;
+    srand(1);
+    for (int round = 0; round < 20000; round++) {
+        if (rand() % 2) {
+            size_t n = rand() % 50;
+            if (rand() % 2) {
+                auto s = make_samples(next, n);
+                bool ok = ring.write(s.data(), n);
+                ASSERT_EQ(ok, n <= capacity - ref.size());
+                if (ok) {
+                    ref.insert(ref.end(), s.begin(), s.end());
+                    next += n;
+                }
+            } else {
+                // 按重采样的用法，只写write_ptr给出的连续部分
+                size_t contiguous = 0;
+                int16_t *p = ring.write_ptr(contiguous);
+                n = std::min(n, contiguous);
+                for (size_t i = 0; i < n; i++) {
+                    p[i] = next;
+                    ref.push_back(next++);
+                }
+                ring.commit(n);
+            }
+        } else {
+            size_t n = rand() % (max_frame + 5);
+            const int16_t *p = ring.peek(n);
+            if (n > ref.size() || n > max_frame) {
+                ASSERT_EQ(p, nullptr);
+                continue;
+            }
+
+            ASSERT_NE(p, nullptr);
+            for (size_t i = 0; i < n; i++) {
+                ASSERT_EQ(p[i], ref[i]);
+            }
+            ring.consume(n);
+            ref.erase(ref.begin(), ref.begin() + n);
+        }
+        ASSERT_EQ(ring.size(), ref.size());
+    }
+}
@@ -0,0 +1,153 @@
+// RtpHistory按序号查找及覆盖淘汰，RtcpFbNack的编解码
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "protocol/rtp/rtp_history.h"
+#include "protocol/rtp/rtcp/rtcp_fb_nack.h"
+
+using namespace mms;
+
+namespace {
+std::shared_ptr<RtpPacket> make_pkt(uint16_t seq, uint32_t ssrc = 0x1234) {
+    auto pkt = std::make_shared<RtpPacket>();
+    pkt->get_header().seqnum = seq;
+    pkt->get_header().ssrc = ssrc;
+    return pkt;
+}
+
+std::vector<uint16_t> nack_round_trip(const std::vector<uint16_t> & seqs, size_t & encoded_size) {
+    RtcpFbNack nack;
+    nack.set_ssrc(1);
+    nack.set_media_source_ssrc(0x1234);
+    for (auto seq : seqs) {
+        nack.add_lost_seq(seq);
+    }
+
+    uint8_t buf[1500];
+    int32_t len = nack.encode(buf, sizeof(buf));
+    EXPECT_GT(len, 0);
+    encoded_size = len;
+    EXPECT_EQ((size_t)len, nack.size());
+
+    RtcpFbNack decoded;
+    EXPECT_EQ(decoded.decode(buf, len), len);
+    EXPECT_EQ(decoded.get_header().get_media_source_ssrc(), 0x1234u);
+    return decoded.get_lost_seqs();
+}
+};
+
+TEST(RtpHistoryTest, LookupAndEviction) {
+    // 1000向上取整为1024
+    RtpHistory history(1000);
+    for (uint32_t seq = 0; seq < 1024; seq++) {
+        history.put(make_pkt(seq));
+    }
+
+    for (uint32_t seq = 0; seq < 1024; seq++) {
+        ASSERT_NE(history.get(seq), nullptr) << "seq " << seq;
+        EXPECT_EQ(history.get(seq)->get_seq_num(), seq);
+    }
+    EXPECT_EQ(history.get(1024), nullptr);
+
+    // 再写一个覆盖最老的包
+    history.put(make_pkt(1024));
+    EXPECT_EQ(history.get(0), nullptr);
+    EXPECT_NE(history.get(1), nullptr);
+    EXPECT_NE(history.get(1024), nullptr);
+    EXPECT_EQ(history.get_ssrc(), 0x1234u);
+}
+
+TEST(RtpHistoryTest, SlotHoldingOtherSeqIsMiss) {
+    RtpHistory history(4);
+    history.put(make_pkt(1));
+    // 5与1落在同一个位置
+    EXPECT_EQ(history.get(5), nullptr);
+    EXPECT_EQ(history.get(2), nullptr);
+    EXPECT_NE(history.get(1), nullptr);
+}
+
+TEST(RtpHistoryTest, SharesPacketInstance) {
+    RtpHistory history(16);
+    auto pkt = make_pkt(7);
+    history.put(pkt);
+    EXPECT_EQ(history.get(7), pkt);
+    EXPECT_EQ(pkt.use_count(), 2);
+}
+
+TEST(RtpHistoryTest, SeqWrapAround) {
+    RtpHistory history(16);
+    for (uint32_t i = 0; i < 12; i++) {
+        history.put(make_pkt((uint16_t)(65530 + i)));
+    }
+
+    for (uint32_t i = 0; i < 12; i++) {
+        EXPECT_NE(history.get((uint16_t)(65530 + i)), nullptr) << "seq " << (uint16_t)(65530 + i);
+    }
+}
+
+TEST(RtpHistoryTest, CapacityCapped) {
+    // 上限32768，超过时只保留最近的32768个
+    RtpHistory history(100000);
+    for (uint32_t seq = 0; seq <= 32768; seq++) {
+        history.put(make_pkt((uint16_t)seq));
+    }
+    EXPECT_EQ(history.get(0), nullptr);
+    EXPECT_NE(history.get(1), nullptr);
+    EXPECT_NE(history.get(32768), nullptr);
+}
+
+TEST(RtcpFbNackTest, EncodeMergesIntoPidBlp) {
+    // 100覆盖101~116，117重新开始，200单独一个
+    std::vector<uint16_t> seqs{100, 101, 105, 116, 117, 118, 200};
+    size_t encoded_size = 0;
+    auto decoded = nack_round_trip(seqs, encoded_size);
+    EXPECT_EQ(decoded, seqs);
+    EXPECT_EQ(encoded_size, 12u + 3 * 4);
+}
+
+TEST(RtcpFbNackTest, SeqWrapAround) {
+    std::vector<uint16_t> seqs{65534, 65535, 0, 3};
+    size_t encoded_size = 0;
+    auto decoded = nack_round_trip(seqs, encoded_size);
+    EXPECT_EQ(decoded, seqs);
+    EXPECT_EQ(encoded_size, 12u + 4);
+}
+
+TEST(RtcpFbNackTest, RejectTruncated) {
+    RtcpFbNack nack;
+    nack.add_lost_seq(10);
+    nack.add_lost_seq(40);
+    uint8_t buf[64];
+    int32_t len = nack.encode(buf, sizeof(buf));
+    ASSERT_GT(len, 4);
+
+    RtcpFbNack decoded;
+    EXPECT_LT(decoded.decode(buf, len - 4), 0);
+}
+
+// 与WebRtcServerSession::process_rtcp_nack相同：按NACK中的序号到历史中找包，已被覆盖的算丢失
+TEST(RtpHistoryTest, NackLookup) {
+    RtpHistory history(64);
+    for (uint32_t seq = 1000; seq < 1100; seq++) {
+        history.put(make_pkt((uint16_t)seq));
+    }
+
+    // 1000~1035已被覆盖
+    size_t encoded_size = 0;
+    auto lost = nack_round_trip({1010, 1036, 1037, 1099}, encoded_size);
+    std::vector<uint16_t> hits;
+    uint32_t misses = 0;
+    for (auto seq : lost) {
+        auto pkt = history.get(seq);
+        if (!pkt) {
+            misses++;
+            continue;
+        }
+        hits.push_back(pkt->get_seq_num());
+    }
+    EXPECT_EQ(misses, 1u);
+    EXPECT_EQ(hits, (std::vector<uint16_t>{1036, 1037, 1099}));
+}
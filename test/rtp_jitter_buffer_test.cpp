@@ -0,0 +1,138 @@
+// RtpJitterBuffer的重排、迟到包、NACK序号生成及缺口超时跳过
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "protocol/rtp/rtp_jitter_buffer.h"
+
+using namespace mms;
+
+namespace {
+const int32_t DELAY_MS = 100;
+
+std::shared_ptr<RtpPacket> make_pkt(uint16_t seq) {
+    auto pkt = std::make_shared<RtpPacket>();
+    pkt->get_header().seqnum = seq;
+    pkt->get_header().ssrc = 0x1234;
+    return pkt;
+}
+
+std::vector<uint16_t> pop_seqs(RtpJitterBuffer & jb, int64_t now_ms) {
+    std::vector<std::shared_ptr<RtpPacket>> pkts;
+    jb.pop(now_ms, pkts);
+    std::vector<uint16_t> seqs;
+    for (auto & pkt : pkts) {
+        seqs.push_back(pkt->get_seq_num());
+    }
+    return seqs;
+}
+
+std::vector<uint16_t> nack_seqs(RtpJitterBuffer & jb, int64_t now_ms) {
+    std::vector<uint16_t> seqs;
+    jb.get_nack_seqs(now_ms, seqs);
+    return seqs;
+}
+};
+
+TEST(RtpJitterBufferTest, ReordersWithinDelay) {
+    RtpJitterBuffer jb(DELAY_MS);
+    EXPECT_TRUE(jb.push(make_pkt(10), 0));
+    EXPECT_TRUE(jb.push(make_pkt(13), 1));
+    EXPECT_TRUE(jb.push(make_pkt(12), 2));
+    // 11未到，只能输出10
+    EXPECT_EQ(pop_seqs(jb, 5), (std::vector<uint16_t>{10}));
+    EXPECT_TRUE(jb.push(make_pkt(11), 20));
+    EXPECT_EQ(pop_seqs(jb, 20), (std::vector<uint16_t>{11, 12, 13}));
+    EXPECT_FALSE(jb.need_key_frame());
+    EXPECT_EQ(jb.get_lost_count(), 0u);
+    EXPECT_EQ(jb.get_recv_count(), 4u);
+}
+
+TEST(RtpJitterBufferTest, DuplicateAndLatePackets) {
+    RtpJitterBuffer jb(DELAY_MS);
+    EXPECT_TRUE(jb.push(make_pkt(1), 0));
+    EXPECT_TRUE(jb.push(make_pkt(3), 0));
+    // 缓冲内重复
+    EXPECT_FALSE(jb.push(make_pkt(3), 1));
+    EXPECT_EQ(pop_seqs(jb, 1), (std::vector<uint16_t>{1}));
+    // 已输出过
+    EXPECT_FALSE(jb.push(make_pkt(1), 2));
+
+    // 3等满delay后放弃2
+    EXPECT_TRUE(pop_seqs(jb, DELAY_MS - 1).empty());
+    EXPECT_EQ(pop_seqs(jb, DELAY_MS), (std::vector<uint16_t>{3}));
+    EXPECT_EQ(jb.get_lost_count(), 1u);
+    EXPECT_TRUE(jb.need_key_frame());
+    EXPECT_FALSE(jb.need_key_frame());
+
+    // 跳过之后才到的包是迟到包，丢弃且不再NACK
+    EXPECT_FALSE(jb.push(make_pkt(2), DELAY_MS + 10));
+    EXPECT_TRUE(nack_seqs(jb, DELAY_MS + 10).empty());
+    EXPECT_TRUE(jb.push(make_pkt(4), DELAY_MS + 10));
+    EXPECT_EQ(pop_seqs(jb, DELAY_MS + 10), (std::vector<uint16_t>{4}));
+}
+
+TEST(RtpJitterBufferTest, NackIntervalAndRecovery) {
+    RtpJitterBuffer jb(DELAY_MS);
+    jb.push(make_pkt(100), 0);
+    jb.push(make_pkt(104), 0);
+    EXPECT_EQ(pop_seqs(jb, 0), (std::vector<uint16_t>{100}));
+
+    EXPECT_EQ(nack_seqs(jb, 0), (std::vector<uint16_t>{101, 102, 103}));
+    // 间隔内不重复请求
+    EXPECT_TRUE(nack_seqs(jb, 39).empty());
+
+    // 补上102，只剩101、103
+    EXPECT_TRUE(jb.push(make_pkt(102), 30));
+    EXPECT_EQ(jb.get_recovered_count(), 1u);
+    EXPECT_EQ(nack_seqs(jb, 40), (std::vector<uint16_t>{101, 103}));
+    EXPECT_EQ(jb.get_nack_count(), 5u);
+
+    jb.push(make_pkt(101), 50);
+    jb.push(make_pkt(103), 50);
+    EXPECT_EQ(jb.get_recovered_count(), 3u);
+    EXPECT_EQ(pop_seqs(jb, 50), (std::vector<uint16_t>{101, 102, 103, 104}));
+    EXPECT_TRUE(nack_seqs(jb, 200).empty());
+    EXPECT_FALSE(jb.need_key_frame());
+    EXPECT_EQ(jb.get_lost_count(), 0u);
+}
+
+TEST(RtpJitterBufferTest, NackGivesUpAfterMaxTimes) {
+    // delay足够长，只看NACK次数上限
+    RtpJitterBuffer jb(100000);
+    jb.push(make_pkt(1), 0);
+    jb.push(make_pkt(3), 0);
+    int32_t times = 0;
+    for (int64_t now_ms = 0; now_ms < 2000; now_ms += 10) {
+        times += nack_seqs(jb, now_ms).size();
+    }
+    EXPECT_EQ(times, 10);
+}
+
+TEST(RtpJitterBufferTest, SeqWrapAround) {
+    RtpJitterBuffer jb(DELAY_MS);
+    jb.push(make_pkt(65533), 0);
+    jb.push(make_pkt(0), 1);
+    jb.push(make_pkt(65535), 2);
+    jb.push(make_pkt(1), 3);
+    EXPECT_EQ(nack_seqs(jb, 3), (std::vector<uint16_t>{65534}));
+    jb.push(make_pkt(65534), 4);
+    EXPECT_EQ(pop_seqs(jb, 4), (std::vector<uint16_t>{65533, 65534, 65535, 0, 1}));
+    EXPECT_EQ(jb.get_lost_count(), 0u);
+}
+
+TEST(RtpJitterBufferTest, LargeJumpResets) {
+    RtpJitterBuffer jb(DELAY_MS);
+    jb.push(make_pkt(10), 0);
+    jb.push(make_pkt(12), 0);
+    EXPECT_EQ(pop_seqs(jb, 0), (std::vector<uint16_t>{10}));
+
+    // 推流端重置序号：丢掉缓冲内容，不对中间的序号发NACK
+    EXPECT_TRUE(jb.push(make_pkt(30000), 5));
+    EXPECT_TRUE(jb.need_key_frame());
+    EXPECT_TRUE(nack_seqs(jb, 5).empty());
+    jb.push(make_pkt(30001), 6);
+    EXPECT_EQ(pop_seqs(jb, 6), (std::vector<uint16_t>{30000, 30001}));
+}
@@ -0,0 +1,140 @@
+// 播放者发送队列：一个慢的播放者不能阻塞源向其他播放者的分发
+// 源按RtpMediaSource::on_video_packets的方式依次把每批包交给各个播放者，播放者用WebRtcServerSession的方式放入队列
+#include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <gtest/gtest.h>
+
+#include "server/webrtc/rtp_send_queue.hpp"
+
+using namespace mms;
+
+namespace {
+constexpr size_t QUEUE_SIZE = 64;
+constexpr int32_t BATCHES = 1000;
+constexpr int32_t PKTS_PER_BATCH = 5;
+
+struct Player {
+    Player(boost::asio::io_context & io) : queue(io, QUEUE_SIZE), timer(io) {}
+    RtpSendQueue queue;
+    boost::asio::steady_timer timer;
+    int32_t received_batches = 0;
+};
+
+std::vector<std::shared_ptr<RtpPacket>> make_batch(uint16_t seq) {
+    std::vector<std::shared_ptr<RtpPacket>> pkts;
+    for (int32_t i = 0; i < PKTS_PER_BATCH; i++) {
+        auto pkt = std::make_shared<RtpPacket>();
+        pkt->get_header().seqnum = seq + i;
+        pkts.push_back(pkt);
+    }
+    return pkts;
+}
+
+// 发送协程，每批之后等待delay，模拟节奏控制，delay<0表示不取(发送被完全阻塞)
+boost::asio::awaitable<void> drain(Player & player, std::chrono::milliseconds delay) {
+    if (delay.count() < 0) {
+        co_return;
+    }
+
+    while (1) {
+        boost::system::error_code ec;
+        co_await player.queue.pop(ec);
+        if (ec) {
+            co_return;
+        }
+        player.received_batches++;
+        if (delay.count() > 0) {
+            player.timer.expires_after(delay);
+            co_await player.timer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+    }
+}
+
+class RtpSendQueueTest : public testing::Test {
+protected:
+    // 源的分发协程，每批之间让出一次，相当于等待下一批网络包
+    boost::asio::awaitable<void> publish(std::vector<std::unique_ptr<Player>> & players) {
+        for (int32_t i = 0; i < BATCHES; i++) {
+            auto pkts = make_batch(i * PKTS_PER_BATCH);
+            for (auto & p : players) {
+                p->queue.try_push(pkts, true);
+            }
+            co_await boost::asio::post(io_, boost::asio::use_awaitable);
+        }
+        published_ = true;
+        for (auto & p : players) {
+            p->queue.close();
+        }
+    }
+
+    void run(std::vector<std::unique_ptr<Player>> & players, const std::vector<std::chrono::milliseconds> & delays) {
+        for (size_t i = 0; i < players.size(); i++) {
+            boost::asio::co_spawn(io_, drain(*players[i], delays[i]), boost::asio::detached);
+        }
+        boost::asio::co_spawn(io_, publish(players), boost::asio::detached);
+        io_.run();
+    }
+
+    boost::asio::io_context io_;
+    bool published_ = false;
+};
+};
+
+TEST_F(RtpSendQueueTest, BlockedPlayerDoesNotStallOthers) {
+    std::vector<std::unique_ptr<Player>> players;
+    for (int32_t i = 0; i < 4; i++) {
+        players.emplace_back(std::make_unique<Player>(io_));
+    }
+    run(players, {std::chrono::milliseconds(-1), std::chrono::milliseconds(0), std::chrono::milliseconds(0), std::chrono::milliseconds(0)});
+
+    ASSERT_TRUE(published_);
+    // 阻塞的播放者只留下队列能放下的部分，其余整批丢弃
+    auto & slow = *players[0];
+    EXPECT_EQ(slow.queue.get_dropped_batches(), (uint64_t)(BATCHES - QUEUE_SIZE));
+    EXPECT_EQ(slow.queue.get_dropped_video_pkts(), (uint64_t)(BATCHES - QUEUE_SIZE) * PKTS_PER_BATCH);
+    EXPECT_EQ(slow.queue.get_pending_batches(), (int32_t)QUEUE_SIZE);
+    for (size_t i = 1; i < players.size(); i++) {
+        EXPECT_EQ(players[i]->received_batches, BATCHES) << "player " << i;
+        EXPECT_EQ(players[i]->queue.get_dropped_batches(), 0u) << "player " << i;
+        EXPECT_EQ(players[i]->queue.get_pending_batches(), 0) << "player " << i;
+    }
+}
+
+TEST_F(RtpSendQueueTest, PacedPlayerDoesNotStallOthers) {
+    // 节奏控制每批等1ms，总耗时远大于源分发完所有批次的时间
+    std::vector<std::unique_ptr<Player>> players;
+    for (int32_t i = 0; i < 3; i++) {
+        players.emplace_back(std::make_unique<Player>(io_));
+    }
+    auto start = std::chrono::steady_clock::now();
+    run(players, {std::chrono::milliseconds(0), std::chrono::milliseconds(1), std::chrono::milliseconds(0)});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(published_);
+    auto & paced = *players[1];
+    EXPECT_GT(paced.queue.get_dropped_batches(), 0u);
+    // 关闭时还在队列中的不再发送
+    EXPECT_EQ((uint64_t)paced.received_batches + paced.queue.get_dropped_batches() + paced.queue.get_pending_batches(), (uint64_t)BATCHES);
+    EXPECT_EQ(players[0]->received_batches, BATCHES);
+    EXPECT_EQ(players[2]->received_batches, BATCHES);
+    // 分发没有按慢的播放者的节奏进行
+    EXPECT_LT(elapsed, std::chrono::milliseconds(BATCHES));
+}
+
+TEST_F(RtpSendQueueTest, ClosedQueueRejects) {
+    Player player(io_);
+    player.queue.close();
+    EXPECT_FALSE(player.queue.try_push(make_batch(0), false));
+    EXPECT_EQ(player.queue.get_dropped_audio_pkts(), (uint64_t)PKTS_PER_BATCH);
+    EXPECT_EQ(player.queue.get_pending_batches(), 0);
+}
@@ -0,0 +1,228 @@
+// simulcast播放的选层(按带宽估计选层、升降层策略、固定层)及切层后ssrc、序号和时间戳的改写
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "server/webrtc/simulcast_layer.hpp"
+
+using namespace mms;
+
+namespace {
+const uint32_t PLAY_SSRC = 0xabcd;
+// 三层：低、中、高
+const std::vector<int64_t> LAYER_BPS{300000, 1000000, 2500000};
+
+struct OutPkt {
+    bool sent = false;
+    uint16_t seq = 0;
+    uint32_t ts = 0;
+    uint32_t ssrc = 0;
+};
+
+OutPkt rewrite(SimulcastRtpRewriter & rewriter, uint32_t ssrc, uint16_t seq, uint32_t ts, int64_t now_ms) {
+    RtpPacket pkt;
+    auto & header = pkt.get_header();
+    header.pt = 96;
+    header.marker = 0;
+    header.seqnum = seq;
+    header.timestamp = ts;
+    header.ssrc = ssrc;
+    pkt.payload_ = new char[10];
+    pkt.payload_len_ = 10;
+
+    uint8_t buf[1500];
+    int32_t len = pkt.encode(buf, sizeof(buf));
+    EXPECT_GT(len, 0);
+
+    OutPkt out;
+    out.sent = rewriter.rewrite(buf, pkt, now_ms);
+    RtpHeader decoded;
+    EXPECT_GT(decoded.decode(buf, len), 0);
+    out.seq = decoded.seqnum;
+    out.ts = decoded.timestamp;
+    out.ssrc = decoded.ssrc;
+    return out;
+}
+};
+
+TEST(SimulcastLayerSelectorTest, ChooseByEstimate) {
+    {// 没有带宽估计选最高码率层
+        SimulcastLayerSelector selector;
+        selector.update_target(LAYER_BPS, 0, 0);
+        EXPECT_EQ(selector.get_target_layer(), 2);
+    }
+
+    {// 不超过估计带宽的0.85
+        SimulcastLayerSelector selector;
+        selector.update_target(LAYER_BPS, 1500000, 0);
+        EXPECT_EQ(selector.get_target_layer(), 1);
+    }
+
+    {// 都超过时选最低码率层
+        SimulcastLayerSelector selector;
+        selector.update_target(LAYER_BPS, 200000, 0);
+        EXPECT_EQ(selector.get_target_layer(), 0);
+    }
+
+    {// 没有码率统计的层不参与，层号不要求按码率排序
+        SimulcastLayerSelector selector;
+        selector.update_target({2500000, 0, 300000}, 1000000, 0);
+        EXPECT_EQ(selector.get_target_layer(), 2);
+        selector.update_target({0, 0, 0}, 1000000, 1000);
+        EXPECT_EQ(selector.get_target_layer(), 0);
+    }
+}
+
+TEST(SimulcastLayerSelectorTest, CheckInterval) {
+    SimulcastLayerSelector selector;
+    EXPECT_TRUE(selector.need_check(0));
+    selector.update_target(LAYER_BPS, 0, 1000);
+    EXPECT_FALSE(selector.need_check(1000 + SimulcastLayerSelector::LAYER_CHECK_INTERVAL_MS - 1));
+    EXPECT_TRUE(selector.need_check(1000 + SimulcastLayerSelector::LAYER_CHECK_INTERVAL_MS));
+}
+
+TEST(SimulcastLayerSelectorTest, SwitchOnlyWhenTargetArrives) {
+    SimulcastLayerSelector selector;
+    selector.update_target(LAYER_BPS, 1500000, 0);
+    // 还没有发送任何层，目标层等关键帧
+    EXPECT_TRUE(selector.is_switch_target(1));
+    EXPECT_FALSE(selector.is_switch_target(0));
+    EXPECT_FALSE(selector.is_sending(0));
+    EXPECT_FALSE(selector.is_sending(1));
+
+    selector.switch_layer(1);
+    EXPECT_EQ(selector.get_cur_layer(), 1);
+    EXPECT_FALSE(selector.is_switch_target(1));
+    EXPECT_TRUE(selector.is_sending(1));
+    EXPECT_FALSE(selector.is_sending(2));
+
+    // 带宽下降，目标变为第0层，关键帧到来之前继续发送第1层
+    selector.update_target(LAYER_BPS, 500000, 500);
+    EXPECT_EQ(selector.get_target_layer(), 0);
+    EXPECT_TRUE(selector.is_switch_target(0));
+    EXPECT_TRUE(selector.is_sending(1));
+    EXPECT_FALSE(selector.is_sending(0));
+}
+
+TEST(SimulcastLayerSelectorTest, DownImmediateUpDelayed) {
+    const int64_t up_delay = SimulcastLayerSelector::LAYER_UP_DELAY_MS;
+    SimulcastLayerSelector selector;
+    selector.update_target(LAYER_BPS, 5000000, 0);
+    selector.switch_layer(2);
+
+    // 降层立即生效
+    selector.update_target(LAYER_BPS, 500000, 500);
+    EXPECT_EQ(selector.get_target_layer(), 0);
+    selector.switch_layer(0);
+
+    // 带宽恢复后要持续满足LAYER_UP_DELAY_MS才升层
+    selector.update_target(LAYER_BPS, 5000000, 1000);
+    EXPECT_EQ(selector.get_target_layer(), 0);
+    selector.update_target(LAYER_BPS, 5000000, 1000 + up_delay - 1);
+    EXPECT_EQ(selector.get_target_layer(), 0);
+    selector.update_target(LAYER_BPS, 5000000, 1000 + up_delay);
+    EXPECT_EQ(selector.get_target_layer(), 2);
+
+    // 中途带宽不满足则重新计时
+    selector.switch_layer(0);
+    selector.update_target(LAYER_BPS, 5000000, 10000);
+    selector.update_target(LAYER_BPS, 500000, 11000);
+    EXPECT_EQ(selector.get_target_layer(), 0);
+    selector.update_target(LAYER_BPS, 5000000, 12000);
+    selector.update_target(LAYER_BPS, 5000000, 10000 + up_delay);
+    EXPECT_EQ(selector.get_target_layer(), 0);
+    selector.update_target(LAYER_BPS, 5000000, 12000 + up_delay);
+    EXPECT_EQ(selector.get_target_layer(), 2);
+}
+
+TEST(SimulcastLayerSelectorTest, FixedLayer) {
+    SimulcastLayerSelector selector;
+    selector.set_fixed_layer(1);
+    EXPECT_TRUE(selector.is_fixed());
+    selector.update_target(LAYER_BPS, 200000, 0);
+    EXPECT_EQ(selector.get_target_layer(), 1);
+    selector.update_target(LAYER_BPS, 0, 1000);
+    EXPECT_EQ(selector.get_target_layer(), 1);
+}
+
+TEST(SimulcastRtpRewriterTest, FirstLayerKeepsSeqAndTs) {
+    SimulcastRtpRewriter rewriter;
+    rewriter.set_ssrc(PLAY_SSRC);
+    EXPECT_FALSE(rewriter.is_started());
+
+    auto out = rewrite(rewriter, 0x1111, 100, 9000, 0);
+    EXPECT_TRUE(out.sent);
+    EXPECT_EQ(out.seq, 100);
+    EXPECT_EQ(out.ts, 9000u);
+    EXPECT_EQ(out.ssrc, PLAY_SSRC);
+    EXPECT_TRUE(rewriter.is_started());
+    EXPECT_EQ(rewriter.get_src_ssrc(), 0x1111u);
+}
+
+TEST(SimulcastRtpRewriterTest, SwitchIsContinuous) {
+    SimulcastRtpRewriter rewriter;
+    rewriter.set_ssrc(PLAY_SSRC);
+    for (uint16_t i = 0; i < 5; i++) {
+        auto out = rewrite(rewriter, 0x1111, 100 + i, 9000 + i * 3000, i * 33);
+        EXPECT_EQ(out.seq, 100 + i);
+    }
+    // 最后输出seq 104，ts 21000，时间132ms
+
+    // 切到另一层，序号接着上一层，时间戳按经过的时间递增
+    auto out = rewrite(rewriter, 0x2222, 5000, 777777, 172);
+    EXPECT_TRUE(out.sent);
+    EXPECT_EQ(out.seq, 105);
+    EXPECT_EQ(out.ts, 21000u + 40 * 90);
+    EXPECT_EQ(out.ssrc, PLAY_SSRC);
+    EXPECT_EQ(rewriter.get_src_ssrc(), 0x2222u);
+
+    out = rewrite(rewriter, 0x2222, 5001, 777777 + 3000, 205);
+    EXPECT_EQ(out.seq, 106);
+    EXPECT_EQ(out.ts, 21000u + 40 * 90 + 3000);
+
+    // 切层前排队的旧层包(如重传)不发送
+    out = rewrite(rewriter, 0x1111, 103, 18000, 210);
+    EXPECT_FALSE(out.sent);
+
+    // 当前层的重传包按同样的偏移改写，不影响后续包
+    out = rewrite(rewriter, 0x2222, 5000, 777777, 220);
+    EXPECT_TRUE(out.sent);
+    EXPECT_EQ(out.seq, 105);
+    out = rewrite(rewriter, 0x2222, 5002, 777777 + 6000, 240);
+    EXPECT_EQ(out.seq, 107);
+}
+
+TEST(SimulcastRtpRewriterTest, SameTimeSwitchStillAdvancesTs) {
+    SimulcastRtpRewriter rewriter;
+    rewriter.set_ssrc(PLAY_SSRC);
+    rewrite(rewriter, 0x1111, 10, 1000, 50);
+    auto out = rewrite(rewriter, 0x2222, 20, 5, 50);
+    EXPECT_EQ(out.seq, 11);
+    EXPECT_EQ(out.ts, 1001u);
+}
+
+TEST(SimulcastRtpRewriterTest, NackSeqMapping) {
+    SimulcastRtpRewriter rewriter;
+    rewriter.set_ssrc(PLAY_SSRC);
+    uint16_t src_seq = 0;
+    EXPECT_FALSE(rewriter.to_src_seq(0, src_seq));
+
+    // 序号回绕：旧层输出到65535，新层从100开始
+    rewrite(rewriter, 0x1111, 65534, 0, 0);
+    rewrite(rewriter, 0x1111, 65535, 3000, 33);
+    auto out = rewrite(rewriter, 0x2222, 100, 0, 66);
+    EXPECT_EQ(out.seq, 0);
+    out = rewrite(rewriter, 0x2222, 101, 3000, 99);
+    EXPECT_EQ(out.seq, 1);
+
+    ASSERT_TRUE(rewriter.to_src_seq(0, src_seq));
+    EXPECT_EQ(src_seq, 100);
+    ASSERT_TRUE(rewriter.to_src_seq(1, src_seq));
+    EXPECT_EQ(src_seq, 101);
+    // 切层之前的序号属于旧层，无法从当前层历史中重传
+    EXPECT_FALSE(rewriter.to_src_seq(65535, src_seq));
+    EXPECT_FALSE(rewriter.to_src_seq(65000, src_seq));
+}
@@ -0,0 +1,51 @@
+// TextBuilder的拼接及整数、秒数格式化
+#include <stdint.h>
+#include <stdio.h>
+#include <limits>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "base/utils/text_builder.h"
+
+using namespace mms;
+
+TEST(TextBuilderTest, AppendStrings) {
+    TextBuilder tb;
+    std::string s = "EXTINF";
+    tb << "#" << s << ':' << std::string_view("2.000,\n");
+    EXPECT_EQ(tb.str(), "#EXTINF:2.000,\n");
+    EXPECT_EQ(tb.size(), tb.str().size());
+}
+
+TEST(TextBuilderTest, Integers) {
+    TextBuilder tb;
+    tb << 0 << ',' << -1 << ',' << (uint8_t)200 << ',' << (int8_t)-5 << ','
+       << std::numeric_limits<int64_t>::max() << ',' << std::numeric_limits<int64_t>::min() << ','
+       << std::numeric_limits<uint64_t>::max();
+    EXPECT_EQ(tb.str(), "0,-1,200,-5,9223372036854775807,-9223372036854775808,18446744073709551615");
+}
+
+TEST(TextBuilderTest, CharIsNotFormattedAsNumber) {
+    TextBuilder tb;
+    tb << 'a' << '\n';
+    EXPECT_EQ(tb.str(), "a\n");
+}
+
+TEST(TextBuilderTest, Seconds) {
+    TextBuilder tb;
+    tb << TextBuilder::sec(0) << ' ' << TextBuilder::sec(2000) << ' ' << TextBuilder::sec(1234) << ' '
+       << TextBuilder::sec(5) << ' ' << TextBuilder::sec(-1500) << ' ' << TextBuilder::sec(-5);
+    EXPECT_EQ(tb.str(), "0.000 2.000 1.234 0.005 -1.500 -0.005");
+}
+
+// 与原来按ms/1000.0保留3位小数的输出一致
+TEST(TextBuilderTest, SecondsMatchPrintf) {
+    for (int64_t ms = -3000; ms <= 100000; ms += 7) {
+        TextBuilder tb;
+        tb << TextBuilder::sec(ms);
+        char expected[32];
+        snprintf(expected, sizeof(expected), "%.3f", ms / 1000.0);
+        ASSERT_EQ(tb.str(), expected) << "ms " << ms;
+    }
+}
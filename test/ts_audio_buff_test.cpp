@@ -0,0 +1,236 @@
+// 转ts时多个音频帧合并为一个PES：合并的条件、PES的PTS和内容
+// 按转ts桥的用法把adts帧放进AudioBuff，满了用TsPacker打包，再从ts切片中解析出音频PES检查
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bridge/ts/ts_audio_buff.hpp"
+#include "protocol/ts/ts_packer.hpp"
+#include "protocol/ts/ts_segment.hpp"
+
+using namespace mms;
+
+namespace {
+struct AudioFrame {
+    std::string adts;// 含7字节头
+    int64_t ts;
+};
+
+struct ParsedPes {
+    uint16_t length = 0;
+    int64_t pts = -1;
+    std::string payload;
+};
+
+class TsAudioBuffTest : public testing::Test {
+protected:
+    void SetUp() override {
+        packer_.set_audio_stream(TsStreamAudioAAC, TS_AUDIO_AAC_PID);
+        seg_ = std::make_shared<TsSegment>();
+        packer_.write_pat_pmt(seg_);
+    }
+
+    // 23ms一帧的aac，每帧内容不同，便于检查合并后的顺序
+    static std::vector<AudioFrame> make_frames(int32_t count, size_t frame_bytes) {
+        std::vector<AudioFrame> frames;
+        for (int32_t i = 0; i < count; i++) {
+            AudioFrame f;
+            f.adts.assign(frame_bytes, (char)i);
+            f.adts[0] = (char)0xff;
+            f.adts[1] = (char)0xf1;
+            f.ts = 1000 + i * 23;
+            frames.emplace_back(std::move(f));
+        }
+        return frames;
+    }
+
+    // 与RtmpToTs::process_aac_packet及flush_audio_pes相同的流程
+    void feed(const std::vector<AudioFrame> & frames) {
+        for (auto & f : frames) {
+            buf_.add_pkt(nullptr, f.ts);
+            buf_.audio_pes_segs.emplace_back(f.adts.data(), 7);
+            buf_.audio_pes_segs.emplace_back(f.adts.data() + 7, f.adts.size() - 7);
+            buf_.audio_pes_len += f.adts.size();
+            if (buf_.is_full()) {
+                flush();
+            }
+        }
+        flush();
+    }
+
+    void flush() {
+        if (buf_.audio_pes_segs.empty()) {
+            return;
+        }
+        flushed_frames_.push_back(buf_.audio_pkts.size());
+        packer_.pack_audio(seg_, buf_.audio_pes_segs, buf_.timestamp);
+        buf_.clear();
+    }
+
+    // 取出音频pid上的所有PES
+    std::vector<ParsedPes> parse_audio_pes() {
+        std::string ts;
+        for (auto & b : seg_->get_ts_data()) {
+            ts.append(b);
+        }
+
+        std::vector<std::string> raw;
+        for (size_t off = 0; off + 188 <= ts.size(); off += 188) {
+            const uint8_t *p = (const uint8_t *)ts.data() + off;
+            EXPECT_EQ(p[0], 0x47);
+            uint16_t pid = ((p[1] & 0x1f) << 8) | p[2];
+            uint8_t adaptation_field_control = (p[3] >> 4) & 0x03;
+            if (pid != TS_AUDIO_AAC_PID || !(adaptation_field_control & 0x01)) {
+                continue;
+            }
+
+            size_t start = 4;
+            if (adaptation_field_control & 0x02) {
+                start += 1 + p[4];
+            }
+
+            if (p[1] & 0x40) {
+                raw.emplace_back();
+            }
+            EXPECT_FALSE(raw.empty());
+            raw.back().append((const char *)p + start, 188 - start);
+        }
+
+        std::vector<ParsedPes> pes_list;
+        for (auto & r : raw) {
+            const uint8_t *p = (const uint8_t *)r.data();
+            EXPECT_GE(r.size(), 14u);
+            EXPECT_EQ(p[0], 0x00);
+            EXPECT_EQ(p[1], 0x00);
+            EXPECT_EQ(p[2], 0x01);
+            EXPECT_EQ(p[3], 0xc0);
+            ParsedPes pes;
+            pes.length = (p[4] << 8) | p[5];
+            // 只有pts
+            EXPECT_EQ(p[7] >> 6, 0x02);
+            EXPECT_EQ(p[9] >> 4, 0x02);
+            pes.pts = ((int64_t)(p[9] & 0x0e) << 29) | ((int64_t)p[10] << 22) | ((int64_t)(p[11] & 0xfe) << 14) |
+                      ((int64_t)p[12] << 7) | (p[13] >> 1);
+            size_t header_len = 9 + p[8];
+            pes.payload = r.substr(header_len);
+            EXPECT_EQ((size_t)pes.length, 3 + p[8] + pes.payload.size());
+            pes_list.emplace_back(std::move(pes));
+        }
+        return pes_list;
+    }
+
+    // 检查每个PES依次包含的帧及PTS
+    void expect_pes(const std::vector<AudioFrame> & frames, const std::vector<size_t> & frames_per_pes) {
+        auto pes_list = parse_audio_pes();
+        ASSERT_EQ(pes_list.size(), frames_per_pes.size());
+        size_t idx = 0;
+        for (size_t i = 0; i < pes_list.size(); i++) {
+            // PES的PTS为第一帧的时间戳
+            EXPECT_EQ(pes_list[i].pts, frames[idx].ts * 90) << "pes " << i;
+            std::string expected;
+            for (size_t n = 0; n < frames_per_pes[i]; n++) {
+                expected.append(frames[idx++].adts);
+            }
+            EXPECT_EQ(pes_list[i].payload, expected) << "pes " << i;
+        }
+        EXPECT_EQ(idx, frames.size());
+    }
+
+    TsPacker packer_;
+    std::shared_ptr<TsSegment> seg_;
+    AudioBuff<int> buf_;
+    std::vector<size_t> flushed_frames_;
+};
+};
+
+TEST_F(TsAudioBuffTest, FlushByFrameCount) {
+    buf_.set_limits(8, 200);
+    auto frames = make_frames(20, 200);
+    feed(frames);
+    std::vector<size_t> expected{8, 8, 4};
+    EXPECT_EQ(flushed_frames_, expected);
+    expect_pes(frames, expected);
+}
+
+TEST_F(TsAudioBuffTest, FlushByDuration) {
+    // 第6帧与第1帧相差115ms，达到100ms
+    buf_.set_limits(8, 100);
+    auto frames = make_frames(14, 200);
+    feed(frames);
+    std::vector<size_t> expected{6, 6, 2};
+    EXPECT_EQ(flushed_frames_, expected);
+    expect_pes(frames, expected);
+}
+
+TEST_F(TsAudioBuffTest, OneFrameDisablesMerging) {
+    buf_.set_limits(1, 200);
+    auto frames = make_frames(5, 200);
+    feed(frames);
+    std::vector<size_t> expected(5, 1);
+    EXPECT_EQ(flushed_frames_, expected);
+    expect_pes(frames, expected);
+}
+
+TEST_F(TsAudioBuffTest, ByteCapKeepsPesLengthIn16Bits) {
+    // 接近ADTS上限的大帧，按字节数提前合并结束
+    buf_.set_limits(100, 100000);
+    auto frames = make_frames(10, 8000);
+    feed(frames);
+    std::vector<size_t> expected{7, 3};
+    EXPECT_EQ(flushed_frames_, expected);
+    expect_pes(frames, expected);
+    for (auto & pes : parse_audio_pes()) {
+        EXPECT_NE(pes.length, 0);
+    }
+}
+
+TEST_F(TsAudioBuffTest, MergingSavesTsPackets) {
+    auto frames = make_frames(64, 200);
+    buf_.set_limits(1, 200);
+    feed(frames);
+    int64_t single_bytes = seg_->get_ts_bytes();
+
+    SetUp();
+    buf_.set_limits(8, 200);
+    feed(frames);
+    int64_t merged_bytes = seg_->get_ts_bytes();
+    // 每帧单独打包需要2个ts包，8帧合并后约9个
+    EXPECT_LT(merged_bytes * 3 / 2, single_bytes);
+}
+
+TEST_F(TsAudioBuffTest, SizeOnFixedInput) {
+    // 固定输入：60s的64kbps、44.1kHz aac，每帧1024个采样，帧长在平均值上下浮动
+    const int32_t frame_count = 60 * 44100 / 1024;
+    std::vector<AudioFrame> frames;
+    int64_t es_bytes = 0;
+    for (int32_t i = 0; i < frame_count; i++) {
+        AudioFrame f;
+        f.adts.assign(186 + (i * 37) % 31 - 15, (char)i);
+        f.adts[0] = (char)0xff;
+        f.adts[1] = (char)0xf1;
+        f.ts = (int64_t)i * 1024 * 1000 / 44100;
+        es_bytes += f.adts.size();
+        frames.emplace_back(std::move(f));
+    }
+
+    std::vector<std::pair<int32_t, int64_t>> results;
+    for (int32_t max_frames : {1, 4, 8}) {
+        SetUp();
+        buf_.set_limits(max_frames, 200);
+        feed(frames);
+        // 去掉开头的pat、pmt
+        int64_t bytes = seg_->get_ts_bytes() - 2 * 188;
+        results.emplace_back(max_frames, bytes);
+        printf("ts_audio_pes_max_frames %d: es %lld bytes, ts %lld bytes (%.1f%% overhead), %.1f MB/hour\n", max_frames,
+               (long long)es_bytes, (long long)bytes, (bytes - es_bytes) * 100.0 / es_bytes, bytes * 60 / 1e6);
+    }
+
+    // 不合并时每帧2个ts包
+    EXPECT_EQ(results[0].second, (int64_t)frame_count * 2 * 188);
+    EXPECT_LT(results[1].second, results[0].second);
+    EXPECT_LT(results[2].second, results[1].second);
+}